@@ -50,18 +50,8 @@ ClusterResult ClusterProcess::process(const SequenceWorkItem& item)
     assert(readInterval.isValid());
 
     // Check if this read has been used yet
-    bool used = false;
-    for(int64_t i = readInterval.lower; i <= readInterval.upper; ++i)
-    {
-        if(m_pMarkedReads->test(i))
-        {
-            used = true;
-            break;
-        }
-    }
-
     ClusterResult result;
-    if(used)
+    if(m_pMarkedReads->testRange(readInterval.lower, readInterval.upper))
         return result; // already part of a cluster, return nothing
 
     // Compute a new cluster around this read
@@ -78,6 +68,11 @@ ClusterResult ClusterProcess::process(const SequenceWorkItem& item)
         ClusterNode node = queue.front();
         queue.pop();
 
+        // Another thread may have finished the cluster containing this read while
+        // we were expanding it. Stop now rather than completing a cluster that will be discarded
+        if(m_pMarkedReads->testRange(readInterval.lower, readInterval.upper))
+            return ClusterResult();
+
         // Update the used index and the result structure with this node's data
         result.clusterNodes.push_back(node);
 
@@ -107,7 +102,7 @@ ClusterResult ClusterProcess::process(const SequenceWorkItem& item)
     }
 
     // If some work was performed, update the bitvector so other threads do not try to merge the same set of reads.
-    // This uses compare-and-swap instructions to ensure the uppdate is atomic. 
+    // This uses an atomic test-and-set to ensure the update is atomic. 
     // If some other thread has merged this set (and updated
     // the bitvector), we discard all the merged data.
     
@@ -127,24 +122,15 @@ ClusterResult ClusterProcess::process(const SequenceWorkItem& item)
     if(oldSize != newSize)
         std::cout << "Warning: duplicate cluster nodes were found\n";
 
-    // Check if the bit in the vector has already been set for the lowest read index
-    // If it has some other thread has already output this set so we do nothing
+    // Claim the set by atomically setting the bit for the lowest read index.
+    // If it was already set some other thread has already output this set so we do nothing
     int64_t lowestIndex = result.clusterNodes.front().interval.lower;
-    bool currentValue = m_pMarkedReads->test(lowestIndex);
-    bool updateSuccess = false;
-
-    if(currentValue == false)
-    {
-        // Attempt to update the bit vector with an atomic CAS. If this returns false
-        // the bit was set by some other thread
-        updateSuccess = m_pMarkedReads->updateCAS(lowestIndex, currentValue, true);
-    }
+    bool updateSuccess = !m_pMarkedReads->testAndSet(lowestIndex);
 
     if(updateSuccess)
     {
-        // We successfully atomically set the bit for the first read in this set
-        // to true. We can safely update the rest of the bits and keep the merged sequences
-        // for output.
+        // We own this set of reads. We can safely update the rest of the bits 
+        // and keep the merged sequences for output.
         std::vector<ClusterNode>::const_iterator iter = result.clusterNodes.begin();
         for(; iter != result.clusterNodes.end(); ++iter)
         {
@@ -152,17 +138,12 @@ ClusterResult ClusterProcess::process(const SequenceWorkItem& item)
             {
                 if(i == lowestIndex) //already set
                     continue;
-                currentValue = m_pMarkedReads->test(i);
-                if(currentValue)
+                if(m_pMarkedReads->testAndSet(i))
                 {
                     // This value should not be true, emit a warning
                     std::cout << "Warning: Bit " << i << " was set outside of critical section\n";
                     std::cout << "Read: " << readString << "\n";
                 }
-                else
-                {
-                    m_pMarkedReads->updateCAS(i, currentValue, true);
-                }
             }
         }
     }
@@ -0,0 +1,353 @@
+//-----------------------------------------------
+// Copyright 2010 Wellcome Trust Sanger Institute
+// Written by Jared Simpson (js18@sanger.ac.uk)
+// Released under the GPL
+//-----------------------------------------------
+//
+// EditDistance - Bit-parallel edit distance and
+// alignment using Myers' algorithm
+//
+#include <cassert>
+#include <cstdlib>
+#include <cstdio>
+#include <algorithm>
+#include <stdint.h>
+#include "EditDistance.h"
+
+typedef uint64_t Word;
+static const int WORD_BITS = 64;
+static const int NUM_CODES = 5;
+
+// The bases are mapped to 0-3, everything else is
+// mapped to 4 and only matches other non-ACGT symbols
+static inline int baseCode(char b)
+{
+    switch(b)
+    {
+        case 'A': return 0;
+        case 'C': return 1;
+        case 'G': return 2;
+        case 'T': return 3;
+        default: return 4;
+    }
+}
+
+// Convert a string to base codes
+static void encode(const std::string& s, std::vector<uint8_t>& outCodes)
+{
+    outCodes.resize(s.size());
+    for(size_t i = 0; i < s.size(); ++i)
+        outCodes[i] = baseCode(s[i]);
+}
+
+static inline const uint8_t* getData(const std::vector<uint8_t>& codes)
+{
+    return codes.empty() ? NULL : &codes[0];
+}
+
+static inline int numBlocksForRows(int rows)
+{
+    return (rows + WORD_BITS - 1) / WORD_BITS;
+}
+
+// The state of the computation of the DP matrix of a pattern against a text.
+// Row i of the matrix corresponds to the prefix of length i of the pattern
+// and column t to the prefix of length t of the text. The vertical
+// differences of each column are stored as Pv (+1) and Mv (-1) bit vectors
+struct MyersMatrix
+{
+    int patternLength;
+    int textLength;
+    int numBlocks;
+
+    // D[m][t] for each column t, or -1 if the cell was outside the band
+    std::vector<int> lastRow;
+
+    // The difference vectors of the last column
+    std::vector<Word> Pv;
+    std::vector<Word> Mv;
+
+    // The difference vectors of every column, if requested
+    std::vector<Word> allPv;
+    std::vector<Word> allMv;
+};
+
+// Advance one block of the pattern by one column. Eq is the match vector of the text
+// symbol, hin is the horizontal difference entering the top of the block. The
+// horizontal difference leaving the block at row outBit is returned.
+static inline int advanceBlock(Word& Pv, Word& Mv, Word Eq, int hin, int outBit)
+{
+    Word Xv = Eq | Mv;
+    if(hin < 0)
+        Eq |= 1;
+    Word Xh = (((Eq & Pv) + Pv) ^ Pv) | Eq;
+    Word Ph = Mv | ~(Xh | Pv);
+    Word Mh = Pv & Xh;
+
+    Word outMask = (Word)1 << outBit;
+    int hout = 0;
+    if(Ph & outMask)
+        hout = 1;
+    else if(Mh & outMask)
+        hout = -1;
+
+    Ph <<= 1;
+    Mh <<= 1;
+    if(hin < 0)
+        Mh |= 1;
+    else if(hin > 0)
+        Ph |= 1;
+
+    Pv = Mh | ~(Xv | Ph);
+    Mv = Ph & Xv;
+    return hout;
+}
+
+// Compute the DP matrix of pattern against text. If bAnchored is true the alignment
+// must start at the beginning of the text (D[0][t] = t) otherwise it may start at
+// any position of the text (D[0][t] = 0). If maxDist is not -1, only the blocks that can
+// contain a cell with value at most maxDist are computed.
+static void computeMatrix(const uint8_t* pattern, int m, const uint8_t* text, int n, bool bAnchored,
+                          int maxDist, bool bStoreColumns, MyersMatrix& matrix)
+{
+    int numBlocks = numBlocksForRows(m);
+    int lastBit = (m - 1) % WORD_BITS;
+
+    matrix.patternLength = m;
+    matrix.textLength = n;
+    matrix.numBlocks = numBlocks;
+    matrix.lastRow.assign(n + 1, -1);
+    matrix.Pv.assign(numBlocks, ~(Word)0);
+    matrix.Mv.assign(numBlocks, 0);
+
+    if(bStoreColumns)
+    {
+        matrix.allPv.assign((size_t)(n + 1) * numBlocks, ~(Word)0);
+        matrix.allMv.assign((size_t)(n + 1) * numBlocks, 0);
+    }
+
+    // The match vectors of the pattern
+    std::vector<Word> peq((size_t)NUM_CODES * numBlocks, 0);
+    for(int i = 0; i < m; ++i)
+        peq[pattern[i] * numBlocks + i / WORD_BITS] |= (Word)1 << (i % WORD_BITS);
+
+    // The value of the bottom cell of each block
+    std::vector<int> blockScore(numBlocks);
+    for(int b = 0; b < numBlocks; ++b)
+        blockScore[b] = std::min((b + 1) * WORD_BITS, m);
+
+    // The value of D[i][t] is at least i - t so the rows
+    // below t + maxDist cannot be within the band
+    int activeBlocks = (maxDist == -1) ? numBlocks : numBlocksForRows(std::min(m, maxDist));
+    matrix.lastRow[0] = (activeBlocks == numBlocks) ? m : -1;
+
+    for(int t = 1; t <= n; ++t)
+    {
+        int topScore = bAnchored ? t - 1 : 0;
+        int newActive = (maxDist == -1) ? numBlocks : numBlocksForRows(std::min(m, t + maxDist));
+
+        // Blocks entering the band start with vertical differences of +1 which
+        // are an upper bound on the true values, which are all above maxDist
+        for(int b = activeBlocks; b < newActive; ++b)
+        {
+            matrix.Pv[b] = ~(Word)0;
+            matrix.Mv[b] = 0;
+            int rows = std::min((b + 1) * WORD_BITS, m) - b * WORD_BITS;
+            blockScore[b] = (b > 0 ? blockScore[b - 1] : topScore) + rows;
+        }
+        activeBlocks = newActive;
+
+        int code = text[t - 1];
+        int hin = bAnchored ? 1 : 0;
+        for(int b = 0; b < activeBlocks; ++b)
+        {
+            int outBit = (b == numBlocks - 1) ? lastBit : WORD_BITS - 1;
+            hin = advanceBlock(matrix.Pv[b], matrix.Mv[b], peq[code * numBlocks + b], hin, outBit);
+            blockScore[b] += hin;
+        }
+
+        if(activeBlocks == numBlocks && numBlocks > 0)
+            matrix.lastRow[t] = blockScore[numBlocks - 1];
+        else if(numBlocks == 0)
+            matrix.lastRow[t] = bAnchored ? t : 0;
+
+        if(bStoreColumns)
+        {
+            std::copy(matrix.Pv.begin(), matrix.Pv.end(), matrix.allPv.begin() + (size_t)t * numBlocks);
+            std::copy(matrix.Mv.begin(), matrix.Mv.end(), matrix.allMv.begin() + (size_t)t * numBlocks);
+        }
+    }
+}
+
+// Return D[i][t] of a matrix computed in anchored mode with the columns stored
+static int getCell(const MyersMatrix& matrix, int i, int t)
+{
+    int score = t;
+    size_t base = (size_t)t * matrix.numBlocks;
+    int fullBlocks = i / WORD_BITS;
+    for(int b = 0; b < fullBlocks; ++b)
+        score += __builtin_popcountll(matrix.allPv[base + b]) - __builtin_popcountll(matrix.allMv[base + b]);
+
+    int remainder = i % WORD_BITS;
+    if(remainder > 0)
+    {
+        Word mask = ((Word)1 << remainder) - 1;
+        score += __builtin_popcountll(matrix.allPv[base + fullBlocks] & mask) -
+                 __builtin_popcountll(matrix.allMv[base + fullBlocks] & mask);
+    }
+    return score;
+}
+
+//
+int EditDistance::globalDistance(const std::string& s1, const std::string& s2, int maxDist)
+{
+    if(maxDist != -1 && abs((int)s1.size() - (int)s2.size()) > maxDist)
+        return -1;
+
+    // Use the shorter string as the pattern to minimize the number of blocks
+    std::vector<uint8_t> pattern;
+    std::vector<uint8_t> text;
+    encode(s1.size() < s2.size() ? s1 : s2, pattern);
+    encode(s1.size() < s2.size() ? s2 : s1, text);
+
+    MyersMatrix matrix;
+    computeMatrix(getData(pattern), pattern.size(), getData(text), text.size(), true, maxDist, false, matrix);
+    int dist = matrix.lastRow[text.size()];
+    if(maxDist != -1 && (dist == -1 || dist > maxDist))
+        return -1;
+    return dist;
+}
+
+//
+int EditDistance::globalAlign(const std::string& s1, const std::string& s2, int maxDist, EditOps& outOps)
+{
+    std::vector<uint8_t> codes1;
+    std::vector<uint8_t> codes2;
+    encode(s1, codes1);
+    encode(s2, codes2);
+    return globalAlign(getData(codes1), codes1.size(), getData(codes2), codes2.size(), maxDist, outOps);
+}
+
+//
+int EditDistance::globalAlign(const uint8_t* pCodes1, size_t len1, const uint8_t* pCodes2, size_t len2,
+                              int maxDist, EditOps& outOps)
+{
+    if(maxDist != -1 && abs((int)len1 - (int)len2) > maxDist)
+        return -1;
+
+    // The rows of the matrix are s2 and the columns are s1
+    MyersMatrix matrix;
+    computeMatrix(pCodes2, len2, pCodes1, len1, true, maxDist, true, matrix);
+    int dist = matrix.lastRow[len1];
+    if(maxDist != -1 && (dist == -1 || dist > maxDist))
+        return -1;
+
+    // Trace back from the bottom-right cell. Every cell on an optimal path has a value
+    // of at most dist so it is within the band.
+    outOps.clear();
+    int i = len2;
+    int t = len1;
+    while(i > 0 || t > 0)
+    {
+        int score = getCell(matrix, i, t);
+        if(i > 0 && t > 0)
+        {
+            bool match = pCodes2[i - 1] == pCodes1[t - 1];
+            if(getCell(matrix, i - 1, t - 1) + (match ? 0 : 1) == score)
+            {
+                outOps.push_back(match ? 'M' : 'X');
+                --i;
+                --t;
+                continue;
+            }
+        }
+
+        if(i > 0 && getCell(matrix, i - 1, t) + 1 == score)
+        {
+            outOps.push_back('I');
+            --i;
+        }
+        else
+        {
+            assert(t > 0 && getCell(matrix, i, t - 1) + 1 == score);
+            outOps.push_back('D');
+            --t;
+        }
+    }
+    std::reverse(outOps.begin(), outOps.end());
+    return dist;
+}
+
+//
+std::string EditDistance::opsToCigar(const EditOps& ops)
+{
+    std::string cigar;
+    size_t i = 0;
+    while(i < ops.size())
+    {
+        char op = ops[i] == 'X' ? 'M' : ops[i];
+        size_t runLength = 0;
+        while(i < ops.size() && (ops[i] == 'X' ? 'M' : ops[i]) == op)
+        {
+            ++runLength;
+            ++i;
+        }
+
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%zu%c", runLength, op);
+        cigar.append(buffer);
+    }
+    return cigar;
+}
+
+//
+void EditDistance::suffixPrefixDistances(const std::string& s1, const std::string& s2, std::vector<int>& outDist)
+{
+    // With s2 as the pattern and the start of the alignment free in s1, the
+    // last column of the matrix holds the distance of every prefix of s2
+    // to the best suffix of s1
+    std::vector<uint8_t> codes1;
+    std::vector<uint8_t> codes2;
+    encode(s1, codes1);
+    encode(s2, codes2);
+
+    MyersMatrix matrix;
+    computeMatrix(getData(codes2), codes2.size(), getData(codes1), codes1.size(), false, -1, false, matrix);
+
+    int m = s2.size();
+    outDist.resize(m + 1);
+    outDist[0] = 0;
+    for(int i = 1; i <= m; ++i)
+    {
+        int b = (i - 1) / WORD_BITS;
+        Word bit = (Word)1 << ((i - 1) % WORD_BITS);
+        int delta = 0;
+        if(matrix.Pv[b] & bit)
+            delta = 1;
+        else if(matrix.Mv[b] & bit)
+            delta = -1;
+        outDist[i] = outDist[i - 1] + delta;
+    }
+}
+
+//
+int EditDistance::findAlignedSuffixLength(const std::string& s1, const std::string& s2, int dist)
+{
+    // Align the reversed s2 to the prefixes of the reversed s1
+    std::vector<uint8_t> rs1;
+    std::vector<uint8_t> rs2;
+    encode(std::string(s1.rbegin(), s1.rend()), rs1);
+    encode(std::string(s2.rbegin(), s2.rend()), rs2);
+
+    MyersMatrix matrix;
+    computeMatrix(getData(rs2), rs2.size(), getData(rs1), rs1.size(), true, dist, false, matrix);
+
+    int bestLength = -1;
+    int target = s2.size();
+    for(int t = 0; t <= (int)s1.size(); ++t)
+    {
+        if(matrix.lastRow[t] == dist && (bestLength == -1 || abs(t - target) < abs(bestLength - target)))
+            bestLength = t;
+    }
+    return bestLength;
+}
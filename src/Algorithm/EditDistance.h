@@ -0,0 +1,58 @@
+//-----------------------------------------------
+// Copyright 2010 Wellcome Trust Sanger Institute
+// Written by Jared Simpson (js18@sanger.ac.uk)
+// Released under the GPL
+//-----------------------------------------------
+//
+// EditDistance - Bit-parallel edit distance and
+// alignment using Myers' algorithm with Hyyro's
+// extension to patterns longer than a machine word.
+// The pattern is split into blocks of 64 rows and
+// each column of the DP matrix is computed with a
+// few word operations per block. When a maximum
+// distance is given, only the blocks that can hold
+// a cell within that distance are computed (Ukkonen's
+// cut-off), which bands the computation.
+//
+#ifndef EDITDISTANCE_H
+#define EDITDISTANCE_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace EditDistance
+{
+    // Alignment operations, from the perspective of s1
+    // M - match, X - mismatch, I - base in s2 not in s1, D - base in s1 not in s2
+    typedef std::string EditOps;
+
+    // Return the edit distance between s1 and s2. If maxDist is not -1
+    // and the distance is greater than maxDist, -1 is returned
+    int globalDistance(const std::string& s1, const std::string& s2, int maxDist = -1);
+
+    // Compute an optimal global alignment between s1 and s2 and return the
+    // edit distance. If maxDist is not -1 and the distance is greater
+    // than maxDist, -1 is returned and outOps is not set
+    int globalAlign(const std::string& s1, const std::string& s2, int maxDist, EditOps& outOps);
+
+    // As above for sequences given as base codes (0-3 for A, C, G, T and
+    // 4 for any other symbol) such as the ranks of a packed sequence
+    int globalAlign(const uint8_t* pCodes1, size_t len1, const uint8_t* pCodes2, size_t len2,
+                    int maxDist, EditOps& outOps);
+
+    // Convert the operations to a CIGAR string using the M, I and D operations
+    std::string opsToCigar(const EditOps& ops);
+
+    // Compute the edit distance between each prefix of s2 and the best matching
+    // suffix of s1. On return, outDist[j] holds the distance for the
+    // prefix s2[0, j) for 0 <= j <= |s2|
+    void suffixPrefixDistances(const std::string& s1, const std::string& s2, std::vector<int>& outDist);
+
+    // Return the length of the suffix of s1 that aligns to s2 with dist edits.
+    // If there are multiple such suffixes, the one with length closest to |s2| is returned.
+    // Returns -1 if there is no suffix that aligns with dist edits.
+    int findAlignedSuffixLength(const std::string& s1, const std::string& s2, int dist);
+};
+
+#endif
@@ -22,7 +22,7 @@ std::string ErrorCorrect::correctVertex(const StringGraph* pGraph, Vertex* pVert
         SeqTrie leftTrie;
         SeqTrie rightTrie;
         SGAlgorithms::makeExtendedSeqTries(pGraph, pVertex, p_error, &leftTrie, &rightTrie);
-        return trieCorrect(pVertex->getSeq().toString(), p_error, leftTrie, rightTrie);
+        return trieCorrect(pVertex->getStr(), p_error, leftTrie, rightTrie);
     }
     else
     {
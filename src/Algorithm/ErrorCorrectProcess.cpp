@@ -13,12 +13,16 @@
 
 //#define KMER_TESTING 1
 
+// Values of the kmer count vector that are not counts
+static const int KMER_UNKNOWN = -1; // the kmer has to be looked up
+static const int KMER_SOLID = -2; // the kmer is in the solid kmer filter but has not been counted
+
 //
 //
 //
 ErrorCorrectProcess::ErrorCorrectProcess(const ErrorCorrectParameters params) : m_params(params)  
 {
-    m_params.depthFilter = 10000;
+
 }
 
 //
@@ -71,7 +75,6 @@ ErrorCorrectResult ErrorCorrectProcess::correct(const SequenceWorkItem& workItem
 ErrorCorrectResult ErrorCorrectProcess::overlapCorrection(const SequenceWorkItem& workItem)
 {
     // Overlap based correction
-    static const double p_error = 0.01f;
     bool done = false;
     int rounds = 0;
     
@@ -95,6 +98,10 @@ ErrorCorrectResult ErrorCorrectProcess::overlapCorrection(const SequenceWorkItem
             sumOverlaps += iter->ranges.interval[0].size();
         }
 
+        // The search stops early when the read has more overlaps than the depth filter
+        if(overlap_result.budgetExceeded)
+            sumOverlaps = overlap_result.totalIntervalSize;
+
         if(m_params.depthFilter > 0 && sumOverlaps > m_params.depthFilter)
         {
             result.num_prefix_overlaps = sumOverlaps;
@@ -104,26 +111,29 @@ ErrorCorrectResult ErrorCorrectProcess::overlapCorrection(const SequenceWorkItem
             break;
         }
 
-        // Convert the overlap block list into a multi-overlap 
-        MultiOverlap mo = blockListToMultiOverlap(currRead, m_blockList);
+        // Stack the overlapping reads on the read
+        blockListToPileup(currRead, m_blockList, m_pileup);
 
         if(m_params.printOverlaps)
+        {
+            MultiOverlap mo = blockListToMultiOverlap(currRead, m_blockList);
             mo.printMasked();
+        }
 
         result.num_prefix_overlaps = 0;
         result.num_suffix_overlaps = 0;
-        mo.countOverlaps(result.num_prefix_overlaps, result.num_suffix_overlaps);
+        m_pileup.countOverlaps(result.num_prefix_overlaps, result.num_suffix_overlaps);
 
         // Perform conflict-aware consensus correction on the read
-        result.correctSequence = mo.consensusConflict(p_error, m_params.conflictCutoff);
+        result.correctSequence = m_pileup.consensusConflict(m_params.conflictCutoff);
 
         ++rounds;
         if(rounds == m_params.numOverlapRounds || result.correctSequence == currRead.seq)
         {
             // Correction has converged or the number of rounds was exceeded.
             // Check if the sequence of the read passes QC in the multioverlap
-            mo.updateRootSeq(result.correctSequence.toString());
-            bQCPass = mo.qcCheck();
+            m_pileup.updateRootSeq(result.correctSequence.toString());
+            bQCPass = m_pileup.qcCheck();
             done = true;
         }
         else
@@ -152,12 +162,14 @@ ErrorCorrectResult ErrorCorrectProcess::overlapCorrection(const SequenceWorkItem
 ErrorCorrectResult ErrorCorrectProcess::kmerCorrection(const SequenceWorkItem& workItem)
 {
     ErrorCorrectResult result;
-    typedef std::map<std::string, int> KmerCountMap;
-    KmerCountMap kmerCache;
 
     SeqRecord currRead = workItem.read;
     std::string readSequence = workItem.read.seq.toString();
 
+    // The reverse complement of the read is kept alongside it so the k-mers
+    // of both strands can be searched in place
+    std::string rcSequence = reverseComplement(readSequence);
+
 #ifdef KMER_TESTING
     std::cout << "Kmer correcting read " << workItem.read.id << "\n";
 #endif
@@ -170,6 +182,7 @@ ErrorCorrectResult ErrorCorrectProcess::kmerCorrection(const SequenceWorkItem& w
     bool done = false;
     int rounds = 0;
     int maxAttempts = m_params.numKmerRounds;
+    const CorrectionThresholds& thresholds = CorrectionThresholds::Instance();
 
     // For each kmer, calculate the minimum phred score seen in the bases
     // of the kmer
@@ -187,41 +200,38 @@ ErrorCorrectResult ErrorCorrectProcess::kmerCorrection(const SequenceWorkItem& w
         minPhredVector[i] = minPhred;
     }
 
+    // The count of each kmer of the read. The counts are kept between rounds and only
+    // the kmers covering a corrected base are looked up again.
+    std::vector<int> countVector(nk > 0 ? nk : 0, KMER_UNKNOWN);
+    std::vector<int> solidVector(n, 0);
+
     while(!done && nk > 0)
     {
         // Compute the kmer counts across the read
         // and determine the positions in the read that are not covered by any solid kmers
         // These are the candidate incorrect bases
-        std::vector<int> countVector(nk, 0);
-        std::vector<int> solidVector(n, 0);
+        std::fill(solidVector.begin(), solidVector.end(), 0);
 
         for(int i = 0; i < nk; ++i)
         {
-            std::string kmer = readSequence.substr(i, m_params.kmerLength);
-
-            // First check if this kmer is in the cache
-            // If its not, find its count from the fm-index and cache it
-            int count = 0;
-            KmerCountMap::iterator iter = kmerCache.find(kmer);
-
-            if(iter != kmerCache.end())
-            {
-                count = iter->second;
-            }
-            else
+            // Kmers in the solid filter do not need to be counted unless their
+            // count is used as the threshold for a correction
+            if(countVector[i] == KMER_UNKNOWN)
             {
-                count = BWTAlgorithms::countSequenceOccurrencesWithCache(kmer, m_params.pOverlapper->getBWT(), m_params.pIntervalCache);
-                kmerCache.insert(std::make_pair(kmer, count));
+                if(m_params.pSolidFilter != NULL && m_params.pSolidFilter->contains(readSequence.data() + i))
+                    countVector[i] = KMER_SOLID;
+                else
+                    countVector[i] = countKmer(readSequence, rcSequence, i);
             }
+            int count = countVector[i];
 
             // Get the phred score for the last base of the kmer
             int phred = minPhredVector[i];
-            countVector[i] = count;
 //            std::cout << i << "\t" << phred << "\t" << count << "\n";
 
             // Determine whether the base is solid or not based on phred scores
-            int threshold = CorrectionThresholds::Instance().getRequiredSupport(phred);
-            if(count >= threshold)
+            int threshold = thresholds.getRequiredSupport(phred);
+            if(count == KMER_SOLID || count >= threshold)
             {
                 for(int j = i; j < i + m_params.kmerLength; ++j)
                     solidVector[j] = 1;
@@ -254,18 +264,28 @@ ErrorCorrectResult ErrorCorrectProcess::kmerCorrection(const SequenceWorkItem& w
             {
                 // Attempt to correct the base using the leftmost covering kmer
                 int phred = workItem.read.getPhredScore(i);
-                int threshold = CorrectionThresholds::Instance().getRequiredSupport(phred);
+                int threshold = thresholds.getRequiredSupport(phred);
 
                 int left_k_idx = (i + 1 >= m_params.kmerLength ? i + 1 - m_params.kmerLength : 0);
-                corrected = attemptKmerCorrection(i, left_k_idx, std::max(countVector[left_k_idx], threshold), readSequence);
-                if(corrected)
-                    break;
+                int left_count = getKmerCount(readSequence, rcSequence, left_k_idx, countVector);
+                corrected = attemptKmerCorrection(i, left_k_idx, std::max(left_count, threshold), readSequence, rcSequence);
+                if(!corrected)
+                {
+                    // base was not corrected, try using the rightmost covering kmer
+                    size_t right_k_idx = std::min(i, n - m_params.kmerLength);
+                    int right_count = getKmerCount(readSequence, rcSequence, right_k_idx, countVector);
+                    corrected = attemptKmerCorrection(i, right_k_idx, std::max(right_count, threshold), readSequence, rcSequence);
+                }
 
-                // base was not corrected, try using the rightmost covering kmer
-                size_t right_k_idx = std::min(i, n - m_params.kmerLength);
-                corrected = attemptKmerCorrection(i, right_k_idx, std::max(countVector[right_k_idx], threshold), readSequence);
                 if(corrected)
+                {
+                    // Invalidate the counts of the kmers that cover the corrected base
+                    int first = std::max(0, i - m_params.kmerLength + 1);
+                    int last = std::min(i, nk - 1);
+                    for(int j = first; j <= last; ++j)
+                        countVector[j] = KMER_UNKNOWN;
                     break;
+                }
             }
         }
 
@@ -290,28 +310,99 @@ ErrorCorrectResult ErrorCorrectProcess::kmerCorrection(const SequenceWorkItem& w
     return result;
 }
 
+// Count the occurrences of the kmer starting at position i of readSequence, including
+// its reverse complement. The reverse complement kmer is read from rcSequence.
+int ErrorCorrectProcess::countKmer(const std::string& readSequence, const std::string& rcSequence, size_t i) const
+{
+    size_t k = m_params.kmerLength;
+    size_t rc_idx = readSequence.size() - i - k;
+    const BWT* pBWT = m_params.pOverlapper->getBWT();
+
+    BWTInterval fwd_interval = BWTAlgorithms::findIntervalWithCache(pBWT, m_params.pIntervalCache, readSequence.data() + i, k);
+    BWTInterval rc_interval = BWTAlgorithms::findIntervalWithCache(pBWT, m_params.pIntervalCache, rcSequence.data() + rc_idx, k);
+
+    int count = 0;
+    if(fwd_interval.isValid())
+        count += fwd_interval.size();
+    if(rc_interval.isValid())
+        count += rc_interval.size();
+    return count;
+}
+
+// Return the count of the kmer starting at position i, counting it
+// if it has not been counted yet
+int ErrorCorrectProcess::getKmerCount(const std::string& readSequence, const std::string& rcSequence, 
+                                      size_t i, std::vector<int>& countVector) const
+{
+    if(countVector[i] < 0)
+        countVector[i] = countKmer(readSequence, rcSequence, i);
+    return countVector[i];
+}
+
+// Add the number of occurrences of w with the base at position pos replaced by each
+// base of the alphabet to outCounts. The interval of the suffix after pos is shared
+// by every substitution so the occurrence counts at its ends are computed once
+// and the intervals for all of the substituted bases are derived from them.
+// If bComplement is set the substituted bases are complemented, which is used
+// to search the reverse complement of a kmer.
+void ErrorCorrectProcess::countSubstitutions(const char* w, size_t len, size_t pos, bool bComplement, size_t* outCounts) const
+{
+    const BWT* pBWT = m_params.pOverlapper->getBWT();
+    size_t suffixLen = len - pos - 1;
+
+    BWTInterval suffix(0, pBWT->getBWLen() - 1);
+    if(suffixLen > 0)
+        suffix = BWTAlgorithms::findIntervalWithCache(pBWT, m_params.pIntervalCache, w + pos + 1, suffixLen);
+    if(!suffix.isValid())
+        return;
+
+    AlphaCount64 lowerOcc = pBWT->getFullOcc(suffix.lower - 1);
+    AlphaCount64 upperOcc = pBWT->getFullOcc(suffix.upper);
+
+    for(int j = 0; j < DNA_ALPHABET::size; ++j)
+    {
+        char b = ALPHABET[j];
+        if(bComplement)
+            b = complement(b);
+
+        size_t pb = pBWT->getPC(b);
+        BWTInterval interval(pb + lowerOcc.get(b), pb + upperOcc.get(b) - 1);
+        for(int p = pos - 1; p >= 0 && interval.isValid(); --p)
+            BWTAlgorithms::updateInterval(interval, w[p], pBWT);
+
+        if(interval.isValid())
+            outCounts[j] += interval.size();
+    }
+}
+
 // Attempt to correct the base at position idx in readSequence. Returns true if a correction was made
 // The correction is made only if the count of the corrected kmer is at least minCount
-bool ErrorCorrectProcess::attemptKmerCorrection(size_t i, size_t k_idx, size_t minCount, std::string& readSequence)
+bool ErrorCorrectProcess::attemptKmerCorrection(size_t i, size_t k_idx, size_t minCount, 
+                                                std::string& readSequence, std::string& rcSequence)
 {
     assert(i >= k_idx && i < k_idx + m_params.kmerLength);
+    size_t k = m_params.kmerLength;
     size_t base_idx = i - k_idx;
+    size_t rc_k_idx = readSequence.size() - k_idx - k;
     char originalBase = readSequence[i];
-    std::string kmer = readSequence.substr(k_idx, m_params.kmerLength);
     size_t bestCount = 0;
     char bestBase = '$';
 
 #if KMER_TESTING
-    std::cout << "i: " << i << " k-idx: " << k_idx << " " << kmer << " " << reverseComplement(kmer) << "\n";
+    std::cout << "i: " << i << " k-idx: " << k_idx << " " << readSequence.substr(k_idx, k) << " " << rcSequence.substr(rc_k_idx, k) << "\n";
 #endif
 
+    // Count every substitution of the base on both strands
+    size_t counts[DNA_ALPHABET::size] = { 0, 0, 0, 0 };
+    countSubstitutions(readSequence.data() + k_idx, k, base_idx, false, counts);
+    countSubstitutions(rcSequence.data() + rc_k_idx, k, k - base_idx - 1, true, counts);
+
     for(int j = 0; j < DNA_ALPHABET::size; ++j)
     {
         char currBase = ALPHABET[j];
         if(currBase == originalBase)
             continue;
-        kmer[base_idx] = currBase;
-        size_t count = BWTAlgorithms::countSequenceOccurrencesWithCache(kmer, m_params.pOverlapper->getBWT(), m_params.pIntervalCache);
+        size_t count = counts[j];
 
 #if KMER_TESTING
         printf("%c %zu\n", currBase, count);
@@ -331,6 +422,7 @@ bool ErrorCorrectProcess::attemptKmerCorrection(size_t i, size_t k_idx, size_t m
     {
         assert(bestBase != '$');
         readSequence[i] = bestBase;
+        rcSequence[readSequence.size() - i - 1] = complement(bestBase);
         return true;
     }
     return false;
@@ -15,8 +15,10 @@
 #include "SequenceProcessFramework.h"
 #include "SequenceWorkItem.h"
 #include "MultiOverlap.h"
+#include "ColumnarPileup.h"
 #include "Metrics.h"
 #include "BWTIntervalCache.h"
+#include "SolidKmerFilter.h"
 
 enum ErrorCorrectAlgorithm
 {
@@ -50,6 +52,9 @@ struct ErrorCorrectParameters
     int numKmerRounds;
     int kmerLength;
 
+    // Optional filter of the solid k-mers, consulted before the FM-index
+    const SolidKmerFilter* pSolidFilter;
+
     // output options
     bool printOverlaps;
 };
@@ -84,9 +89,16 @@ class ErrorCorrectProcess
         ErrorCorrectResult kmerCorrection(const SequenceWorkItem& item);
         ErrorCorrectResult overlapCorrection(const SequenceWorkItem& workItem);
 
-        bool attemptKmerCorrection(size_t i, size_t k_idx, size_t minCount, std::string& readSequence);
+        bool attemptKmerCorrection(size_t i, size_t k_idx, size_t minCount, 
+                                   std::string& readSequence, std::string& rcSequence);
+
+        int countKmer(const std::string& readSequence, const std::string& rcSequence, size_t i) const;
+        int getKmerCount(const std::string& readSequence, const std::string& rcSequence, 
+                         size_t i, std::vector<int>& countVector) const;
+        void countSubstitutions(const char* w, size_t len, size_t pos, bool bComplement, size_t* outCounts) const;
 
         OverlapBlockList m_blockList;
+        ColumnarPileup m_pileup;
         ErrorCorrectParameters m_params;
 };
 
@@ -6,6 +6,7 @@
 //
 // FMMergeProcess - Merge unambiguously overlapping sequences
 //
+#include <limits>
 #include "FMMergeProcess.h"
 #include "SGAlgorithms.h"
 #include "SGVisitors.h"
@@ -43,15 +44,7 @@ FMMergeResult FMMergeProcess::process(const SequenceWorkItem& item)
     assert(readInterval.isValid());
 
     // Check if this read has been used yet
-    bool used = false;
-    for(int64_t i = readInterval.lower; i <= readInterval.upper; ++i)
-    {
-        if(m_pMarkedReads->test(i))
-        {
-            used = true;
-            break;
-        }
-    }
+    bool used = m_pMarkedReads->testRange(readInterval.lower, readInterval.upper);
 
     FMMergeResult result;
 
@@ -63,7 +56,7 @@ FMMergeResult FMMergeProcess::process(const SequenceWorkItem& item)
         ssID << "IDX-" << readInterval.lower;
         std::string rootID = ssID.str();
         
-        Vertex* pVertex = new(pGraph->getVertexAllocator()) Vertex(rootID, readString);
+        Vertex* pVertex = pGraph->createVertex(rootID, readString);
         pGraph->addVertex(pVertex);
 
         // Add the root vertex to the result structure
@@ -75,7 +68,7 @@ FMMergeResult FMMergeProcess::process(const SequenceWorkItem& item)
         // Construct the overlap block list for this node
         SeqRecord record;
         record.id = pVertex->getID();
-        record.seq = pVertex->getSeq().toString();
+        record.seq = pVertex->getStr();
         OverlapBlockList blockList;
         m_pOverlapper->overlapRead(record, m_minOverlap, &blockList);
 
@@ -89,18 +82,26 @@ FMMergeResult FMMergeProcess::process(const SequenceWorkItem& item)
             FMMergeCandidate currCandidate = queue.front();
             queue.pop();
 
+            // Stop if another thread has merged this read while we were building the graph
+            if(m_pMarkedReads->testRange(readInterval.lower, readInterval.upper))
+            {
+                used = true;
+                break;
+            }
+
             // Determine whether this is a valid vertex to merge or not.
             // It is valid if it has a single edge in the direction of the vertex
             // that added it to the candidate list
             SeqRecord record;
             record.id = currCandidate.pVertex->getID();
-            record.seq = currCandidate.pVertex->getSeq().toString();
+            record.seq = currCandidate.pVertex->getStr();
 
             OverlapBlockList candidateBlockList;
-            m_pOverlapper->overlapRead(record, m_minOverlap, &candidateBlockList);
+            OverlapResult candidateResult = m_pOverlapper->overlapRead(record, m_minOverlap, &candidateBlockList);
             removeContainmentBlocks(currCandidate.pVertex->getSeqLen(), &candidateBlockList);
 
-            bool validMergeNode = checkCandidate(currCandidate, &candidateBlockList);
+            // A read with too many overlaps to search is not merged
+            bool validMergeNode = !candidateResult.searchAborted && checkCandidate(currCandidate, &candidateBlockList);
             if(validMergeNode)
             {
                 addCandidates(pGraph, currCandidate.pVertex, currCandidate.pEdge, &candidateBlockList, queue);
@@ -113,30 +114,33 @@ FMMergeResult FMMergeProcess::process(const SequenceWorkItem& item)
             }
         }
         
-        // The graph has now been constructed. Remove all the nodes that are marked invalid for merging
-        pGraph->sweepVertices(GC_RED);
-
-        SGDuplicateVisitor dupVisit(true);
-        pGraph->visit(dupVisit);
-        
-        // Merge nodes
-        pGraph->simplify();
-
-        // If there was a cycle in the graph, it is possible that more than 1 vertex 
-        // remains in the graph. Copy the vertex sequences into the result object.
-        pGraph->getVertexSequences(result.mergedSequences);
-        result.isMerged = true;
+        if(!used)
+        {
+            // The graph has now been constructed. Remove all the nodes that are marked invalid for merging
+            pGraph->sweepVertices(GC_RED);
+
+            SGDuplicateVisitor dupVisit(true);
+            pGraph->visit(dupVisit);
+            
+            // Merge nodes
+            pGraph->simplify();
+
+            // If there was a cycle in the graph, it is possible that more than 1 vertex 
+            // remains in the graph. Copy the vertex sequences into the result object.
+            pGraph->getVertexSequences(result.mergedSequences);
+        }
         delete pGraph;
     }
-    else
-    {
-        result.isMerged = false;
-    }
+
+    // Nothing is output for a read that was already merged
+    result.isMerged = !used;
+    if(used)
+        result.usedIntervals.clear();
 
     if(result.isMerged)
     {
         // If some work was performed, update the bitvector so other threads do not try to merge the same set of reads.
-        // This uses compare-and-swap instructions to ensure the uppdate is atomic. 
+        // This uses an atomic test-and-set to ensure the update is atomic. 
         // If some other thread has merged this set (and updated
         // the bitvector), we discard all the merged data.
         
@@ -151,24 +155,15 @@ FMMergeResult FMMergeProcess::process(const SequenceWorkItem& item)
                                                                 BWTInterval::equal);
         result.usedIntervals.erase(newEnd, result.usedIntervals.end());
 
-        // Check if the bit in the vector has already been set for the lowest read index
-        // If it has some other thread has already output this set so we do nothing
+        // Claim the set by atomically setting the bit for the lowest read index.
+        // If it was already set some other thread has already output this set so we do nothing
         int64_t lowestIndex = result.usedIntervals.front().lower;
-        bool currentValue = m_pMarkedReads->test(lowestIndex);
-        bool updateSuccess = false;
-
-        if(currentValue == false)
-        {
-            // Attempt to update the bit vector with an atomic CAS. If this returns false
-            // the bit was set by some other thread
-            updateSuccess = m_pMarkedReads->updateCAS(lowestIndex, currentValue, true);
-        }
+        bool updateSuccess = !m_pMarkedReads->testAndSet(lowestIndex);
 
         if(updateSuccess)
         {
-            // We successfully atomically set the bit for the first read in this set
-            // to true. We can safely update the rest of the bits and keep the merged sequences
-            // for output.
+            // We own this set of reads. We can safely update the rest of the bits 
+            // and keep the merged sequences for output.
             std::vector<BWTInterval>::const_iterator iter = result.usedIntervals.begin();
             for(; iter != result.usedIntervals.end(); ++iter)
             {
@@ -177,16 +172,11 @@ FMMergeResult FMMergeProcess::process(const SequenceWorkItem& item)
                     if(i == lowestIndex) //already set
                         continue;
 
-                    currentValue = m_pMarkedReads->test(i);
-                    if(currentValue)
+                    if(m_pMarkedReads->testAndSet(i))
                     {
                         // This value should not be true, emit a warning
                         std::cout << "Warning: Bit " << i << " was set outside of critical section\n";
                     }
-                    else
-                    {
-                        m_pMarkedReads->updateCAS(i, currentValue, true);
-                    }
                 }
             }
         }
@@ -253,7 +243,7 @@ void FMMergeProcess::addCandidates(StringGraph* pGraph, const Vertex* pX, const
             // Construct new candidate vertices and add them to the graph
             std::string vertexID = iter->toCanonicalID();
             assert(vertexID != pX->getID());
-            std::string vertexSeq = iter->getFullString(pX->getSeq().toString());
+            std::string vertexSeq = iter->getFullString(pX->getStr());
             Overlap ovrXY = iter->toOverlap(pX->getID(), vertexID, pX->getSeqLen(), vertexSeq.length());
 
             // The vertex may already exist in the graph if the graph contains a loop
@@ -262,7 +252,7 @@ void FMMergeProcess::addCandidates(StringGraph* pGraph, const Vertex* pX, const
             // Generate the new vertex
             if(pY == NULL)
             {
-                pY = new(pGraph->getVertexAllocator()) Vertex(vertexID, vertexSeq);
+                pY = pGraph->createVertex(vertexID, vertexSeq);
                 pGraph->addVertex(pY);
             }
 
@@ -291,7 +281,11 @@ FMMergePostProcess::FMMergePostProcess(std::ostream* pWriter, BitVector* pMarked
                                                                                           m_numTotal(0), 
                                                                                           m_totalLength(0), 
                                                                                           m_pWriter(pWriter), 
-                                                                                          m_pMarkedReads(pMarkedReads)
+                                                                                          m_pMarkedReads(pMarkedReads),
+                                                                                          m_pSAI(NULL),
+                                                                                          m_startIdx(0),
+                                                                                          m_endIdx(0),
+                                                                                          m_namePrefix("merged-")
 {
 
 }
@@ -310,6 +304,14 @@ void FMMergePostProcess::process(const SequenceWorkItem& item, const FMMergeResu
     (void)item;
     m_numTotal += 1;
 
+    // The set is written by the job that owns its lowest read
+    if(result.isMerged && m_pSAI != NULL)
+    {
+        size_t lowestIdx = getLowestReadIndex(result);
+        if(lowestIdx < m_startIdx || lowestIdx >= m_endIdx)
+            return;
+    }
+
     if(result.isMerged)
     {
         // Write out the merged sequences
@@ -317,7 +319,7 @@ void FMMergePostProcess::process(const SequenceWorkItem& item, const FMMergeResu
                 iter != result.mergedSequences.end(); ++iter)
         {
             std::stringstream nameSS;
-            nameSS << "merged-" << m_numMerged++;
+            nameSS << m_namePrefix << m_numMerged++;
             SeqRecord record;
             record.id = nameSS.str();
             record.seq = *iter;
@@ -327,3 +329,30 @@ void FMMergePostProcess::process(const SequenceWorkItem& item, const FMMergeResu
         }
     }
 }
+
+//
+void FMMergePostProcess::setReadRange(const SuffixArray* pSAI, size_t start, size_t end)
+{
+    m_pSAI = pSAI;
+    m_startIdx = start;
+    m_endIdx = end;
+}
+
+//
+size_t FMMergePostProcess::getLowestReadIndex(const FMMergeResult& result) const
+{
+    // The intervals are over the suffixes starting with '$', which
+    // are the first entries of the suffix array
+    size_t lowestIdx = std::numeric_limits<size_t>::max();
+    std::vector<BWTInterval>::const_iterator iter = result.usedIntervals.begin();
+    for(; iter != result.usedIntervals.end(); ++iter)
+    {
+        for(int64_t i = iter->lower; i <= iter->upper; ++i)
+        {
+            size_t readIdx = m_pSAI->get(i).getID();
+            if(readIdx < lowestIdx)
+                lowestIdx = readIdx;
+        }
+    }
+    return lowestIdx;
+}
@@ -15,6 +15,7 @@
 #include "BitVector.h"
 #include "Bigraph.h"
 #include "SGUtil.h"
+#include "SuffixArray.h"
 
 struct FMMergeResult
 {
@@ -79,13 +80,31 @@ class FMMergePostProcess
         
         void process(const SequenceWorkItem& item, const FMMergeResult& result);
 
+        // Only write out the merged sets whose lowest read index is in [start, end).
+        // This is used to split the merge over independent jobs. Every set is 
+        // written by exactly one job. pSAI is used to translate the intervals
+        // of the set to read indices.
+        void setReadRange(const SuffixArray* pSAI, size_t start, size_t end);
+
+        // Set the prefix used to name the merged sequences (default: merged-)
+        void setNamePrefix(const std::string& prefix) { m_namePrefix = prefix; }
+
     private:
+
+        // Return the lowest read index of the reads in the merged set
+        size_t getLowestReadIndex(const FMMergeResult& result) const;
+
         size_t m_numMerged;
         size_t m_numTotal;
         size_t m_totalLength;
 
         std::ostream* m_pWriter;
         BitVector* m_pMarkedReads;
+
+        const SuffixArray* m_pSAI;
+        size_t m_startIdx;
+        size_t m_endIdx;
+        std::string m_namePrefix;
 };
 
 #endif
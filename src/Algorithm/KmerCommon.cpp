@@ -0,0 +1,130 @@
+//-----------------------------------------------
+// Copyright 2010 Wellcome Trust Sanger Institute
+// Written by Jared Simpson (js18@sanger.ac.uk)
+// Released under the GPL
+//-----------------------------------------------
+//
+// KmerCommon - Build and cache histograms of the
+// k-mer counts of an FM-index
+//
+#include <sstream>
+#include <sys/stat.h>
+#include "KmerCommon.h"
+#include "BWTAlgorithms.h"
+#include "ThreadPool.h"
+
+// The sample is split into this many blocks with their own random state
+static const size_t NUM_SAMPLE_BLOCKS = 64;
+
+// Pool task that samples blocks of reads into its own histogram. Each
+// task takes blocks from a shared counter until all have been sampled.
+class KmerSampleTask : public PoolTask
+{
+    public:
+        KmerSampleTask(const BWT* pBWT, int k, size_t numSamples, unsigned int seed,
+                       size_t* pNextBlock) : m_pBWT(pBWT), m_k(k), m_numSamples(numSamples),
+                                             m_seed(seed), m_pNextBlock(pNextBlock) {}
+
+        void run()
+        {
+            size_t block;
+            while((block = __sync_fetch_and_add(m_pNextBlock, 1)) < NUM_SAMPLE_BLOCKS)
+            {
+                size_t start = block * m_numSamples / NUM_SAMPLE_BLOCKS;
+                size_t end = (block + 1) * m_numSamples / NUM_SAMPLE_BLOCKS;
+                unsigned int blockSeed = m_seed * NUM_SAMPLE_BLOCKS + block;
+                for(size_t i = start; i < end; ++i)
+                    addString(BWTAlgorithms::sampleRandomString(m_pBWT, &blockSeed));
+            }
+        }
+
+        const KmerDistribution& getDistribution() const { return m_distribution; }
+
+    private:
+
+        // Count each kmer of s on both strands. The reverse complement kmers
+        // are read from the reverse complement of s.
+        void addString(const std::string& s)
+        {
+            int n = s.size();
+            int nk = n - m_k + 1;
+            std::string rc = reverseComplement(s);
+            for(int j = 0; j < nk; ++j)
+            {
+                BWTInterval fwd_interval = BWTAlgorithms::findInterval(m_pBWT, s.data() + j, m_k);
+                BWTInterval rc_interval = BWTAlgorithms::findInterval(m_pBWT, rc.data() + n - j - m_k, m_k);
+
+                int count = 0;
+                if(fwd_interval.isValid())
+                    count += fwd_interval.size();
+                if(rc_interval.isValid())
+                    count += rc_interval.size();
+                m_distribution.add(count);
+            }
+        }
+
+        const BWT* m_pBWT;
+        int m_k;
+        size_t m_numSamples;
+        unsigned int m_seed;
+        size_t* m_pNextBlock;
+        KmerDistribution m_distribution;
+};
+
+//
+std::string KmerCommon::getDistributionFilename(const std::string& prefix, int k, const std::string& producer)
+{
+    std::stringstream ss;
+    ss << prefix << ".k" << k << "." << producer << KDIST_EXT;
+    return ss.str();
+}
+
+//
+std::string KmerCommon::getIndexKey(const std::string& bwtFilename, const BWT* pBWT, int k, const std::string& sample)
+{
+    std::stringstream ss;
+    ss << "k=" << k << " strings=" << pBWT->getNumStrings() << " symbols=" << pBWT->getBWLen();
+
+    // The number of each base
+    for(int i = 0; i < DNA_ALPHABET::size; ++i)
+    {
+        char b = DNA_ALPHABET::getBase(i);
+        BaseCount upper = i + 1 < DNA_ALPHABET::size ? pBWT->getPC(DNA_ALPHABET::getBase(i + 1)) : pBWT->getBWLen();
+        ss << " " << b << "=" << upper - pBWT->getPC(b);
+    }
+
+    struct stat fileStat;
+    if(stat(bwtFilename.c_str(), &fileStat) == 0)
+        ss << " bytes=" << fileStat.st_size << " mtime=" << fileStat.st_mtime;
+    ss << " sample=" << sample;
+    return ss.str();
+}
+
+//
+void KmerCommon::sampleDistribution(const BWT* pBWT, int k, size_t numSamples, unsigned int seed,
+                                    int numThreads, KmerDistribution& outDist)
+{
+    size_t nextBlock = 0;
+    std::vector<KmerSampleTask*> tasks;
+    for(int i = 0; i < numThreads; ++i)
+        tasks.push_back(new KmerSampleTask(pBWT, k, numSamples, seed, &nextBlock));
+
+    if(numThreads <= 1)
+    {
+        tasks.front()->run();
+    }
+    else
+    {
+        TaskGroup taskGroup;
+        ThreadPool& pool = ThreadPool::getInstance();
+        for(int i = 0; i < numThreads; ++i)
+            pool.submit(tasks[i], &taskGroup, pool.getNodeForWorker(i));
+        taskGroup.wait();
+    }
+
+    for(size_t i = 0; i < tasks.size(); ++i)
+    {
+        outDist.merge(tasks[i]->getDistribution());
+        delete tasks[i];
+    }
+}
@@ -0,0 +1,42 @@
+//-----------------------------------------------
+// Copyright 2010 Wellcome Trust Sanger Institute
+// Written by Jared Simpson (js18@sanger.ac.uk)
+// Released under the GPL
+//-----------------------------------------------
+//
+// KmerCommon - Build and cache histograms of the
+// k-mer counts of an FM-index. A histogram is
+// stored next to the index in PREFIX.kK.PRODUCER.kdist
+// with a key describing the index so it is only
+// reused for the index it was computed from.
+//
+#ifndef KMERCOMMON_H
+#define KMERCOMMON_H
+
+#include "BWT.h"
+#include "KmerDistribution.h"
+
+#define KDIST_EXT ".kdist"
+
+namespace KmerCommon
+{
+
+// Return the name of the file that caches the histogram of k-mers of length k.
+// Each program that caches a histogram passes its own name as the producer so
+// the programs do not overwrite each other's histogram
+std::string getDistributionFilename(const std::string& prefix, int k, const std::string& producer);
+
+// Return a string that identifies the index in bwtFilename, the k-mer length and
+// the reads that were sampled. The key includes the size, modification time and
+// base composition of the index so a rebuilt index does not match an old histogram
+std::string getIndexKey(const std::string& bwtFilename, const BWT* pBWT, int k, const std::string& sample);
+
+// Add the counts of the k-mers of numSamples randomly chosen reads to outDist.
+// The reads are chosen in fixed blocks that are each seeded from seed,
+// so the histogram depends on the seed but not on the number of threads
+void sampleDistribution(const BWT* pBWT, int k, size_t numSamples, unsigned int seed,
+                        int numThreads, KmerDistribution& outDist);
+
+};
+
+#endif
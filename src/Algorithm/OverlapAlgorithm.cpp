@@ -6,6 +6,7 @@
 #include "OverlapAlgorithm.h"
 #include "ASQG.h"
 #include <tr1/unordered_set>
+#include <map>
 #include <math.h>
 
 // Collect the complete set of overlaps in pOBOut
@@ -16,6 +17,41 @@ static const AlignFlags preSufAF(true, true, false);
 
 //#define DEBUGOVERLAP 1
 
+// Sum the sizes of the intervals of the blocks in the list
+static int64_t sumIntervalSizes(const OverlapBlockList& blockList)
+{
+    int64_t sum = 0;
+    for(OverlapBlockList::const_iterator iter = blockList.begin(); iter != blockList.end(); ++iter)
+        sum += iter->ranges.interval[0].size();
+    return sum;
+}
+
+// Add the range [lower, upper] to a set of disjoint ranges keyed by their
+// lower end. Returns the number of positions that were not already covered.
+static int64_t addToRangeUnion(std::map<int64_t, int64_t>& ranges, int64_t lower, int64_t upper)
+{
+    std::map<int64_t, int64_t>::iterator iter = ranges.upper_bound(lower);
+    if(iter != ranges.begin())
+    {
+        --iter;
+        if(iter->second < lower)
+            ++iter;
+    }
+
+    int64_t newLower = lower;
+    int64_t newUpper = upper;
+    int64_t covered = 0;
+    while(iter != ranges.end() && iter->first <= upper)
+    {
+        newLower = std::min(newLower, iter->first);
+        newUpper = std::max(newUpper, iter->second);
+        covered += iter->second - iter->first + 1;
+        ranges.erase(iter++);
+    }
+    ranges[newLower] = newUpper;
+    return (newUpper - newLower + 1) - covered;
+}
+
 // Perform the overlap
 OverlapResult OverlapAlgorithm::overlapRead(const SeqRecord& read, int minOverlap, OverlapBlockList* pOutList) const
 {
@@ -166,6 +202,16 @@ OverlapResult OverlapAlgorithm::overlapReadExact(const SeqRecord& read, int minO
     oblSuffixFwd.splice(oblSuffixFwd.end(), oblSuffixRev);
     oblPrefixFwd.splice(oblPrefixFwd.end(), oblPrefixRev);
 
+    // Stop before the transitive reduction if the read has too many overlaps
+    result.totalIntervalSize = sumIntervalSizes(oblFwdContain) + sumIntervalSizes(oblRevContain) +
+                               sumIntervalSizes(oblSuffixFwd) + sumIntervalSizes(oblPrefixFwd);
+    if(m_budget.maxIntervalSize != -1 && result.totalIntervalSize > m_budget.maxIntervalSize)
+    {
+        result.searchAborted = true;
+        result.budgetExceeded = true;
+        return result;
+    }
+
     // Move the containments to the output list
     pOBOut->splice(pOBOut->end(), oblFwdContain);
     pOBOut->splice(pOBOut->end(), oblRevContain);
@@ -306,6 +352,9 @@ bool OverlapAlgorithm::findOverlapBlocksInexact(const std::string& w, const BWT*
     OverlapBlockList workingList;
     SearchSeedVector::iterator iter;
 
+    // The read index ranges of the blocks found, used to enforce the budget
+    std::map<int64_t, int64_t> readRanges;
+
     // Create and extend the initial seeds
     int actual_seed_length = m_seedLength;
     int actual_seed_stride = m_seedStride;
@@ -331,14 +380,14 @@ bool OverlapAlgorithm::findOverlapBlocksInexact(const std::string& w, const BWT*
     bool fail = false;
     while(!pCurrVector->empty())
     {
-        if(m_maxSeeds != -1 && (int)pCurrVector->size() > m_maxSeeds)
+        if(m_budget.maxSeeds != -1 && (int)pCurrVector->size() > m_budget.maxSeeds)
         {
             fail = true;
             break;
         }
 
         iter = pCurrVector->begin();
-        while(iter != pCurrVector->end())
+        while(iter != pCurrVector->end() && !fail)
         {
             SearchSeed& align = *iter;
 
@@ -362,6 +411,30 @@ bool OverlapAlgorithm::findOverlapBlocksInexact(const std::string& w, const BWT*
                         assert(probe.interval[1].lower > 0);
                         OverlapBlock nBlock(probe, align.ranges, overlapLen, align.z, af, align.historyLink->getHistoryVector());
                         workingList.push_back(nBlock);
+
+                        // Stop as soon as the read has too many overlaps. The same read can be
+                        // found by several seeds or at several overlap lengths so the reads
+                        // are counted by the union of their ranges, which is the number that
+                        // remain once the submaximal blocks are removed.
+                        if(m_budget.maxIntervalSize != -1)
+                        {
+                            BWTInterval readRange = nBlock.ranges.interval[0];
+                            if(overlapLen == len)
+                            {
+                                // Only the reads that end with this read are contained
+                                BWTIntervalPair terminated = nBlock.ranges;
+                                BWTAlgorithms::updateBothR(terminated, '$', nBlock.getExtensionBWT(pBWT, pRevBWT));
+                                readRange = terminated.interval[0];
+                            }
+
+                            if(readRange.isValid())
+                                result.totalIntervalSize += addToRangeUnion(readRanges, readRange.lower, readRange.upper);
+                            if(result.totalIntervalSize > m_budget.maxIntervalSize)
+                            {
+                                result.budgetExceeded = true;
+                                fail = true;
+                            }
+                        }
                     }
                 }
 
@@ -385,6 +458,10 @@ bool OverlapAlgorithm::findOverlapBlocksInexact(const std::string& w, const BWT*
             ++iter;
             //pCurrVector->erase(iter++);
         }
+
+        if(fail)
+            break;
+
         pCurrVector->clear();
         assert(pCurrVector->empty());
         pCurrVector->swap(*pNextVector);
@@ -24,9 +24,33 @@ enum OverlapMode
 
 struct OverlapResult
 {
-    OverlapResult() : isSubstring(false), searchAborted(false) {}
+    OverlapResult() : isSubstring(false), searchAborted(false), budgetExceeded(false), totalIntervalSize(0) {}
     bool isSubstring;
     bool searchAborted;
+
+    // The search was stopped because the budget was used up
+    bool budgetExceeded;
+
+    // The total size of the intervals of the overlap blocks that were
+    // counted against the budget
+    int64_t totalIntervalSize;
+};
+
+// Limits on the work done to overlap a single read. When a limit is
+// exceeded the search stops, no blocks are returned and the result
+// is flagged as aborted. A value of -1 disables a limit.
+struct OverlapBudget
+{
+    OverlapBudget() : maxIntervalSize(-1), maxSeeds(-1) {}
+
+    // The maximum total size of the intervals of the overlap blocks,
+    // counted after the submaximal blocks are removed and before the
+    // transitive blocks are. The inexact search stops as soon as
+    // this is exceeded.
+    int64_t maxIntervalSize;
+
+    // The maximum number of seeds that are extended at once
+    int maxSeeds;
 };
 
 class OverlapAlgorithm
@@ -42,8 +66,7 @@ class OverlapAlgorithm
                                          m_seedStride(seedStride),
                                          m_bIrreducible(irrOnly),
                                          m_exactModeOverlap(false),
-                                         m_exactModeIrreducible(false),
-                                         m_maxSeeds(maxSeeds) {}
+                                         m_exactModeIrreducible(false) { m_budget.maxSeeds = maxSeeds; }
 
         // Perform the overlap
         // This function is threaded so everything must be const
@@ -71,6 +94,10 @@ class OverlapAlgorithm
         void setExactModeOverlap(bool b) { m_exactModeOverlap = b; }
         void setExactModeIrreducible(bool b) { m_exactModeIrreducible = b; }
 
+        // Limit the work done for each read. This replaces the maxSeeds
+        // value given to the constructor.
+        void setBudget(const OverlapBudget& budget) { m_budget = budget; }
+
         //
         const BWT* getBWT() const { return m_pBWT; }
         const BWT* getRBWT() const { return m_pRevBWT; }
@@ -168,8 +195,8 @@ class OverlapAlgorithm
         bool m_exactModeOverlap;
         bool m_exactModeIrreducible;
         
-        // Optional parameter to limit the amount of branching that is performed
-        int m_maxSeeds; 
+        // Optional limits on the amount of branching and the number of overlaps
+        OverlapBudget m_budget;
 };
 
 #endif
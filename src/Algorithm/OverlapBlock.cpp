@@ -500,6 +500,39 @@ MultiOverlap blockListToMultiOverlap(const SeqRecord& record, OverlapBlockList&
     return out;
 }
 
+//
+void blockListToPileup(const SeqRecord& record, OverlapBlockList& blockList, ColumnarPileup& outPileup)
+{
+    std::string read_seq = record.seq.toString();
+    outPileup.reset(read_seq, record.qual);
+
+    for(OverlapBlockList::iterator iter = blockList.begin(); iter != blockList.end(); ++iter)
+    {
+        std::string overlap_string = iter->getOverlapString(read_seq);
+
+        // Compute the endpoints of the overlap, as in blockListToMultiOverlap
+        int s1 = read_seq.length() - iter->overlapLen;
+        int e1 = s1 + iter->overlapLen - 1;
+        SeqCoord sc1(s1, e1, read_seq.length());
+
+        int s2 = 0;
+        int e2 = s2 + iter->overlapLen - 1;
+        SeqCoord sc2(s2, e2, overlap_string.length());
+
+        if(iter->flags.isQueryRev())
+            sc1.flip();
+        if(iter->flags.isTargetRev())
+            sc2.flip();
+
+        if(sc1.isContained())
+            continue; // skip containments
+
+        // Every member of the block has the same sequence and placement
+        Match match(sc1, sc2, false, -1);
+        outPileup.addRow(overlap_string, match.inverseTranslate(0), iter->ranges.interval[0].size(), sc1);
+    }
+}
+
 // make an id string from a read index
 std::string makeIdxString(int64_t idx)
 {
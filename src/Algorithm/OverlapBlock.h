@@ -18,6 +18,7 @@
 #include "SearchHistory.h"
 #include "GraphCommon.h"
 #include "MultiOverlap.h"
+#include "ColumnarPileup.h"
 
 // Flags indicating how a given read was aligned to the FM-index
 // Used for internal bookkeeping
@@ -213,6 +214,10 @@ void removeContainmentBlocks(int readLen, OverlapBlockList* pList);
 // Convert an overlap block list into a multiple overlap
 MultiOverlap blockListToMultiOverlap(const SeqRecord& record, OverlapBlockList& blockList);
 
+// Fill a pileup with the same overlaps as blockListToMultiOverlap.
+// Each block is added as one row weighted by the number of reads in it.
+void blockListToPileup(const SeqRecord& record, OverlapBlockList& blockList, ColumnarPileup& outPileup);
+
 // 
 std::string makeIdxString(int64_t idx);
 
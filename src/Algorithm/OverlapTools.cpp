@@ -10,6 +10,7 @@
 #include "OverlapTools.h"
 #include "SuffixArray.h"
 #include "RLBWT.h"
+#include "EditDistance.h"
 
 //#define DPOVERLAPPRINT 1
 
@@ -35,9 +36,8 @@ bool OverlapTools::boundedOverlapDP(const std::string& s1, const std::string& s2
     std::string sub1 = s1.substr(s1.size() - sublen);
     std::string sub2 = s2.substr(0, sublen);
 
-    DPAlignment dpAlign(sub1, sub2, DPM_OVERLAP, DPSS_SIMILARITY);
     Match match;
-    bool validMatch = findBestOverlapByScore(sub1, sub2, minOverlap, maxErrorRate, dpAlign, match);
+    bool validMatch = findBestOverlapByEditDistance(sub1, sub2, minOverlap, maxErrorRate, match);
     if(validMatch)
     {
         // If we are matching a substring of both s1 and s2, and the match
@@ -71,6 +71,63 @@ bool OverlapTools::boundedOverlapDP(const std::string& s1, const std::string& s2
     }
 }    
 
+//
+bool OverlapTools::findBestOverlapByEditDistance(const std::string& s1, const std::string& s2,
+                                                 int minOverlap, double maxErrorRate, Match& outMatch)
+{
+    // Compute the edit distance between every prefix of s2 and
+    // its best matching suffix of s1 with the bit-parallel kernel
+    std::vector<int> distances;
+    EditDistance::suffixPrefixDistances(s1, s2, distances);
+
+    // Choose the overlap length that maximizes the same similarity score used by
+    // DPAlignment (+7 per match, -10 per edit), which prefers long overlaps with few edits.
+    // Overlaps that end in a gap in s1 always score less than the overlap one base shorter.
+    int bestOverlapLen = -1;
+    int bestScore = 0;
+    for(int j = minOverlap; j < (int)distances.size(); ++j)
+    {
+        int num_edits = distances[j];
+        int score = 7 * (j - num_edits) - 10 * num_edits;
+        if(score <= bestScore)
+            continue;
+
+        std::string prefix = s2.substr(0, j);
+        int s1_len = EditDistance::findAlignedSuffixLength(s1, prefix, num_edits);
+        if(s1_len <= 0)
+            continue;
+
+        Match currMatch;
+        currMatch.isReverse = false;
+        currMatch.coord[0].interval.start = s1.size() - s1_len;
+        currMatch.coord[0].interval.end = s1.size() - 1; // match coords are inclusive
+        currMatch.coord[0].seqlen = s1.size();
+        currMatch.coord[1].interval.start = 0;
+        currMatch.coord[1].interval.end = j - 1;
+        currMatch.coord[1].seqlen = s2.size();
+        currMatch.setNumDiffs(num_edits);
+        double errorRate = (double)num_edits / currMatch.getMinOverlapLength();
+        bool isValid = errorRate < maxErrorRate && currMatch.getMinOverlapLength() >= minOverlap &&
+                       currMatch.coord[0].isExtreme() && currMatch.coord[1].isExtreme();
+
+        if(isValid)
+        {
+            bestOverlapLen = j;
+            bestScore = score;
+            outMatch = currMatch;
+        }
+    }
+
+#ifdef DPOVERLAPPRINT
+    if(bestOverlapLen > 0)
+    {
+        std::cout << "\nBest overlap: " << bestOverlapLen << "\n";
+        outMatch.printMatch(s1, s2);
+    }
+#endif
+    return bestOverlapLen > 0;
+}
+
 //
 bool OverlapTools::findBestOverlapByScore(const std::string& s1, const std::string& s2, 
                                           int minOverlap, double maxErrorRate, 
@@ -27,10 +27,16 @@ namespace OverlapTools
     // This is something of a heavy function and the longest possible match must be provided
     // If there is a match between minOverlap and maxOverlap with edit distance less than maxErrorRate, it will be returned.
     // If there are multiple valid matches like this, the highest scoring match will be returned under the DPSS_SIMILARITY
-    // scoring scheme. If true is returned, a valid match has been found and outMatch is filled in appropriately.
+    // scoring scheme. The edit distances are computed with the bit-parallel kernel in EditDistance. If true is returned, a valid match has been found and outMatch is filled in appropriately.
     // This function should not be used to find overlaps greater than 500bp
     bool boundedOverlapDP(const std::string& s1, const std::string& s2, int minOverlap, int maxOverlap, double maxErrorRate, Match& outMatch);
 
+    // Find the best overlap between a suffix of s1 and a prefix of s2 using the
+    // bit-parallel edit distance kernel. Returns true if a valid overlap has been found
+    // and fills in the match structure
+    bool findBestOverlapByEditDistance(const std::string& s1, const std::string& s2,
+                                       int minOverlap, double maxErrorRate, Match& outMatch);
+
     // Find the best overlap using the dpAlign structure. Returns true
     // if a valid overlap has been found and fills in the match structure
     bool findBestOverlapByScore(const std::string& s1, const std::string& s2, 
@@ -39,10 +39,12 @@ struct KmerWindow
 //
 //
 //
-QCProcess::QCProcess(const BWT* pBWT, const BWT* pRBWT, BitVector* pSharedBV, bool checkDup, bool checkKmer, int kmerLength, int kmerThreshold) :
+QCProcess::QCProcess(const BWT* pBWT, const BWT* pRBWT, BitVector* pSharedBV, bool checkDup, bool checkKmer, int kmerLength, int kmerThreshold,
+                     const SuffixArray* pSAI) :
                      m_pBWT(pBWT),
                      m_pRBWT(pRBWT),
                      m_pSharedBV(pSharedBV),
+                     m_pSAI(pSAI),
                      m_checkDuplicate(checkDup),
                      m_checkKmer(checkKmer),
                      m_kmerLength(kmerLength),
@@ -190,7 +192,7 @@ bool QCProcess::performKmerCheck(const SequenceWorkItem& workItem)
 // Look up the interval of the read in the BWT. If the index of the read
 bool QCProcess::performDuplicateCheck(const SequenceWorkItem& workItem)
 {
-    assert(m_pSharedBV != NULL);
+    assert(m_pSharedBV != NULL || m_pSAI != NULL);
 
     std::string w = workItem.read.seq.toString();
     std::string rc_w = reverseComplement(w);
@@ -223,28 +225,30 @@ bool QCProcess::performDuplicateCheck(const SequenceWorkItem& workItem)
     int64_t ri = rcIntervals.interval[0].isValid() ? rcIntervals.interval[0].lower : std::numeric_limits<int64_t>::max();
     int64_t canonicalIdx = std::min(fi, ri);
 
-    // Check if the bit reprsenting the canonical index is set in the shared bit vector
-    if(!m_pSharedBV->test(canonicalIdx))
-    {
-        // This read is not a duplicate
-        // Attempt to atomically set the bit from false to true
-        if(m_pSharedBV->updateCAS(canonicalIdx, false, true))
-        {
-            // Call succeed, return that this read is not a duplicate
-            return true;
-        }
-        else
-        {
-            // Call failed, some other thread set the bit before
-            // this thread. Return that the reead is a duplicate
-            return false;
-        }
-    }
-    else
-    {
-        // this read is duplicate
+    // Without a shared bit vector the copy with the lowest read index is kept,
+    // which is the copy that is kept when the reads are processed in order.
+    // This is needed when only a sample of the reads is checked
+    if(m_pSharedBV == NULL)
+        return workItem.idx == getLowestReadIndex(fwdIntervals.interval[0], rcIntervals.interval[0]);
+
+    // Check if the bit reprsenting the canonical index is set in the shared bit vector.
+    // The plain read avoids a locked instruction for the common duplicate case
+    if(m_pSharedBV->test(canonicalIdx))
         return false;
-    }
+
+    // Claim the bit. If some other thread set it first, this read is a duplicate
+    return !m_pSharedBV->testAndSet(canonicalIdx);
+}
+
+// The intervals are lexicographic ranks of the reads
+size_t QCProcess::getLowestReadIndex(const BWTInterval& fwdInterval, const BWTInterval& rcInterval) const
+{
+    size_t lowest = std::numeric_limits<size_t>::max();
+    for(int64_t i = fwdInterval.lower; fwdInterval.isValid() && i <= fwdInterval.upper; ++i)
+        lowest = std::min(lowest, (size_t)m_pSAI->get(i).getID());
+    for(int64_t i = rcInterval.lower; rcInterval.isValid() && i <= rcInterval.upper; ++i)
+        lowest = std::min(lowest, (size_t)m_pSAI->get(i).getID());
+    return lowest;
 }
 
 //
@@ -255,7 +259,8 @@ QCPostProcess::QCPostProcess(std::ostream* pCorrectedWriter,
                                 m_pCorrectedWriter(pCorrectedWriter),
                                 m_pDiscardWriter(pDiscardWriter),
                                 m_readsKept(0), m_readsDiscarded(0),
-                                m_readsFailedKmer(0), m_readsFailedDup(0)
+                                m_readsFailedKmer(0), m_readsFailedDup(0),
+                                m_populationSize(0)
 {
 
 }
@@ -267,6 +272,25 @@ QCPostProcess::~QCPostProcess()
     std::cout << "Reads discarded: " << m_readsDiscarded << "\n";
     std::cout << "Reads failed kmer check: " << m_readsFailedKmer << "\n";
     std::cout << "Reads failed duplicate check: " << m_readsFailedDup << "\n";
+
+    if(m_populationSize > 0)
+    {
+        size_t numReads = m_readsKept + m_readsDiscarded;
+        printf("\n*** Estimates for all %zu reads from a sample of %zu (95%% confidence intervals): \n", m_populationSize, numReads);
+        printEstimate("Fraction of reads kept", m_readsKept, numReads);
+        printEstimate("Fraction of reads failed kmer check", m_readsFailedKmer, numReads);
+        printEstimate("Fraction of reads failed duplicate check", m_readsFailedDup, numReads);
+    }
+}
+
+//
+void QCPostProcess::printEstimate(const char* name, size_t count, size_t numReads) const
+{
+    double estimate = numReads > 0 ? (double)count / numReads : 0.0f;
+    double lower, upper;
+    RatioEstimator::getWilsonInterval(count, numReads, Z_95, m_populationSize, lower, upper);
+    printf("%s: %lf [%lf, %lf] (about %.0lf reads)\n", name, estimate, lower, 
+           upper, estimate * m_populationSize);
 }
 
 //
@@ -275,7 +299,8 @@ void QCPostProcess::process(const SequenceWorkItem& item, const QCResult& result
     SeqRecord record = item.read;
     if(result.kmerPassed && result.dupPassed)
     {
-        record.write(*m_pCorrectedWriter);
+        if(m_pCorrectedWriter != NULL)
+            record.write(*m_pCorrectedWriter);
         ++m_readsKept;
     }
     else
@@ -286,7 +311,8 @@ void QCPostProcess::process(const SequenceWorkItem& item, const QCResult& result
         newID << item.read.id << ",seqrank=" << item.idx;
         record.id = newID.str();
 
-        record.write(*m_pDiscardWriter);
+        if(m_pDiscardWriter != NULL)
+            record.write(*m_pDiscardWriter);
         ++m_readsDiscarded;
 
         if(!result.kmerPassed)
@@ -15,6 +15,8 @@
 #include "SequenceProcessFramework.h"
 #include "SequenceWorkItem.h"
 #include "BitVector.h"
+#include "SuffixArray.h"
+#include "RatioEstimator.h"
 
 class QCResult
 {
@@ -29,7 +31,11 @@ class QCResult
 class QCProcess
 {
     public:
-        QCProcess(const BWT* pBWT, const BWT* pRBWT, BitVector* pSharedBV, bool checkDup, bool checkKmer, int kmerLength, int kmerThreshold);
+        // If pSharedBV is NULL, the duplicate check keeps the copy of a read with the
+        // lowest index, which is looked up in the lexicographic index pSAI, instead 
+        // of the first copy that is processed
+        QCProcess(const BWT* pBWT, const BWT* pRBWT, BitVector* pSharedBV, bool checkDup, bool checkKmer, int kmerLength, int kmerThreshold,
+                  const SuffixArray* pSAI = NULL);
         ~QCProcess();
         QCResult process(const SequenceWorkItem& item);
 
@@ -37,10 +43,14 @@ class QCProcess
         bool performDuplicateCheck(const SequenceWorkItem& item);
 
     private:
+
+        // Returns the lowest index of the reads in the lexicographic intervals
+        size_t getLowestReadIndex(const BWTInterval& fwdInterval, const BWTInterval& rcInterval) const;
         
         const BWT* m_pBWT;
         const BWT* m_pRBWT;
         BitVector* m_pSharedBV;
+        const SuffixArray* m_pSAI;
 
         bool m_checkDuplicate;
         bool m_checkKmer;
@@ -52,13 +62,20 @@ class QCProcess
 class QCPostProcess
 {
     public:
+        // The writers can be NULL to only count the reads
         QCPostProcess(std::ostream* pCorrectedWriter, std::ostream* pDiscardWriter);
         ~QCPostProcess();
 
         void process(const SequenceWorkItem& item, const QCResult& result);
 
+        // The reads are a sample of a set of populationSize reads. 
+        // Confidence intervals are printed for the estimates
+        void setPopulationSize(size_t populationSize) { m_populationSize = populationSize; }
+
     private:
 
+        void printEstimate(const char* name, size_t count, size_t numReads) const;
+
         std::ostream* m_pCorrectedWriter;
         std::ostream* m_pDiscardWriter;
 
@@ -66,6 +83,7 @@ class QCPostProcess
         size_t m_readsDiscarded;
         size_t m_readsFailedKmer;
         size_t m_readsFailedDup;
+        size_t m_populationSize;
 };
 
 #endif
@@ -0,0 +1,258 @@
+//-----------------------------------------------
+// Copyright 2010 Wellcome Trust Sanger Institute
+// Written by Jared Simpson (js18@sanger.ac.uk)
+// Released under the GPL
+//-----------------------------------------------
+//
+// SolidKmerFilter - Blocked Bloom filter of the
+// solid k-mers of an FM-index
+//
+#include <cassert>
+#include "SolidKmerFilter.h"
+#include "BWTAlgorithms.h"
+#include "ThreadPool.h"
+
+// The traversal is split into one unit of work per k-mer suffix of this length
+static const int SEED_LENGTH = 3;
+
+// Pool task that traverses the k-mers ending in a set of seed suffixes.
+// Each task takes seeds from a shared counter until all have been processed.
+class SolidKmerTask : public PoolTask
+{
+    public:
+        SolidKmerTask(SolidKmerFilter* pFilter, const BWT* pBWT,
+                      const std::vector<std::string>* pSeeds, size_t* pNextSeed) : m_pFilter(pFilter),
+                                                                                   m_pBWT(pBWT),
+                                                                                   m_pSeeds(pSeeds),
+                                                                                   m_pNextSeed(pNextSeed),
+                                                                                   m_numInserted(0)
+        {
+            m_kmer.resize(pFilter->m_k);
+            m_rcKmer.resize(pFilter->m_k);
+        }
+
+        void run()
+        {
+            int k = m_pFilter->m_k;
+            size_t idx;
+            while((idx = __sync_fetch_and_add(m_pNextSeed, 1)) < m_pSeeds->size())
+            {
+                const std::string& seed = (*m_pSeeds)[idx];
+                BWTInterval interval = BWTAlgorithms::findInterval(m_pBWT, seed);
+                if(!interval.isValid())
+                    continue;
+                m_kmer.replace(k - seed.size(), seed.size(), seed);
+                extend(interval, seed.size());
+            }
+        }
+
+        size_t getNumInserted() const { return m_numInserted; }
+
+    private:
+
+        // The interval is for the last depth symbols of m_kmer. Extend it
+        // backwards by every base, computing the occurrence counts at
+        // the ends of the interval once for all four bases.
+        void extend(const BWTInterval& interval, int depth)
+        {
+            int k = m_pFilter->m_k;
+            if(depth == k)
+            {
+                addKmer(interval.size());
+                return;
+            }
+
+            AlphaCount64 lowerOcc = m_pBWT->getFullOcc(interval.lower - 1);
+            AlphaCount64 upperOcc = m_pBWT->getFullOcc(interval.upper);
+            for(int j = 0; j < DNA_ALPHABET::size; ++j)
+            {
+                char b = ALPHABET[j];
+                size_t pb = m_pBWT->getPC(b);
+                BWTInterval next(pb + lowerOcc.get(b), pb + upperOcc.get(b) - 1);
+                if(!next.isValid())
+                    continue;
+                m_kmer[k - depth - 1] = b;
+                extend(next, depth + 1);
+            }
+        }
+
+        // Insert the k-mer in m_kmer if it is solid. The reverse complement
+        // is only searched when the forward strand is not enough
+        void addKmer(int64_t count)
+        {
+            int k = m_pFilter->m_k;
+            if(count < m_pFilter->m_minCount)
+            {
+                for(int i = 0; i < k; ++i)
+                    m_rcKmer[k - i - 1] = complement(m_kmer[i]);
+                BWTInterval rc_interval = BWTAlgorithms::findInterval(m_pBWT, m_rcKmer.data(), k);
+                if(rc_interval.isValid())
+                    count += rc_interval.size();
+                if(count < m_pFilter->m_minCount)
+                    return;
+            }
+
+            uint64_t code;
+            bool valid = m_pFilter->encodeCanonical(m_kmer.data(), code);
+            assert(valid);
+            (void)valid;
+            m_pFilter->insert(code);
+            ++m_numInserted;
+        }
+
+        SolidKmerFilter* m_pFilter;
+        const BWT* m_pBWT;
+        const std::vector<std::string>* m_pSeeds;
+        size_t* m_pNextSeed;
+        size_t m_numInserted;
+
+        std::string m_kmer;
+        std::string m_rcKmer;
+};
+
+//
+SolidKmerFilter::SolidKmerFilter(int k, size_t numBits) : m_k(k), m_minCount(0), m_numInserted(0)
+{
+    assert(m_k > 0 && m_k <= 31);
+    size_t bitsPerBlock = WORDS_PER_BLOCK * 64;
+    m_numBlocks = (numBits + bitsPerBlock - 1) / bitsPerBlock;
+    if(m_numBlocks == 0)
+        m_numBlocks = 1;
+    m_blocks.assign(m_numBlocks * WORDS_PER_BLOCK, 0);
+}
+
+//
+void SolidKmerFilter::build(const BWT* pBWT, int minCount, int numThreads)
+{
+    m_minCount = minCount;
+
+    // Enumerate the seed suffixes
+    int seedLength = m_k < SEED_LENGTH ? m_k : SEED_LENGTH;
+    std::vector<std::string> seeds(1, "");
+    for(int i = 0; i < seedLength; ++i)
+    {
+        std::vector<std::string> next;
+        for(size_t j = 0; j < seeds.size(); ++j)
+            for(int b = 0; b < DNA_ALPHABET::size; ++b)
+                next.push_back(ALPHABET[b] + seeds[j]);
+        seeds.swap(next);
+    }
+
+    size_t nextSeed = 0;
+    std::vector<SolidKmerTask*> tasks;
+    for(int i = 0; i < numThreads; ++i)
+        tasks.push_back(new SolidKmerTask(this, pBWT, &seeds, &nextSeed));
+
+    if(numThreads <= 1)
+    {
+        tasks.front()->run();
+    }
+    else
+    {
+        TaskGroup taskGroup;
+        ThreadPool& pool = ThreadPool::getInstance();
+        for(int i = 0; i < numThreads; ++i)
+            pool.submit(tasks[i], &taskGroup, pool.getNodeForWorker(i));
+        taskGroup.wait();
+    }
+
+    for(size_t i = 0; i < tasks.size(); ++i)
+    {
+        m_numInserted += tasks[i]->getNumInserted();
+        delete tasks[i];
+    }
+}
+
+//
+bool SolidKmerFilter::contains(const char* w) const
+{
+    uint64_t code;
+    if(!encodeCanonical(w, code))
+        return false;
+    return test(code);
+}
+
+//
+size_t SolidKmerFilter::getDefaultNumBits(const BWT* pBWT, int minCount, int bitsPerKmer)
+{
+    // Every solid k-mer accounts for at least minCount positions of the index
+    size_t maxKmers = pBWT->getBWLen() / (minCount > 0 ? minCount : 1);
+    return maxKmers * bitsPerKmer;
+}
+
+//
+bool SolidKmerFilter::encodeCanonical(const char* w, uint64_t& outCode) const
+{
+    uint64_t fwd = 0;
+    uint64_t rc = 0;
+    int rcShift = 2 * (m_k - 1);
+    for(int i = 0; i < m_k; ++i)
+    {
+        uint64_t code;
+        switch(w[i])
+        {
+            case 'A': code = 0; break;
+            case 'C': code = 1; break;
+            case 'G': code = 2; break;
+            case 'T': code = 3; break;
+            default: return false;
+        }
+        fwd = (fwd << 2) | code;
+        rc = (rc >> 2) | ((3 - code) << rcShift);
+    }
+    outCode = fwd < rc ? fwd : rc;
+    return true;
+}
+
+//
+void SolidKmerFilter::insert(uint64_t code)
+{
+    uint64_t hash = mix64(code);
+    uint64_t* pBlock = getBlock(hash);
+    uint64_t probes = mix64(hash + 0x9E3779B97F4A7C15ULL);
+    for(int i = 0; i < NUM_PROBES; ++i)
+    {
+        int bit = probes & 511;
+        probes >>= 9;
+        __sync_fetch_and_or(&pBlock[bit >> 6], 1ULL << (bit & 63));
+    }
+}
+
+//
+bool SolidKmerFilter::test(uint64_t code) const
+{
+    uint64_t hash = mix64(code);
+    const uint64_t* pBlock = getBlock(hash);
+    uint64_t probes = mix64(hash + 0x9E3779B97F4A7C15ULL);
+    for(int i = 0; i < NUM_PROBES; ++i)
+    {
+        int bit = probes & 511;
+        probes >>= 9;
+        if(!(pBlock[bit >> 6] & (1ULL << (bit & 63))))
+            return false;
+    }
+    return true;
+}
+
+//
+inline uint64_t* SolidKmerFilter::getBlock(uint64_t hash)
+{
+    return &m_blocks[(hash % m_numBlocks) * WORDS_PER_BLOCK];
+}
+
+//
+inline const uint64_t* SolidKmerFilter::getBlock(uint64_t hash) const
+{
+    return &m_blocks[(hash % m_numBlocks) * WORDS_PER_BLOCK];
+}
+
+// The finalizer of MurmurHash3
+inline uint64_t SolidKmerFilter::mix64(uint64_t key)
+{
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return key;
+}
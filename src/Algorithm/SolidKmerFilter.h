@@ -0,0 +1,78 @@
+//-----------------------------------------------
+// Copyright 2010 Wellcome Trust Sanger Institute
+// Written by Jared Simpson (js18@sanger.ac.uk)
+// Released under the GPL
+//-----------------------------------------------
+//
+// SolidKmerFilter - Blocked Bloom filter holding the
+// k-mers that occur at least minCount times in an
+// FM-index, counting both strands. The filter is built
+// once by a parallel traversal of the FM-index and lets
+// the k-mer corrector skip the FM-index search for
+// k-mers that are known to be solid. A k-mer that is not
+// in the filter must still be looked up in the FM-index.
+// Each k-mer sets bits in a single 512-bit block so a
+// query touches one cache line. As with any Bloom filter,
+// a small fraction of the k-mers that are not solid are
+// reported as solid. This fraction falls as the filter
+// is made larger.
+//
+#ifndef SOLIDKMERFILTER_H
+#define SOLIDKMERFILTER_H
+
+#include <vector>
+#include <stdint.h>
+#include "BWT.h"
+
+class SolidKmerFilter
+{
+    public:
+
+        // k must be at most 31
+        SolidKmerFilter(int k, size_t numBits);
+
+        // Insert every k-mer of pBWT that occurs at least minCount times
+        void build(const BWT* pBWT, int minCount, int numThreads);
+
+        // Returns true if the k-mer starting at w is in the filter
+        bool contains(const char* w) const;
+
+        // Returns the number of bits that gives a filter with at least
+        // bitsPerKmer bits for every k-mer of pBWT that could be solid
+        static size_t getDefaultNumBits(const BWT* pBWT, int minCount, int bitsPerKmer);
+
+        int getK() const { return m_k; }
+        int getMinCount() const { return m_minCount; }
+        size_t getNumInserted() const { return m_numInserted; }
+        size_t getMemSize() const { return m_blocks.size() * sizeof(uint64_t); }
+
+    private:
+
+        friend class SolidKmerTask;
+
+        static const int WORDS_PER_BLOCK = 8;
+        static const int NUM_PROBES = 6;
+
+        // Encode the k-mer starting at w as the smaller of its forward
+        // and reverse complement 2-bit codes. Returns false if the k-mer
+        // contains a base that is not A, C, G or T
+        bool encodeCanonical(const char* w, uint64_t& outCode) const;
+
+        // Set the bits of the k-mer. This is safe to call from multiple threads
+        void insert(uint64_t code);
+        bool test(uint64_t code) const;
+
+        // The block of the k-mer and the probe bits within it
+        inline uint64_t* getBlock(uint64_t hash);
+        inline const uint64_t* getBlock(uint64_t hash) const;
+
+        static inline uint64_t mix64(uint64_t key);
+
+        int m_k;
+        int m_minCount;
+        size_t m_numBlocks;
+        size_t m_numInserted;
+        std::vector<uint64_t> m_blocks;
+};
+
+#endif
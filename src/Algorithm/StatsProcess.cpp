@@ -6,6 +6,7 @@
 //
 // StatsProcess - Compute statistics about the reads
 //
+#include <limits>
 #include "StatsProcess.h"
 #include "BWTAlgorithms.h"
 #include "MultiOverlap.h"
@@ -79,7 +80,7 @@ StatsResult StatsProcess::process(const SequenceWorkItem& workItem)
 //
 //
 //
-StatsPostProcess::StatsPostProcess(bool bPrintKmer) : m_bPrintKmer(bPrintKmer), m_basesCounted(0), m_basesWrong(0), m_depthSum(0.0f), m_numReads(0), m_numPerfect(0)
+StatsPostProcess::StatsPostProcess(bool bPrintKmer) : m_bPrintKmer(bPrintKmer), m_basesCounted(0), m_basesWrong(0), m_depthSum(0.0f), m_numReads(0), m_numPerfect(0), m_populationSize(0)
 {
 }
 
@@ -97,6 +98,27 @@ StatsPostProcess::~StatsPostProcess()
     printf("%d out of %d bases are potentially incorrect (%lf)\n", m_basesWrong, m_basesCounted, (double)m_basesWrong/m_basesCounted);
     printf("%d reads out of %d are perfect (%lf)\n", m_numPerfect, m_numReads, (double)m_numPerfect/m_numReads);
     printf("Mean overlap depth: %.2lf\n", m_depthSum / m_numReads);
+
+    if(m_populationSize > 0)
+    {
+        printf("\n*** Estimates for all %zu reads from a sample of %d (95%% confidence intervals): \n", m_populationSize, m_numReads);
+        printEstimate("Fraction of bases potentially incorrect", m_wrongEstimate, 0.0f, 1.0f);
+
+        double lower, upper;
+        RatioEstimator::getWilsonInterval(m_numPerfect, m_numReads, Z_95, m_populationSize, lower, upper);
+        printf("Fraction of reads perfect: %lf [%lf, %lf]\n", (double)m_numPerfect / m_numReads, lower, upper);
+
+        printEstimate("Mean overlap depth", m_depthEstimate, 0.0f, std::numeric_limits<double>::max());
+    }
+}
+
+//
+void StatsPostProcess::printEstimate(const char* name, const RatioEstimator& estimator, 
+                                     double minValue, double maxValue) const
+{
+    double lower, upper;
+    estimator.getInterval(Z_95, m_populationSize, minValue, maxValue, lower, upper);
+    printf("%s: %lf [%lf, %lf]\n", name, estimator.getEstimate(), lower, upper);
 }
 
 //
@@ -110,4 +132,7 @@ void StatsPostProcess::process(const SequenceWorkItem& /*item*/, const StatsResu
     m_depthSum += result.mean_depth;
     m_numReads += 1;
     m_numPerfect += (result.bases_wrong == 0 ? 1 : 0);
+
+    m_wrongEstimate.add(result.bases_wrong, result.bases_counted);
+    m_depthEstimate.add(result.mean_depth, 1);
 }
@@ -15,6 +15,7 @@
 #include "SequenceWorkItem.h"
 #include "OverlapAlgorithm.h"
 #include "KmerDistribution.h"
+#include "RatioEstimator.h"
 
 class StatsResult
 {
@@ -57,8 +58,20 @@ class StatsPostProcess
 
         void process(const SequenceWorkItem& item, const StatsResult& result);
 
+        // Access the kmer distribution, which can be loaded from a previous run
+        const KmerDistribution& getKmerDistribution() const { return m_kmerDist; }
+        void setKmerDistribution(const KmerDistribution& dist) { m_kmerDist = dist; }
+
+        // The reads are a sample of a set of populationSize reads. 
+        // Confidence intervals are printed for the estimates
+        void setPopulationSize(size_t populationSize) { m_populationSize = populationSize; }
+
     private:
 
+        // Print the estimate with its interval clipped to [minValue, maxValue]
+        void printEstimate(const char* name, const RatioEstimator& estimator, 
+                           double minValue, double maxValue) const;
+
         KmerDistribution m_kmerDist;
         bool m_bPrintKmer;
         int m_basesCounted;
@@ -66,6 +79,10 @@ class StatsPostProcess
         double m_depthSum;
         int m_numReads;
         int m_numPerfect;
+
+        size_t m_populationSize;
+        RatioEstimator m_wrongEstimate;
+        RatioEstimator m_depthEstimate;
 };
 
 #endif
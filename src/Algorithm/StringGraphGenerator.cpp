@@ -87,7 +87,7 @@ void StringGraphGenerator::buildGraph(FrontierQueue& queue)
         // Search the FM-index for the current vertex
         SeqRecord record;
         record.id = node.pVertex->getID();
-        record.seq = node.pVertex->getSeq().toString();
+        record.seq = node.pVertex->getStr();
         
         OverlapBlockList blockList;
         assert(blockList.empty());
@@ -132,13 +132,13 @@ void StringGraphGenerator::updateGraphAndQueue(GraphFrontier& currNode, Frontier
             continue; // skip self-edges
 
 
-        std::string vertexSeq = iter->getFullString(pX->getSeq().toString());
+        std::string vertexSeq = iter->getFullString(pX->getStr());
         Overlap o = iter->toOverlap(pX->getID(), vertexID, pX->getSeqLen(), vertexSeq.length());
 
 /*
 #if DEBUGGENERATE
         std::cout << "has overlap to: " << vertexID << " len: " << iter->overlapLen << " flags: " << iter->flags << "\n";
-        std::cout << "Overlap string: " << iter->getOverlapString(pX->getSeq().toString()) << "\n";
+        std::cout << "Overlap string: " << iter->getOverlapString(pX->getStr()) << "\n";
 #endif
 */      
         // Check if a vertex with endVertexID exists in the graph
@@ -151,8 +151,8 @@ void StringGraphGenerator::updateGraphAndQueue(GraphFrontier& currNode, Frontier
             std::cout << "Vertex sequence: " << vertexSeq << "\n";
 #endif
             // Generate the new vertex
-            vertexSeq = iter->getFullString(pX->getSeq().toString());
-            pVertex = new(m_pGraph->getVertexAllocator()) Vertex(vertexID, vertexSeq);
+            vertexSeq = iter->getFullString(pX->getStr());
+            pVertex = m_pGraph->createVertex(vertexID, vertexSeq);
             pVertex->setColor(UNEXPLORED_COLOR);
             m_pGraph->addVertex(pVertex);
         }
@@ -199,7 +199,7 @@ Vertex* StringGraphGenerator::addTerminalVertex(const SeqRecord& record)
     Vertex* pVertex = m_pGraph->getVertex(endID);
     if(pVertex == NULL)
     {
-        pVertex = new(m_pGraph->getVertexAllocator()) Vertex(endID, record.seq.toString());
+        pVertex = m_pGraph->createVertex(endID, record.seq.toString());
         m_pGraph->addVertex(pVertex);
     }
     return pVertex;
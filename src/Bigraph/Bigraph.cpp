@@ -11,21 +11,106 @@
 #include <fstream>
 #include <iostream>
 #include "Bigraph.h"
+#include "PathCompactVisitor.h"
 #include "Timer.h"
 #include "ASQG.h"
 
+static const uint32_t SNAPSHOT_MAGIC = 0x53474753; // "SGGS"
+static const uint32_t SNAPSHOT_VERSION = 1;
+
+template<typename T>
+static void writeRaw(std::ostream& out, const T& value)
+{
+    out.write((const char*)&value, sizeof(T));
+}
+
+static void writeRawString(std::ostream& out, const std::string& str)
+{
+    writeRaw(out, (uint32_t)str.size());
+    out.write(str.data(), str.size());
+}
+
+// Reader for the fields of a snapshot. Every read and every record count
+// is checked against the number of bytes left in the file so a damaged
+// snapshot is reported before anything is allocated for it. The first
+// error is printed and every later read fails.
+class SnapshotReader
+{
+    public:
+        SnapshotReader(const std::string& filename) : m_filename(filename), 
+                                                      m_in(filename.c_str(), std::ios::in | std::ios::binary),
+                                                      m_remaining(0), m_good(true)
+        {
+            assertFileOpen(m_in, filename);
+            m_in.seekg(0, std::ios::end);
+            m_remaining = m_in.tellg();
+            m_in.seekg(0, std::ios::beg);
+        }
+
+        template<typename T>
+        bool read(T& value) { return readBytes((char*)&value, sizeof(T)); }
+
+        bool readBytes(char* pData, uint64_t n)
+        {
+            if(!checkCount(n, 1))
+                return false;
+            m_in.read(pData, n);
+            if(!m_in.good())
+                return fail("could not be read");
+            m_remaining -= n;
+            return true;
+        }
+
+        bool readString(std::string& str)
+        {
+            uint32_t len = 0;
+            if(!read(len) || !checkCount(len, 1))
+                return false;
+            str.resize(len);
+            return len == 0 || readBytes(&str[0], len);
+        }
+
+        // Check that count records of at least recordBytes each fit in the rest of the file
+        bool checkCount(uint64_t count, uint64_t recordBytes)
+        {
+            if(m_good && count > m_remaining / recordBytes)
+                return fail("is truncated");
+            return m_good;
+        }
+
+        bool fail(const std::string& reason)
+        {
+            if(m_good)
+                std::cerr << "Error: " << m_filename << " " << reason << "\n";
+            m_good = false;
+            return false;
+        }
+
+        bool isGood() const { return m_good; }
+
+    private:
+        std::string m_filename;
+        std::ifstream m_in;
+        uint64_t m_remaining;
+        bool m_good;
+};
+
+// The smallest number of bytes used by a vertex and by an edge in a snapshot.
+// A vertex has the length of its name, its sequence length, its contained
+// flag and the number of its edges.
+static const uint64_t SNAPSHOT_MIN_VERTEX_BYTES = 13;
+static const uint64_t SNAPSHOT_EDGE_BYTES = 18;
+
 //
 //
 //
-Bigraph::Bigraph() : m_hasContainment(false), m_hasTransitive(false), m_isExactMode(false), m_minOverlap(0), m_errorRate(0.0f)
+Bigraph::Bigraph() : m_numVertices(0), m_hasContainment(false), m_hasTransitive(false), m_isExactMode(false), m_minOverlap(0), m_errorRate(0.0f),
+                     m_trackDirty(false), m_inDirtyRound(false), m_dirtyCursor(0)
 {
     // Set up the memory pools for the graph
     m_pEdgeAllocator = new SimpleAllocator<Edge>();
     m_pVertexAllocator = new SimpleAllocator<Vertex>();
-
-    m_vertices.set_deleted_key("");
-    //WARN_ONCE("HARDCODED HASH TABLE MAX SIZE");
-    //m_vertices.resize(600000000);
+    m_pSeqArena = new SeqArena();
 }
 
 //
@@ -33,16 +118,39 @@ Bigraph::Bigraph() : m_hasContainment(false), m_hasTransitive(false), m_isExactM
 //
 Bigraph::~Bigraph()
 {
-    VertexPtrMap::iterator iter = m_vertices.begin(); 
-    for(; iter != m_vertices.end(); ++iter)
+    for(size_t i = 0; i < m_vertices.size(); ++i)
     {
-        delete iter->second;
-        iter->second = NULL;
+        delete m_vertices[i];
+        m_vertices[i] = NULL;
     }
 
     // Clean up the memory pools
     delete m_pEdgeAllocator;
     delete m_pVertexAllocator;
+    delete m_pSeqArena;
+}
+
+//
+// Create a vertex
+//
+Vertex* Bigraph::createVertex(const VertexID& id, const std::string& seq)
+{
+    VertexIdx idx = m_nameTable.add(id);
+    return new(m_pVertexAllocator) Vertex(idx, m_nameTable.getName(idx), m_pSeqArena->add(seq), seq.size());
+}
+
+//
+Vertex* Bigraph::createVertex(const VertexID& id, const uint8_t* pPackedSeq, size_t seqLen)
+{
+    VertexIdx idx = m_nameTable.add(id);
+    return new(m_pVertexAllocator) Vertex(idx, m_nameTable.getName(idx), m_pSeqArena->add(pPackedSeq, seqLen), seqLen);
+}
+
+//
+void Bigraph::setVertexSeq(Vertex* pVertex, const std::string& seq)
+{
+    pVertex->setSeq(m_pSeqArena->add(seq), seq.size());
+    markDirty(pVertex);
 }
 
 //
@@ -50,9 +158,17 @@ Bigraph::~Bigraph()
 //
 void Bigraph::addVertex(Vertex* pVert)
 {
-    std::pair<VertexPtrMapIter, bool> result = 
-           m_vertices.insert(std::make_pair(pVert->getID(), pVert));
-    if(!result.second)
+    VertexIdx idx = pVert->getIndex();
+    assert(idx < m_nameTable.size() && m_nameTable.getName(idx) == pVert->getName());
+    if(idx >= m_vertices.size())
+        m_vertices.resize(m_nameTable.size(), NULL);
+
+    if(m_vertices[idx] == NULL)
+    {
+        m_vertices[idx] = pVert;
+        ++m_numVertices;
+    }
+    else
     {
         std::cerr << "Error: Attempted to insert vertex into graph with a duplicate id: " <<
                      pVert->getID() << "\n";
@@ -69,9 +185,10 @@ void Bigraph::removeIslandVertex(Vertex* pVertex)
     assert(pVertex->countEdges() == 0);
 
     // Remove the vertex from the collection
-    VertexID id = pVertex->getID();
+    VertexIdx idx = pVertex->getIndex();
     delete pVertex;
-    m_vertices.erase(id);
+    m_vertices[idx] = NULL;
+    --m_numVertices;
 }
 
 //
@@ -79,13 +196,21 @@ void Bigraph::removeIslandVertex(Vertex* pVertex)
 //
 void Bigraph::removeConnectedVertex(Vertex* pVertex)
 {
+    if(m_trackDirty)
+    {
+        EdgePtrVec edges = pVertex->getEdges();
+        for(size_t i = 0; i < edges.size(); ++i)
+            markDirty(edges[i]->getEnd());
+    }
+
     // Remove the edges pointing to this Vertex
     pVertex->deleteEdges();
 
     // Remove the vertex from the collection
-    VertexID id = pVertex->getID();
+    VertexIdx idx = pVertex->getIndex();
     delete pVertex;
-    m_vertices.erase(id);
+    m_vertices[idx] = NULL;
+    --m_numVertices;
 }
 
 
@@ -94,8 +219,7 @@ void Bigraph::removeConnectedVertex(Vertex* pVertex)
 //
 bool Bigraph::hasVertex(VertexID id)
 {
-    VertexPtrMapIter iter = m_vertices.find(id);
-    return iter != m_vertices.end();
+    return getVertex(id) != NULL;
 }
 
 //
@@ -103,10 +227,18 @@ bool Bigraph::hasVertex(VertexID id)
 //
 Vertex* Bigraph::getVertex(VertexID id) const
 {
-    VertexPtrMapConstIter iter = m_vertices.find(id);
-    if(iter == m_vertices.end())
+    VertexIdx idx = m_nameTable.find(id);
+    if(idx == VertexNameTable::INVALID_INDEX)
         return NULL;
-    return iter->second;
+    return getVertex(idx);
+}
+
+//
+Vertex* Bigraph::getVertex(VertexIdx idx) const
+{
+    if(idx >= m_vertices.size())
+        return NULL;
+    return m_vertices[idx];
 }
 
 //
@@ -116,6 +248,7 @@ void Bigraph::addEdge(Vertex* pVertex, Edge* pEdge)
 {
     assert(pEdge->getStart() == pVertex);
     pVertex->addEdge(pEdge);
+    markDirty(pVertex);
 }
 
 //
@@ -123,6 +256,7 @@ void Bigraph::addEdge(Vertex* pVertex, Edge* pEdge)
 //
 void Bigraph::removeEdge(const EdgeDesc& ed)
 {
+    markDirty(ed.pVertex);
     ed.pVertex->removeEdge(ed);
 }
 
@@ -132,9 +266,10 @@ void Bigraph::removeEdge(const EdgeDesc& ed)
 void Bigraph::mergeVertices(VertexID id1, VertexID id2)
 {
     Vertex* pVert1 = getVertex(id1);
+    Vertex* pVert2 = getVertex(id2);
 
     // Get the edges from vertex1 to vertex2
-    EdgePtrVec edgesTo = pVert1->findEdgesTo(id2);
+    EdgePtrVec edgesTo = pVert1->findEdgesTo(pVert2);
 
     if(edgesTo.empty())
     {
@@ -164,7 +299,7 @@ void Bigraph::merge(Vertex* pV1, Edge* pEdge)
     //std::cout << "Merging " << pV1->getID() << " with " << pV2->getID() << "\n";
 
     // Merge the data
-    pV1->merge(pEdge);
+    pV1->merge(pEdge, m_pSeqArena);
 
     // Get the twin edge (the edge in v2 that points to v1)
     Edge* pTwin = pEdge->getTwin();
@@ -208,6 +343,7 @@ void Bigraph::merge(Vertex* pV1, Edge* pEdge)
     // Remove V2
     // It is guarenteed to not be connected
     removeIslandVertex(pV2);
+    markDirty(pV1);
     //validate();
 }
 
@@ -215,17 +351,13 @@ void Bigraph::merge(Vertex* pV1, Edge* pEdge)
 int Bigraph::sweepVertices(GraphColor c)
 {
     int numRemoved = 0;
-    VertexPtrMapIter iter = m_vertices.begin();
-    while(iter != m_vertices.end())
+    for(size_t i = 0; i < m_vertices.size(); ++i)
     {
-        VertexPtrMapIter next = iter;
-        ++next;
-        if(iter->second->getColor() == c)
+        if(m_vertices[i] != NULL && m_vertices[i]->getColor() == c)
         {
-            removeConnectedVertex(iter->second); 
+            removeConnectedVertex(m_vertices[i]); 
             ++numRemoved;
         }
-        iter = next;
     }
     return numRemoved;
 }
@@ -235,31 +367,135 @@ int Bigraph::sweepVertices(GraphColor c)
 int Bigraph::sweepEdges(GraphColor c)
 {
     int numRemoved = 0;
-    for(VertexPtrMapIter iter = m_vertices.begin(); iter != m_vertices.end(); ++iter)
-        numRemoved += iter->second->sweepEdges(c);
+    for(size_t i = 0; i < m_vertices.size(); ++i)
+    {
+        if(m_vertices[i] != NULL)
+        {
+            int n = m_vertices[i]->sweepEdges(c);
+            if(n > 0)
+                markDirty(m_vertices[i]);
+            numRemoved += n;
+        }
+    }
     return numRemoved;
 }
 
+//
+void Bigraph::setDirtyTracking(bool b)
+{
+    m_trackDirty = b;
+    std::vector<uint8_t>().swap(m_dirtyMarks);
+    std::vector<VertexIdx>().swap(m_dirtyVertices);
+    m_dirtyQueue = DirtyQueue();
+}
+
+// Mark the vertex and its neighbours
+void Bigraph::markDirty(Vertex* pVertex)
+{
+    if(!m_trackDirty)
+        return;
+
+    addDirty(pVertex->getIndex());
+    EdgePtrVec edges = pVertex->getEdges();
+    for(size_t i = 0; i < edges.size(); ++i)
+        addDirty(edges[i]->getEnd()->getIndex());
+}
+
+// Vertices after the cursor of a serial round are added to the round,
+// the rest are deferred to the next round
+void Bigraph::addDirty(VertexIdx idx)
+{
+    if(idx >= m_dirtyMarks.size())
+        m_dirtyMarks.resize(std::max((size_t)idx + 1, m_vertices.size()), 0);
+
+    if(m_inDirtyRound && idx > m_dirtyCursor)
+    {
+        if(!(m_dirtyMarks[idx] & DIRTY_CURRENT))
+        {
+            m_dirtyMarks[idx] |= DIRTY_CURRENT;
+            m_dirtyQueue.push(idx);
+        }
+    }
+    else if(!(m_dirtyMarks[idx] & DIRTY_NEXT))
+    {
+        m_dirtyMarks[idx] |= DIRTY_NEXT;
+        m_dirtyVertices.push_back(idx);
+    }
+}
+
+// Move the vertices marked for the next round into the queue of the current round
+void Bigraph::beginDirtyRound()
+{
+    assert(m_dirtyQueue.empty());
+    for(size_t i = 0; i < m_dirtyVertices.size(); ++i)
+    {
+        VertexIdx idx = m_dirtyVertices[i];
+        m_dirtyMarks[idx] = DIRTY_CURRENT;
+        m_dirtyQueue.push(idx);
+    }
+    m_dirtyVertices.clear();
+}
+
+// Take the lowest index from the queue of the current round. Returns false
+// and ends the round when the queue is empty.
+bool Bigraph::nextDirtyVertex(VertexIdx& outIdx)
+{
+    if(m_dirtyQueue.empty())
+    {
+        m_inDirtyRound = false;
+        return false;
+    }
+
+    outIdx = m_dirtyQueue.top();
+    m_dirtyQueue.pop();
+    m_dirtyMarks[outIdx] &= ~DIRTY_CURRENT;
+    m_inDirtyRound = true;
+    m_dirtyCursor = outIdx;
+    return true;
+}
+
+// Take the vertices marked for the next round, in index order
+void Bigraph::takeDirtyVertices(VertexPtrVec& outVertices)
+{
+    std::sort(m_dirtyVertices.begin(), m_dirtyVertices.end());
+    outVertices.reserve(m_dirtyVertices.size());
+    for(size_t i = 0; i < m_dirtyVertices.size(); ++i)
+    {
+        VertexIdx idx = m_dirtyVertices[i];
+        m_dirtyMarks[idx] = 0;
+        if(m_vertices[idx] != NULL)
+            outVertices.push_back(m_vertices[idx]);
+    }
+    m_dirtyVertices.clear();
+}
+
 //    Simplify the graph by compacting singular edges
-void Bigraph::simplify()
+void Bigraph::simplify(int numThreads)
 {
     assert(!hasContainment());
-    simplify(ED_SENSE);
-    simplify(ED_ANTISENSE);
+    PathCompactVisitor compactVisit;
+    visitParallel(compactVisit, numThreads);
+
+    // Paths that form cycles do not have a start vertex
+    // and are left for the pairwise merge
+    simplifyPairwise(ED_SENSE);
+    simplifyPairwise(ED_ANTISENSE);
 }
 
 // Simplify the graph by compacting edges in the given direction
-void Bigraph::simplify(EdgeDir dir)
+void Bigraph::simplifyPairwise(EdgeDir dir)
 {
     bool graph_changed = true;
     while(graph_changed)
     {
         graph_changed = false;
-        VertexPtrMapIter iter = m_vertices.begin(); 
-        while(iter != m_vertices.end())
+        for(size_t i = 0; i < m_vertices.size(); ++i)
         {
+            if(m_vertices[i] == NULL)
+                continue;
+
             // Get the edges for this direction
-            EdgePtrVec edges = iter->second->getEdges(dir);
+            EdgePtrVec edges = m_vertices[i]->getEdges(dir);
 
             // If there is a single edge in this direction, merge the vertices
             // Don't merge singular self edges though
@@ -271,12 +507,10 @@ void Bigraph::simplify(EdgeDir dir)
                 Vertex* pV2 = pSingle->getEnd();
                 if(pV2->countEdges(pTwin->getDir()) == 1)
                 {
-                    merge(iter->second, pSingle);
+                    merge(m_vertices[i], pSingle);
                     graph_changed = true;
                 }
             }
-
-            ++iter;
         }
     } 
 }
@@ -292,22 +526,26 @@ void Bigraph::simplify(EdgeDir dir)
 void Bigraph::renameVertices(const std::string& prefix)
 {
     size_t currIdx = 0;
-    size_t numVertices = m_vertices.size();
+    size_t numVertices = m_numVertices;
     std::vector<Vertex*> vertexPtrVec(numVertices, 0);
 
-    VertexPtrMapIter iter = m_vertices.begin();
-    while(iter != m_vertices.end())
+    for(size_t i = 0; i < m_vertices.size(); ++i)
     {
+        if(m_vertices[i] == NULL)
+            continue;
+
+        // The old names stay in the name table
         std::stringstream ss;
         ss << prefix << currIdx;
-        iter->second->setID(ss.str());
-        vertexPtrVec[currIdx] = iter->second;
-        ++iter;
+        VertexIdx idx = m_nameTable.add(ss.str());
+        m_vertices[i]->setName(idx, m_nameTable.getName(idx));
+        vertexPtrVec[currIdx] = m_vertices[i];
         ++currIdx;
     }
 
     // Clear the old graph
     m_vertices.clear();
+    m_numVertices = 0;
     
     // Re-add the vertices
     for(size_t i = 0; i < numVertices; ++i)
@@ -319,9 +557,11 @@ void Bigraph::renameVertices(const std::string& prefix)
 //
 void Bigraph::sortVertexAdjListsByLen()
 {
-    VertexPtrMapIter iter = m_vertices.begin();
-    for(; iter != m_vertices.end(); ++iter)
-        iter->second->sortAdjListByLen();
+    for(size_t i = 0; i < m_vertices.size(); ++i)
+    {
+        if(m_vertices[i] != NULL)
+            m_vertices[i]->sortAdjListByLen();
+    }
 }
 
 
@@ -330,9 +570,11 @@ void Bigraph::sortVertexAdjListsByLen()
 //
 void Bigraph::sortVertexAdjListsByID()
 {
-    VertexPtrMapIter iter = m_vertices.begin();
-    for(; iter != m_vertices.end(); ++iter)
-        iter->second->sortAdjListByID();
+    for(size_t i = 0; i < m_vertices.size(); ++i)
+    {
+        if(m_vertices[i] != NULL)
+            m_vertices[i]->sortAdjListByID();
+    }
 }
 
 //
@@ -340,10 +582,12 @@ void Bigraph::sortVertexAdjListsByID()
 //
 void Bigraph::validate()
 {
-    VertexPtrMapIter iter = m_vertices.begin();
-    for(; iter != m_vertices.end(); ++iter)
+    for(size_t i = 0; i < m_vertices.size(); ++i)
     {
-        iter->second->validate();
+        if(m_vertices[i] == NULL)
+            continue;
+
+        m_vertices[i]->validate();
     }
 }
 
@@ -384,14 +628,16 @@ void Bigraph::flip(VertexID /*id*/)
 VertexIDVec Bigraph::getNonBranchingVertices() const
 {
     VertexIDVec out;
-    VertexPtrMapConstIter iter = m_vertices.begin(); 
-    for(; iter != m_vertices.end(); ++iter)
+    for(size_t i = 0; i < m_vertices.size(); ++i)
     {
-        int senseEdges = iter->second->countEdges(ED_SENSE);
-        int antisenseEdges = iter->second->countEdges(ED_ANTISENSE);
+        if(m_vertices[i] == NULL)
+            continue;
+
+        int senseEdges = m_vertices[i]->countEdges(ED_SENSE);
+        int antisenseEdges = m_vertices[i]->countEdges(ED_ANTISENSE);
         if(antisenseEdges <= 1 && senseEdges <= 1)
         {
-            out.push_back(iter->second->getID());
+            out.push_back(m_vertices[i]->getID());
         }
     }
     return out;
@@ -406,13 +652,15 @@ PathVector Bigraph::getLinearComponents()
 {
     PathVector outPaths;
     setColors(GC_WHITE);
-    VertexPtrMapIter iter = m_vertices.begin(); 
-    for(; iter != m_vertices.end(); ++iter)
+    for(size_t i = 0; i < m_vertices.size(); ++i)
     {
+        if(m_vertices[i] == NULL)
+            continue;
+
         // Output the linear path containing this vertex if it hasnt been visited already
-        if(iter->second->getColor() != GC_BLACK)
+        if(m_vertices[i]->getColor() != GC_BLACK)
         {
-            outPaths.push_back(constructLinearPath(iter->second->getID()));
+            outPaths.push_back(constructLinearPath(m_vertices[i]->getID()));
         }
     }
     assert(checkColors(GC_BLACK));
@@ -425,10 +673,11 @@ PathVector Bigraph::getLinearComponents()
 //
 Path Bigraph::constructLinearPath(VertexID id)
 {
+    Vertex* pVertex = getVertex(id);
     Path sensePath;
     Path antisensePath;
-    followLinear(id, ED_SENSE, sensePath);
-    followLinear(id, ED_ANTISENSE, antisensePath);
+    followLinear(pVertex, ED_SENSE, sensePath);
+    followLinear(pVertex, ED_ANTISENSE, antisensePath);
 
     // Construct the final path 
     Path final = reversePath(antisensePath);
@@ -440,9 +689,8 @@ Path Bigraph::constructLinearPath(VertexID id)
 // Recursively follow the graph in the specified direction without branching
 // outPath is an out-parameter of the edges that were followed
 //
-void Bigraph::followLinear(VertexID id, EdgeDir dir, Path& outPath)
+void Bigraph::followLinear(Vertex* pVertex, EdgeDir dir, Path& outPath)
 {
-    Vertex* pVertex = getVertex(id);
     EdgePtrVec edges = pVertex->getEdges(dir);
 
     // Color the vertex
@@ -457,7 +705,7 @@ void Bigraph::followLinear(VertexID id, EdgeDir dir, Path& outPath)
         EdgeDir corrected_dir = correctDir(pSingle->getDir(), pSingle->getComp());
 
         // Recurse
-        followLinear(pSingle->getEndID(), corrected_dir, outPath);
+        followLinear(pSingle->getEnd(), corrected_dir, outPath);
     }
 }
 
@@ -473,19 +721,23 @@ Path Bigraph::reversePath(const Path& path)
 //
 Vertex* Bigraph::getFirstVertex() const
 {
-    if(m_vertices.empty())
-        return NULL;
-    else
-        return m_vertices.begin()->second;
+    for(size_t i = 0; i < m_vertices.size(); ++i)
+    {
+        if(m_vertices[i] != NULL)
+            return m_vertices[i];
+    }
+    return NULL;
 }
 
 // Returns a vector of pointers to the vertices
 VertexPtrVec Bigraph::getAllVertices() const
 {
     VertexPtrVec out;
-    VertexPtrMapConstIter iter = m_vertices.begin();
-    for(; iter != m_vertices.end(); ++iter)
-        out.push_back(iter->second);
+    for(size_t i = 0; i < m_vertices.size(); ++i)
+    {
+        if(m_vertices[i] != NULL)
+            out.push_back(m_vertices[i]);
+    }
     return out;
 }
 
@@ -493,9 +745,11 @@ VertexPtrVec Bigraph::getAllVertices() const
 // Append vertex sequences to the vector
 void Bigraph::getVertexSequences(std::vector<std::string>& outSequences) const
 {
-    VertexPtrMapConstIter iter = m_vertices.begin();
-    for(; iter != m_vertices.end(); ++iter)
-        outSequences.push_back(iter->second->getSeq().toString());
+    for(size_t i = 0; i < m_vertices.size(); ++i)
+    {
+        if(m_vertices[i] != NULL)
+            outSequences.push_back(m_vertices[i]->getStr());
+    }
 }
 
 
@@ -506,10 +760,12 @@ void Bigraph::getVertexSequences(std::vector<std::string>& outSequences) const
 bool Bigraph::visit(VertexVisitFunction f)
 {
     bool modified = false;
-    VertexPtrMapConstIter iter = m_vertices.begin(); 
-    for(; iter != m_vertices.end(); ++iter)
+    for(size_t i = 0; i < m_vertices.size(); ++i)
     {
-        modified = f(this, iter->second) || modified;
+        if(m_vertices[i] == NULL)
+            continue;
+
+        modified = f(this, m_vertices[i]) || modified;
     }
     return modified;
 }
@@ -519,11 +775,13 @@ bool Bigraph::visit(VertexVisitFunction f)
 //
 void Bigraph::setColors(GraphColor c)
 {
-    VertexPtrMapIter iter = m_vertices.begin(); 
-    for(; iter != m_vertices.end(); ++iter)
+    for(size_t i = 0; i < m_vertices.size(); ++i)
     {
-        iter->second->setColor(c);
-        iter->second->setEdgeColors(c);
+        if(m_vertices[i] == NULL)
+            continue;
+
+        m_vertices[i]->setColor(c);
+        m_vertices[i]->setEdgeColors(c);
     }
 }
 
@@ -602,12 +860,14 @@ double Bigraph::getErrorRate() const
 //
 bool Bigraph::checkColors(GraphColor c)
 {
-    VertexPtrMapIter iter = m_vertices.begin(); 
-    for(; iter != m_vertices.end(); ++iter)
+    for(size_t i = 0; i < m_vertices.size(); ++i)
     {
-        if(iter->second->getColor() != c)
+        if(m_vertices[i] == NULL)
+            continue;
+
+        if(m_vertices[i]->getColor() != c)
         {
-            std::cerr << "Warning vertex " << iter->second->getID() << " is color " << iter->second->getColor() << " expected " << c << "\n";
+            std::cerr << "Warning vertex " << m_vertices[i]->getID() << " is color " << m_vertices[i]->getColor() << " expected " << c << "\n";
             return false;
         }
     }
@@ -622,10 +882,12 @@ void Bigraph::stats() const
     int numVerts = 0;
     int numEdges = 0;
 
-    VertexPtrMapConstIter iter = m_vertices.begin(); 
-    for(; iter != m_vertices.end(); ++iter)
+    for(size_t i = 0; i < m_vertices.size(); ++i)
     {
-        numEdges += iter->second->countEdges();
+        if(m_vertices[i] == NULL)
+            continue;
+
+        numEdges += m_vertices[i]->countEdges();
         ++numVerts;
     }
 
@@ -637,7 +899,7 @@ void Bigraph::stats() const
 //
 size_t Bigraph::getNumVertices() const
 {
-    return m_vertices.size();
+    return m_numVertices;
 }
 
 //
@@ -651,13 +913,15 @@ void Bigraph::printMemSize() const
     size_t numEdges = 0;
     size_t edgeMem = 0;
 
-    VertexPtrMapConstIter iter = m_vertices.begin(); 
-    for(; iter != m_vertices.end(); ++iter)
+    for(size_t i = 0; i < m_vertices.size(); ++i)
     {
+        if(m_vertices[i] == NULL)
+            continue;
+
         ++numVerts;
-        vertMem += iter->second->getMemSize();
+        vertMem += m_vertices[i]->getMemSize();
 
-        EdgePtrVec edges = iter->second->getEdges();
+        EdgePtrVec edges = m_vertices[i]->getEdges();
         for(EdgePtrVecIter edgeIter = edges.begin(); edgeIter != edges.end(); ++edgeIter)
         {
             ++numEdges;
@@ -667,6 +931,56 @@ void Bigraph::printMemSize() const
     printf("num verts: %zu using %zu bytes (%.2lf per vert)\n", numVerts, vertMem, double(vertMem) / numVerts);
     printf("num edges: %zu using %zu bytes (%.2lf per edge)\n", numEdges, edgeMem, double(edgeMem) / numEdges);
     printf("total: %zu\n", edgeMem + vertMem);
+    printf("pools: %zu vertex bytes, %zu edge bytes, %zu sequence bytes\n", m_pVertexAllocator->getMemSize(), 
+                                                                              m_pEdgeAllocator->getMemSize(),
+                                                                              m_pSeqArena->getMemSize());
+}
+
+//
+void Bigraph::compact()
+{
+    SimpleAllocator<Vertex>* pVertexAllocator = new SimpleAllocator<Vertex>();
+    SimpleAllocator<Edge>* pEdgeAllocator = new SimpleAllocator<Edge>();
+    SeqArena* pSeqArena = new SeqArena();
+
+    // Copy the vertices and their edges. The vertices are copied in
+    // index order and the edges of a vertex are allocated together.
+    VertexPtrVec oldVertices(m_vertices.size(), NULL);
+    for(size_t i = 0; i < m_vertices.size(); ++i)
+    {
+        if(m_vertices[i] == NULL)
+            continue;
+        oldVertices[i] = m_vertices[i];
+        m_vertices[i] = oldVertices[i]->relocate(pVertexAllocator, pSeqArena);
+        m_vertices[i]->relocateEdges(pEdgeAllocator);
+    }
+
+    // The twin of each old edge points to its copy
+    for(size_t i = 0; i < m_vertices.size(); ++i)
+    {
+        if(m_vertices[i] == NULL)
+            continue;
+
+        EdgePtrVec edges = m_vertices[i]->getEdges();
+        for(EdgePtrVecIter edgeIter = edges.begin(); edgeIter != edges.end(); ++edgeIter)
+        {
+            Edge* pEdge = *edgeIter;
+            pEdge->setTwin(pEdge->getTwin()->getTwin());
+            pEdge->setEnd(m_vertices[pEdge->getEnd()->getIndex()]);
+        }
+    }
+
+    // The old vertices no longer hold any edges. The old edges
+    // are released along with their pools.
+    for(size_t i = 0; i < oldVertices.size(); ++i)
+        delete oldVertices[i];
+
+    delete m_pVertexAllocator;
+    delete m_pEdgeAllocator;
+    delete m_pSeqArena;
+    m_pVertexAllocator = pVertexAllocator;
+    m_pEdgeAllocator = pEdgeAllocator;
+    m_pSeqArena = pSeqArena;
 }
 
 //
@@ -679,13 +993,15 @@ void Bigraph::writeDot(const std::string& filename, int dotFlags) const
     std::string graphType = (dotFlags & DF_UNDIRECTED) ? "graph" : "digraph";
 
     out << graphType << " G\n{\n";
-    VertexPtrMapConstIter iter = m_vertices.begin(); 
-    for(; iter != m_vertices.end(); ++iter)
+    for(size_t i = 0; i < m_vertices.size(); ++i)
     {
-        VertexID id = iter->second->getID();
+        if(m_vertices[i] == NULL)
+            continue;
+
+        VertexID id = m_vertices[i]->getID();
         out << "\"" << id << "\" [ label =\"" << id << "\" ";
         out << "];\n";
-        iter->second->writeEdges(out, dotFlags);
+        m_vertices[i]->writeEdges(out, dotFlags);
     }
     out << "}\n";
     out.close();
@@ -707,19 +1023,23 @@ void Bigraph::writeASQG(const std::string& filename) const
     headerRecord.write(*pWriter);
 
 
-    VertexPtrMapConstIter iter; 
-
     // Vertices
-    for(iter = m_vertices.begin(); iter != m_vertices.end(); ++iter)
+    for(size_t i = 0; i < m_vertices.size(); ++i)
     {
-        ASQG::VertexRecord vertexRecord(iter->second->getID(), iter->second->getSeq().toString());
+        if(m_vertices[i] == NULL)
+            continue;
+
+        ASQG::VertexRecord vertexRecord(m_vertices[i]->getID(), m_vertices[i]->getStr());
         vertexRecord.write(*pWriter);
     }
 
     // Edges
-    for(iter = m_vertices.begin(); iter != m_vertices.end(); ++iter)
+    for(size_t i = 0; i < m_vertices.size(); ++i)
     {
-        EdgePtrVec edges = iter->second->getEdges();
+        if(m_vertices[i] == NULL)
+            continue;
+
+        EdgePtrVec edges = m_vertices[i]->getEdges();
         for(EdgePtrVecIter edgeIter = edges.begin(); edgeIter != edges.end(); ++edgeIter)
         {
             // We write one record for every bidirectional edge so only write edges
@@ -740,4 +1060,199 @@ void Bigraph::writeASQG(const std::string& filename) const
     delete pWriter;
 }
 
+//
+// Write a binary snapshot of the graph
+//
+void Bigraph::writeSnapshot(const std::string& filename, const std::string& tag) const
+{
+    std::ofstream* pWriter = new std::ofstream(filename.c_str(), std::ios::out | std::ios::binary);
+    assertFileOpen(*pWriter, filename);
+
+    writeRaw(*pWriter, SNAPSHOT_MAGIC);
+    writeRaw(*pWriter, SNAPSHOT_VERSION);
+    writeRawString(*pWriter, tag);
+
+    // Graph parameters
+    writeRaw(*pWriter, (uint8_t)m_hasContainment);
+    writeRaw(*pWriter, (uint8_t)m_hasTransitive);
+    writeRaw(*pWriter, (uint8_t)m_isExactMode);
+    writeRaw(*pWriter, (int32_t)m_minOverlap);
+    writeRaw(*pWriter, m_errorRate);
+
+    // The vertices are renumbered densely in index order. The twin
+    // of an edge is stored as its position in the edge list of the end vertex.
+    std::vector<uint32_t> ordinals(m_vertices.size());
+    std::vector<std::pair<const Edge*, uint32_t> > edgePositions;
+    uint32_t numVertices = 0;
+    for(size_t i = 0; i < m_vertices.size(); ++i)
+    {
+        if(m_vertices[i] == NULL)
+            continue;
+        ordinals[i] = numVertices++;
 
+        EdgePtrVec edges = m_vertices[i]->getEdges();
+        for(size_t j = 0; j < edges.size(); ++j)
+            edgePositions.push_back(std::make_pair((const Edge*)edges[j], (uint32_t)j));
+    }
+    std::sort(edgePositions.begin(), edgePositions.end());
+
+    writeRaw(*pWriter, numVertices);
+    for(size_t i = 0; i < m_vertices.size(); ++i)
+    {
+        const Vertex* pVertex = m_vertices[i];
+        if(pVertex == NULL)
+            continue;
+
+        writeRawString(*pWriter, pVertex->getName());
+        writeRaw(*pWriter, (uint32_t)pVertex->getSeqLen());
+        pWriter->write((const char*)pVertex->getPackedSeq(), SeqArena::getNumBytes(pVertex->getSeqLen()));
+        writeRaw(*pWriter, (uint8_t)pVertex->isContained());
+    }
+
+    for(size_t i = 0; i < m_vertices.size(); ++i)
+    {
+        if(m_vertices[i] == NULL)
+            continue;
+
+        EdgePtrVec edges = m_vertices[i]->getEdges();
+        writeRaw(*pWriter, (uint32_t)edges.size());
+        for(EdgePtrVecIter iter = edges.begin(); iter != edges.end(); ++iter)
+        {
+            const Edge* pEdge = *iter;
+            std::vector<std::pair<const Edge*, uint32_t> >::const_iterator twinIter;
+            twinIter = std::lower_bound(edgePositions.begin(), edgePositions.end(), 
+                                        std::make_pair((const Edge*)pEdge->getTwin(), (uint32_t)0));
+            assert(twinIter != edgePositions.end() && twinIter->first == pEdge->getTwin());
+
+            const SeqCoord& coord = pEdge->getMatchCoord();
+            writeRaw(*pWriter, ordinals[pEdge->getEnd()->getIndex()]);
+            writeRaw(*pWriter, twinIter->second);
+            writeRaw(*pWriter, (uint8_t)pEdge->getDir());
+            writeRaw(*pWriter, (uint8_t)pEdge->getComp());
+            writeRaw(*pWriter, (int32_t)coord.interval.start);
+            writeRaw(*pWriter, (int32_t)coord.interval.end);
+        }
+    }
+    delete pWriter;
+}
+
+//
+// Load a graph from a binary snapshot
+//
+Bigraph* Bigraph::loadSnapshot(const std::string& filename, std::string& outTag)
+{
+    SnapshotReader reader(filename);
+
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    if(!reader.read(magic) || !reader.read(version))
+        return NULL;
+
+    if(magic != SNAPSHOT_MAGIC || version != SNAPSHOT_VERSION)
+    {
+        reader.fail("is not a graph snapshot");
+        return NULL;
+    }
+
+    uint8_t containFlag, transitiveFlag, exactFlag;
+    int32_t minOverlap;
+    double errorRate;
+    uint32_t numVertices = 0;
+    if(!reader.readString(outTag) || !reader.read(containFlag) || !reader.read(transitiveFlag) ||
+       !reader.read(exactFlag) || !reader.read(minOverlap) || !reader.read(errorRate) ||
+       !reader.read(numVertices) || !reader.checkCount(numVertices, SNAPSHOT_MIN_VERTEX_BYTES))
+    {
+        return NULL;
+    }
+
+    Bigraph* pGraph = new Bigraph;
+    pGraph->setContainmentFlag(containFlag);
+    pGraph->setTransitiveFlag(transitiveFlag);
+    pGraph->setExactMode(exactFlag);
+    pGraph->setMinOverlap(minOverlap);
+    pGraph->setErrorRate(errorRate);
+
+    VertexPtrVec vertices(numVertices);
+    std::string name;
+    std::vector<uint8_t> packed;
+    for(uint32_t i = 0; i < numVertices && reader.isGood(); ++i)
+    {
+        uint32_t seqLen;
+        uint8_t flag;
+        if(!reader.readString(name) || !reader.read(seqLen) || 
+           !reader.checkCount(SeqArena::getNumBytes(seqLen), 1))
+        {
+            break;
+        }
+
+        packed.resize(SeqArena::getNumBytes(seqLen) + 1);
+        if(!reader.readBytes((char*)&packed[0], SeqArena::getNumBytes(seqLen)) || !reader.read(flag))
+            break;
+
+        if(pGraph->getVertex(name) != NULL)
+        {
+            reader.fail("has a duplicate vertex " + name);
+            break;
+        }
+
+        vertices[i] = pGraph->createVertex(name, &packed[0], seqLen);
+        vertices[i]->setContained(flag);
+        pGraph->addVertex(vertices[i]);
+    }
+
+    // Create every edge before setting the twins
+    std::vector<EdgePtrVec> edges(numVertices);
+    std::vector<std::vector<std::pair<uint32_t, uint32_t> > > twins(numVertices);
+    for(uint32_t i = 0; i < numVertices && reader.isGood(); ++i)
+    {
+        uint32_t numEdges = 0;
+        if(!reader.read(numEdges) || !reader.checkCount(numEdges, SNAPSHOT_EDGE_BYTES))
+            break;
+
+        for(uint32_t j = 0; j < numEdges; ++j)
+        {
+            uint32_t endOrdinal, twinPos;
+            uint8_t dir, comp;
+            int32_t start, end;
+            if(!reader.read(endOrdinal) || !reader.read(twinPos) || !reader.read(dir) || 
+               !reader.read(comp) || !reader.read(start) || !reader.read(end))
+            {
+                break;
+            }
+
+            int seqLen = vertices[i]->getSeqLen();
+            if(endOrdinal >= numVertices || dir > ED_ANTISENSE || comp > EC_REVERSE || 
+               start < 0 || start > end || end >= seqLen)
+            {
+                reader.fail("has an invalid edge");
+                break;
+            }
+
+            SeqCoord coord(start, end, seqLen);
+            edges[i].push_back(new(pGraph->getEdgeAllocator()) Edge(vertices[endOrdinal], (EdgeDir)dir, (EdgeComp)comp, coord));
+            twins[i].push_back(std::make_pair(endOrdinal, twinPos));
+        }
+    }
+
+    for(uint32_t i = 0; i < numVertices && reader.isGood(); ++i)
+    {
+        for(size_t j = 0; j < edges[i].size(); ++j)
+        {
+            const EdgePtrVec& endEdges = edges[twins[i][j].first];
+            if(twins[i][j].second >= endEdges.size())
+            {
+                reader.fail("has an invalid edge");
+                break;
+            }
+            edges[i][j]->setTwin(endEdges[twins[i][j].second]);
+            pGraph->addEdge(vertices[i], edges[i][j]);
+        }
+    }
+
+    if(!reader.isGood())
+    {
+        delete pGraph;
+        return NULL;
+    }
+    return pGraph;
+}
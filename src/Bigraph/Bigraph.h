@@ -13,22 +13,18 @@
 #include <stdio.h>
 #include <vector>
 #include <map>
+#include <queue>
+#include <functional>
+#include <algorithm>
 #include "GraphCommon.h"
 #include "Vertex.h"
 #include "Edge.h"
-#include "HashMap.h"
+#include "VertexNameTable.h"
+#include "ThreadPool.h"
 
 //
 // Typedefs
 //
-//typedef std::map<VertexID, Vertex*> VertexPtrMap;
-//typedef __gnu_cxx::hash_map<VertexID, Vertex*> VertexPtrMap;
-//typedef std::tr1::unordered_map<VertexID, Vertex*> VertexPtrMap;
-typedef SparseHashMap<VertexID, Vertex*, StringHasher> VertexPtrMap;
-
-typedef VertexPtrMap::iterator VertexPtrMapIter;
-typedef VertexPtrMap::const_iterator VertexPtrMapConstIter;
-
 class Bigraph;
 typedef bool(*VertexVisitFunction)(Bigraph*, Vertex*);
 
@@ -37,6 +33,24 @@ typedef std::vector<Path> PathVector;
 typedef std::vector<VertexID> VertexIDVec;
 typedef std::vector<Vertex*> VertexPtrVec;
 
+// The parts of the graph that a visitor reads and writes when
+// it visits a vertex. Visitors that can be run by visitParallel
+// report their scope with getVisitScope()
+enum VisitScope
+{
+    // The visit only reads the vertex and its neighbourhood.
+    // Any changes to the graph are buffered per thread
+    // and applied serially in postvisit
+    VS_READ_ONLY,
+
+    // The visit modifies the neighbourhood of the vertex
+    // so the vertices must be visited one at a time
+    VS_EXCLUSIVE
+};
+
+template<typename VF>
+class VisitTask;
+
 class Bigraph
 {
 
@@ -45,6 +59,14 @@ class Bigraph
         Bigraph();
         ~Bigraph();
 
+        // Create a vertex with the given name and sequence. The vertex
+        // is not part of the graph until it is added with addVertex
+        Vertex* createVertex(const VertexID& id, const std::string& seq);
+        Vertex* createVertex(const VertexID& id, const uint8_t* pPackedSeq, size_t seqLen);
+
+        // Replace the sequence of a vertex. The sequence is stored in the graph's arena
+        void setVertexSeq(Vertex* pVertex, const std::string& seq);
+
         // Add a vertex
         void addVertex(Vertex* pVert);
         
@@ -58,8 +80,10 @@ class Bigraph
         // Check if a vertex exists
         bool hasVertex(VertexID id);
 
-        // Get a vertex
+        // Get a vertex by name or by index. NULL is returned
+        // if the vertex is not in the graph
         Vertex* getVertex(VertexID id) const;
+        Vertex* getVertex(VertexIdx idx) const;
 
         // Add an edge
         void addEdge(Vertex* pVertex, Edge* pEdge);
@@ -80,8 +104,9 @@ class Bigraph
         // Rename all the vertices in the graph
         void renameVertices(const std::string& prefix = "");
 
-        // Simplify the graph by removing transitive edges
-        void simplify();
+        // Simplify the graph by collapsing the non-branching paths
+        // into single vertices. The paths are found using numThreads threads.
+        void simplify(int numThreads = 1);
 
         // Validate that the graph is sane
         void validate();
@@ -114,8 +139,19 @@ class Bigraph
         void stats() const;
         void printMemSize() const;
 
+        // Move every vertex and edge into newly allocated pools, copy the
+        // vertex sequences into a new arena and release the old storage. Pools are only returned to the system
+        // when all their objects have been freed so after a large number
+        // of deletions the remaining objects are packed together by this call. 
+        // All Vertex and Edge pointers held outside of the graph are invalidated.
+        void compact();
+
         size_t getNumVertices() const;
 
+        // Returns one more than the largest vertex index in the graph. Arrays
+        // indexed by VertexIdx need this many entries to cover every vertex.
+        size_t getVertexIndexLimit() const { return m_vertices.size(); }
+
         // Visit each vertex in the graph and perform the visit function
         bool visit(VertexVisitFunction f);
 
@@ -131,14 +167,78 @@ class Bigraph
         {
             bool modified = false;
             vf.previsit(this);
-            VertexPtrMapConstIter iter = m_vertices.begin(); 
-            for(; iter != m_vertices.end(); ++iter)
+            for(size_t i = 0; i < m_vertices.size(); ++i)
+            {
+                if(m_vertices[i] != NULL)
+                    modified = vf.visit(this, m_vertices[i]) || modified;
+            }
+            vf.postvisit(this);
+            return modified;
+        }
+
+        // Visit the vertices of the graph using numThreads threads. Besides the
+        // functions used by visit(), the functor must implement:
+        //   VisitScope getVisitScope(const Bigraph* pGraph) const
+        //   void beginParallel(int numThreads)
+        //   bool visitParallel(Bigraph* pGraph, Vertex* pVertex, int threadIdx)
+        // The vertices are split into chunks that are handed out to the threads on demand.
+        // If the functor requires exclusive access to the graph, the serial visit is used
+        template<typename VF>
+        bool visitParallel(VF& vf, int numThreads)
+        {
+            if(numThreads <= 1 || vf.getVisitScope(this) == VS_EXCLUSIVE)
+                return visit(vf);
+
+            vf.previsit(this);
+            VertexPtrVec vertices = getAllVertices();
+            bool modified = runVisitTasks(vf, vertices, numThreads);
+            vf.postvisit(this);
+            return modified;
+        }
+
+        // Dirty tracking. While it is enabled, every vertex or edge modification
+        // made through the graph marks the vertices it touches and their neighbours
+        // as dirty. Visitors that change edges directly through the Vertex
+        // interface must call markDirty before doing so.
+        void setDirtyTracking(bool b);
+        bool hasDirtyVertices() const { return !m_dirtyVertices.empty(); }
+        void markDirty(Vertex* pVertex);
+
+        // Visit only the vertices that were marked dirty since the previous
+        // round, in index order. Vertices that are marked during the round and come
+        // after the current vertex are visited in the same round. For a visitor
+        // that only looks at the neighbourhood of a vertex, a dirty round after
+        // a full round gives the same result as another full round
+        template<typename VF>
+        bool visitDirty(VF& vf)
+        {
+            bool modified = false;
+            vf.previsit(this);
+            beginDirtyRound();
+            VertexIdx idx;
+            while(nextDirtyVertex(idx))
             {
-                modified = vf.visit(this, iter->second) || modified;
+                if(m_vertices[idx] != NULL)
+                    modified = vf.visit(this, m_vertices[idx]) || modified;
             }
             vf.postvisit(this);
             return modified;
         }
+
+        // The parallel version of visitDirty, see visitParallel
+        template<typename VF>
+        bool visitDirtyParallel(VF& vf, int numThreads)
+        {
+            if(numThreads <= 1 || vf.getVisitScope(this) == VS_EXCLUSIVE)
+                return visitDirty(vf);
+
+            vf.previsit(this);
+            VertexPtrVec vertices;
+            takeDirtyVertices(vertices);
+            bool modified = runVisitTasks(vf, vertices, numThreads);
+            vf.postvisit(this);
+            return modified;
+        }
         
         // Set the colors for the entire graph
         void setColors(GraphColor c);
@@ -169,6 +269,13 @@ class Bigraph
         void writeDot(const std::string& filename, int dotFlags = 0) const;
         void writeASQG(const std::string& filename) const;
 
+        // Write a binary snapshot of the graph that can be reloaded with loadSnapshot.
+        // The snapshot keeps the order of the vertices and their edges. The tag
+        // is stored in the snapshot and returned when it is loaded. If the snapshot
+        // is truncated or damaged, an error is printed and NULL is returned.
+        void writeSnapshot(const std::string& filename, const std::string& tag) const;
+        static Bigraph* loadSnapshot(const std::string& filename, std::string& outTag);
+
         // Returns an allocator for the edges of the graph
         SimpleAllocator<Edge>* getEdgeAllocator() { return m_pEdgeAllocator; }
 
@@ -177,15 +284,52 @@ class Bigraph
 
     private:
         
-        // Simplify the graph by compacting edges in the given direction
-        void simplify(EdgeDir dir);
+        // Simplify the graph by merging pairs of vertices joined
+        // by singular edges in the given direction
+        void simplifyPairwise(EdgeDir dir);
+
+        void followLinear(Vertex* pVertex, EdgeDir dir, Path& outPath);
+
+        // Run the parallel visit function of vf on the vertices
+        template<typename VF>
+        bool runVisitTasks(VF& vf, const VertexPtrVec& vertices, int numThreads)
+        {
+            vf.beginParallel(numThreads);
+            size_t nextIdx = 0;
 
-        void followLinear(VertexID id, EdgeDir dir, Path& outPath);
+            ThreadPool& pool = ThreadPool::getInstance();
+            TaskGroup taskGroup;
+            std::vector<VisitTask<VF>*> tasks(numThreads);
+            for(int i = 0; i < numThreads; ++i)
+            {
+                tasks[i] = new VisitTask<VF>(this, &vf, &vertices, &nextIdx, i);
+                pool.submit(tasks[i], &taskGroup, pool.getNodeForWorker(i));
+            }
+            taskGroup.wait();
+
+            bool modified = false;
+            for(int i = 0; i < numThreads; ++i)
+            {
+                modified = tasks[i]->isModified() || modified;
+                delete tasks[i];
+            }
+            return modified;
+        }
+
+        // Dirty set management
+        void addDirty(VertexIdx idx);
+        void beginDirtyRound();
+        bool nextDirtyVertex(VertexIdx& outIdx);
+        void takeDirtyVertices(VertexPtrVec& outVertices);
 
         //
         // data
         //
-        VertexPtrMap m_vertices;
+
+        // The vertices indexed by VertexIdx. Removed vertices leave a NULL entry.
+        VertexPtrVec m_vertices;
+        size_t m_numVertices;
+        VertexNameTable m_nameTable;
 
         // Graph parameters
         bool m_hasContainment;
@@ -198,6 +342,60 @@ class Bigraph
         // Memory management
         SimpleAllocator<Vertex>* m_pVertexAllocator;
         SimpleAllocator<Edge>* m_pEdgeAllocator;
+        SeqArena* m_pSeqArena;
+
+        // Dirty tracking. Each vertex has a mark for the next round and
+        // a mark for the serial round in progress, if any.
+        static const uint8_t DIRTY_NEXT = 0x1;
+        static const uint8_t DIRTY_CURRENT = 0x2;
+        typedef std::priority_queue<VertexIdx, std::vector<VertexIdx>, std::greater<VertexIdx> > DirtyQueue;
+
+        bool m_trackDirty;
+        std::vector<uint8_t> m_dirtyMarks;
+        std::vector<VertexIdx> m_dirtyVertices;
+        DirtyQueue m_dirtyQueue;
+        bool m_inDirtyRound;
+        VertexIdx m_dirtyCursor;
+};
+
+// Visit chunks of vertices on a pool thread until all the vertices have been taken
+template<typename VF>
+class VisitTask : public PoolTask
+{
+    public:
+        VisitTask(Bigraph* pGraph, VF* pVisitor, const VertexPtrVec* pVertices,
+                  size_t* pNextIdx, int threadIdx) : m_pGraph(pGraph),
+                                                     m_pVisitor(pVisitor),
+                                                     m_pVertices(pVertices),
+                                                     m_pNextIdx(pNextIdx),
+                                                     m_threadIdx(threadIdx),
+                                                     m_modified(false) {}
+
+        void run()
+        {
+            static const size_t CHUNK_SIZE = 4096;
+            size_t numVertices = m_pVertices->size();
+            while(true)
+            {
+                size_t start = __sync_fetch_and_add(m_pNextIdx, CHUNK_SIZE);
+                if(start >= numVertices)
+                    break;
+
+                size_t end = std::min(start + CHUNK_SIZE, numVertices);
+                for(size_t i = start; i < end; ++i)
+                    m_modified = m_pVisitor->visitParallel(m_pGraph, (*m_pVertices)[i], m_threadIdx) || m_modified;
+            }
+        }
+
+        bool isModified() const { return m_modified; }
+
+    private:
+        Bigraph* m_pGraph;
+        VF* m_pVisitor;
+        const VertexPtrVec* m_pVertices;
+        size_t* m_pNextIdx;
+        int m_threadIdx;
+        bool m_modified;
 };
 
 #endif
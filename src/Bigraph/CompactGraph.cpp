@@ -0,0 +1,310 @@
+//-----------------------------------------------
+// Copyright 2010 Wellcome Trust Sanger Institute
+// Written by Jared Simpson (js18@sanger.ac.uk)
+// Released under the GPL
+//-----------------------------------------------
+//
+// CompactGraph - Immutable compressed sparse row
+// representation of a Bigraph
+//
+#include <assert.h>
+#include <algorithm>
+#include "CompactGraph.h"
+#include "Alphabet.h"
+#include "Util.h"
+#include <iostream>
+
+// Order vertices by name
+struct VertexIDLess
+{
+    bool operator()(const Vertex* pA, const Vertex* pB) const { return strcmp(pA->getName(), pB->getName()) < 0; }
+};
+
+// Look up the index of a pointer in a table sorted by pointer
+template<typename T>
+static uint32_t lookupIndex(const std::vector<std::pair<const T*, uint32_t> >& table, const T* ptr)
+{
+    typename std::vector<std::pair<const T*, uint32_t> >::const_iterator iter;
+    iter = std::lower_bound(table.begin(), table.end(), std::make_pair(ptr, (uint32_t)0));
+    assert(iter != table.end() && iter->first == ptr);
+    return iter->second;
+}
+
+//
+CompactGraph::CompactGraph(const Bigraph* pGraph) : m_numBases(0),
+                                                    m_hasContainment(pGraph->hasContainment()),
+                                                    m_hasTransitive(pGraph->hasTransitive()),
+                                                    m_isExactMode(pGraph->isExactMode()),
+                                                    m_minOverlap(pGraph->getMinOverlap()),
+                                                    m_errorRate(pGraph->getErrorRate())
+{
+    VertexPtrVec vertices = pGraph->getAllVertices();
+    std::sort(vertices.begin(), vertices.end(), VertexIDLess());
+
+    size_t numVertices = vertices.size();
+    if(numVertices > MAX_VERTICES)
+    {
+        std::cerr << "Error: the graph has " << numVertices << " vertices but a CompactGraph can hold at most "
+                  << MAX_VERTICES << "\n";
+        exit(EXIT_FAILURE);
+    }
+
+    std::vector<std::pair<const Vertex*, uint32_t> > vertexTable(numVertices);
+    for(size_t i = 0; i < numVertices; ++i)
+        vertexTable[i] = std::make_pair(vertices[i], (uint32_t)i);
+    std::sort(vertexTable.begin(), vertexTable.end());
+
+    // Build the vertex records, names and sequences and count the edges
+    m_vertices.resize(numVertices);
+    m_nameOffsets.resize(numVertices);
+    m_edgeOffsets.resize(2 * numVertices + 1);
+
+    uint64_t numEdges = 0;
+    for(size_t i = 0; i < numVertices; ++i)
+    {
+        Vertex* pVertex = vertices[i];
+        std::string seq = pVertex->getStr();
+        if(seq.size() > MAX_SEQ_LEN)
+        {
+            std::cerr << "Error: vertex " << pVertex->getID() << " has " << seq.size() 
+                      << " bases but a CompactGraph vertex can hold at most " << MAX_SEQ_LEN << "\n";
+            exit(EXIT_FAILURE);
+        }
+        m_vertices[i].seqOffset = appendSeq(seq);
+        m_vertices[i].seqLen = seq.size();
+        m_vertices[i].flags = pVertex->isContained() ? CONTAINED_FLAG : 0;
+
+        const char* pName = pVertex->getName();
+        m_nameOffsets[i] = m_names.size();
+        m_names.insert(m_names.end(), pName, pName + strlen(pName) + 1);
+
+        m_edgeOffsets[2 * i] = numEdges;
+        numEdges += pVertex->countEdges(ED_SENSE);
+        m_edgeOffsets[2 * i + 1] = numEdges;
+        numEdges += pVertex->countEdges(ED_ANTISENSE);
+    }
+    m_edgeOffsets[2 * numVertices] = numEdges;
+    if(numEdges > MAX_EDGES)
+    {
+        std::cerr << "Error: the graph has " << numEdges << " edges but a CompactGraph can hold at most "
+                  << MAX_EDGES << "\n";
+        exit(EXIT_FAILURE);
+    }
+
+    // Build the edge records. The twins are resolved
+    // once the index of every edge is known.
+    m_edges.resize(numEdges);
+    std::vector<const Edge*> edgePtrs(numEdges);
+    for(size_t i = 0; i < numVertices; ++i)
+    {
+        for(size_t d = 0; d < ED_COUNT; ++d)
+        {
+            EdgeDir dir = EDGE_DIRECTIONS[d];
+            EdgePtrVec edges = vertices[i]->getEdges(dir);
+            uint64_t base = m_edgeOffsets[2 * i + dir];
+            for(size_t j = 0; j < edges.size(); ++j)
+            {
+                Edge* pEdge = edges[j];
+                CompactEdge& record = m_edges[base + j];
+                record.endData = lookupIndex(vertexTable, (const Vertex*)pEdge->getEnd());
+                if(pEdge->getDir() == ED_ANTISENSE)
+                    record.endData |= DIR_FLAG;
+                if(pEdge->getComp() == EC_REVERSE)
+                    record.endData |= COMP_FLAG;
+
+                const SeqCoord& coord = pEdge->getMatchCoord();
+                record.matchStart = coord.interval.start;
+                record.matchEnd = coord.interval.end;
+                record.twinIdx = 0;
+                edgePtrs[base + j] = pEdge;
+            }
+        }
+    }
+
+    std::vector<std::pair<const Edge*, uint32_t> > edgeTable(numEdges);
+    for(size_t i = 0; i < numEdges; ++i)
+        edgeTable[i] = std::make_pair(edgePtrs[i], (uint32_t)i);
+    std::sort(edgeTable.begin(), edgeTable.end());
+
+    for(size_t i = 0; i < numEdges; ++i)
+        m_edges[i].twinIdx = lookupIndex(edgeTable, (const Edge*)edgePtrs[i]->getTwin());
+}
+
+//
+Bigraph* CompactGraph::toBigraph() const
+{
+    Bigraph* pGraph = new Bigraph;
+    pGraph->setContainmentFlag(m_hasContainment);
+    pGraph->setTransitiveFlag(m_hasTransitive);
+    pGraph->setExactMode(m_isExactMode);
+    pGraph->setMinOverlap(m_minOverlap);
+    pGraph->setErrorRate(m_errorRate);
+
+    size_t numVertices = m_vertices.size();
+    std::vector<Vertex*> vertices(numVertices);
+    for(size_t i = 0; i < numVertices; ++i)
+    {
+        Vertex* pVertex = pGraph->createVertex(getName(i), getSeq(i));
+        pVertex->setContained(isContained(i));
+        pGraph->addVertex(pVertex);
+        vertices[i] = pVertex;
+    }
+
+    // Create every edge before setting the twins
+    size_t numEdges = m_edges.size();
+    std::vector<Edge*> edges(numEdges);
+    for(size_t i = 0; i < numEdges; ++i)
+    {
+        const CompactEdge* pRecord = &m_edges[i];
+        edges[i] = new(pGraph->getEdgeAllocator()) Edge(vertices[getEndIdx(pRecord)], getDir(pRecord),
+                                                          getComp(pRecord), getMatchCoord(pRecord));
+    }
+
+    for(size_t i = 0; i < numVertices; ++i)
+    {
+        for(uint64_t j = m_edgeOffsets[2 * i]; j < m_edgeOffsets[2 * i + 2]; ++j)
+        {
+            edges[j]->setTwin(edges[m_edges[j].twinIdx]);
+            pGraph->addEdge(vertices[i], edges[j]);
+        }
+    }
+    return pGraph;
+}
+
+//
+std::string CompactGraph::getSeq(VertexIdx idx) const
+{
+    size_t len = m_vertices[idx].seqLen;
+    std::string out(len, 'A');
+    for(size_t i = 0; i < len; ++i)
+        out[i] = getBase(idx, i);
+    return out;
+}
+
+//
+char CompactGraph::getBase(VertexIdx idx, size_t pos) const
+{
+    uint64_t p = m_vertices[idx].seqOffset + pos;
+    uint64_t rank = (m_seqArena[p / BASES_PER_WORD] >> (2 * (p % BASES_PER_WORD))) & 3;
+    return DNA_ALPHABET::getBase(rank);
+}
+
+//
+CompactGraph::VertexIdx CompactGraph::findVertex(const VertexID& id) const
+{
+    size_t lo = 0;
+    size_t hi = m_vertices.size();
+    while(lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        int cmp = id.compare(&m_names[m_nameOffsets[mid]]);
+        if(cmp == 0)
+            return mid;
+        else if(cmp < 0)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    return INVALID_VERTEX;
+}
+
+//
+void CompactGraph::getEdges(VertexIdx idx, EdgeDir dir, CompactEdgePtrVec& outEdges) const
+{
+    for(uint64_t e = m_edgeOffsets[2 * idx + dir]; e < m_edgeOffsets[2 * idx + dir + 1]; ++e)
+        outEdges.push_back(&m_edges[e]);
+}
+
+//
+void CompactGraph::getConnectedComponents(std::vector<std::vector<VertexIdx> >& outComponents) const
+{
+    std::vector<bool> visited(m_vertices.size(), false);
+    for(size_t i = 0; i < m_vertices.size(); ++i)
+    {
+        if(visited[i])
+            continue;
+
+        // Breadth-first search from vertex i
+        std::vector<VertexIdx> component;
+        component.push_back(i);
+        visited[i] = true;
+        for(size_t j = 0; j < component.size(); ++j)
+        {
+            for(uint64_t e = m_edgeOffsets[2 * component[j]]; e < m_edgeOffsets[2 * component[j] + 2]; ++e)
+            {
+                VertexIdx endIdx = getEndIdx(&m_edges[e]);
+                if(!visited[endIdx])
+                {
+                    visited[endIdx] = true;
+                    component.push_back(endIdx);
+                }
+            }
+        }
+        outComponents.push_back(component);
+    }
+}
+
+//
+SeqCoord CompactGraph::getMatchCoord(const CompactEdge* pEdge) const
+{
+    return SeqCoord(pEdge->matchStart, pEdge->matchEnd, getSeqLen(getStartIdx(pEdge)));
+}
+
+//
+size_t CompactGraph::getExtensionLength(const CompactEdge* pEdge) const
+{
+    return getMatchCoord(getTwin(pEdge)).complement().length();
+}
+
+//
+std::string CompactGraph::getLabel(const CompactEdge* pEdge) const
+{
+    SeqCoord unmatched = getMatchCoord(getTwin(pEdge)).complement();
+    std::string seq = unmatched.getSubstring(getSeq(getEndIdx(pEdge)));
+    if(getComp(pEdge) == EC_REVERSE)
+        seq = reverseComplement(seq);
+    return seq;
+}
+
+//
+size_t CompactGraph::getMemSize() const
+{
+    return sizeof(*this) +
+           m_vertices.capacity() * sizeof(CompactVertex) +
+           m_edgeOffsets.capacity() * sizeof(uint64_t) +
+           m_edges.capacity() * sizeof(CompactEdge) +
+           m_seqArena.capacity() * sizeof(uint64_t) +
+           m_names.capacity() * sizeof(char) +
+           m_nameOffsets.capacity() * sizeof(uint64_t);
+}
+
+//
+void CompactGraph::printMemSize() const
+{
+    size_t numVerts = m_vertices.size();
+    size_t vertMem = m_vertices.capacity() * sizeof(CompactVertex) +
+                     m_seqArena.capacity() * sizeof(uint64_t) +
+                     m_names.capacity() + m_nameOffsets.capacity() * sizeof(uint64_t);
+
+    size_t numEdges = m_edges.size();
+    size_t edgeMem = m_edges.capacity() * sizeof(CompactEdge) + m_edgeOffsets.capacity() * sizeof(uint64_t);
+
+    printf("num verts: %zu using %zu bytes (%.2lf per vert)\n", numVerts, vertMem, double(vertMem) / numVerts);
+    printf("num edges: %zu using %zu bytes (%.2lf per edge)\n", numEdges, edgeMem, double(edgeMem) / numEdges);
+    printf("total: %zu\n", edgeMem + vertMem);
+}
+
+//
+uint64_t CompactGraph::appendSeq(const std::string& s)
+{
+    uint64_t offset = m_numBases;
+    for(size_t i = 0; i < s.size(); ++i)
+    {
+        uint64_t pos = m_numBases++;
+        if(pos / BASES_PER_WORD >= m_seqArena.size())
+            m_seqArena.push_back(0);
+        uint64_t rank = DNA_ALPHABET::getBaseRank(s[i]);
+        m_seqArena[pos / BASES_PER_WORD] |= rank << (2 * (pos % BASES_PER_WORD));
+    }
+    return offset;
+}
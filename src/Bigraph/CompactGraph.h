@@ -0,0 +1,184 @@
+//-----------------------------------------------
+// Copyright 2010 Wellcome Trust Sanger Institute
+// Written by Jared Simpson (js18@sanger.ac.uk)
+// Released under the GPL
+//-----------------------------------------------
+//
+// CompactGraph - Immutable compressed sparse row
+// representation of a Bigraph for the read-only
+// stages of an assembly. Vertices are identified by
+// dense integer indices (in order of their names),
+// the sequences are packed
+// 2 bits per base into a single arena, the vertex
+// names are kept in a separate character table
+// and the edges of each vertex are stored
+// contiguously as 16-byte records.
+//
+#ifndef COMPACTGRAPH_H
+#define COMPACTGRAPH_H
+
+#include <stdint.h>
+#include "Bigraph.h"
+
+// A directed edge. The twin of an edge describes the
+// same overlap from the end vertex
+struct CompactEdge
+{
+    uint32_t endData; // index of the end vertex in the low 30 bits, dir/comp flags in the top bits
+    uint32_t twinIdx; // index of the twin edge
+
+    // The matched interval of the start vertex
+    int32_t matchStart;
+    int32_t matchEnd;
+};
+
+//
+struct CompactVertex
+{
+    uint64_t seqOffset; // position of the first base in the sequence arena
+    uint32_t seqLen;
+    uint32_t flags;
+};
+
+typedef std::vector<const CompactEdge*> CompactEdgePtrVec;
+
+class CompactGraph
+{
+    public:
+
+        typedef uint32_t VertexIdx;
+        typedef uint32_t EdgeIdx;
+        static const VertexIdx INVALID_VERTEX = 0xFFFFFFFF;
+
+        // Build the compact representation of pGraph. The program exits with an error
+        // if pGraph has more vertices, edges or bases in a vertex than the records can hold.
+        CompactGraph(const Bigraph* pGraph);
+
+        // Create a new Bigraph with the same vertices, edges and parameters
+        // as this graph. The vertex and edge colors are not stored so
+        // all the colors of the new graph are GC_WHITE.
+        Bigraph* toBigraph() const;
+
+        // Vertex access
+        size_t getNumVertices() const { return m_vertices.size(); }
+        const CompactVertex* getVertex(VertexIdx idx) const { return &m_vertices[idx]; }
+        VertexIdx getIndex(const CompactVertex* pVertex) const { return pVertex - &m_vertices[0]; }
+        VertexID getName(VertexIdx idx) const { return VertexID(&m_names[m_nameOffsets[idx]]); }
+        std::string getSeq(VertexIdx idx) const;
+        char getBase(VertexIdx idx, size_t pos) const;
+        size_t getSeqLen(VertexIdx idx) const { return m_vertices[idx].seqLen; }
+        bool isContained(VertexIdx idx) const { return m_vertices[idx].flags & CONTAINED_FLAG; }
+
+        // Returns the index of the vertex with the given name or INVALID_VERTEX
+        // if there is no such vertex. The vertices are indexed in order of
+        // their names so this is a binary search.
+        VertexIdx findVertex(const VertexID& id) const;
+
+        // Edge access. The edges of a vertex in one direction are
+        // the contiguous range [getEdgesBegin(), getEdgesEnd())
+        size_t getNumEdges() const { return m_edges.size(); }
+        const CompactEdge* getEdgesBegin(VertexIdx idx, EdgeDir dir) const { return &m_edges[0] + m_edgeOffsets[2 * idx + dir]; }
+        const CompactEdge* getEdgesEnd(VertexIdx idx, EdgeDir dir) const { return &m_edges[0] + m_edgeOffsets[2 * idx + dir + 1]; }
+        size_t countEdges(VertexIdx idx, EdgeDir dir) const { return m_edgeOffsets[2 * idx + dir + 1] - m_edgeOffsets[2 * idx + dir]; }
+        size_t countEdges(VertexIdx idx) const { return m_edgeOffsets[2 * idx + 2] - m_edgeOffsets[2 * idx]; }
+        void getEdges(VertexIdx idx, EdgeDir dir, CompactEdgePtrVec& outEdges) const;
+
+        // Partition the vertices into connected components. Each component is
+        // listed in breadth-first order from its vertex with the lowest index.
+        void getConnectedComponents(std::vector<std::vector<VertexIdx> >& outComponents) const;
+
+        // Edge properties
+        EdgeIdx getEdgeIndex(const CompactEdge* pEdge) const { return pEdge - &m_edges[0]; }
+        const CompactEdge* getTwin(const CompactEdge* pEdge) const { return &m_edges[pEdge->twinIdx]; }
+        VertexIdx getEndIdx(const CompactEdge* pEdge) const { return pEdge->endData & END_MASK; }
+        VertexIdx getStartIdx(const CompactEdge* pEdge) const { return getEndIdx(getTwin(pEdge)); }
+        const CompactVertex* getEnd(const CompactEdge* pEdge) const { return &m_vertices[getEndIdx(pEdge)]; }
+        EdgeDir getDir(const CompactEdge* pEdge) const { return (pEdge->endData & DIR_FLAG) ? ED_ANTISENSE : ED_SENSE; }
+        EdgeComp getComp(const CompactEdge* pEdge) const { return (pEdge->endData & COMP_FLAG) ? EC_REVERSE : EC_SAME; }
+        EdgeDir getTwinDir(const CompactEdge* pEdge) const { return getDir(getTwin(pEdge)); }
+
+        // The match coordinates of the edge on the start vertex
+        SeqCoord getMatchCoord(const CompactEdge* pEdge) const;
+
+        // The number of bases the edge extends past the start vertex (see Edge::getSeqLen)
+        size_t getExtensionLength(const CompactEdge* pEdge) const;
+
+        // The sequence the edge extends past the start vertex (see Edge::getLabel)
+        std::string getLabel(const CompactEdge* pEdge) const;
+
+        // Graph parameters
+        bool hasContainment() const { return m_hasContainment; }
+        bool hasTransitive() const { return m_hasTransitive; }
+        bool isExactMode() const { return m_isExactMode; }
+        int getMinOverlap() const { return m_minOverlap; }
+        double getErrorRate() const { return m_errorRate; }
+
+        size_t getMemSize() const;
+        void printMemSize() const;
+
+    private:
+
+        static const uint32_t END_MASK = 0x3FFFFFFF;
+        static const uint32_t DIR_FLAG = 0x40000000;
+        static const uint32_t COMP_FLAG = 0x80000000;
+        static const uint32_t CONTAINED_FLAG = 0x1;
+
+        // Limits imposed by the sizes of the record fields
+        static const uint64_t MAX_VERTICES = END_MASK;
+        static const uint64_t MAX_EDGES = 0xFFFFFFFF;
+        static const uint64_t MAX_SEQ_LEN = 0xFFFFFFFF;
+        static const int BASES_PER_WORD = 32;
+
+        // Append s to the sequence arena and return the offset of its first base
+        uint64_t appendSeq(const std::string& s);
+
+        //
+        std::vector<CompactVertex> m_vertices;
+        std::vector<uint64_t> m_edgeOffsets;
+        std::vector<CompactEdge> m_edges;
+
+        // 2-bit packed sequences
+        std::vector<uint64_t> m_seqArena;
+        uint64_t m_numBases;
+
+        // Null-terminated vertex names
+        std::vector<char> m_names;
+        std::vector<uint64_t> m_nameOffsets;
+
+        // Graph parameters
+        bool m_hasContainment;
+        bool m_hasTransitive;
+        bool m_isExactMode;
+        int m_minOverlap;
+        double m_errorRate;
+};
+
+// Allows a CompactGraph to be searched with GraphSearchTree
+class CompactGraphAccessor
+{
+    public:
+        CompactGraphAccessor(const CompactGraph* pGraph = NULL) : m_pGraph(pGraph) {}
+
+        CompactEdgePtrVec getEdges(const CompactVertex* pVertex, EdgeDir dir) const
+        {
+            CompactEdgePtrVec edges;
+            m_pGraph->getEdges(m_pGraph->getIndex(pVertex), dir, edges);
+            return edges;
+        }
+
+        const CompactVertex* getEnd(const CompactEdge* pEdge) const { return m_pGraph->getEnd(pEdge); }
+        EdgeDir getExpandDir(const CompactEdge* pEdge) const { return !m_pGraph->getTwinDir(pEdge); }
+
+    private:
+        const CompactGraph* m_pGraph;
+};
+
+// The extension distance of an edge of a CompactGraph
+struct CompactDistanceFunction
+{
+    CompactDistanceFunction(const CompactGraph* pGraph = NULL) : m_pGraph(pGraph) {}
+    int operator()(const CompactEdge* pEdge) const { return m_pGraph->getExtensionLength(pEdge); }
+    const CompactGraph* m_pGraph;
+};
+
+#endif
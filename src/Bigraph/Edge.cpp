@@ -34,25 +34,35 @@ std::string Edge::getLabel() const
 
 // Join the edge pEdge into this edge, adding to the start
 void Edge::join(const Edge* pEdge)
+{
+    join(pEdge->getMatch(), pEdge->getComp(), pEdge->getStart());
+}
+
+//
+void Edge::join(const Match& m12, EdgeComp comp, Vertex* pStart)
 {
     // Update the match coordinate
-    Match m12 = pEdge->getMatch();
-    Match m23 = getMatch();
-    m_matchCoord = m12.inverseTranslate(m23.coord[0]);
+    m_matchCoord = m12.inverseTranslate(m_matchCoord);
 
-    if(pEdge->getComp() == EC_REVERSE)
+    if(comp == EC_REVERSE)
         flip();
 
-    // Now, update the twin of this edge to extend to the twin of pEdge
-    m_pTwin->extend(pEdge->getTwin());
+    // Now, update the twin of this edge to end at the new start
+    m_pTwin->extend(comp, pStart);
 }
 
 // Extend this edge by adding pEdge to the end
 void Edge::extend(const Edge* pEdge)
 {
-    if(pEdge->getComp() == EC_REVERSE)
+    extend(pEdge->getComp(), pEdge->getEnd());
+}
+
+//
+void Edge::extend(EdgeComp comp, Vertex* pEnd)
+{
+    if(comp == EC_REVERSE)
         flipComp();
-    m_pEnd = pEdge->getEnd();
+    m_pEnd = pEnd;
 }
 
 // return the mapping from V1 to V2 via this edge
@@ -133,7 +143,7 @@ void Edge::validate() const
         std::cerr << "V2M: " << m_v2 << "\n";
         std::cerr << "V1MC: " << getMatchCoord() << "\n";
         std::cerr << "V2MC: " << pTwin->getMatchCoord() << "\n";
-        std::cerr << "V1: " << getStart()->getSeq() << "\n";
+        std::cerr << "V1: " << getStart()->getStr() << "\n";
         std::cerr << "Validation failed for edge " << *this << "\n";
         assert(false);
     }
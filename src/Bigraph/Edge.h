@@ -82,8 +82,14 @@ class Edge
         // Join merges pEdge into this edge, with pEdge describing the starting point
         void join(const Edge* pEdge);
 
+        // Join with the start vertex replaced by pStart. m12 maps the coordinates of
+        // pStart to the coordinates of the current start vertex and comp is the 
+        // orientation of the current start vertex with respect to pStart
+        void join(const Match& m12, EdgeComp comp, Vertex* pStart);
+
         // Extend merged pEdge into this edge, with pEdge describing the endpoint
         void extend(const Edge* pEdge);
+        void extend(EdgeComp comp, Vertex* pEnd);
 
         // Post merge update function
         void update() {}
@@ -106,6 +112,7 @@ class Edge
         
         // setters
         void setTwin(Edge* pEdge) { m_pTwin = pEdge; }
+        void setEnd(Vertex* pVertex) { m_pEnd = pVertex; }
         void setColor(GraphColor c) { m_color = c; }
 
         // getters
@@ -141,11 +148,10 @@ class Edge
             return pAllocator->alloc();
         }
 
-        void operator delete(void* /*target*/, size_t /*size*/)
+        // The memory is returned to the pool that the edge was allocated from
+        void operator delete(void* target, size_t /*size*/)
         {
-            // Deletions are handled at the graph/pool level. The lifetime of an edge
-            // is as long as the graph it belongs to, even if it is deleted before
-            // the graph.
+            SimpleAllocator<Edge>::release(target);
         }
 
         // Validate that the edge is sane
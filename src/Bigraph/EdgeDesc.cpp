@@ -13,9 +13,9 @@
 bool EdgeDesc::operator<(const EdgeDesc& obj) const
 {
     assert(pVertex != NULL && obj.pVertex != NULL);
-    if(pVertex->getID() < obj.pVertex->getID())
+    if(pVertex->getIndex() < obj.pVertex->getIndex())
         return true;
-    else if(pVertex->getID() > obj.pVertex->getID())
+    else if(pVertex->getIndex() > obj.pVertex->getIndex())
         return false;
     else if(dir < obj.dir)
         return true;
@@ -31,7 +31,7 @@ bool EdgeDesc::operator<(const EdgeDesc& obj) const
 bool EdgeDesc::operator==(const EdgeDesc& obj) const
 {
     assert(pVertex != NULL && obj.pVertex != NULL);
-    return pVertex->getID() == obj.pVertex->getID() && dir == obj.dir && comp == obj.comp;
+    return pVertex->getIndex() == obj.pVertex->getIndex() && dir == obj.dir && comp == obj.comp;
 }
 
 std::ostream& operator<<(std::ostream& out, const EdgeDesc& ed)
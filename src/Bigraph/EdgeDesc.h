@@ -25,7 +25,8 @@ struct EdgeDesc
     inline EdgeDir getTransitiveDir() const { return (comp == EC_SAME) ? dir : !dir; }
     inline EdgeDir getTwinDir() const { return (comp == EC_SAME) ? !dir : dir; }
 
-    // Operators
+    // Operators. Descriptions are compared by the index of the vertex
+    // so they are only comparable between edges of the same graph
     bool operator<(const EdgeDesc& obj) const;
     bool operator==(const EdgeDesc& obj) const;
     friend std::ostream& operator<<(std::ostream& out, const EdgeDesc& ed);
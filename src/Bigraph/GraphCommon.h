@@ -54,6 +54,10 @@ const GraphColor GC_RED = 4;
 typedef std::string VertexID;
 typedef std::vector<VertexID> VertexIDVec;
 
+// Dense index of a vertex within its graph. The name of the
+// vertex is only needed for output and is kept in the VertexNameTable
+typedef uint32_t VertexIdx;
+
 //
 // Edge Operations
 //
@@ -0,0 +1,171 @@
+//-----------------------------------------------
+// Copyright 2010 Wellcome Trust Sanger Institute
+// Written by Jared Simpson (js18@sanger.ac.uk)
+// Released under the GPL
+//-----------------------------------------------
+//
+// PathCompactVisitor - Collapse maximal non-branching
+// paths of the graph into single vertices
+//
+#include <assert.h>
+#include "PathCompactVisitor.h"
+#include "Util.h"
+
+//
+Edge* PathCompactVisitor::getLinearEdge(const Vertex* pVertex, EdgeDir dir)
+{
+    EdgePtrVec edges = pVertex->getEdges(dir);
+    if(edges.size() != 1 || edges.front()->isSelf())
+        return NULL;
+
+    Edge* pEdge = edges.front();
+    if(pEdge->getEnd()->countEdges(pEdge->getTwin()->getDir()) != 1)
+        return NULL;
+    return pEdge;
+}
+
+//
+void PathCompactVisitor::previsit(Bigraph* /*pGraph*/)
+{
+    m_threadPaths.assign(1, LinearPathVector());
+}
+
+//
+bool PathCompactVisitor::visit(Bigraph* /*pGraph*/, Vertex* pVertex)
+{
+    return findPath(pVertex, m_threadPaths[0]);
+}
+
+//
+void PathCompactVisitor::beginParallel(int numThreads)
+{
+    m_threadPaths.assign(numThreads, LinearPathVector());
+}
+
+//
+bool PathCompactVisitor::visitParallel(Bigraph* /*pGraph*/, Vertex* pVertex, int threadIdx)
+{
+    return findPath(pVertex, m_threadPaths[threadIdx]);
+}
+
+//
+void PathCompactVisitor::postvisit(Bigraph* pGraph)
+{
+    // The paths are vertex-disjoint so they can be spliced in any order
+    for(size_t i = 0; i < m_threadPaths.size(); ++i)
+    {
+        for(size_t j = 0; j < m_threadPaths[i].size(); ++j)
+            splicePath(pGraph, m_threadPaths[i][j]);
+    }
+    m_threadPaths.clear();
+}
+
+//
+bool PathCompactVisitor::findPath(Vertex* pVertex, LinearPathVector& outPaths) const
+{
+    for(size_t idx = 0; idx < ED_COUNT; idx++)
+    {
+        // The path starts at pVertex if it can be extended in dir only 
+        EdgeDir dir = EDGE_DIRECTIONS[idx];
+        Edge* pEdge = getLinearEdge(pVertex, dir);
+        if(pEdge == NULL || getLinearEdge(pVertex, !dir) != NULL)
+            continue;
+
+        EdgePtrVec edges;
+        while(pEdge != NULL)
+        {
+            edges.push_back(pEdge);
+            pEdge = getLinearEdge(pEdge->getEnd(), pEdge->getTransitiveDir());
+        }
+
+        if(edges.back()->getEnd()->getIndex() < pVertex->getIndex())
+            continue;
+
+        // The sequence added by each vertex is the part of the vertex
+        // that is not matched to the previous vertex, in the orientation of pVertex
+        std::vector<std::string> labels(edges.size());
+        EdgeComp comp = EC_SAME;
+        size_t totalLen = pVertex->getSeqLen();
+        for(size_t i = 0; i < edges.size(); ++i)
+        {
+            if(edges[i]->getComp() == EC_REVERSE)
+                comp = !comp;
+            SeqCoord unmatched = edges[i]->getTwin()->getMatchCoord().complement();
+            labels[i] = unmatched.getSubstring(edges[i]->getEnd()->getStr());
+            if(comp == EC_REVERSE)
+                labels[i] = reverseComplement(labels[i]);
+            totalLen += labels[i].size();
+        }
+
+        outPaths.push_back(LinearPath());
+        LinearPath& path = outPaths.back();
+        path.pStart = pVertex;
+        path.dir = dir;
+        path.edges.swap(edges);
+        path.endComp = comp;
+        path.seq.reserve(totalLen);
+        if(dir == ED_SENSE)
+        {
+            path.seq = pVertex->getStr();
+            for(size_t i = 0; i < labels.size(); ++i)
+                path.seq.append(labels[i]);
+        }
+        else
+        {
+            for(size_t i = labels.size(); i > 0; --i)
+                path.seq.append(labels[i - 1]);
+            path.seq.append(pVertex->getStr());
+        }
+        return true;
+    }
+    return false;
+}
+
+// The result is the same as merging the vertices of the path
+// into the start vertex one at a time with Bigraph::merge
+void PathCompactVisitor::splicePath(Bigraph* pGraph, LinearPath& path)
+{
+    Vertex* pStart = path.pStart;
+    Edge* pLastEdge = path.edges.back();
+    Vertex* pLast = pLastEdge->getEnd();
+    EdgeDir lastDir = pLastEdge->getTransitiveDir();
+
+    VertexPtrVec pathVertices(path.edges.size());
+    for(size_t i = 0; i < path.edges.size(); ++i)
+        pathVertices[i] = path.edges[i]->getEnd();
+
+    // Update the edges on the other side of the start vertex. If
+    // sequence was prepended their coordinates are offset.
+    int newLen = path.seq.size();
+    int offset = newLen - pStart->getSeqLen();
+    EdgePtrVec startEdges = pStart->getEdges(!path.dir);
+    for(EdgePtrVecIter iter = startEdges.begin(); iter != startEdges.end(); ++iter)
+    {
+        (*iter)->updateSeqLen(newLen);
+        if(path.dir == ED_ANTISENSE)
+            (*iter)->offsetMatch(offset);
+    }
+
+    // Move the edges at the end of the path to the start vertex. 
+    // The last vertex is placed at the end of the merged sequence.
+    int lastLen = pLast->getSeqLen();
+    SeqCoord startCoord = (path.dir == ED_SENSE) ? SeqCoord(newLen - lastLen, newLen - 1, newLen) :
+                                                   SeqCoord(0, lastLen - 1, newLen);
+    Match placement(startCoord, SeqCoord(0, lastLen - 1, lastLen), path.endComp == EC_REVERSE, -1);
+
+    EdgePtrVec endEdges = pLast->getEdges(lastDir);
+    for(EdgePtrVecIter iter = endEdges.begin(); iter != endEdges.end(); ++iter)
+    {
+        Edge* pEdge = *iter;
+        pLast->removeEdge(pEdge);
+        pEdge->join(placement, path.endComp, pStart);
+        assert(pEdge->getDir() == path.dir);
+        pStart->addEdge(pEdge);
+    }
+
+    // Removing a vertex of the path deletes the edge to the next vertex
+    for(size_t i = 0; i < pathVertices.size(); ++i)
+        pGraph->removeConnectedVertex(pathVertices[i]);
+
+    pGraph->setVertexSeq(pStart, path.seq);
+}
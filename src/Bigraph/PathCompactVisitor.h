@@ -0,0 +1,65 @@
+//-----------------------------------------------
+// Copyright 2010 Wellcome Trust Sanger Institute
+// Written by Jared Simpson (js18@sanger.ac.uk)
+// Released under the GPL
+//-----------------------------------------------
+//
+// PathCompactVisitor - Collapse maximal non-branching
+// paths of the graph into single vertices. The paths
+// are found and their merged sequences are built 
+// independently of each other so this can run 
+// with visitParallel. The paths are spliced into
+// the graph serially in postvisit.
+//
+#ifndef PATHCOMPACTVISITOR_H
+#define PATHCOMPACTVISITOR_H
+
+#include "Bigraph.h"
+
+// A non-branching path to be collapsed into its start vertex
+struct LinearPath
+{
+    Vertex* pStart;
+    EdgeDir dir;
+
+    // The edges along the path, starting at pStart
+    EdgePtrVec edges;
+
+    // The orientation of the last vertex of the path relative to pStart
+    EdgeComp endComp;
+
+    // The sequence of the collapsed path
+    std::string seq;
+};
+typedef std::vector<LinearPath> LinearPathVector;
+
+class PathCompactVisitor
+{
+    public:
+        PathCompactVisitor() {}
+
+        VisitScope getVisitScope(const Bigraph* /*pGraph*/) const { return VS_READ_ONLY; }
+        void previsit(Bigraph* pGraph);
+        bool visit(Bigraph* pGraph, Vertex* pVertex);
+        void beginParallel(int numThreads);
+        bool visitParallel(Bigraph* pGraph, Vertex* pVertex, int threadIdx);
+        void postvisit(Bigraph* pGraph);
+
+        // Returns the edge of pVertex in direction dir that can be collapsed
+        // or NULL if there is no such edge. The edge can be collapsed if it is the only
+        // edge in dir, it is not a self-edge and its twin is the only edge in its direction.
+        static Edge* getLinearEdge(const Vertex* pVertex, EdgeDir dir);
+
+    private:
+
+        // Find the path starting at pVertex and build its sequence. Each path
+        // is found from the end vertex with the lowest index only.
+        bool findPath(Vertex* pVertex, LinearPathVector& outPaths) const;
+
+        // Collapse the path into its start vertex
+        void splicePath(Bigraph* pGraph, LinearPath& path);
+
+        std::vector<LinearPathVector> m_threadPaths;
+};
+
+#endif
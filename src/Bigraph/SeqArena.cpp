@@ -0,0 +1,78 @@
+//-----------------------------------------------
+// Copyright 2010 Wellcome Trust Sanger Institute
+// Written by Jared Simpson (js18@sanger.ac.uk)
+// Released under the GPL
+//-----------------------------------------------
+//
+// SeqArena - Append-only store for the vertex
+// sequences of a graph
+//
+#include <string.h>
+#include "SeqArena.h"
+
+//
+SeqArena::SeqArena() : m_pCurrBlock(NULL), m_blockUsed(BLOCK_SIZE), m_blockBytes(0)
+{
+
+}
+
+//
+SeqArena::~SeqArena()
+{
+    for(size_t i = 0; i < m_blocks.size(); ++i)
+        delete [] m_blocks[i];
+}
+
+//
+const uint8_t* SeqArena::add(const std::string& seq)
+{
+    size_t len = seq.size();
+    uint8_t* pOut = allocate(getNumBytes(len));
+    memset(pOut, 0, getNumBytes(len));
+    for(size_t i = 0; i < len; ++i)
+        pOut[i / 4] |= DNA_ALPHABET::getBaseRank(seq[i]) << (2 * (3 - i % 4));
+    return pOut;
+}
+
+//
+const uint8_t* SeqArena::add(const uint8_t* pData, size_t len)
+{
+    size_t bytes = getNumBytes(len);
+    uint8_t* pOut = allocate(bytes);
+    memcpy(pOut, pData, bytes);
+    return pOut;
+}
+
+//
+std::string SeqArena::decode(const uint8_t* pData, size_t len)
+{
+    std::string out(len, 'A');
+    for(size_t i = 0; i < len; ++i)
+        out[i] = getBase(pData, i);
+    return out;
+}
+
+//
+uint8_t* SeqArena::allocate(size_t bytes)
+{
+    if(bytes > BLOCK_SIZE)
+    {
+        // Oversized sequences get their own block. The current
+        // block stays open for the following sequences.
+        uint8_t* pBlock = new uint8_t[bytes];
+        m_blocks.push_back(pBlock);
+        m_blockBytes += bytes;
+        return pBlock;
+    }
+
+    if(m_blockUsed + bytes > BLOCK_SIZE)
+    {
+        m_pCurrBlock = new uint8_t[BLOCK_SIZE];
+        m_blocks.push_back(m_pCurrBlock);
+        m_blockUsed = 0;
+        m_blockBytes += BLOCK_SIZE;
+    }
+    uint8_t* pOut = m_pCurrBlock + m_blockUsed;
+    m_blockUsed += bytes;
+    return pOut;
+}
@@ -0,0 +1,73 @@
+//-----------------------------------------------
+// Copyright 2010 Wellcome Trust Sanger Institute
+// Written by Jared Simpson (js18@sanger.ac.uk)
+// Released under the GPL
+//-----------------------------------------------
+//
+// SeqArena - Append-only store for the vertex
+// sequences of a graph. Each sequence is packed
+// 2 bits per base into a contiguous run of bytes 
+// within large blocks that are never moved, so 
+// a vertex only needs a pointer to its first byte 
+// and its length. Sequences are never freed 
+// individually; replaced sequences stay in the 
+// arena until the graph is compacted.
+//
+#ifndef SEQARENA_H
+#define SEQARENA_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "Alphabet.h"
+
+class SeqArena
+{
+    public:
+
+        SeqArena();
+        ~SeqArena();
+
+        // Pack seq into the arena and return a pointer to the packed copy
+        const uint8_t* add(const std::string& seq);
+
+        // Copy a packed sequence of len bases into the arena
+        const uint8_t* add(const uint8_t* pData, size_t len);
+
+        // Return the rank or the base of the i-th position of a packed sequence
+        static uint8_t getRank(const uint8_t* pData, size_t i)
+        {
+            return (pData[i / 4] >> (2 * (3 - i % 4))) & 3;
+        }
+
+        static char getBase(const uint8_t* pData, size_t i)
+        {
+            return DNA_ALPHABET::getBase(getRank(pData, i));
+        }
+
+        // Unpack a sequence of len bases
+        static std::string decode(const uint8_t* pData, size_t len);
+
+        // The number of bytes used by a packed sequence of len bases
+        static size_t getNumBytes(size_t len) { return (len + 3) / 4; }
+
+        size_t getMemSize() const { return m_blockBytes; }
+
+    private:
+
+        // Not copyable, vertices point into the blocks of the arena
+        SeqArena(const SeqArena&);
+        SeqArena& operator=(const SeqArena&);
+
+        // Return a pointer to a run of unused bytes
+        uint8_t* allocate(size_t bytes);
+
+        static const size_t BLOCK_SIZE = 1 << 20;
+
+        std::vector<uint8_t*> m_blocks;
+        uint8_t* m_pCurrBlock;
+        size_t m_blockUsed;
+        size_t m_blockBytes;
+};
+
+#endif
@@ -57,12 +57,12 @@ Edge* TransitiveGroup::getEdge(EdgeDesc ed) const
 // Return the MultiOverlap corresponding to this transitive group
 MultiOverlap TransitiveGroup::getMultiOverlap() const
 {
-    MultiOverlap mo(m_pVertex->getID(), m_pVertex->getSeq().toString());
+    MultiOverlap mo(m_pVertex->getID(), m_pVertex->getStr());
 
     for(size_t i = 0; i < m_edges.size(); ++i)
     {
         Edge* pEdge = m_edges[i];
-        mo.add(pEdge->getEnd()->getSeq().toString(), pEdge->getOverlap());
+        mo.add(pEdge->getEnd()->getStr(), pEdge->getOverlap());
     }
     return mo;
 }
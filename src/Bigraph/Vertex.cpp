@@ -26,27 +26,28 @@ Vertex::~Vertex()
 // by the the content of the edge label
 // Then, all the edges that are pointing to this node
 // must be updated to contain the extension of the vertex
-void Vertex::merge(Edge* pEdge)
+void Vertex::merge(Edge* pEdge, SeqArena* pArena)
 {
     Edge* pTwin = pEdge->getTwin();
     //std::cout << "Adding label to " << getID() << " str: " << pSE->getLabel() << "\n";
 
     // Merge the sequence
-    DNAEncodedString label = pEdge->getLabel();
+    std::string label = pEdge->getLabel();
     size_t label_len = label.length();
-    pEdge->updateSeqLen(m_seq.length() + label_len);
+    pEdge->updateSeqLen(m_seqLen + label_len);
     bool prepend = false;
 
+    std::string seq = getStr();
     if(pEdge->getDir() == ED_SENSE)
     {
-        m_seq.append(label);
+        seq.append(label);
     }
     else
     {
-        label.append(m_seq);
-        std::swap(m_seq, label);
+        seq.insert(0, label);
         prepend = true;
     }
+    setSeq(pArena->add(seq), seq.size());
 
     pEdge->extendMatch(label_len);
     pTwin->extendMatchFullLength();
@@ -54,7 +55,7 @@ void Vertex::merge(Edge* pEdge)
     // All the SeqCoords for the edges must have their seqlen field updated
     // Also, if we prepended sequence to this edge, all the matches in the 
     // SENSE direction must have their coordinates offset
-    size_t newLen = m_seq.length();
+    size_t newLen = m_seqLen;
     for(EdgePtrVecIter iter = m_edges.begin(); iter != m_edges.end(); ++iter)
     {
         Edge* pUpdateEdge = *iter;
@@ -293,11 +294,11 @@ TransitiveGroupCollection Vertex::computeTransitiveGroups(EdgeDir dir)
 // Get a multioverlap object representing the overlaps for this vertex
 MultiOverlap Vertex::getMultiOverlap() const
 {
-    MultiOverlap mo(getID(), getSeq().toString());
+    MultiOverlap mo(getID(), getStr());
     for(size_t i = 0; i < m_edges.size(); ++i)
     {
         Edge* pEdge = m_edges[i];
-        mo.add(pEdge->getEnd()->getSeq().toString(), pEdge->getOverlap());
+        mo.add(pEdge->getEnd()->getStr(), pEdge->getOverlap());
     }
     return mo;
 }
@@ -479,13 +480,13 @@ Edge* Vertex::getEdge(const EdgeDesc& ed)
 }
 
 // Find edges to the specified vertex
-EdgePtrVec Vertex::findEdgesTo(VertexID id)
+EdgePtrVec Vertex::findEdgesTo(const Vertex* pY)
 {
     EdgePtrVecConstIter iter = m_edges.begin();
     EdgePtrVec outEdges;
     for(; iter != m_edges.end(); ++iter)
     {
-        if((*iter)->getEndID() == id)
+        if((*iter)->getEnd() == pY)
             outEdges.push_back(*iter);
     }
     return outEdges;
@@ -507,6 +508,16 @@ EdgePtrVec Vertex::getEdges(EdgeDir dir) const
     return outEdges;
 }
 
+//
+void Vertex::getEdges(EdgeDir dir, EdgePtrVec& outEdges) const
+{
+    outEdges.clear();
+    for(EdgePtrVecConstIter iter = m_edges.begin(); iter != m_edges.end(); ++iter)
+    {
+        if((*iter)->getDir() == dir)
+            outEdges.push_back(*iter);
+    }
+}
 
 // Get the edges
 EdgePtrVec Vertex::getEdges() const
@@ -535,10 +546,32 @@ size_t Vertex::countEdges(EdgeDir dir)
     return ev.size();
 }
 
+//
+Vertex* Vertex::relocate(SimpleAllocator<Vertex>* pAllocator, SeqArena* pArena)
+{
+    Vertex* pCopy = new(pAllocator) Vertex(m_idx, m_pName, pArena->add(m_pSeq, m_seqLen), m_seqLen);
+    pCopy->m_edges.swap(m_edges);
+    pCopy->m_color = m_color;
+    pCopy->m_isContained = m_isContained;
+    return pCopy;
+}
+
+//
+void Vertex::relocateEdges(SimpleAllocator<Edge>* pAllocator)
+{
+    for(EdgePtrVecIter iter = m_edges.begin(); iter != m_edges.end(); ++iter)
+    {
+        Edge* pEdge = *iter;
+        Edge* pCopy = new(pAllocator) Edge(*pEdge);
+        pEdge->setTwin(pCopy);
+        *iter = pCopy;
+    }
+}
+
 // Return the amount of memory this vertex is using, in bytes
 size_t Vertex::getMemSize() const
 {
-    return sizeof(*this) + (m_edges.size() * sizeof(Edge*)) + m_seq.getMemSize();
+    return sizeof(*this) + (m_edges.size() * sizeof(Edge*)) + SeqArena::getNumBytes(m_seqLen);
 }
 
 
@@ -21,7 +21,7 @@
 #include "GraphCommon.h"
 #include "TransitiveGroupCollection.h"
 #include "QualityVector.h"
-#include "EncodedString.h"
+#include "SeqArena.h"
 #include "SimpleAllocator.h"
 
 // Forward declare
@@ -56,16 +56,22 @@ class Vertex
 {
     public:
     
-        Vertex(VertexID id, const std::string& s) : m_id(id), 
-                                                    m_seq(s), 
-                                                    m_color(GC_WHITE),
-                                                    m_isContained(false) {}
+        // Vertices are created by Bigraph::createVertex, which
+        // assigns the index and stores the name in the graph's name table
+        // and the sequence in the graph's sequence arena
+        Vertex(VertexIdx idx, const char* pName, const uint8_t* pSeq, size_t seqLen) : m_idx(idx),
+                                                                                      m_pName(pName),
+                                                                                      m_pSeq(pSeq),
+                                                                                      m_seqLen(seqLen),
+                                                                                      m_color(GC_WHITE),
+                                                                                      m_isContained(false) {}
         ~Vertex();
 
         // High-level modification functions
         
-        // Merge another vertex into this vertex, as specified by pEdge
-        void merge(Edge* pEdge);
+        // Merge another vertex into this vertex, as specified by pEdge.
+        // The merged sequence is stored in pArena
+        void merge(Edge* pEdge, SeqArena* pArena);
 
         // sort the edges by the ID of the vertex they point to
         void sortAdjListByID();
@@ -100,9 +106,12 @@ class Vertex
         bool hasEdgeTo(const Vertex* pY) const;
 
         Edge* getEdge(const EdgeDesc& ed);
-        EdgePtrVec findEdgesTo(VertexID id);
+        EdgePtrVec findEdgesTo(const Vertex* pY);
         EdgePtrVec getEdges(EdgeDir dir) const;
         EdgePtrVec getEdges() const;
+
+        // Fill outEdges with the edges in direction dir, reusing its storage
+        void getEdges(EdgeDir dir, EdgePtrVec& outEdges) const;
         EdgePtrVecIter findEdge(const EdgeDesc& ed);
         EdgePtrVecConstIter findEdge(const EdgeDesc& ed) const;
 
@@ -113,18 +122,20 @@ class Vertex
         void validate() const;
         
         // setters
-        void setID(VertexID id) { m_id = id; }
+        void setName(VertexIdx idx, const char* pName) { m_idx = idx; m_pName = pName; }
         void setEdgeColors(GraphColor c);
-        void setSeq(const std::string& s) { m_seq = s; }
+        void setSeq(const uint8_t* pSeq, size_t seqLen) { m_pSeq = pSeq; m_seqLen = seqLen; }
         void setColor(GraphColor c) { m_color = c; }
         void setContained(bool c) { m_isContained = c; }
 
         // getters
-        VertexID getID() const { return m_id; }
+        VertexID getID() const { return VertexID(m_pName); }
+        const char* getName() const { return m_pName; }
+        VertexIdx getIndex() const { return m_idx; }
         GraphColor getColor() const { return m_color; }
-        const DNAEncodedString& getSeq() const { return m_seq; }
-        std::string getStr() const { return m_seq.toString(); }
-        size_t getSeqLen() const { return m_seq.length(); }
+        const uint8_t* getPackedSeq() const { return m_pSeq; }
+        std::string getStr() const { return SeqArena::decode(m_pSeq, m_seqLen); }
+        size_t getSeqLen() const { return m_seqLen; }
         size_t getMemSize() const;
         bool isContained() const { return m_isContained; }
 
@@ -134,13 +145,22 @@ class Vertex
             return pAllocator->alloc();
         }
 
-        void operator delete(void* /*target*/, size_t /*size*/)
+        // The memory is returned to the pool that the vertex was allocated from
+        void operator delete(void* target, size_t /*size*/)
         {
-            // delete does nothing since all allocations go through the memory pool
-            // belonging to the graph. The memory allocated for the vertex will be
-            // cleaned up when the graph is destroyed.
+            SimpleAllocator<Vertex>::release(target);
         }
 
+        // Copy this vertex into memory from pAllocator and its sequence into pArena. 
+        // The edges are moved to the copy and this vertex is left without edges.
+        Vertex* relocate(SimpleAllocator<Vertex>* pAllocator, SeqArena* pArena);
+
+        // Copy the edges of this vertex into memory from pAllocator.
+        // The twin pointer of each old edge is set to its copy so
+        // the twins of the copies can be found once all the edges 
+        // of the graph have been relocated. The old edges are not freed.
+        void relocateEdges(SimpleAllocator<Edge>* pAllocator);
+
         // Output edges in graphviz format
         void writeEdges(std::ostream& out, int dotFlags) const;
 
@@ -155,9 +175,11 @@ class Vertex
         // Ensure all the edges in DIR are unique
         bool markDuplicateEdges(EdgeDir dir, GraphColor dupColor);
 
-        VertexID m_id;
+        VertexIdx m_idx;
+        const char* m_pName;
         EdgePtrVec m_edges;
-        DNAEncodedString m_seq;
+        const uint8_t* m_pSeq;
+        uint32_t m_seqLen;
         GraphColor m_color;
         bool m_isContained;
 };
@@ -0,0 +1,85 @@
+//-----------------------------------------------
+// Copyright 2010 Wellcome Trust Sanger Institute
+// Written by Jared Simpson (js18@sanger.ac.uk)
+// Released under the GPL
+//-----------------------------------------------
+//
+// VertexNameTable - Map the names of the vertices
+// of a graph to dense integer indices
+//
+#include <assert.h>
+#include "VertexNameTable.h"
+
+//
+VertexNameTable::VertexNameTable() : m_pCurrBlock(NULL), m_blockUsed(BLOCK_SIZE), m_blockBytes(0)
+{
+
+}
+
+//
+VertexNameTable::~VertexNameTable()
+{
+    for(size_t i = 0; i < m_blocks.size(); ++i)
+        delete [] m_blocks[i];
+}
+
+//
+VertexIdx VertexNameTable::add(const VertexID& name)
+{
+    NameIndexMap::const_iterator iter = m_index.find(name.c_str());
+    if(iter != m_index.end())
+        return iter->second;
+
+    assert(m_names.size() < INVALID_INDEX);
+    VertexIdx idx = m_names.size();
+    const char* pName = storeName(name);
+    m_names.push_back(pName);
+    m_index.insert(std::make_pair(pName, idx));
+    return idx;
+}
+
+//
+VertexIdx VertexNameTable::find(const VertexID& name) const
+{
+    NameIndexMap::const_iterator iter = m_index.find(name.c_str());
+    if(iter == m_index.end())
+        return INVALID_INDEX;
+    return iter->second;
+}
+
+//
+size_t VertexNameTable::getMemSize() const
+{
+    return m_blockBytes + 
+           m_names.capacity() * sizeof(const char*) +
+           m_index.size() * sizeof(std::pair<const char*, VertexIdx>);
+}
+
+//
+const char* VertexNameTable::storeName(const VertexID& name)
+{
+    size_t len = name.size() + 1;
+    char* pOut;
+    if(len > BLOCK_SIZE)
+    {
+        // Oversized names get their own block. The current
+        // block stays open for the following names.
+        pOut = new char[len];
+        m_blocks.push_back(pOut);
+        m_blockBytes += len;
+    }
+    else
+    {
+        if(m_blockUsed + len > BLOCK_SIZE)
+        {
+            m_pCurrBlock = new char[BLOCK_SIZE];
+            m_blocks.push_back(m_pCurrBlock);
+            m_blockUsed = 0;
+            m_blockBytes += BLOCK_SIZE;
+        }
+        pOut = m_pCurrBlock + m_blockUsed;
+        m_blockUsed += len;
+    }
+    memcpy(pOut, name.c_str(), len);
+    return pOut;
+}
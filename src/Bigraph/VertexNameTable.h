@@ -0,0 +1,80 @@
+//-----------------------------------------------
+// Copyright 2010 Wellcome Trust Sanger Institute
+// Written by Jared Simpson (js18@sanger.ac.uk)
+// Released under the GPL
+//-----------------------------------------------
+//
+// VertexNameTable - Map the names of the vertices
+// of a graph to dense integer indices. The names
+// are copied once into large character blocks which
+// are never moved, so a pointer to a name remains
+// valid for the lifetime of the table.
+//
+#ifndef VERTEXNAMETABLE_H
+#define VERTEXNAMETABLE_H
+
+#include <string.h>
+#include <vector>
+#include "GraphCommon.h"
+#include "HashMap.h"
+
+class VertexNameTable
+{
+    public:
+
+        static const VertexIdx INVALID_INDEX = 0xFFFFFFFF;
+
+        VertexNameTable();
+        ~VertexNameTable();
+
+        // Return the index of name, adding it to the table if it is not present
+        VertexIdx add(const VertexID& name);
+
+        // Return the index of name or INVALID_INDEX if it is not in the table
+        VertexIdx find(const VertexID& name) const;
+
+        // Return the name with the given index
+        const char* getName(VertexIdx idx) const { return m_names[idx]; }
+
+        size_t size() const { return m_names.size(); }
+        size_t getMemSize() const;
+
+    private:
+
+        // Names are hashed and compared by their characters, not their address
+        struct NameHasher
+        {
+            size_t operator()(const char* s) const
+            {
+                size_t h = 0;
+                for(; *s != '\0'; ++s)
+                    h = 5 * h + *s;
+                return h;
+            }
+        };
+
+        struct NameEqual
+        {
+            bool operator()(const char* a, const char* b) const { return strcmp(a, b) == 0; }
+        };
+
+        typedef SparseHashMap<const char*, VertexIdx, NameHasher, NameEqual> NameIndexMap;
+
+        // Not copyable, the index refers to the blocks of this table
+        VertexNameTable(const VertexNameTable&);
+        VertexNameTable& operator=(const VertexNameTable&);
+
+        // Copy name into the blocks and return a pointer to the copy
+        const char* storeName(const VertexID& name);
+
+        static const size_t BLOCK_SIZE = 1 << 20;
+
+        std::vector<const char*> m_names;
+        NameIndexMap m_index;
+        std::vector<char*> m_blocks;
+        char* m_pCurrBlock;
+        size_t m_blockUsed;
+        size_t m_blockBytes;
+};
+
+#endif
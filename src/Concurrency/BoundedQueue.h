@@ -0,0 +1,107 @@
+///-----------------------------------------------
+// Copyright 2010 Wellcome Trust Sanger Institute
+// Written by Jared Simpson (js18@sanger.ac.uk)
+// Released under the GPL
+//-----------------------------------------------
+//
+// BoundedQueue - Fixed-capacity blocking FIFO used
+// to connect the stages of a threaded pipeline.
+// push() blocks while the queue is full and pop()
+// blocks while it is empty.
+//
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <queue>
+#include <iostream>
+#include <cstdlib>
+#include <cassert>
+
+template<typename T>
+class BoundedQueue
+{
+    public:
+        BoundedQueue(size_t capacity);
+        ~BoundedQueue();
+
+        // Add an item to the back of the queue, waiting for a free slot if necessary
+        void push(const T& item);
+
+        // Remove the item at the front of the queue, waiting for one to be available if necessary
+        T pop();
+
+        size_t getCapacity() const { return m_capacity; }
+
+    private:
+
+        // Not copyable
+        BoundedQueue(const BoundedQueue&);
+        BoundedQueue& operator=(const BoundedQueue&);
+
+        std::queue<T> m_queue;
+        size_t m_capacity;
+
+        pthread_mutex_t m_mutex;
+
+        // Counts the number of empty slots/available items
+        sem_t m_slotSem;
+        sem_t m_itemSem;
+};
+
+//
+template<typename T>
+BoundedQueue<T>::BoundedQueue(size_t capacity) : m_capacity(capacity)
+{
+    assert(capacity > 0);
+    sem_init( &m_slotSem, PTHREAD_PROCESS_PRIVATE, capacity );
+    sem_init( &m_itemSem, PTHREAD_PROCESS_PRIVATE, 0 );
+    int ret = pthread_mutex_init(&m_mutex, NULL);
+    if(ret != 0)
+    {
+        std::cerr << "Mutex initialization failed with error " << ret << ", aborting" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+}
+
+//
+template<typename T>
+BoundedQueue<T>::~BoundedQueue()
+{
+    sem_destroy(&m_slotSem);
+    sem_destroy(&m_itemSem);
+    int ret = pthread_mutex_destroy(&m_mutex);
+    if(ret != 0)
+    {
+        std::cerr << "Mutex destruction failed with error " << ret << ", aborting" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+}
+
+//
+template<typename T>
+void BoundedQueue<T>::push(const T& item)
+{
+    sem_wait(&m_slotSem);
+    pthread_mutex_lock(&m_mutex);
+    m_queue.push(item);
+    pthread_mutex_unlock(&m_mutex);
+    sem_post(&m_itemSem);
+}
+
+//
+template<typename T>
+T BoundedQueue<T>::pop()
+{
+    sem_wait(&m_itemSem);
+    pthread_mutex_lock(&m_mutex);
+    assert(!m_queue.empty());
+    T item = m_queue.front();
+    m_queue.pop();
+    pthread_mutex_unlock(&m_mutex);
+    sem_post(&m_slotSem);
+    return item;
+}
+
+#endif
@@ -4,11 +4,13 @@
 // Released under the GPL
 //-----------------------------------------------
 //
-// Implementation of a multikey quicksort worker thread
+// Implementation of a multikey quicksort worker thread.
+// The worker is run as a task on the ThreadPool.
 //
 #include <pthread.h>
 #include <semaphore.h>
 #include "mkqs.h"
+#include "ThreadPool.h"
 
 // 
 template<typename T>
@@ -22,7 +24,7 @@ struct MkqsJob
 
 //
 template<typename T, class PrimarySorter, class FinalSorter>
-class MkqsThread
+class MkqsThread : public PoolTask
 {
     typedef MkqsJob<T> Job;
     typedef std::queue<Job> JobQueue;
@@ -43,15 +45,13 @@ class MkqsThread
                                                       m_numProcessed(0) {}
         ~MkqsThread();
 
-        void start();
         void stop();
-        void join();
 
-        static void* startThread(void* obj);
+        // Main work loop
+        void run();
 
     private:
 
-        void run();
         void process(Job& job);
 
         // Data
@@ -65,7 +65,6 @@ class MkqsThread
         const PrimarySorter* m_pPrimary;
         const FinalSorter* m_pFinal;
 
-        pthread_t m_thread;
         volatile bool m_stopRequested;
         int m_numProcessed;
 };
@@ -76,18 +75,6 @@ MkqsThread<T, PrimarySorter, FinalSorter>::~MkqsThread()
 {
 }
 
-// Start thread
-template<typename T, class PrimarySorter, class FinalSorter>
-void MkqsThread<T, PrimarySorter, FinalSorter>::start()
-{
-    int ret = pthread_create(&m_thread, 0, &MkqsThread<T, PrimarySorter, FinalSorter>::startThread, this);
-    if(ret != 0)
-    {
-        std::cerr << "Thread creation failed with error " << ret << ", aborting" << std::endl;
-        exit(EXIT_FAILURE);
-    }
-}
-
 // Stop thread
 template<typename T, class PrimarySorter, class FinalSorter>
 void MkqsThread<T, PrimarySorter, FinalSorter>::stop()
@@ -95,18 +82,6 @@ void MkqsThread<T, PrimarySorter, FinalSorter>::stop()
     m_stopRequested = true;
 }
 
-// Called from the external main function, joins the thread to the main on exit
-template<typename T, class PrimarySorter, class FinalSorter>
-void MkqsThread<T, PrimarySorter, FinalSorter>::join()
-{
-    int ret = pthread_join(m_thread, NULL);
-    if(ret != 0)
-    {
-        std::cerr << "Thread join failed with error " << ret << ", aborting" << std::endl;
-        exit(EXIT_FAILURE);
-    }
-}
-
 // Run thread
 template<typename T, class PrimarySorter, class FinalSorter>
 void MkqsThread<T, PrimarySorter, FinalSorter>::run()
@@ -118,9 +93,7 @@ void MkqsThread<T, PrimarySorter, FinalSorter>::run()
         
         // Exit if the thread was stopped
         if(m_stopRequested)
-        {
-            pthread_exit(NULL);
-        }
+            return;
 
         // Take an item from the queue and process it
         pthread_mutex_lock(m_pQueueMutex);
@@ -150,11 +123,3 @@ void MkqsThread<T, PrimarySorter, FinalSorter>::run()
         m_numProcessed += 1;
     }
 }
-
-// Thread entry point
-template<typename T, class PrimarySorter, class FinalSorter>
-void* MkqsThread<T, PrimarySorter, FinalSorter>::startThread(void* obj)
-{
-    reinterpret_cast<MkqsThread*>(obj)->run();
-    return NULL;
-}
@@ -34,3 +34,102 @@ OverlapResult RmdupProcess::process(const SequenceWorkItem& workItem)
     m_blockList.clear();
     return result;
 }
+
+//
+//
+//
+RmdupDecisionProcess::RmdupDecisionProcess(const OverlapAlgorithm* pOverlapper,
+                                           const ReadInfoTable* pRIT,
+                                           const SuffixArray* pFwdSAI,
+                                           const SuffixArray* pRevSAI) : m_pOverlapper(pOverlapper),
+                                                                         m_pRIT(pRIT),
+                                                                         m_pFwdSAI(pFwdSAI),
+                                                                         m_pRevSAI(pRevSAI)
+{
+
+}
+
+// This applies the same rules as OverlapCommon::parseHitsString
+// without writing the blocks to a hits file and parsing them back
+RmdupResult RmdupDecisionProcess::process(const SequenceWorkItem& workItem)
+{
+    RmdupResult result;
+    OverlapResult overlapResult = m_pOverlapper->alignReadDuplicate(workItem.read, &m_blockList);
+    result.isSubstring = overlapResult.isSubstring;
+
+    const ReadInfo queryInfo = m_pRIT->getReadInfo(workItem.idx);
+    for(OverlapBlockList::const_iterator iter = m_blockList.begin(); iter != m_blockList.end(); ++iter)
+    {
+        const SuffixArray* pCurrSAI = (iter->flags.isTargetRev()) ? m_pRevSAI : m_pFwdSAI;
+        for(int64_t j = iter->ranges.interval[0].lower; j <= iter->ranges.interval[0].upper; ++j)
+        {
+            // The index of the second read is given as the position in the SuffixArray index
+            const ReadInfo targetInfo = m_pRIT->getReadInfo(pCurrSAI->get(j).getID());
+
+            // Skip self alignments
+            if(queryInfo.id == targetInfo.id)
+                continue;
+
+            // Skip the overlaps that would be reported again from the other read
+            Overlap o = iter->toOverlap(queryInfo.id, targetInfo.id, queryInfo.length, targetInfo.length);
+            if(o.id[0] < o.id[1] || (o.match.isContainment() && iter->flags.isQueryRev()))
+                continue;
+
+            result.numOverlaps += 1;
+            if(o.isContainment() && o.getContainedIdx() == 0)
+                result.isContained = true;
+        }
+    }
+    m_blockList.clear();
+    return result;
+}
+
+//
+RmdupDecisionPostProcess::RmdupDecisionPostProcess(std::ostream* pWriter, 
+                                                   std::ostream* pDupWriter) : m_pWriter(pWriter),
+                                                                               m_pDupWriter(pDupWriter),
+                                                                               m_substringRemoved(0),
+                                                                               m_identicalRemoved(0),
+                                                                               m_kept(0)
+{
+
+}
+
+//
+RmdupDecisionPostProcess::~RmdupDecisionPostProcess()
+{
+    printf("[sga::rmdup] Removed %zu substring reads\n", m_substringRemoved);
+    printf("[sga::rmdup] Removed %zu identical reads\n", m_identicalRemoved);
+    printf("[sga::rmdup] Kept %zu reads\n", m_kept);
+}
+
+//
+void RmdupDecisionPostProcess::process(const SequenceWorkItem& item, const RmdupResult& result)
+{
+    SeqItem outItem = {item.read.id, item.read.seq};
+    if(result.isSubstring || result.isContained)
+    {
+        if(result.isSubstring)
+            ++m_substringRemoved;
+        else
+            ++m_identicalRemoved;
+
+        // The read's index in the sequence data base
+        // is needed when removing it from the FM-index.
+        // In the output fasta, we set the reads ID to be the index
+        // and record its old id in the fasta header.
+        std::stringstream newID;
+        newID << item.read.id << ",seqrank=" << item.idx;
+        outItem.id = newID.str();
+
+        // Write some metadata with the fasta record
+        std::stringstream meta;
+        meta << item.read.id << " NumOverlaps: " << result.numOverlaps;
+        outItem.write(*m_pDupWriter, meta.str());
+    }
+    else
+    {
+        ++m_kept;
+        outItem.write(*m_pWriter);
+    }
+}
@@ -13,6 +13,8 @@
 #include "Util.h"
 #include "OverlapAlgorithm.h"
 #include "SequenceProcessFramework.h"
+#include "ReadInfoTable.h"
+#include "SuffixArray.h"
 
 // Compute the overlap blocks for reads
 class RmdupProcess
@@ -39,4 +41,52 @@ class RmdupPostProcess
         void process(const SequenceWorkItem& /*item*/, const OverlapResult& /*result*/) {}
 };
 
+// The keep/remove decision for a single read
+struct RmdupResult
+{
+    RmdupResult() : isSubstring(false), isContained(false), numOverlaps(0) {}
+
+    bool isSubstring;
+    bool isContained;
+    size_t numOverlaps;
+};
+
+// Decide whether each read is a duplicate directly from its overlap blocks.
+// The table and suffix array indices are shared by all threads
+class RmdupDecisionProcess
+{
+    public:
+        RmdupDecisionProcess(const OverlapAlgorithm* pOverlapper,
+                             const ReadInfoTable* pRIT,
+                             const SuffixArray* pFwdSAI,
+                             const SuffixArray* pRevSAI);
+
+        RmdupResult process(const SequenceWorkItem& item);
+
+    private:
+        OverlapBlockList m_blockList;
+        const OverlapAlgorithm* m_pOverlapper;
+        const ReadInfoTable* m_pRIT;
+        const SuffixArray* m_pFwdSAI;
+        const SuffixArray* m_pRevSAI;
+};
+
+// Write the kept reads and the duplicates in input order
+class RmdupDecisionPostProcess
+{
+    public:
+        RmdupDecisionPostProcess(std::ostream* pWriter, std::ostream* pDupWriter);
+        ~RmdupDecisionPostProcess();
+
+        void process(const SequenceWorkItem& item, const RmdupResult& result);
+
+    private:
+        std::ostream* m_pWriter;
+        std::ostream* m_pDupWriter;
+
+        size_t m_substringRemoved;
+        size_t m_identicalRemoved;
+        size_t m_kept;
+};
+
 #endif
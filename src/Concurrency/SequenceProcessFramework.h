@@ -7,9 +7,15 @@
 // SequenceProcessFramework - Generic framework for performing
 // some operations on all sequneces in a file, serially or in parallel
 //
+#include <map>
+#include <set>
+#include <sstream>
+#include <algorithm>
 #include "ThreadWorker.h"
+#include "SequenceReaderThread.h"
 #include "Timer.h"
 #include "SequenceWorkItem.h"
+#include "BWTAlgorithms.h"
 
 #ifndef SEQUENCEPROCESSFRAMEWORK_H
 #define SEQUENCEPROCESSFRAMEWORK_H
@@ -19,15 +25,24 @@ namespace SequenceProcessFramework
 
 const size_t BUFFER_SIZE = 1000;
 
+// The number of batches in flight per worker thread in the parallel pipeline
+const size_t BATCHES_PER_THREAD = 3;
+
 // Process n sequences from a file. With the default value of -1, n becomes the largest value representable for
-// a size_t and all values will be read
+// a size_t and all values will be read. If start is given, the first start sequences are read
+// but not processed so only the sequences with index in [start, n) are processed. The work items keep
+// their index in the file. The number of sequences processed is returned.
 template<class Input, class Output, class Processor, class PostProcessor>
-size_t processSequencesSerial(SeqReader& reader, Processor* pProcessor, PostProcessor* pPostProcessor, size_t n = -1)
+size_t processSequencesSerial(SeqReader& reader, Processor* pProcessor, PostProcessor* pPostProcessor, 
+                              size_t n = -1, size_t start = 0)
 {
     Timer timer("SequenceProcess", true);
 
     WorkItemGenerator<Input> generator(&reader);
     Input workItem;
+
+    // Skip the sequences before the start of the range
+    while(generator.getNumConsumed() < start && generator.generate(workItem)) {}
     
     // Generate work items using the generic generation class while the number
     // of sequences consumed from the SeqReader is less than n and there 
@@ -44,176 +59,291 @@ size_t processSequencesSerial(SeqReader& reader, Processor* pProcessor, PostProc
     assert(n == (size_t)-1 || generator.getNumConsumed() == n);
 
     //
+    size_t numProcessed = generator.getNumConsumed() > start ? generator.getNumConsumed() - start : 0;
     double proc_time_secs = timer.getElapsedWallTime();
     printf("[sga::process] processed %zu sequences in %lfs (%lf sequences/s)\n", 
-            generator.getNumConsumed(), proc_time_secs, (double)generator.getNumConsumed() / proc_time_secs);    
+            numProcessed, proc_time_secs, (double)numProcessed / proc_time_secs);    
     
-    return generator.getNumConsumed();
+    return numProcessed;
 }
 
 // Framework for performing some processing on every sequence in a file
 template<class Input, class Output, class Processor, class PostProcessor>
-size_t processSequencesSerial(const std::string& readsFile, Processor* pProcessor, PostProcessor* pPostProcessor)
+size_t processSequencesSerial(const std::string& readsFile, Processor* pProcessor, PostProcessor* pPostProcessor,
+                              size_t n = -1, size_t start = 0)
 {
     SeqReader reader(readsFile);
-    return processSequencesSerial<Input, Output, Processor, PostProcessor>(reader, pProcessor, pPostProcessor);
+    return processSequencesSerial<Input, Output, Processor, PostProcessor>(reader, pProcessor, pPostProcessor, n, start);
 }
 
 // Design:
 // This function is a generic function to read in sequences from
 // a file and perform some work on them. The actual processing is done
 // by the Processor class that is passed in. The number of threads
-// created is determined by the size of the vector of processors - 
-// one thread per processor. 
+// used is determined by the size of the vector of processors - 
+// one thread per processor. The threads are taken from the process-wide
+// ThreadPool, the i-th processor is run on the NUMA node returned by
+// ThreadPool::getNodeForWorker(i).
 //
-// The function reads in a batch of sequences from a file and buffers
-// them. Once the buffers are full, the reads are dispatched to the thread
-// which run the actual processing independently. An optional post processor
-// can be specified to process the results that the threads return. If the n
-// parameter is used, at most n sequences will be read from the file
+// The work is organized as a three-stage pipeline. A dedicated reader
+// thread decompresses and parses the input and packs the sequences into
+// batches. The batches are dealt round-robin to the workers through one 
+// bounded queue per worker, so each processor sees the same reads in the
+// same order on every run and per-thread output files, like the overlap hits,
+// are reproducible. The completed batches are passed back to the calling
+// thread, which acts as the writer: it restores the input order and runs the
+// optional post processor on the results. The batches are recycled through
+// a pool of fixed size so the amount of buffered data is bounded and 
+// parsing/post-processing never stall the workers. If the n parameter is used, at most n sequences 
+// will be read from the file. As in processSequencesSerial, the start parameter
+// restricts the processing to the sequences with index in [start, n).
 template<class Input, class Output, class Processor, class PostProcessor>
 size_t processSequencesParallel(SeqReader& reader, 
                                 std::vector<Processor*> processPtrVector, 
                                 PostProcessor* pPostProcessor, 
-                                size_t n = -1)
+                                size_t n = -1,
+                                size_t start = 0)
 {
     Timer timer("SequenceProcess", true);
 
     // Helpful typedefs
     typedef ThreadWorker<Input, Output, Processor> Thread;
     typedef std::vector<Thread*> ThreadPtrVector;
+    typedef SequenceReaderThread<Input, Output> ReaderThread;
 
-    typedef std::vector<Input> InputItemVector;
-    typedef std::vector<InputItemVector*> InputBufferVector;
-
-    typedef std::vector<Output> OutputVector;
-    typedef std::vector<OutputVector*> OutputBufferVector;
-    typedef std::vector<sem_t*> SemaphorePtrVector;
-
-    typedef WorkItemGenerator<Input> InputGenerator;
+    typedef WorkItemBatch<Input, Output> Batch;
+    typedef BoundedQueue<Batch*> BatchQueue;
+    typedef std::map<size_t, Batch*> BatchMap;
 
     // Initialize threads, one thread per processor that was passed in
     int numThreads = processPtrVector.size();
+    size_t numBatches = BATCHES_PER_THREAD * numThreads;
 
-    ThreadPtrVector threadVec(numThreads);
-    InputBufferVector inputBuffers(numThreads);
-    OutputBufferVector outputBuffers(numThreads);
-    SemaphorePtrVector semVec(numThreads);
-
-    // Create the threads
+    // Create the queues connecting the stages. The work and output queues
+    // have room for every batch plus the end-of-input markers
+    // so only the free queue ever blocks the reader
+    BatchQueue freeQueue(numBatches);
+    std::vector<BatchQueue*> workQueues(numThreads);
     for(int i = 0; i < numThreads; ++i)
-    {
-        semVec[i] = new sem_t;
-        sem_init( semVec[i], PTHREAD_PROCESS_PRIVATE, 0 );
+        workQueues[i] = new BatchQueue(numBatches + 1);
+    BatchQueue outputQueue(numBatches + numThreads);
 
-        // Create and start the thread
-        threadVec[i] = new Thread(semVec[i], processPtrVector[i], BUFFER_SIZE);
-        threadVec[i]->start();
+    std::vector<Batch*> batches(numBatches);
+    for(size_t i = 0; i < numBatches; ++i)
+    {
+        batches[i] = new Batch;
+        batches[i]->inputs.reserve(BUFFER_SIZE);
+        batches[i]->outputs.reserve(BUFFER_SIZE);
+        freeQueue.push(batches[i]);
+    }
 
-        inputBuffers[i] = new InputItemVector;
-        inputBuffers[i]->reserve(BUFFER_SIZE);
+    // Start the workers and the reader on the pool
+    ThreadPool& pool = ThreadPool::getInstance();
+    TaskGroup taskGroup;
 
-        outputBuffers[i] = new OutputVector;
-        outputBuffers[i]->reserve(BUFFER_SIZE);
+    ThreadPtrVector threadVec(numThreads);
+    for(int i = 0; i < numThreads; ++i)
+    {
+        threadVec[i] = new Thread(workQueues[i], &outputQueue, processPtrVector[i]);
+        pool.submit(threadVec[i], &taskGroup, pool.getNodeForWorker(i));
     }
 
-    size_t numWorkItemsRead = 0;
+    ReaderThread readerThread(&reader, &freeQueue, workQueues, BUFFER_SIZE, start, n);
+    pool.submit(&readerThread, &taskGroup);
+
+    // Post-process the completed batches in input order. Batches that 
+    // complete out of order are held until their predecessors arrive
     size_t numWorkItemsWrote = 0;
-    bool done = false;
-    int next_thread = 0;
-    int num_buffers_full = 0;
+    size_t nextReportCount = 50 * BUFFER_SIZE * numThreads;
+    size_t nextBatchID = 0;
+    int numThreadsFinished = 0;
+    BatchMap pendingBatches;
 
-    InputGenerator generator(&reader);
-    while(!done)
+    while(numThreadsFinished < numThreads)
     {
-        // Parse reads from the stream and add them into the incoming buffers
-        Input workItem;
-        bool valid = generator.generate(workItem);
-        if(valid)
+        Batch* pBatch = outputQueue.pop();
+        if(pBatch == NULL)
         {
-            inputBuffers[next_thread]->push_back(workItem);
-            numWorkItemsRead += 1;
+            ++numThreadsFinished;
+            continue;
+        }
 
-            // Change buffers if this one is full
-            if(inputBuffers[next_thread]->size() == BUFFER_SIZE)
+        pendingBatches.insert(std::make_pair(pBatch->id, pBatch));
+
+        typename BatchMap::iterator iter = pendingBatches.begin();
+        while(iter != pendingBatches.end() && iter->first == nextBatchID)
+        {
+            Batch* pNext = iter->second;
+            assert(pNext->inputs.size() == pNext->outputs.size());
+            for(size_t j = 0; j < pNext->inputs.size(); ++j)
             {
-                ++num_buffers_full;
-                ++next_thread;
+                pPostProcessor->process(pNext->inputs[j], pNext->outputs[j]);
+                ++numWorkItemsWrote;
             }
-        }
-        
-        done = !valid || generator.getNumConsumed() == n;
 
-        // Once all buffers are full or the input is finished, dispatch the reads to the threads
-        // by swapping work buffers. 
-        if(num_buffers_full == numThreads || done)
-        {
-            int numLoops = 0;
-            do
+            pNext->inputs.clear();
+            pNext->outputs.clear();
+            freeQueue.push(pNext);
+
+            pendingBatches.erase(iter++);
+            ++nextBatchID;
+
+            if(numWorkItemsWrote >= nextReportCount)
             {
-                // Wait for all threads to be ready to receive
-                for(int i = 0; i < numThreads; ++i)
-                {
-                    sem_wait(semVec[i]);
-                    Thread* pThread = threadVec[i];
-                    pThread->swapBuffers(*inputBuffers[i], *outputBuffers[i]);
-                }
-                num_buffers_full = 0;
-                next_thread = 0;
-
-                // Process the results and clear the buffers
-                for(int i = 0; i < numThreads; ++i)
-                {
-                    assert(inputBuffers[i]->size() == outputBuffers[i]->size());
-                    for(size_t j = 0; j < inputBuffers[i]->size(); ++j)
-                    {
-                        pPostProcessor->process((*inputBuffers[i])[j], (*outputBuffers[i])[j]);
-                        ++numWorkItemsWrote;
-                    }
-                    
-                    inputBuffers[i]->clear();
-                    outputBuffers[i]->clear();
-                }
-
-                if(generator.getNumConsumed() % (50 * BUFFER_SIZE * numThreads) == 0)
-                    printf("[sga] Processed %zu sequences\n", generator.getNumConsumed());
-
-                // This should never loop more than twice
-                assert(numLoops < 2);
-                ++numLoops;
-            } while(done && numWorkItemsWrote < numWorkItemsRead);
+                printf("[sga] Processed %zu sequences\n", numWorkItemsWrote);
+                nextReportCount += 50 * BUFFER_SIZE * numThreads;
+            }
         }
     }
 
     // Cleanup
+    taskGroup.wait(); // Blocks until the reader and workers have finished
     for(int i = 0; i < numThreads; ++i)
     {
-        threadVec[i]->stop(); // Blocks until the thread joins
         delete threadVec[i];
+        delete workQueues[i];
+    }
+
+    assert(pendingBatches.empty());
+    for(size_t i = 0; i < numBatches; ++i)
+    {
+        assert(batches[i]->inputs.empty() && batches[i]->outputs.empty());
+        delete batches[i];
+    }
+
+    size_t numProcessed = readerThread.getNumGenerated();
+    assert(n == (size_t)-1 || readerThread.getNumConsumed() == n);
+    assert(numProcessed == numWorkItemsWrote);
+
+    double proc_time_secs = timer.getElapsedWallTime();
+    printf("[sga::process] processed %zu sequences in %lfs (%lf sequences/s)\n", 
+            numProcessed, proc_time_secs, (double)numProcessed / proc_time_secs);
+    return numProcessed;
+}
 
-        sem_destroy(semVec[i]);
-        delete semVec[i];
+// Pool task that processes blocks of BUFFER_SIZE items of a vector of work items.
+// The tasks take blocks from a shared counter until every item has been processed
+template<class Input, class Output, class Processor>
+class WorkItemVectorTask : public PoolTask
+{
+    public:
+        WorkItemVectorTask(const std::vector<Input>* pItems, std::vector<Output>* pOutputs,
+                           Processor* pProcessor, size_t* pNextBlock) : m_pItems(pItems),
+                                                                        m_pOutputs(pOutputs),
+                                                                        m_pProcessor(pProcessor),
+                                                                        m_pNextBlock(pNextBlock) {}
+
+        void run()
+        {
+            size_t n = m_pItems->size();
+            size_t block;
+            while((block = __sync_fetch_and_add(m_pNextBlock, 1)) * BUFFER_SIZE < n)
+            {
+                size_t end = std::min((block + 1) * BUFFER_SIZE, n);
+                for(size_t i = block * BUFFER_SIZE; i < end; ++i)
+                    (*m_pOutputs)[i] = m_pProcessor->process((*m_pItems)[i]);
+            }
+        }
+
+    private:
+        const std::vector<Input>* m_pItems;
+        std::vector<Output>* m_pOutputs;
+        Processor* m_pProcessor;
+        size_t* m_pNextBlock;
+};
+
+// Process work items that are already in memory, storing the output of
+// the i-th item in outputs[i]. One thread is used per processor, as in
+// processSequencesParallel. No post-processing is done, the caller is free
+// to visit the outputs in any order. The number of items processed is returned.
+template<class Input, class Output, class Processor>
+size_t processWorkItems(const std::vector<Input>& items, std::vector<Processor*> processPtrVector, std::vector<Output>& outputs)
+{
+    Timer timer("SequenceProcess", true);
+    outputs.resize(items.size());
 
-        assert(inputBuffers[i]->empty());
-        delete inputBuffers[i];
+    int numThreads = processPtrVector.size();
+    size_t nextBlock = 0;
+    std::vector<WorkItemVectorTask<Input, Output, Processor>*> tasks(numThreads);
+    for(int i = 0; i < numThreads; ++i)
+        tasks[i] = new WorkItemVectorTask<Input, Output, Processor>(&items, &outputs, processPtrVector[i], &nextBlock);
 
-        assert(outputBuffers[i]->empty());
-        delete outputBuffers[i];
+    if(numThreads <= 1)
+    {
+        tasks.front()->run();
+    }
+    else
+    {
+        ThreadPool& pool = ThreadPool::getInstance();
+        TaskGroup taskGroup;
+        for(int i = 0; i < numThreads; ++i)
+            pool.submit(tasks[i], &taskGroup, pool.getNodeForWorker(i));
+        taskGroup.wait();
     }
-    assert(n == (size_t)-1 || generator.getNumConsumed() == n);
-    assert(numWorkItemsRead == numWorkItemsWrote);
+
+    for(int i = 0; i < numThreads; ++i)
+        delete tasks[i];
 
     double proc_time_secs = timer.getElapsedWallTime();
     printf("[sga::process] processed %zu sequences in %lfs (%lf sequences/s)\n", 
-            generator.getNumConsumed(), proc_time_secs, (double)generator.getNumConsumed() / proc_time_secs);
-    return generator.getNumConsumed();
+            items.size(), proc_time_secs, (double)items.size() / proc_time_secs);
+    return items.size();
+}
+
+// Process a uniformly random sample of numSamples of the reads in an FM-index
+// instead of the reads in a file. The reads are drawn without replacement using
+// Floyd's algorithm and are extracted from pBWT, so the reads file is not read 
+// and the run time depends on the size of the sample only. The index of a read 
+// in the FM-index is its index in the reads file. It is used as the index and
+// the name of the work item. If numSamples is at least the number of reads, 
+// every read is processed. The outputs are post-processed in increasing order
+// of the read index. The number of reads processed is returned.
+template<class Output, class Processor, class PostProcessor>
+size_t processSequencesSampled(const BWT* pBWT, size_t numSamples, unsigned int seed,
+                               std::vector<Processor*> processPtrVector, PostProcessor* pPostProcessor)
+{
+    size_t numStrings = pBWT->getNumStrings();
+    std::vector<size_t> indices;
+    if(numSamples >= numStrings)
+    {
+        for(size_t i = 0; i < numStrings; ++i)
+            indices.push_back(i);
+    }
+    else
+    {
+        std::set<size_t> chosen;
+        for(size_t j = numStrings - numSamples; j < numStrings; ++j)
+        {
+            size_t r = (((size_t)rand_r(&seed) << 31) | rand_r(&seed)) % (j + 1);
+            if(!chosen.insert(r).second)
+                chosen.insert(j);
+        }
+        indices.assign(chosen.begin(), chosen.end());
+    }
+
+    std::vector<SequenceWorkItem> items(indices.size());
+    for(size_t i = 0; i < indices.size(); ++i)
+    {
+        std::stringstream name;
+        name << indices[i];
+        items[i].idx = indices[i];
+        items[i].read.id = name.str();
+        items[i].read.seq = BWTAlgorithms::extractString(pBWT, indices[i]);
+    }
+
+    std::vector<Output> outputs;
+    processWorkItems(items, processPtrVector, outputs);
+    for(size_t i = 0; i < items.size(); ++i)
+        pPostProcessor->process(items[i], outputs[i]);
+    return items.size();
 }
 
 template<class Input, class Output, class Processor, class PostProcessor>
-size_t processSequencesParallel(const std::string& readsFile, std::vector<Processor*> processPtrVector, PostProcessor* pPostProcessor)
+size_t processSequencesParallel(const std::string& readsFile, std::vector<Processor*> processPtrVector, PostProcessor* pPostProcessor,
+                                size_t n = -1, size_t start = 0)
 {
     SeqReader reader(readsFile);
-    return processSequencesParallel<Input, Output, Processor, PostProcessor>(reader, processPtrVector, pPostProcessor);
+    return processSequencesParallel<Input, Output, Processor, PostProcessor>(reader, processPtrVector, pPostProcessor, n, start);
 }
 
 };
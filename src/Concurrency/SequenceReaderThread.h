@@ -0,0 +1,125 @@
+///-----------------------------------------------
+// Copyright 2010 Wellcome Trust Sanger Institute
+// Written by Jared Simpson (js18@sanger.ac.uk)
+// Released under the GPL
+//-----------------------------------------------
+//
+// SequenceReaderThread - Input stage of the parallel
+// sequence processing pipeline. The thread decompresses
+// and parses the input file, packs the work items into
+// batches taken from a pool of free batches and passes
+// the full batches on to the worker threads. Batch i goes
+// to worker i % numWorkers so the reads each worker sees
+// do not depend on scheduling. The reader is run as a task
+// on the ThreadPool.
+//
+#ifndef SEQUENCEREADERTHREAD_H
+#define SEQUENCEREADERTHREAD_H
+
+#include "ThreadPool.h"
+#include "BoundedQueue.h"
+#include "SequenceWorkItem.h"
+
+template<class Input, class Output>
+class SequenceReaderThread : public PoolTask
+{
+    typedef WorkItemBatch<Input, Output> Batch;
+    typedef BoundedQueue<Batch*> BatchQueue;
+
+    public:
+        SequenceReaderThread(SeqReader* pReader,
+                             BatchQueue* pFreeQueue,
+                             const std::vector<BatchQueue*>& workQueues,
+                             size_t batchSize,
+                             size_t start,
+                             size_t n);
+
+        // Main work loop
+        void run();
+
+        // The total number of sequences consumed from the reader and 
+        // the number passed on to the workers. Only valid after the task has finished
+        size_t getNumConsumed() const { return m_numConsumed; }
+        size_t getNumGenerated() const { return m_numGenerated; }
+
+    private:
+
+        SeqReader* m_pReader;
+        BatchQueue* m_pFreeQueue;
+        std::vector<BatchQueue*> m_workQueues;
+        size_t m_batchSize;
+        size_t m_startItem;
+        size_t m_maxItems;
+        size_t m_numConsumed;
+        size_t m_numGenerated;
+};
+
+//
+template<class Input, class Output>
+SequenceReaderThread<Input, Output>::SequenceReaderThread(SeqReader* pReader,
+                                                          BatchQueue* pFreeQueue,
+                                                          const std::vector<BatchQueue*>& workQueues,
+                                                          size_t batchSize,
+                                                          size_t start,
+                                                          size_t n) : m_pReader(pReader),
+                                                                      m_pFreeQueue(pFreeQueue),
+                                                                      m_workQueues(workQueues),
+                                                                      m_batchSize(batchSize),
+                                                                      m_startItem(start),
+                                                                      m_maxItems(n),
+                                                                      m_numConsumed(0),
+                                                                      m_numGenerated(0)
+{
+
+}
+
+// Main reader loop
+template<class Input, class Output>
+void SequenceReaderThread<Input, Output>::run()
+{
+    WorkItemGenerator<Input> generator(m_pReader);
+
+    // Skip the sequences before the start of the range
+    Input skipItem;
+    while(generator.getNumConsumed() < m_startItem && generator.generate(skipItem)) {}
+
+    size_t batchID = 0;
+    bool done = false;
+    while(!done)
+    {
+        // Wait for the writer to release a batch
+        Batch* pBatch = m_pFreeQueue->pop();
+        assert(pBatch->inputs.empty() && pBatch->outputs.empty());
+        pBatch->id = batchID;
+
+        Input workItem;
+        while(pBatch->inputs.size() < m_batchSize)
+        {
+            if(generator.getNumConsumed() == m_maxItems || !generator.generate(workItem))
+            {
+                done = true;
+                break;
+            }
+            pBatch->inputs.push_back(workItem);
+        }
+
+        if(!pBatch->inputs.empty())
+        {
+            m_numGenerated += pBatch->inputs.size();
+            m_workQueues[batchID % m_workQueues.size()]->push(pBatch);
+            ++batchID;
+        }
+        else
+        {
+            m_pFreeQueue->push(pBatch);
+        }
+    }
+
+    m_numConsumed = generator.getNumConsumed();
+
+    // Signal the end of the input to each worker
+    for(size_t i = 0; i < m_workQueues.size(); ++i)
+        m_workQueues[i]->push(NULL);
+}
+
+#endif
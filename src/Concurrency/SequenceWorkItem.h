@@ -26,6 +26,19 @@ struct SequenceWorkItemPair
     SequenceWorkItem second;
 };
 
+// A batch of work items that is passed between the stages 
+// of the parallel processing pipeline. The id is the position
+// of the batch in the input stream and is used to restore
+// the input order before post-processing
+template<class INPUT, class OUTPUT>
+struct WorkItemBatch
+{
+    WorkItemBatch() : id(0) {}
+    size_t id;
+    std::vector<INPUT> inputs;
+    std::vector<OUTPUT> outputs;
+};
+
 // Genereic class to generate work items 
 template<class INPUT>
 class WorkItemGenerator
@@ -0,0 +1,104 @@
+//-----------------------------------------------
+// Copyright 2010 Wellcome Trust Sanger Institute
+// Written by Jared Simpson (js18@sanger.ac.uk)
+// Released under the GPL
+//-----------------------------------------------
+//
+// ShardCommon - Support for splitting a job over
+// independent processes by read index
+//
+#include <cstdio>
+#include "ShardCommon.h"
+
+#define SHARD_TAG_START ".shard-"
+
+//
+std::string ShardSpec::getTag() const
+{
+    std::stringstream ss;
+    ss << SHARD_TAG_START << index << "-of-" << count;
+    return ss.str();
+}
+
+//
+std::string ShardSpec::tagFilename(const std::string& filename) const
+{
+    if(!isSharded() || filename.empty())
+        return filename;
+
+    // Insert the tag before the last extension, skipping a gzip extension
+    std::string base = filename;
+    std::string gzExt;
+    if(isGzip(base))
+    {
+        gzExt = GZIP_EXT;
+        base = base.substr(0, base.size() - gzExt.size());
+    }
+
+    std::string ext;
+    size_t dotPos = base.find_last_of('.');
+    size_t slashPos = base.find_last_of('/');
+    if(dotPos != std::string::npos && (slashPos == std::string::npos || dotPos > slashPos))
+    {
+        ext = base.substr(dotPos);
+        base = base.substr(0, dotPos);
+    }
+    return base + getTag() + ext + gzExt;
+}
+
+//
+void ShardSpec::getReadRange(size_t numReads, size_t& start, size_t& end) const
+{
+    start = (numReads * index) / count;
+    end = (numReads * (index + 1)) / count;
+}
+
+//
+bool ShardCommon::parseShardSpec(const std::string& str, ShardSpec& spec)
+{
+    int index;
+    int count;
+    char trailing;
+    if(sscanf(str.c_str(), "%d/%d%c", &index, &count, &trailing) != 2)
+        return false;
+
+    if(count <= 0 || index < 0 || index >= count)
+        return false;
+
+    spec.index = index;
+    spec.count = count;
+    return true;
+}
+
+//
+bool ShardCommon::parseShardFilename(const std::string& filename, ShardSpec& spec)
+{
+    std::string name = stripDirectories(filename);
+    size_t tagPos = name.rfind(SHARD_TAG_START);
+    if(tagPos == std::string::npos)
+        return false;
+
+    int index;
+    int count;
+    if(sscanf(name.c_str() + tagPos, SHARD_TAG_START "%d-of-%d", &index, &count) != 2)
+        return false;
+
+    if(count <= 0 || index < 0 || index >= count)
+        return false;
+
+    spec.index = index;
+    spec.count = count;
+    return true;
+}
+
+//
+std::string ShardCommon::stripShardTag(const std::string& filename)
+{
+    ShardSpec spec;
+    if(!parseShardFilename(filename, spec))
+        return filename;
+
+    std::string tag = spec.getTag();
+    size_t tagPos = filename.rfind(tag);
+    return filename.substr(0, tagPos) + filename.substr(tagPos + tag.size());
+}
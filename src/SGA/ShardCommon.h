@@ -0,0 +1,55 @@
+//-----------------------------------------------
+// Copyright 2010 Wellcome Trust Sanger Institute
+// Written by Jared Simpson (js18@sanger.ac.uk)
+// Released under the GPL
+//-----------------------------------------------
+//
+// ShardCommon - Support for splitting a job over
+// independent processes by read index. Shard i of N
+// processes the reads in a contiguous range of read
+// indices and writes its outputs to files tagged with
+// .shard-i-of-N. The outputs are combined with 
+// sga merge-shards.
+//
+#ifndef SHARDCOMMON_H
+#define SHARDCOMMON_H
+
+#include "Util.h"
+
+struct ShardSpec
+{
+    ShardSpec() : index(0), count(1) {}
+
+    bool isSharded() const { return count > 1; }
+
+    // Return the tag for this shard, like .shard-0-of-4
+    std::string getTag() const;
+
+    // Return filename with the shard tag inserted before the extension.
+    // If the job is not sharded or filename is empty, filename is returned unchanged
+    std::string tagFilename(const std::string& filename) const;
+
+    // Calculate the half-open range of read indices [start, end) this shard processes
+    void getReadRange(size_t numReads, size_t& start, size_t& end) const;
+
+    int index;
+    int count;
+};
+
+namespace ShardCommon
+{
+
+// Parse a shard specification of the form i/N, with 0 <= i < N.
+// Returns false if the specification is malformed
+bool parseShardSpec(const std::string& str, ShardSpec& spec);
+
+// Extract the shard from a filename produced by ShardSpec::tagFilename.
+// Returns false if the filename does not contain a shard tag
+bool parseShardFilename(const std::string& filename, ShardSpec& spec);
+
+// Remove the shard tag from a filename
+std::string stripShardTag(const std::string& filename);
+
+};
+
+#endif
@@ -34,6 +34,7 @@ static const char *ASSEMBLE_USAGE_MESSAGE =
 "\n"
 "  -v, --verbose                        display verbose output\n"
 "      --help                           display this help and exit\n"
+"      -t, --threads=NUM                use NUM threads for the graph visits that can run in parallel (default: 1)\n"
 "      -o, --out-prefix=NAME            use NAME as the prefix of the output files (output files will be NAME-contigs.fa, etc)\n"
 "      -m, --min-overlap=LEN            only use overlaps of at least LEN. This can be used to filter\n"
 "                                       the overlap set so that the overlap step only needs to be run once.\n"
@@ -52,11 +53,17 @@ static const char *ASSEMBLE_USAGE_MESSAGE =
 "\nSmall repeat resolution parameters:\n"
 "      -r,--resolve-small=LEN           resolve small repeats using spanning overlaps when the difference between the shortest\n"
 "                                       and longest overlap is greater than LEN (default: not performed)\n"
+"\nCheckpoint parameters:\n"
+"          --checkpoint                 write a binary snapshot of the graph to NAME-STAGE.snapshot after each of the\n"
+"                                       stages contain, transitive, trim, repeats and coverage\n"
+"          --resume-from=STAGE          start the assembly at STAGE (one of transitive, trim, repeats, coverage, smooth).\n"
+"                                       The input file must be a snapshot written by --checkpoint instead of an ASQG file\n"
 "\nReport bugs to " PACKAGE_BUGREPORT "\n\n";
 
 namespace opt
 {
     static unsigned int verbose;
+    static int numThreads = 1;
     static std::string asqgFile;
     static std::string outContigsFile;
     static std::string outVariantsFile;
@@ -81,14 +88,20 @@ namespace opt
     static int coverageCutoff = 0;
     static bool bValidate;
     static bool bExact = true;
+
+    // Checkpoint parameters
+    static bool bCheckpoint = false;
+    static std::string checkpointPrefix;
+    static int resumeStage = 0;
 }
 
-static const char* shortopts = "p:o:m:d:g:b:a:c:r:x:sv";
+static const char* shortopts = "p:o:m:d:g:b:a:c:r:x:t:sv";
 
-enum { OPT_HELP = 1, OPT_VERSION, OPT_VALIDATE, OPT_EDGESTATS, OPT_EXACT, OPT_MAXINDEL };
+enum { OPT_HELP = 1, OPT_VERSION, OPT_VALIDATE, OPT_EDGESTATS, OPT_EXACT, OPT_MAXINDEL, OPT_CHECKPOINT, OPT_RESUME };
 
 static const struct option longopts[] = {
     { "verbose",            no_argument,       NULL, 'v' },
+    { "threads",            required_argument, NULL, 't' },
     { "out-prefix",         required_argument, NULL, 'o' },
     { "min-overlap",        required_argument, NULL, 'm' },
     { "bubble",             required_argument, NULL, 'b' },
@@ -105,6 +118,8 @@ static const struct option longopts[] = {
     { "help",               no_argument,       NULL, OPT_HELP },
     { "version",            no_argument,       NULL, OPT_VERSION },
     { "validate",           no_argument,       NULL, OPT_VALIDATE},
+    { "checkpoint",         no_argument,       NULL, OPT_CHECKPOINT },
+    { "resume-from",        required_argument, NULL, OPT_RESUME },
     { NULL, 0, NULL, 0 }
 };
 
@@ -121,12 +136,89 @@ int assembleMain(int argc, char** argv)
     return 0;
 }
 
+// The stages of the assembly, in the order they are run
+enum AssembleStage
+{
+    AS_CONTAIN,
+    AS_TRANSITIVE,
+    AS_TRIM,
+    AS_REPEATS,
+    AS_COVERAGE,
+    AS_SMOOTH,
+    AS_NUM_STAGES
+};
+
+static const char* STAGE_NAMES[AS_NUM_STAGES] = { "contain", "transitive", "trim", "repeats", "coverage", "smooth" };
+
+// Return the stage with the given name or -1 if there is no such stage
+static int findStage(const std::string& name)
+{
+    for(int i = 0; i < AS_NUM_STAGES; ++i)
+    {
+        if(name == STAGE_NAMES[i])
+            return i;
+    }
+    return -1;
+}
+
+// Returns true if the stage modifies the graph with the current options
+static bool isStageEnabled(int stage)
+{
+    if(stage == AS_REPEATS)
+        return opt::resolveSmallRepeatLen > 0;
+    return true;
+}
+
+// Write a snapshot of the graph after stage has completed
+static void writeCheckpoint(StringGraph* pGraph, AssembleStage stage)
+{
+    if(!opt::bCheckpoint)
+        return;
+
+    std::string filename = opt::checkpointPrefix + "-" + STAGE_NAMES[stage] + ".snapshot";
+    std::cout << "Writing checkpoint to " << filename << "\n";
+    pGraph->writeSnapshot(filename, STAGE_NAMES[stage]);
+}
+
+// Load the graph from a snapshot written before the resume stage
+static StringGraph* loadCheckpoint()
+{
+    std::string tag;
+    StringGraph* pGraph = Bigraph::loadSnapshot(opt::asqgFile, tag);
+    if(pGraph == NULL)
+        exit(EXIT_FAILURE);
+
+    int snapshotStage = findStage(tag);
+    if(snapshotStage < 0 || snapshotStage >= opt::resumeStage)
+    {
+        std::cerr << "Error: the snapshot " << opt::asqgFile << " was written after stage " << tag
+                  << " and cannot be used to resume from stage " << STAGE_NAMES[opt::resumeStage] << "\n";
+        exit(EXIT_FAILURE);
+    }
+
+    for(int i = snapshotStage + 1; i < opt::resumeStage; ++i)
+    {
+        if(isStageEnabled(i))
+            std::cerr << "Warning: stage " << STAGE_NAMES[i] << " is skipped when resuming from the " << tag << " snapshot\n";
+    }
+    return pGraph;
+}
+
 void assemble()
 {
     Timer t("sga assemble");
-    StringGraph* pGraph = SGUtil::loadASQG(opt::asqgFile, opt::minOverlap, true);
-    if(opt::bExact)
-        pGraph->setExactMode(true);
+    StringGraph* pGraph;
+    if(opt::resumeStage == AS_CONTAIN)
+    {
+        pGraph = SGUtil::loadASQG(opt::asqgFile, opt::minOverlap, true);
+        if(opt::bExact)
+            pGraph->setExactMode(true);
+    }
+    else
+    {
+        std::cout << "Resuming from stage " << STAGE_NAMES[opt::resumeStage] << "\n";
+        pGraph = loadCheckpoint();
+    }
     pGraph->printMemSize();
 
     // Visitor functors
@@ -142,72 +234,108 @@ void assemble()
     SGErrorCorrectVisitor errorCorrectVisit;
     SGValidateStructureVisitor validationVisit;
 
-    // Pre-assembly graph stats
-    std::cout << "Initial graph stats\n";
-    pGraph->visit(statsVisit);    
-
-    // Remove containments from the graph
-    std::cout << "Removing contained vertices\n";
-    while(pGraph->hasContainment())
-        pGraph->visit(containVisit);
+    if(opt::resumeStage <= AS_CONTAIN)
+    {
+        // Pre-assembly graph stats
+        std::cout << "Initial graph stats\n";
+        pGraph->visit(statsVisit);    
+
+        // Remove containments from the graph. After the first round only
+        // the vertices that were flagged as contained need to be revisited
+        std::cout << "Removing contained vertices\n";
+        pGraph->setDirtyTracking(true);
+        if(pGraph->hasContainment())
+            pGraph->visitParallel(containVisit, opt::numThreads);
+        while(pGraph->hasContainment())
+            pGraph->visitDirtyParallel(containVisit, opt::numThreads);
+        pGraph->setDirtyTracking(false);
+
+        // Pre-assembly graph stats
+        std::cout << "Post-contain removal graph stats\n";
+        pGraph->visit(statsVisit);    
+        writeCheckpoint(pGraph, AS_CONTAIN);
+    }
 
-    // Pre-assembly graph stats
-    std::cout << "Post-contain removal graph stats\n";
-    pGraph->visit(statsVisit);    
+    if(opt::resumeStage <= AS_TRANSITIVE)
+    {
+        // Remove any extraneous transitive edges that may remain in the graph
+        std::cout << "Removing transitive edges\n";
+        pGraph->visitParallel(trVisit, opt::numThreads);
 
-    // Remove any extraneous transitive edges that may remain in the graph
-    std::cout << "Removing transitive edges\n";
-    pGraph->visit(trVisit);
+        // Compact together unbranched chains of vertices
+        pGraph->simplify(opt::numThreads);
+        
+        if(opt::bValidate)
+        {
+            std::cout << "Validating graph structure\n";
+            pGraph->visit(validationVisit);
+        }
 
-    // Compact together unbranched chains of vertices
-    pGraph->simplify();
-    
-    if(opt::bValidate)
-    {
-        std::cout << "Validating graph structure\n";
-        pGraph->visit(validationVisit);
+        //
+        std::cout << "Pre-remodelling graph stats\n";
+        pGraph->visit(statsVisit);
+        writeCheckpoint(pGraph, AS_TRANSITIVE);
     }
 
-    //
-    std::cout << "Pre-remodelling graph stats\n";
-    pGraph->visit(statsVisit);
-
-    // Remove dead-end branches from the graph
-    if(opt::numTrimRounds > 0)
+    if(opt::resumeStage <= AS_TRIM)
     {
-        std::cout << "Trimming bad vertices\n"; 
-        int numTrims = opt::numTrimRounds;
-        while(numTrims-- > 0)
-           pGraph->visit(trimVisit);
-        std::cout << "After trimming stats\n";
-        pGraph->visit(statsVisit);
+        // Remove dead-end branches from the graph
+        if(opt::numTrimRounds > 0)
+        {
+            std::cout << "Trimming bad vertices\n"; 
+            // Later rounds only revisit the neighbours of the trimmed vertices
+            pGraph->setDirtyTracking(true);
+            pGraph->visitParallel(trimVisit, opt::numThreads);
+            int numTrims = opt::numTrimRounds - 1;
+            while(numTrims-- > 0 && pGraph->hasDirtyVertices())
+               pGraph->visitDirtyParallel(trimVisit, opt::numThreads);
+            pGraph->setDirtyTracking(false);
+            std::cout << "After trimming stats\n";
+            pGraph->visit(statsVisit);
+        }
+
+        // Most of the deletions have been made by this point so pack
+        // the remaining vertices and edges into fresh pools
+        pGraph->compact();
+        pGraph->printMemSize();
+        writeCheckpoint(pGraph, AS_TRIM);
     }
 
     // Resolve small repeats
-    if(opt::resolveSmallRepeatLen > 0)
+    if(opt::resumeStage <= AS_REPEATS && opt::resolveSmallRepeatLen > 0)
     {
         SGSmallRepeatResolveVisitor smallRepeatVisit(opt::resolveSmallRepeatLen);
         std::cout << "Resolving small repeats\n";
 
-        while(pGraph->visit(smallRepeatVisit)) {}
+        pGraph->setDirtyTracking(true);
+        if(pGraph->visit(smallRepeatVisit))
+            while(pGraph->visitDirty(smallRepeatVisit)) {}
+        pGraph->setDirtyTracking(false);
         
         std::cout << "After small repeat resolve graph stats\n";
         pGraph->visit(statsVisit);
+        writeCheckpoint(pGraph, AS_REPEATS);
     }
 
-    //
-    if(opt::coverageCutoff > 0)
+    if(opt::resumeStage <= AS_COVERAGE)
     {
-        std::cout << "Coverage visit\n";
-        SGCoverageVisitor coverageVisit(opt::coverageCutoff);
-        pGraph->visit(coverageVisit);
-        pGraph->visit(trimVisit);
-        pGraph->visit(trimVisit);
-        pGraph->visit(trimVisit);
-    }
+        //
+        if(opt::coverageCutoff > 0)
+        {
+            std::cout << "Coverage visit\n";
+            SGCoverageVisitor coverageVisit(opt::coverageCutoff);
+            pGraph->visit(coverageVisit);
+            pGraph->setDirtyTracking(true);
+            pGraph->visitParallel(trimVisit, opt::numThreads);
+            pGraph->visitDirtyParallel(trimVisit, opt::numThreads);
+            pGraph->visitDirtyParallel(trimVisit, opt::numThreads);
+            pGraph->setDirtyTracking(false);
+        }
 
-    // Peform another round of simplification
-    pGraph->simplify();
+        // Peform another round of simplification
+        pGraph->simplify(opt::numThreads);
+        writeCheckpoint(pGraph, AS_COVERAGE);
+    }
     
     if(opt::numBubbleRounds > 0)
     {
@@ -215,8 +343,8 @@ void assemble()
         SGSmoothingVisitor smoothingVisit(opt::outVariantsFile, opt::maxBubbleGapDivergence, opt::maxBubbleDivergence, opt::maxIndelLength);
         int numSmooth = opt::numBubbleRounds;
         while(numSmooth-- > 0)
-            pGraph->visit(smoothingVisit);
-        pGraph->simplify();
+            pGraph->visitParallel(smoothingVisit, opt::numThreads);
+        pGraph->simplify(opt::numThreads);
     }
     
     pGraph->renameVertices("contig-");
@@ -244,6 +372,7 @@ void parseAssembleOptions(int argc, char** argv)
     // Set defaults
     opt::minOverlap = 0;
     std::string prefix = "default";
+    std::string resumeStageName;
     bool die = false;
     for (char c; (c = getopt_long(argc, argv, shortopts, longopts, NULL)) != -1;) 
     {
@@ -254,6 +383,7 @@ void parseAssembleOptions(int argc, char** argv)
             case 'm': arg >> opt::minOverlap; break;
             case '?': die = true; break;
             case 'v': opt::verbose++; break;
+            case 't': arg >> opt::numThreads; break;
             case 'l': arg >> opt::trimLengthThreshold; break;
             case 'b': arg >> opt::numBubbleRounds; break;
             case 'd': arg >> opt::maxBubbleDivergence; break;
@@ -266,6 +396,8 @@ void parseAssembleOptions(int argc, char** argv)
             case OPT_EXACT: opt::bExact = true; break;
             case OPT_EDGESTATS: opt::bEdgeStats = true; break;
             case OPT_VALIDATE: opt::bValidate = true; break;
+            case OPT_CHECKPOINT: opt::bCheckpoint = true; break;
+            case OPT_RESUME: arg >> resumeStageName; break;
             case OPT_HELP:
                 std::cout << ASSEMBLE_USAGE_MESSAGE;
                 exit(EXIT_SUCCESS);
@@ -280,6 +412,7 @@ void parseAssembleOptions(int argc, char** argv)
     opt::outContigsFile = prefix + "-contigs.fa";
     opt::outVariantsFile = prefix + "-variants.fa";
     opt::outGraphFile = prefix + "-graph.asqg.gz";
+    opt::checkpointPrefix = prefix;
 
     if (argc - optind < 1) 
     {
@@ -292,6 +425,22 @@ void parseAssembleOptions(int argc, char** argv)
         die = true;
     }
 
+    if(opt::numThreads <= 0)
+    {
+        std::cerr << SUBPROGRAM ": invalid number of threads: " << opt::numThreads << "\n";
+        die = true;
+    }
+
+    if(!resumeStageName.empty())
+    {
+        opt::resumeStage = findStage(resumeStageName);
+        if(opt::resumeStage <= AS_CONTAIN)
+        {
+            std::cerr << SUBPROGRAM ": invalid stage to resume from: " << resumeStageName << "\n";
+            die = true;
+        }
+    }
+
     if (die) 
     {
         std::cerr << "Try `" << SUBPROGRAM << " --help' for more information.\n";
@@ -46,6 +46,8 @@ static const char *CLUSTER_USAGE_MESSAGE =
 "      -m, --min-overlap=N              require an overlap of at least N bases between reads (default: 45)\n"
 "      -e, --error-rate                 the maximum error rate allowed to consider two sequences aligned (default: exact matches only)\n"
 "      -t, --threads=NUM                use NUM worker threads to compute the overlaps (default: no threading)\n"
+"          --max-overlaps=N             stop the overlap search for a read once it has more than N overlaps. The cluster\n"
+"                                       is not extended through such reads (default: no limit)\n"
 "\nReport bugs to " PACKAGE_BUGREPORT "\n\n";
 
 namespace opt
@@ -60,11 +62,12 @@ namespace opt
     static int numThreads = 1;
     static double errorRate = 0.0f;
     static unsigned int minOverlap = DEFAULT_MIN_OVERLAP;
+    static int64_t maxOverlaps = 0;
 }
 
 static const char* shortopts = "o:m:c:t:e:";
 
-enum { OPT_HELP = 1, OPT_VERSION };
+enum { OPT_HELP = 1, OPT_VERSION, OPT_MAX_OVERLAPS };
 
 static const struct option longopts[] = {
     { "verbose",        no_argument,       NULL, 'v' },
@@ -73,6 +76,7 @@ static const struct option longopts[] = {
     { "min-overlap",    required_argument, NULL, 'm' },
     { "error-rate",     required_argument, NULL, 'e' },
     { "threads",        required_argument, NULL, 't' },
+    { "max-overlaps",   required_argument, NULL, OPT_MAX_OVERLAPS },
     { "help",           no_argument,       NULL, OPT_HELP },
     { "version",        no_argument,       NULL, OPT_VERSION },
     { NULL, 0, NULL, 0 }
@@ -100,6 +104,11 @@ void cluster()
     pOverlapper->setExactModeOverlap(opt::errorRate < 0.001f);
     pOverlapper->setExactModeIrreducible(opt::errorRate < 0.001f);
 
+    OverlapBudget overlapBudget;
+    if(opt::maxOverlaps > 0)
+        overlapBudget.maxIntervalSize = opt::maxOverlaps;
+    pOverlapper->setBudget(overlapBudget);
+
     BitVector markedReads(pBWT->getNumStrings());
 
     std::string preclustersFile = opt::outFile + ".preclusters";
@@ -192,6 +201,7 @@ void parseClusterOptions(int argc, char** argv)
             case 'e': arg >> opt::errorRate; break;
             case 'm': arg >> opt::minOverlap; break;
             case 't': arg >> opt::numThreads; break;
+            case OPT_MAX_OVERLAPS: arg >> opt::maxOverlaps; break;
             case '?': die = true; break;
             case 'v': opt::verbose++; break;
             case OPT_HELP:
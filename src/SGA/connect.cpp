@@ -134,7 +134,7 @@ struct CoveredVertexVisitor
             not_used += 1;
             SeqRecord record;
             record.id = pX->getID();
-            record.seq = pX->getSeq().toString();
+            record.seq = pX->getStr();
             record.write(m_notUsedWriter);
         }
 
@@ -142,7 +142,7 @@ struct CoveredVertexVisitor
         {
             SeqRecord record;
             record.id = pX->getID();
-            record.seq = pX->getSeq().toString();
+            record.seq = pX->getStr();
             record.write(*m_pWriter);
             internal += 1;
         }
@@ -10,6 +10,7 @@
 #include <fstream>
 #include <sstream>
 #include <iterator>
+#include <algorithm>
 #include "Util.h"
 #include "correct.h"
 #include "SuffixArray.h"
@@ -25,9 +26,30 @@
 #include "CorrectionThresholds.h"
 #include "KmerDistribution.h"
 #include "BWTIntervalCache.h"
+#include "ThreadPool.h"
+#include "ShardCommon.h"
+#include "SolidKmerFilter.h"
+#include "KmerCommon.h"
+#include "ReadTable.h"
+
+// The FM-indices of the reads and the structures built on them
+struct CorrectionIndex
+{
+    CorrectionIndex() : pBWT(NULL), pRBWT(NULL), pIntervalCache(NULL), pOverlapper(NULL), pSolidFilter(NULL) {}
+
+    BWT* pBWT;
+    BWT* pRBWT;
+    BWTIntervalCache* pIntervalCache;
+    OverlapAlgorithm* pOverlapper;
+    SolidKmerFilter* pSolidFilter;
+};
 
 // Functions
 int learnKmerParameters(const BWT* pBWT);
+void initCorrectionIndex(CorrectionIndex& index);
+void freeCorrectionIndex(CorrectionIndex& index);
+void setIndexParameters(const CorrectionIndex& index, ErrorCorrectParameters& ecParams);
+void correctInPasses(CorrectionIndex& index, ErrorCorrectParameters& ecParams, ErrorCorrectPostProcess* pPostProcessor);
 
 //
 // Getopt
@@ -52,12 +74,25 @@ static const char *CORRECT_USAGE_MESSAGE =
 "      -d, --sample-rate=N              use occurrence array sample rate of N in the FM-index. Higher values use significantly\n"
 "                                       less memory at the cost of higher runtime. This value must be a power of 2 (default: 128)\n"
 "      -a, --algorithm=STR              specify the correction algorithm to use. STR must be one of kmer, hybrid, overlap. (default: kmer)\n"
+"          --passes=N                   correct the reads in N passes. The reads are loaded into memory once and after\n"
+"                                       each pass the corrected reads are indexed in memory. The next pass corrects the\n"
+"                                       reads that failed the QC check or contain a k-mer that was corrected elsewhere\n"
+"                                       against this index. This replaces running sga index and sga correct N times\n"
+"                                       but needs memory for the reads and their suffix array (default: 1)\n"
 "          --metrics=FILE               collect error correction metrics (error rate by position in read, etc) and write them to FILE\n"
+"          --shard=I/N                  only correct the I-th of N equal ranges of reads (0 <= I < N). The output files\n"
+"                                       are tagged with the shard. Combine the outputs of all the shards with sga merge-shards\n"
 "\nKmer correction parameters:\n"
 "      -k, --kmer-size=N                The length of the kmer to use. (default: 31)\n"
 "      -x, --kmer-threshold=N           Attempt to correct kmers that are seen less than N times. (default: 3)\n"
 "      -i, --kmer-rounds=N              Perform N rounds of k-mer correction, correcting up to N bases (default: 10)\n"
 "          --learn                      Attempt to learn the k-mer correction threshold (experimental). Overrides -x parameter.\n"
+"                                       The k-mer histogram is saved to PREFIX.kN.correct.kdist and reused by later runs on the same index\n"
+"          --solid-filter               before correcting, collect the solid k-mers of the index into a Bloom filter and\n"
+"                                       only search the FM-index for k-mers that are not in the filter. A small fraction\n"
+"                                       of the k-mers that are not solid are treated as solid. Requires k <= 31\n"
+"          --filter-memory=MB           use MB megabytes for the solid k-mer filter (default: 8 bits for each k-mer\n"
+"                                       of the index that could be solid)\n"
 "\nOverlap correction parameters:\n"
 "      -e, --error-rate                 the maximum error rate allowed between two sequences to consider them overlapped (default: 0.04)\n"
 "      -m, --min-overlap=LEN            minimum overlap required between two reads (default: 45)\n"
@@ -71,6 +106,8 @@ static const char *CORRECT_USAGE_MESSAGE =
 "      -b, --branch-cutoff=N            stop the overlap search at N branches. This parameter is used to control the search time for\n"
 "                                       highly-repetitive reads. If the number of branches exceeds N, the search stops and the read\n"
 "                                       will not be corrected. This is not enabled by default.\n"
+"          --depth-filter=N             do not correct reads that have more than N overlaps. The overlap search stops\n"
+"                                       as soon as N overlaps have been found. 0 disables the filter (default: 10000)\n"
 "      -r, --rounds=NUM                 iteratively correct reads up to a maximum of NUM rounds (default: 1)\n"
 "\nReport bugs to " PACKAGE_BUGREPORT "\n\n";
 
@@ -82,6 +119,7 @@ namespace opt
     static unsigned int verbose;
     static int numThreads = 1;
     static int numOverlapRounds = 1;
+    static int numPasses = 1;
     static std::string prefix;
     static std::string readsFile;
     static std::string outFile;
@@ -95,19 +133,23 @@ namespace opt
     static int seedStride = 0;
     static int conflictCutoff = 5;
     static int branchCutoff = -1;
+    static int depthFilter = 10000;
 
     static int kmerLength = 31;
     static int kmerThreshold = 3;
     static int numKmerRounds = 10;
     static bool bLearnKmerParams = false;
+    static bool bSolidFilter = false;
+    static size_t filterMemoryMB = 0;
 
     static int intervalCacheLength = 10;
     static ErrorCorrectAlgorithm algorithm = ECA_KMER;
+    static ShardSpec shard;
 }
 
 static const char* shortopts = "p:m:d:e:t:l:s:o:r:b:a:c:k:x:i:v";
 
-enum { OPT_HELP = 1, OPT_VERSION, OPT_METRICS, OPT_DISCARD, OPT_LEARN };
+enum { OPT_HELP = 1, OPT_VERSION, OPT_METRICS, OPT_DISCARD, OPT_LEARN, OPT_SHARD, OPT_SOLID_FILTER, OPT_FILTER_MEMORY, OPT_DEPTH_FILTER, OPT_PASSES };
 
 static const struct option longopts[] = {
     { "verbose",       no_argument,       NULL, 'v' },
@@ -123,14 +165,19 @@ static const struct option longopts[] = {
     { "sample-rate",   required_argument, NULL, 'd' },
     { "conflict",      required_argument, NULL, 'c' },
     { "branch-cutoff", required_argument, NULL, 'b' },
+    { "depth-filter",  required_argument, NULL, OPT_DEPTH_FILTER },
+    { "passes",        required_argument, NULL, OPT_PASSES },
     { "kmer-size",     required_argument, NULL, 'k' },
     { "kmer-threshold",required_argument, NULL, 'x' },
     { "kmer-rounds",   required_argument, NULL, 'i' },
     { "learn",         no_argument,       NULL, OPT_LEARN },
+    { "solid-filter",  no_argument,       NULL, OPT_SOLID_FILTER },
+    { "filter-memory", required_argument, NULL, OPT_FILTER_MEMORY },
     { "discard",       no_argument,       NULL, OPT_DISCARD },
     { "help",          no_argument,       NULL, OPT_HELP },
     { "version",       no_argument,       NULL, OPT_VERSION },
     { "metrics",       required_argument, NULL, OPT_METRICS },
+    { "shard",         required_argument, NULL, OPT_SHARD },
     { NULL, 0, NULL, 0 }
 };
 
@@ -141,45 +188,39 @@ int correctMain(int argc, char** argv)
 {
     parseCorrectOptions(argc, argv);
 
-    BWT* pBWT = new BWT(opt::prefix + BWT_EXT, opt::sampleRate);
-    BWT* pRBWT = NULL;
+    CorrectionIndex index;
+    index.pBWT = new BWT(opt::prefix + BWT_EXT, opt::sampleRate);
 
     // If the correction mode is k-mer only, then do not load the reverse
     // BWT as it is not needed
     if(opt::algorithm != ECA_KMER)
-        pRBWT = new BWT(opt::prefix + RBWT_EXT, opt::sampleRate);
-    
-    BWTIntervalCache intervalCache(opt::intervalCacheLength, pBWT);
-
-    OverlapAlgorithm* pOverlapper = new OverlapAlgorithm(pBWT, NULL, 
-                                                         opt::errorRate, opt::seedLength, 
-                                                         opt::seedStride, false, opt::branchCutoff);
-    
+        index.pRBWT = new BWT(opt::prefix + RBWT_EXT, opt::sampleRate);
 
     // Learn the parameters of the kmer corrector
     if(opt::bLearnKmerParams)
     {
-        int threshold = learnKmerParameters(pBWT);
+        int threshold = learnKmerParameters(index.pBWT);
         if(threshold != -1)
             CorrectionThresholds::Instance().setBaseMinSupport(threshold);
     }
 
+    initCorrectionIndex(index);
 
     // Open outfiles and start a timer
     std::ostream* pWriter = createWriter(opt::outFile);
     std::ostream* pDiscardWriter = (!opt::discardFile.empty() ? createWriter(opt::discardFile) : NULL);
     Timer* pTimer = new Timer(PROGRAM_IDENT);
-    pBWT->printInfo();
+    index.pBWT->printInfo();
 
     // Set the error correction parameters
     ErrorCorrectParameters ecParams;
-    ecParams.pOverlapper = pOverlapper;
-    ecParams.pIntervalCache = &intervalCache;
+    setIndexParameters(index, ecParams);
     ecParams.algorithm = opt::algorithm;
 
     ecParams.minOverlap = opt::minOverlap;
     ecParams.numOverlapRounds = opt::numOverlapRounds;
     ecParams.conflictCutoff = opt::conflictCutoff;
+    ecParams.depthFilter = opt::depthFilter;
 
     ecParams.numKmerRounds = opt::numKmerRounds;
     ecParams.kmerLength = opt::kmerLength;
@@ -189,14 +230,28 @@ int correctMain(int argc, char** argv)
     bool bCollectMetrics = !opt::metricsFile.empty();
     ErrorCorrectPostProcess postProcessor(pWriter, pDiscardWriter, bCollectMetrics);
 
-    if(opt::numThreads <= 1)
+    // Determine the range of reads to correct
+    size_t startIdx = 0;
+    size_t endIdx = -1;
+    if(opt::shard.isSharded())
+    {
+        opt::shard.getReadRange(index.pBWT->getNumStrings(), startIdx, endIdx);
+        printf("[%s] shard %d of %d: correcting reads [%zu, %zu)\n", PROGRAM_IDENT, opt::shard.index, opt::shard.count, startIdx, endIdx);
+    }
+
+    if(opt::numPasses > 1)
+    {
+        correctInPasses(index, ecParams, &postProcessor);
+    }
+    else if(opt::numThreads <= 1)
     {
         // Serial mode
         ErrorCorrectProcess processor(ecParams); 
         SequenceProcessFramework::processSequencesSerial<SequenceWorkItem,
                                                          ErrorCorrectResult, 
                                                          ErrorCorrectProcess, 
-                                                         ErrorCorrectPostProcess>(opt::readsFile, &processor, &postProcessor);
+                                                         ErrorCorrectPostProcess>(opt::readsFile, &processor, &postProcessor,
+                                                                                  endIdx, startIdx);
     }
     else
     {
@@ -211,7 +266,8 @@ int correctMain(int argc, char** argv)
         SequenceProcessFramework::processSequencesParallel<SequenceWorkItem,
                                                            ErrorCorrectResult, 
                                                            ErrorCorrectProcess, 
-                                                           ErrorCorrectPostProcess>(opt::readsFile, processorVector, &postProcessor);
+                                                           ErrorCorrectPostProcess>(opt::readsFile, processorVector, &postProcessor,
+                                                                                    endIdx, startIdx);
 
         for(int i = 0; i < opt::numThreads; ++i)
         {
@@ -226,44 +282,267 @@ int correctMain(int argc, char** argv)
         delete pMetricsWriter;
     }
 
-    delete pBWT;
-    if(pRBWT != NULL)
-        delete pRBWT;
-
-    delete pOverlapper;
+    freeCorrectionIndex(index);
     delete pTimer;
     
     delete pWriter;
     if(pDiscardWriter != NULL)
         delete pDiscardWriter;
 
-    if(opt::numThreads > 1)
-        pthread_exit(NULL);
+    // Release the worker threads
+    ThreadPool::shutdown();
 
     return 0;
 }
 
+// Build the interval cache, the overlapper and the solid k-mer
+// filter on the FM-indices of the reads
+void initCorrectionIndex(CorrectionIndex& index)
+{
+    index.pIntervalCache = new BWTIntervalCache(opt::intervalCacheLength, index.pBWT);
+    index.pOverlapper = new OverlapAlgorithm(index.pBWT, index.pRBWT, 
+                                             opt::errorRate, opt::seedLength, 
+                                             opt::seedStride, false, opt::branchCutoff);
+
+    // Stop searching for overlaps once the depth filter is exceeded
+    OverlapBudget overlapBudget;
+    overlapBudget.maxSeeds = opt::branchCutoff;
+    if(opt::depthFilter > 0)
+        overlapBudget.maxIntervalSize = opt::depthFilter;
+    index.pOverlapper->setBudget(overlapBudget);
+
+    // Collect the solid kmers. A kmer in the filter must be solid
+    // for bases of any quality
+    if(opt::bSolidFilter && opt::algorithm != ECA_OVERLAP)
+    {
+        Timer filterTimer("SolidKmerFilter");
+        int minCount = std::max(CorrectionThresholds::Instance().getMinSupportLowQuality(),
+                                CorrectionThresholds::Instance().getMinSupportHighQuality());
+        size_t numBits = opt::filterMemoryMB * 8 * 1024 * 1024;
+        if(numBits == 0)
+            numBits = SolidKmerFilter::getDefaultNumBits(index.pBWT, minCount, 8);
+
+        index.pSolidFilter = new SolidKmerFilter(opt::kmerLength, numBits);
+        index.pSolidFilter->build(index.pBWT, minCount, opt::numThreads);
+        printf("[%s] inserted %zu solid %d-mers (count >= %d) into a %.1lfMB filter\n", PROGRAM_IDENT,
+               index.pSolidFilter->getNumInserted(), opt::kmerLength, minCount,
+               (double)index.pSolidFilter->getMemSize() / (1024 * 1024));
+    }
+}
+
+//
+void freeCorrectionIndex(CorrectionIndex& index)
+{
+    delete index.pSolidFilter;
+    delete index.pOverlapper;
+    delete index.pIntervalCache;
+    delete index.pRBWT;
+    delete index.pBWT;
+    index = CorrectionIndex();
+}
+
+//
+void setIndexParameters(const CorrectionIndex& index, ErrorCorrectParameters& ecParams)
+{
+    ecParams.pOverlapper = index.pOverlapper;
+    ecParams.pIntervalCache = index.pIntervalCache;
+    ecParams.pSolidFilter = index.pSolidFilter;
+}
+
+// Build the FM-index of the reads in pRT without writing it to disk
+static BWT* buildInMemoryBWT(const ReadTable* pRT)
+{
+    SuffixArray* pSA = new SuffixArray(pRT, opt::numThreads);
+    BWT* pBWT = new BWT(pSA, pRT, opt::sampleRate);
+    delete pSA;
+    return pBWT;
+}
+
+// Hash the k-mer starting at pos so that both strands have the same hash
+static uint64_t hashCanonicalKmer(const std::string& seq, size_t pos, int k)
+{
+    uint64_t fwd = 14695981039346656037ULL;
+    uint64_t rc = 14695981039346656037ULL;
+    for(int i = 0; i < k; ++i)
+    {
+        fwd = (fwd ^ (uint8_t)seq[pos + i]) * 1099511628211ULL;
+        rc = (rc ^ (uint8_t)complement(seq[pos + k - i - 1])) * 1099511628211ULL;
+    }
+    return fwd < rc ? fwd : rc;
+}
+
+// Add the hashes of the k-mers of before that cover a base that differs from after
+static void addChangedKmers(const std::string& before, const std::string& after, int k, std::vector<uint64_t>& outHashes)
+{
+    if(before.size() != after.size() || (int)before.size() < k)
+        return;
+
+    // The k-mer starting at i covers a changed base if the
+    // first changed base at or after i is before i + k
+    int n = before.size();
+    int nextChange = n;
+    for(int i = n - 1; i >= 0; --i)
+    {
+        if(before[i] != after[i])
+            nextChange = i;
+        if(i <= n - k && nextChange < i + k)
+            outHashes.push_back(hashCanonicalKmer(before, i, k));
+    }
+}
+
+// Returns true if a k-mer of seq is in the sorted vector of hashes
+static bool hasChangedKmer(const std::string& seq, int k, const std::vector<uint64_t>& hashes)
+{
+    for(int i = 0; i + k <= (int)seq.size(); ++i)
+    {
+        if(std::binary_search(hashes.begin(), hashes.end(), hashCanonicalKmer(seq, i, k)))
+            return true;
+    }
+    return false;
+}
+
+// Correct the reads in opt::numPasses passes. The first pass searches the
+// index on disk. Each later pass searches an index of the reads as corrected
+// by the previous pass. A read is corrected again if it failed the QC check
+// or if it contains a k-mer that a correction of the previous pass removed
+// from some read, as that k-mer is less frequent in the new index. The 
+// counts of the other k-mers can only grow so the reads that passed stay
+// solid. The results are post-processed in input order once the last 
+// pass is done.
+void correctInPasses(CorrectionIndex& index, ErrorCorrectParameters& ecParams, ErrorCorrectPostProcess* pPostProcessor)
+{
+    std::vector<SequenceWorkItem> reads;
+    SeqReader reader(opt::readsFile);
+    SeqRecord record;
+    while(reader.get(record))
+        reads.push_back(SequenceWorkItem(reads.size(), record));
+
+    std::vector<ErrorCorrectResult> results(reads.size());
+    std::vector<size_t> activeReads(reads.size());
+    for(size_t i = 0; i < reads.size(); ++i)
+        activeReads[i] = i;
+
+    std::vector<SequenceWorkItem> passReads;
+    std::vector<ErrorCorrectResult> passResults;
+    for(int pass = 1; pass <= opt::numPasses && !activeReads.empty(); ++pass)
+    {
+        if(pass > 1)
+        {
+            // Replace the index with an index of the corrected reads.
+            // The ids of the reads are not needed to search it.
+            Timer indexTimer("InMemoryIndex");
+            freeCorrectionIndex(index);
+
+            ReadTable readTable;
+            for(size_t i = 0; i < reads.size(); ++i)
+            {
+                SeqItem item;
+                item.seq = results[i].correctSequence;
+                readTable.addRead(item);
+            }
+
+            index.pBWT = buildInMemoryBWT(&readTable);
+            if(opt::algorithm != ECA_KMER)
+            {
+                readTable.reverseAll();
+                index.pRBWT = buildInMemoryBWT(&readTable);
+            }
+            initCorrectionIndex(index);
+            setIndexParameters(index, ecParams);
+        }
+
+        passReads.clear();
+        for(size_t i = 0; i < activeReads.size(); ++i)
+        {
+            passReads.push_back(reads[activeReads[i]]);
+            if(pass > 1)
+                passReads.back().read.seq = results[activeReads[i]].correctSequence;
+        }
+
+        std::vector<ErrorCorrectProcess*> processorVector;
+        for(int i = 0; i < opt::numThreads; ++i)
+            processorVector.push_back(new ErrorCorrectProcess(ecParams));
+        SequenceProcessFramework::processWorkItems(passReads, processorVector, passResults);
+        for(int i = 0; i < opt::numThreads; ++i)
+            delete processorVector[i];
+
+        size_t numChanged = 0;
+        size_t numFailed = 0;
+        std::vector<uint64_t> changedKmers;
+        std::vector<bool> isActive(reads.size(), false);
+        for(size_t i = 0; i < activeReads.size(); ++i)
+        {
+            ErrorCorrectResult& result = passResults[i];
+            std::string before = passReads[i].read.seq.toString();
+            std::string after = result.correctSequence.toString();
+            if(before != after)
+            {
+                addChangedKmers(before, after, opt::kmerLength, changedKmers);
+                ++numChanged;
+            }
+
+            if(!result.kmerQC && !result.overlapQC)
+            {
+                isActive[activeReads[i]] = true;
+                ++numFailed;
+            }
+            results[activeReads[i]] = result;
+        }
+
+        printf("[%s] pass %d: corrected %zu reads, changed %zu, %zu failed QC\n", PROGRAM_IDENT,
+               pass, activeReads.size(), numChanged, numFailed);
+
+        // Select the reads for the next pass
+        activeReads.clear();
+        if(pass == opt::numPasses || numChanged == 0)
+            break;
+
+        std::sort(changedKmers.begin(), changedKmers.end());
+        changedKmers.erase(std::unique(changedKmers.begin(), changedKmers.end()), changedKmers.end());
+        for(size_t i = 0; i < reads.size(); ++i)
+        {
+            if(isActive[i] || hasChangedKmer(results[i].correctSequence.toString(), opt::kmerLength, changedKmers))
+                activeReads.push_back(i);
+        }
+    }
+
+    for(size_t i = 0; i < reads.size(); ++i)
+        pPostProcessor->process(reads[i], results[i]);
+}
+
 // Learn parameters of the kmer corrector
 int learnKmerParameters(const BWT* pBWT)
 {
     std::cout << "Learning kmer parameters\n";
-    srand(time(0));
+
+    // Reuse the histogram of a previous run on the same index if there is one
+    int k = opt::kmerLength;
+    std::string distFile = KmerCommon::getDistributionFilename(opt::prefix, k, "correct");
+
+    // Every shard must choose the same threshold so the
+    // sample is seeded deterministically when sharding.
+    // Otherwise any sample of the same size can be reused
+    unsigned int seed = opt::shard.isSharded() ? opt::shard.count : time(0);
     size_t n_samples = 10000;
+    std::stringstream source;
+    source << "sample of " << n_samples << " reads";
+    if(opt::shard.isSharded())
+        source << " with seed " << seed;
+
+    std::string indexKey = KmerCommon::getIndexKey(opt::prefix + BWT_EXT, pBWT, k, source.str());
+    std::string cachedKey;
+    std::string cachedSource;
 
-    //
     KmerDistribution kmerDistribution;
-    int k = opt::kmerLength;
-    for(size_t i = 0; i < n_samples; ++i)
+    if(kmerDistribution.readFile(distFile, cachedKey, cachedSource) && cachedKey == indexKey)
     {
-        std::string s = BWTAlgorithms::sampleRandomString(pBWT);
-        int n = s.size();
-        int nk = n - k + 1;
-        for(int j = 0; j < nk; ++j)
-        {
-            std::string kmer = s.substr(j, k);
-            int count = BWTAlgorithms::countSequenceOccurrences(kmer, pBWT);
-            kmerDistribution.add(count);
-        }
+        std::cout << "Using the kmer distribution in " << distFile << " (" << cachedSource << ")\n";
+    }
+    else
+    {
+        kmerDistribution = KmerDistribution();
+        KmerCommon::sampleDistribution(pBWT, k, n_samples, seed, opt::numThreads, kmerDistribution);
+        kmerDistribution.writeFile(distFile, indexKey, source.str());
     }
 
     //
@@ -323,8 +602,19 @@ void parseCorrectOptions(int argc, char** argv)
             case 'b': arg >> opt::branchCutoff; break;
             case 'i': arg >> opt::numKmerRounds; break;
             case OPT_LEARN: opt::bLearnKmerParams = true; break;
+            case OPT_SOLID_FILTER: opt::bSolidFilter = true; break;
+            case OPT_FILTER_MEMORY: arg >> opt::filterMemoryMB; break;
+            case OPT_DEPTH_FILTER: arg >> opt::depthFilter; break;
+            case OPT_PASSES: arg >> opt::numPasses; break;
             case OPT_DISCARD: bDiscardReads = true; break;
             case OPT_METRICS: arg >> opt::metricsFile; break;
+            case OPT_SHARD:
+                if(!ShardCommon::parseShardSpec(arg.str(), opt::shard))
+                {
+                    std::cerr << SUBPROGRAM ": invalid shard specification: " << arg.str() << ", expected I/N\n";
+                    die = true;
+                }
+                break;
             case OPT_HELP:
                 std::cout << CORRECT_USAGE_MESSAGE;
                 exit(EXIT_SUCCESS);
@@ -357,6 +647,18 @@ void parseCorrectOptions(int argc, char** argv)
         die = true;
     }
     
+    if(opt::numPasses <= 0)
+    {
+        std::cerr << SUBPROGRAM ": invalid number of passes: " << opt::numPasses << ", must be at least 1\n";
+        die = true;
+    }
+
+    if(opt::numPasses > 1 && opt::shard.isSharded())
+    {
+        std::cerr << SUBPROGRAM ": --passes cannot be used with --shard, every pass indexes all of the reads\n";
+        die = true;
+    }
+
     if(opt::numKmerRounds <= 0)
     {
         std::cerr << SUBPROGRAM ": invalid number of kmer rounds: " << opt::numKmerRounds << ", must be at least 1\n";
@@ -375,6 +677,12 @@ void parseCorrectOptions(int argc, char** argv)
         die = true;
     }
 
+    if(opt::bSolidFilter && opt::kmerLength > 31)
+    {
+        std::cerr << SUBPROGRAM ": the solid k-mer filter requires a kmer length of at most 31\n";
+        die = true;
+    }
+
     // Determine the correction algorithm to use
     if(!algo_str.empty())
     {
@@ -443,4 +751,8 @@ void parseCorrectOptions(int argc, char** argv)
     {
         opt::discardFile.clear();
     }
+
+    opt::outFile = opt::shard.tagFilename(opt::outFile);
+    opt::discardFile = opt::shard.tagFilename(opt::discardFile);
+    opt::metricsFile = opt::shard.tagFilename(opt::metricsFile);
 }
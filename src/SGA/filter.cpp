@@ -24,8 +24,10 @@
 #include "QCProcess.h"
 #include "BWTDiskConstruction.h"
 #include "BitVector.h"
+#include "ThreadPool.h"
 
 // Functions
+void sampleFilter(const BWT* pBWT, const BWT* pRBWT);
 
 //
 // Getopt
@@ -53,6 +55,10 @@ static const char *FILTER_USAGE_MESSAGE =
 "                                       less memory at the cost of higher runtime. This value must be a power of 2 (default: 128)\n"
 "      --no-duplicate-check             turn off duplicate removal\n"
 "      --no-kmer-check                  turn off the kmer check\n"
+"      -s, --sample=N                   only report the fraction of reads that would be discarded, estimated from N reads\n"
+"                                       drawn uniformly at random from the FM-index, with 95% confidence intervals.\n"
+"                                       READSFILE is not read and no reads are written\n"
+"          --seed=N                     use N as the seed for --sample (default: based on the time)\n"
 "\nK-mer filter options:\n"
 "      -k, --kmer-size=N                The length of the kmer to use. (default: 27)\n"
 "      -x, --kmer-threshold=N           Require at least N kmer coverage for each kmer in a read. (default: 3)\n"
@@ -76,11 +82,15 @@ namespace opt
 
     static int kmerLength = 27;
     static int kmerThreshold = 3;
+
+    static size_t numSamples = 0;
+    static unsigned int seed = 0;
+    static bool bSeed = false;
 }
 
-static const char* shortopts = "p:d:t:o:k:x:v";
+static const char* shortopts = "p:d:t:o:k:x:s:v";
 
-enum { OPT_HELP = 1, OPT_VERSION, PT_DISCARD, OPT_NO_RMDUP, OPT_NO_KMER };
+enum { OPT_HELP = 1, OPT_VERSION, PT_DISCARD, OPT_NO_RMDUP, OPT_NO_KMER, OPT_SEED };
 
 static const struct option longopts[] = {
     { "verbose",            no_argument,       NULL, 'v' },
@@ -90,6 +100,8 @@ static const struct option longopts[] = {
     { "sample-rate",        required_argument, NULL, 'd' },
     { "kmer-size",          required_argument, NULL, 'k' },
     { "kmer-threshold",     required_argument, NULL, 'x' },
+    { "sample",             required_argument, NULL, 's' },
+    { "seed",               required_argument, NULL, OPT_SEED },
     { "help",               no_argument,       NULL, OPT_HELP },
     { "version",            no_argument,       NULL, OPT_VERSION },
     { "no-duplicate-check", no_argument,       NULL, OPT_NO_RMDUP },
@@ -109,6 +121,16 @@ int filterMain(int argc, char** argv)
     BWT* pBWT = new BWT(opt::prefix + BWT_EXT, opt::sampleRate);
     BWT* pRBWT = new BWT(opt::prefix + RBWT_EXT, opt::sampleRate);
     pBWT->printInfo();
+
+    if(opt::numSamples > 0)
+    {
+        sampleFilter(pBWT, pRBWT);
+        delete pBWT;
+        delete pRBWT;
+        delete pTimer;
+        ThreadPool::shutdown();
+        return 0;
+    }
     
     std::ostream* pWriter = createWriter(opt::outFile);
     std::ostream* pDiscardWriter = createWriter(opt::discardFile);
@@ -168,12 +190,40 @@ int filterMain(int argc, char** argv)
 
     delete pTimer;
 
-    if(opt::numThreads > 1)
-        pthread_exit(NULL);
+    // Release the worker threads
+    ThreadPool::shutdown();
 
     return 0;
 }
 
+// Estimate the fraction of the reads that the filters would discard
+// from a random sample of the reads in the FM-index
+void sampleFilter(const BWT* pBWT, const BWT* pRBWT)
+{
+    printf("[%s] sampling %zu reads with seed %u\n", PROGRAM_IDENT, opt::numSamples, opt::seed);
+    QCPostProcess postProcessor(NULL, NULL);
+    postProcessor.setPopulationSize(pBWT->getNumStrings());
+
+    // The duplicate check does not use the shared bit vector as the reads
+    // are not processed in the order of the file. The copy of a read that 
+    // is kept is found with the lexicographic index instead
+    SuffixArray* pSAI = NULL;
+    if(opt::dupCheck)
+        pSAI = new SuffixArray(opt::prefix + SAI_EXT);
+
+    std::vector<QCProcess*> processorVector;
+    for(int i = 0; i < opt::numThreads; ++i)
+        processorVector.push_back(new QCProcess(pBWT, pRBWT, NULL, opt::dupCheck, opt::kmerCheck, opt::kmerLength, opt::kmerThreshold, pSAI));
+
+    SequenceProcessFramework::processSequencesSampled<QCResult,
+                                                      QCProcess,
+                                                      QCPostProcess>(pBWT, opt::numSamples, opt::seed, processorVector, &postProcessor);
+
+    for(int i = 0; i < opt::numThreads; ++i)
+        delete processorVector[i];
+    delete pSAI;
+}
+
 // 
 // Handle command line arguments
 //
@@ -192,6 +242,8 @@ void parseFilterOptions(int argc, char** argv)
             case 'd': arg >> opt::sampleRate; break;
             case 'k': arg >> opt::kmerLength; break;
             case 'x': arg >> opt::kmerThreshold; break;
+            case 's': arg >> opt::numSamples; break;
+            case OPT_SEED: arg >> opt::seed; opt::bSeed = true; break;
             case OPT_NO_RMDUP: opt::dupCheck = false; break;
             case OPT_NO_KMER: opt::kmerCheck = false; break;
             case '?': die = true; break;
@@ -254,4 +306,7 @@ void parseFilterOptions(int argc, char** argv)
     }
 
     opt::discardFile = opt::prefix + ".discard.fa";
+
+    if(!opt::bSeed)
+        opt::seed = time(0);
 }
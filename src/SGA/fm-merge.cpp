@@ -25,6 +25,8 @@
 #include "OverlapProcess.h"
 #include "ReadInfoTable.h"
 #include "FMMergeProcess.h"
+#include "ThreadPool.h"
+#include "ShardCommon.h"
 
 //
 // Getopt
@@ -46,6 +48,11 @@ static const char *FMMERGE_USAGE_MESSAGE =
 "      -t, --threads=NUM                use NUM worker threads (default: no threading)\n"
 "      -m, --min-overlap=LEN            minimum overlap required between two reads to merge (default: 45)\n"
 "      -o, --outfile=FILE               write the merged sequences to FILE (default: basename.merged.fa)\n"
+"          --max-overlaps=N             stop the overlap search for a read once it has more than N overlaps. Such reads\n"
+"                                       are not merged (default: no limit)\n"
+"          --shard=I/N                  only start merges from the I-th of N equal ranges of reads (0 <= I < N). Each set of\n"
+"                                       merged reads is written by the shard containing its lowest read index. The output file\n"
+"                                       is tagged with the shard. Combine the outputs of all the shards with sga merge-shards\n"
 "\nReport bugs to " PACKAGE_BUGREPORT "\n\n";
 
 static const char* PROGRAM_IDENT =
@@ -59,17 +66,21 @@ namespace opt
     static std::string outFile;
     static std::string prefix;
     static unsigned int minOverlap = DEFAULT_MIN_OVERLAP;
+    static int64_t maxOverlaps = 0;
+    static ShardSpec shard;
 }
 
 static const char* shortopts = "p:m:d:e:t:l:s:o:vix";
 
-enum { OPT_HELP = 1, OPT_VERSION };
+enum { OPT_HELP = 1, OPT_VERSION, OPT_SHARD, OPT_MAX_OVERLAPS };
 
 static const struct option longopts[] = {
     { "verbose",     no_argument,       NULL, 'v' },
     { "threads",     required_argument, NULL, 't' },
     { "min-overlap", required_argument, NULL, 'm' },
     { "outfile",     required_argument, NULL, 'o' },
+    { "shard",       required_argument, NULL, OPT_SHARD },
+    { "max-overlaps",required_argument, NULL, OPT_MAX_OVERLAPS },
     { "help",        no_argument,       NULL, OPT_HELP },
     { "version",     no_argument,       NULL, OPT_VERSION },
     { NULL, 0, NULL, 0 }
@@ -87,6 +98,11 @@ int FMMergeMain(int argc, char** argv)
     OverlapAlgorithm* pOverlapper = new OverlapAlgorithm(pBWT, pRBWT,0.0f, 0,0,true); 
     pOverlapper->setExactModeOverlap(true);
     pOverlapper->setExactModeIrreducible(true);
+
+    OverlapBudget overlapBudget;
+    if(opt::maxOverlaps > 0)
+        overlapBudget.maxIntervalSize = opt::maxOverlaps;
+    pOverlapper->setBudget(overlapBudget);
     Timer* pTimer = new Timer(PROGRAM_IDENT);
     pBWT->printInfo();
 
@@ -98,6 +114,24 @@ int FMMergeMain(int argc, char** argv)
     std::ostream* pWriter = createWriter(opt::outFile);
     FMMergePostProcess postProcessor(pWriter, &markedReads);
 
+    // Determine the range of reads to process. The suffix array
+    // is needed to decide which shard owns each merged set
+    size_t startIdx = 0;
+    size_t endIdx = -1;
+    SuffixArray* pSAI = NULL;
+    if(opt::shard.isSharded())
+    {
+        opt::shard.getReadRange(pBWT->getNumStrings(), startIdx, endIdx);
+        printf("[%s] shard %d of %d: merging from reads [%zu, %zu)\n", PROGRAM_IDENT, opt::shard.index, opt::shard.count, startIdx, endIdx);
+
+        pSAI = new SuffixArray(opt::prefix + SAI_EXT);
+        postProcessor.setReadRange(pSAI, startIdx, endIdx);
+
+        std::stringstream nameSS;
+        nameSS << "merged-s" << opt::shard.index << "-";
+        postProcessor.setNamePrefix(nameSS.str());
+    }
+
     if(opt::numThreads <= 1)
     {
         printf("[%s] starting serial-mode read merging\n", PROGRAM_IDENT);
@@ -105,7 +139,8 @@ int FMMergeMain(int argc, char** argv)
         SequenceProcessFramework::processSequencesSerial<SequenceWorkItem,
                                                          FMMergeResult, 
                                                          FMMergeProcess, 
-                                                         FMMergePostProcess>(opt::readsFile, &processor, &postProcessor);
+                                                         FMMergePostProcess>(opt::readsFile, &processor, &postProcessor,
+                                                                             endIdx, startIdx);
     }
     else
     {
@@ -121,7 +156,8 @@ int FMMergeMain(int argc, char** argv)
         SequenceProcessFramework::processSequencesParallel<SequenceWorkItem,
                                                          FMMergeResult, 
                                                          FMMergeProcess, 
-                                                         FMMergePostProcess>(opt::readsFile, processorVector, &postProcessor);
+                                                         FMMergePostProcess>(opt::readsFile, processorVector, &postProcessor,
+                                                                             endIdx, startIdx);
         
         for(size_t i = 0; i < processorVector.size(); ++i)
         {
@@ -144,11 +180,13 @@ int FMMergeMain(int argc, char** argv)
     delete pBWT; 
     delete pRBWT;
     delete pWriter;
+    if(pSAI != NULL)
+        delete pSAI;
 
     // Cleanup
     delete pTimer;
-    if(opt::numThreads > 1)
-        pthread_exit(NULL);
+    // Release the worker threads
+    ThreadPool::shutdown();
 
     return 0;
 }
@@ -168,8 +206,16 @@ void parseFMMergeOptions(int argc, char** argv)
             case 'p': arg >> opt::prefix; break;
             case 'o': arg >> opt::outFile; break;
             case 't': arg >> opt::numThreads; break;
+            case OPT_MAX_OVERLAPS: arg >> opt::maxOverlaps; break;
             case '?': die = true; break;
             case 'v': opt::verbose++; break;
+            case OPT_SHARD:
+                if(!ShardCommon::parseShardSpec(arg.str(), opt::shard))
+                {
+                    std::cerr << SUBPROGRAM ": invalid shard specification: " << arg.str() << ", expected I/N\n";
+                    die = true;
+                }
+                break;
             case OPT_HELP:
                 std::cout << FMMERGE_USAGE_MESSAGE;
                 exit(EXIT_SUCCESS);
@@ -208,4 +254,6 @@ void parseFMMergeOptions(int argc, char** argv)
 
     if(opt::outFile.empty())
         opt::outFile = opt::prefix + ".merged.fa";
+
+    opt::outFile = opt::shard.tagFilename(opt::outFile);
 }
@@ -18,6 +18,7 @@
 #include "SequenceProcessFramework.h"
 #include "RmdupProcess.h"
 #include "BWTDiskConstruction.h"
+#include "ThreadPool.h"
 
 struct GmapData
 {
@@ -99,8 +100,8 @@ int gmapMain(int argc, char** argv)
     gmap();
     delete pTimer;
 
-    if(opt::numThreads > 1)
-        pthread_exit(NULL);
+    // Release the worker threads
+    ThreadPool::shutdown();
     return 0;
 }
 
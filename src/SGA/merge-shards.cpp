@@ -0,0 +1,185 @@
+//-----------------------------------------------
+// Copyright 2010 Wellcome Trust Sanger Institute
+// Written by Jared Simpson (js18@sanger.ac.uk)
+// Released under the GPL
+//-----------------------------------------------
+//
+// merge-shards - Combine the output files of a job
+// that was split with --shard into a single file
+//
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include "Util.h"
+#include "merge-shards.h"
+#include "SGACommon.h"
+#include "ShardCommon.h"
+
+//
+// Getopt
+//
+#define SUBPROGRAM "merge-shards"
+static const char *MERGESHARDS_VERSION_MESSAGE =
+SUBPROGRAM " Version " PACKAGE_VERSION "\n"
+"Written by Jared Simpson.\n"
+"\n"
+"Copyright 2010 Wellcome Trust Sanger Institute\n";
+
+static const char *MERGESHARDS_USAGE_MESSAGE =
+"Usage: " PACKAGE_NAME " " SUBPROGRAM " [OPTION] ... FILE1 FILE2 ... FILEN\n"
+"Combine the output files of sga overlap, rmdup, correct or fm-merge runs using --shard into a single file.\n"
+"If every file is tagged with its shard, the files are combined in shard order and all the shards must be present.\n"
+"Otherwise the files are combined in the order they are given. ASQG files are combined so the header\n"
+"is written once followed by all the vertices then all the edges. Other files are concatenated.\n"
+"\n"
+"      --help                           display this help and exit\n"
+"      -v, --verbose                    display verbose output\n"
+"      -o, --out=FILE                   write the combined output to FILE (default: FILE1 without the shard tag)\n"
+"\nReport bugs to " PACKAGE_BUGREPORT "\n\n";
+
+namespace opt
+{
+    static unsigned int verbose;
+    static std::string outFile;
+    static StringVector inFiles;
+}
+
+static const char* shortopts = "o:v";
+
+enum { OPT_HELP = 1, OPT_VERSION };
+
+static const struct option longopts[] = {
+    { "verbose",     no_argument,       NULL, 'v' },
+    { "out",         required_argument, NULL, 'o' },
+    { "help",        no_argument,       NULL, OPT_HELP },
+    { "version",     no_argument,       NULL, OPT_VERSION },
+    { NULL, 0, NULL, 0 }
+};
+
+// Order the input files by shard index. Returns false if the files
+// are not a complete set of shards, in which case the order is unchanged
+static bool sortByShard(StringVector& files)
+{
+    std::vector<std::string> sorted(files.size());
+    for(size_t i = 0; i < files.size(); ++i)
+    {
+        ShardSpec spec;
+        if(!ShardCommon::parseShardFilename(files[i], spec))
+            return false;
+        if(spec.count != (int)files.size() || !sorted[spec.index].empty())
+            return false;
+        sorted[spec.index] = files[i];
+    }
+    files.swap(sorted);
+    return true;
+}
+
+// Copy the lines of the file starting with any of the record types in recordTypes.
+// If recordTypes is empty, every line is copied
+static void copyRecords(const std::string& filename, const StringVector& recordTypes, std::ostream* pWriter)
+{
+    std::istream* pReader = createReader(filename);
+    std::string line;
+    while(getline(*pReader, line))
+    {
+        bool copy = recordTypes.empty();
+        for(size_t i = 0; i < recordTypes.size() && !copy; ++i)
+            copy = line.compare(0, recordTypes[i].size(), recordTypes[i]) == 0;
+
+        if(copy)
+            *pWriter << line << "\n";
+    }
+    delete pReader;
+}
+
+//
+// Main
+//
+int mergeShardsMain(int argc, char** argv)
+{
+    parseMergeShardsOptions(argc, argv);
+
+    if(!sortByShard(opt::inFiles))
+        std::cerr << "[" SUBPROGRAM "] Warning: the input files are not a complete set of shards, combining them in the order given\n";
+
+    std::ostream* pWriter = createWriter(opt::outFile);
+
+    // ASQG files have the header from the first file, followed
+    // by the vertex records of every file then the edge records
+    bool isASQG = opt::inFiles.front().find(ASQG_EXT) != std::string::npos;
+
+    if(isASQG)
+    {
+        StringVector headerTypes(1, "HT");
+        StringVector vertexTypes(1, "VT");
+        StringVector edgeTypes(1, "ED");
+
+        copyRecords(opt::inFiles.front(), headerTypes, pWriter);
+        for(size_t i = 0; i < opt::inFiles.size(); ++i)
+            copyRecords(opt::inFiles[i], vertexTypes, pWriter);
+        for(size_t i = 0; i < opt::inFiles.size(); ++i)
+            copyRecords(opt::inFiles[i], edgeTypes, pWriter);
+    }
+    else
+    {
+        StringVector allTypes;
+        for(size_t i = 0; i < opt::inFiles.size(); ++i)
+            copyRecords(opt::inFiles[i], allTypes, pWriter);
+    }
+
+    if(opt::verbose > 0)
+        std::cout << "Combined " << opt::inFiles.size() << " files into " << opt::outFile << "\n";
+
+    delete pWriter;
+    return 0;
+}
+
+//
+// Handle command line arguments
+//
+void parseMergeShardsOptions(int argc, char** argv)
+{
+    bool die = false;
+    for (char c; (c = getopt_long(argc, argv, shortopts, longopts, NULL)) != -1;)
+    {
+        std::istringstream arg(optarg != NULL ? optarg : "");
+        switch (c)
+        {
+            case 'o': arg >> opt::outFile; break;
+            case '?': die = true; break;
+            case 'v': opt::verbose++; break;
+            case OPT_HELP:
+                std::cout << MERGESHARDS_USAGE_MESSAGE;
+                exit(EXIT_SUCCESS);
+            case OPT_VERSION:
+                std::cout << MERGESHARDS_VERSION_MESSAGE;
+                exit(EXIT_SUCCESS);
+        }
+    }
+
+    if (argc - optind < 1)
+    {
+        std::cerr << SUBPROGRAM ": missing arguments\n";
+        die = true;
+    }
+
+    if (die)
+    {
+        std::cout << "\n" << MERGESHARDS_USAGE_MESSAGE;
+        exit(EXIT_FAILURE);
+    }
+
+    // Parse the input filenames
+    while(optind < argc)
+        opt::inFiles.push_back(argv[optind++]);
+
+    if(opt::outFile.empty())
+    {
+        opt::outFile = ShardCommon::stripShardTag(opt::inFiles.front());
+        if(opt::outFile == opt::inFiles.front())
+        {
+            std::cerr << SUBPROGRAM ": the input files are not tagged with a shard, the output file must be given with -o\n";
+            exit(EXIT_FAILURE);
+        }
+    }
+}
@@ -0,0 +1,24 @@
+//-----------------------------------------------
+// Copyright 2010 Wellcome Trust Sanger Institute
+// Written by Jared Simpson (js18@sanger.ac.uk)
+// Released under the GPL
+//-----------------------------------------------
+//
+// merge-shards - Combine the output files of a job
+// that was split with --shard into a single file
+//
+#ifndef MERGESHARDS_H
+#define MERGESHARDS_H
+#include <getopt.h>
+#include "config.h"
+#include "Util.h"
+
+// functions
+
+//
+int mergeShardsMain(int argc, char** argv);
+
+// options
+void parseMergeShardsOptions(int argc, char** argv);
+
+#endif
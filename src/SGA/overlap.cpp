@@ -23,6 +23,9 @@
 #include "SequenceProcessFramework.h"
 #include "OverlapProcess.h"
 #include "ReadInfoTable.h"
+#include "BWTReplicaSet.h"
+#include "ShardCommon.h"
+#include "ThreadPool.h"
 
 //
 enum OutputType
@@ -34,10 +37,12 @@ enum OutputType
 // Functions
 size_t computeHitsSerial(const std::string& prefix, const std::string& readsFile, 
                          const OverlapAlgorithm* pOverlapper, int minOverlap, 
+                         size_t startIdx, size_t endIdx,
                          StringVector& filenameVec, std::ostream* pASQGWriter);
 
 size_t computeHitsParallel(int numThreads, const std::string& prefix, const std::string& readsFile, 
-                           const OverlapAlgorithm* pOverlapper, int minOverlap, 
+                           const std::vector<OverlapAlgorithm*>& overlappers, int minOverlap, 
+                           size_t startIdx, size_t endIdx,
                            StringVector& filenameVec, std::ostream* pASQGWriter);
 
 //
@@ -75,6 +80,12 @@ static const char *OVERLAP_USAGE_MESSAGE =
 "                                       is specified (see above). This parameter defaults to the same value as --seed-length\n"
 "      -d, --sample-rate=N              sample the symbol counts every N symbols in the FM-index. Higher values use significantly\n"
 "                                       less memory at the cost of higher runtime. This value must be a power of 2 (default: 128)\n"
+"          --numa-replicate             load a copy of the FM-index into the memory of each NUMA node. The worker threads\n"
+"                                       use the copy local to the node they run on. This requires the threads to be pinned\n"
+"                                       by setting SGA_THREAD_AFFINITY=node or SGA_THREAD_AFFINITY=core\n"
+"          --shard=I/N                  only compute the overlaps for the I-th of N equal ranges of reads (0 <= I < N).\n"
+"                                       The output file name is tagged with the shard. Combine the outputs of all\n"
+"                                       the shards with sga merge-shards\n"
 "\nReport bugs to " PACKAGE_BUGREPORT "\n\n";
 
 static const char* PROGRAM_IDENT =
@@ -96,11 +107,13 @@ namespace opt
     static int sampleRate = BWT::DEFAULT_SAMPLE_RATE_SMALL;
     static bool bIrreducibleOnly = true;
     static bool bExactIrreducible = false;
+    static bool bReplicateIndex = false;
+    static ShardSpec shard;
 }
 
 static const char* shortopts = "p:m:d:e:t:l:s:o:vix";
 
-enum { OPT_HELP = 1, OPT_VERSION, OPT_EXACT };
+enum { OPT_HELP = 1, OPT_VERSION, OPT_EXACT, OPT_NUMA_REPLICATE, OPT_SHARD };
 
 static const struct option longopts[] = {
     { "verbose",     no_argument,       NULL, 'v' },
@@ -114,6 +127,8 @@ static const struct option longopts[] = {
     { "seed-stride", required_argument, NULL, 's' },
     { "exhaustive",  no_argument,       NULL, 'x' },
     { "exact",       no_argument,       NULL, OPT_EXACT },
+    { "numa-replicate", no_argument,    NULL, OPT_NUMA_REPLICATE },
+    { "shard",       required_argument, NULL, OPT_SHARD },
     { "help",        no_argument,       NULL, OPT_HELP },
     { "version",     no_argument,       NULL, OPT_VERSION },
     { NULL, 0, NULL, 0 }
@@ -144,34 +159,60 @@ int overlapMain(int argc, char** argv)
 
     // Compute the overlap hits
     StringVector hitsFilenames;
-    BWT* pBWT = new BWT(opt::prefix + BWT_EXT, opt::sampleRate);
-    BWT* pRBWT = new BWT(opt::prefix + RBWT_EXT, opt::sampleRate);
-    OverlapAlgorithm* pOverlapper = new OverlapAlgorithm(pBWT, pRBWT, 
-                                                         opt::errorRate, opt::seedLength, 
-                                                         opt::seedStride, opt::bIrreducibleOnly);
+    bool replicate = opt::bReplicateIndex && opt::numThreads > 1;
+    BWTReplicaSet* pBWTSet = new BWTReplicaSet(opt::prefix + BWT_EXT, opt::sampleRate, replicate);
+    BWTReplicaSet* pRBWTSet = new BWTReplicaSet(opt::prefix + RBWT_EXT, opt::sampleRate, replicate);
 
-    pOverlapper->setExactModeOverlap(opt::errorRate <= 0.0001);
-    pOverlapper->setExactModeIrreducible(opt::errorRate <= 0.0001);
+    // Create one overlapper per copy of the index
+    std::vector<OverlapAlgorithm*> overlappers;
+    for(size_t i = 0; i < pBWTSet->getNumReplicas(); ++i)
+    {
+        OverlapAlgorithm* pOverlapper = new OverlapAlgorithm(pBWTSet->get(i), pRBWTSet->get(i), 
+                                                             opt::errorRate, opt::seedLength, 
+                                                             opt::seedStride, opt::bIrreducibleOnly);
+
+        pOverlapper->setExactModeOverlap(opt::errorRate <= 0.0001);
+        pOverlapper->setExactModeIrreducible(opt::errorRate <= 0.0001);
+        overlappers.push_back(pOverlapper);
+    }
+
+    if(pBWTSet->getNumReplicas() > 1)
+        printf("[%s] loaded %zu copies of the FM-index\n", PROGRAM_IDENT, pBWTSet->getNumReplicas());
 
     Timer* pTimer = new Timer(PROGRAM_IDENT);
 
+    const BWT* pBWT = pBWTSet->get(ThreadPool::ANY_NODE);
     pBWT->printInfo();
+
+    // Determine the range of reads to process. The intermediate files
+    // of a shard are tagged so shards can share a working directory
+    size_t startIdx = 0;
+    size_t endIdx = -1;
+    std::string hitsPrefix = opt::prefix;
+    if(opt::shard.isSharded())
+    {
+        opt::shard.getReadRange(pBWT->getNumStrings(), startIdx, endIdx);
+        hitsPrefix += opt::shard.getTag();
+        printf("[%s] shard %d of %d: processing reads [%zu, %zu)\n", PROGRAM_IDENT, opt::shard.index, opt::shard.count, startIdx, endIdx);
+    }
+
     size_t count;
     if(opt::numThreads <= 1)
     {
         printf("[%s] starting serial-mode overlap computation\n", PROGRAM_IDENT);
-        count = computeHitsSerial(opt::prefix, opt::readsFile, pOverlapper, opt::minOverlap, hitsFilenames, pASQGWriter);
+        count = computeHitsSerial(hitsPrefix, opt::readsFile, overlappers.front(), opt::minOverlap, startIdx, endIdx, hitsFilenames, pASQGWriter);
     }
     else
     {
         printf("[%s] starting parallel-mode overlap computation with %d threads\n", PROGRAM_IDENT, opt::numThreads);
-        count = computeHitsParallel(opt::numThreads, opt::prefix, opt::readsFile, pOverlapper, opt::minOverlap, hitsFilenames, pASQGWriter);
+        count = computeHitsParallel(opt::numThreads, hitsPrefix, opt::readsFile, overlappers, opt::minOverlap, startIdx, endIdx, hitsFilenames, pASQGWriter);
     }
 
     // Get the number of strings in the BWT, this is used to pre-allocated the read table
-    delete pOverlapper;
-    delete pBWT; 
-    delete pRBWT;
+    for(size_t i = 0; i < overlappers.size(); ++i)
+        delete overlappers[i];
+    delete pBWTSet; 
+    delete pRBWTSet;
 
     // Parse the hits files and write the overlaps to the ASQG file
     convertHitsToASQG(hitsFilenames, pASQGWriter);
@@ -179,8 +220,8 @@ int overlapMain(int argc, char** argv)
     // Cleanup
     delete pASQGWriter;
     delete pTimer;
-    if(opt::numThreads > 1)
-        pthread_exit(NULL);
+    // Release the worker threads
+    ThreadPool::shutdown();
 
     return 0;
 }
@@ -189,6 +230,7 @@ int overlapMain(int argc, char** argv)
 // Return the number of reads processed
 size_t computeHitsSerial(const std::string& prefix, const std::string& readsFile, 
                          const OverlapAlgorithm* pOverlapper, int minOverlap, 
+                         size_t startIdx, size_t endIdx,
                          StringVector& filenameVec, std::ostream* pASQGWriter)
 {
     std::string filename = prefix + HITS_EXT + GZIP_EXT;
@@ -201,19 +243,25 @@ size_t computeHitsSerial(const std::string& prefix, const std::string& readsFile
            SequenceProcessFramework::processSequencesSerial<SequenceWorkItem,
                                                             OverlapResult, 
                                                             OverlapProcess, 
-                                                            OverlapPostProcess>(readsFile, &processor, &postProcessor);
+                                                            OverlapPostProcess>(readsFile, &processor, &postProcessor, 
+                                                                                endIdx, startIdx);
     return numProcessed;
 }
 
 // Compute the hits for each read in the SeqReader file with threading
 // The way this works is we create a vector of numThreads OverlapProcess pointers and 
 // pass this to the SequenceProcessFramework which wraps the processes
-// in threads and distributes the reads to each thread.
+// in threads and distributes the reads to each thread. If the index has been 
+// replicated, each process uses the overlapper for the NUMA node its thread runs on.
 // The number of reads processsed is returned
 size_t computeHitsParallel(int numThreads, const std::string& prefix, const std::string& readsFile, 
-                           const OverlapAlgorithm* pOverlapper, int minOverlap, 
+                           const std::vector<OverlapAlgorithm*>& overlappers, int minOverlap, 
+                           size_t startIdx, size_t endIdx,
                            StringVector& filenameVec, std::ostream* pASQGWriter)
 {
+    ThreadPool& pool = ThreadPool::getInstance();
+    const OverlapAlgorithm* pOverlapper = overlappers.front();
+
     std::string filename = prefix + HITS_EXT + GZIP_EXT;
 
     std::vector<OverlapProcess*> processorVector;
@@ -223,7 +271,9 @@ size_t computeHitsParallel(int numThreads, const std::string& prefix, const std:
         ss << prefix << "-thread" << i << HITS_EXT << GZIP_EXT;
         std::string outfile = ss.str();
         filenameVec.push_back(outfile);
-        OverlapProcess* pProcessor = new OverlapProcess(outfile, pOverlapper, minOverlap);
+        int node = pool.getNodeForWorker(i);
+        const OverlapAlgorithm* pLocalOverlapper = node == ThreadPool::ANY_NODE ? pOverlapper : overlappers[node % overlappers.size()];
+        OverlapProcess* pProcessor = new OverlapProcess(outfile, pLocalOverlapper, minOverlap);
         processorVector.push_back(pProcessor);
     }
 
@@ -234,7 +284,8 @@ size_t computeHitsParallel(int numThreads, const std::string& prefix, const std:
            SequenceProcessFramework::processSequencesParallel<SequenceWorkItem,
                                                               OverlapResult, 
                                                               OverlapProcess, 
-                                                              OverlapPostProcess>(readsFile, processorVector, &postProcessor);
+                                                              OverlapPostProcess>(readsFile, processorVector, &postProcessor,
+                                                                                  endIdx, startIdx);
     for(int i = 0; i < numThreads; ++i)
         delete processorVector[i];
     return numProcessed;
@@ -304,6 +355,14 @@ void parseOverlapOptions(int argc, char** argv)
             case 's': arg >> opt::seedStride; break;
             case 'd': arg >> opt::sampleRate; break;
             case OPT_EXACT: opt::bExactIrreducible = true; break;
+            case OPT_NUMA_REPLICATE: opt::bReplicateIndex = true; break;
+            case OPT_SHARD:
+                if(!ShardCommon::parseShardSpec(arg.str(), opt::shard))
+                {
+                    std::cerr << SUBPROGRAM ": invalid shard specification: " << arg.str() << ", expected I/N\n";
+                    die = true;
+                }
+                break;
             case 'x': opt::bIrreducibleOnly = false; break;
             case '?': die = true; break;
             case 'v': opt::verbose++; break;
@@ -367,4 +426,6 @@ void parseOverlapOptions(int argc, char** argv)
     {
         opt::outFile = opt::prefix + ASQG_EXT + GZIP_EXT;
     }
+
+    opt::outFile = opt::shard.tagFilename(opt::outFile);
 }
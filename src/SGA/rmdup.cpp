@@ -13,17 +13,18 @@
 #include "overlap.h"
 #include "Timer.h"
 #include "SGACommon.h"
-#include "OverlapCommon.h"
 #include "SequenceProcessFramework.h"
 #include "RmdupProcess.h"
 #include "BWTDiskConstruction.h"
+#include "ThreadPool.h"
+#include "ShardCommon.h"
 
 // functions
-size_t computeRmdupHitsSerial(const std::string& prefix, const std::string& readsFile, 
-                              const OverlapAlgorithm* pOverlapper, StringVector& filenameVec);
+size_t computeRmdupSerial(const std::string& readsFile, RmdupDecisionProcess* pProcessor,
+                          RmdupDecisionPostProcess* pPostProcessor, size_t startIdx, size_t endIdx);
  
-size_t computeRmdupHitsParallel(int numThreads, const std::string& prefix, const std::string& readsFile, 
-                                const OverlapAlgorithm* pOverlapper, StringVector& filenameVec);
+size_t computeRmdupParallel(int numThreads, const std::string& readsFile, RmdupDecisionProcess* pProcessor,
+                            RmdupDecisionPostProcess* pPostProcessor, size_t startIdx, size_t endIdx);
 
 //
 // Getopt
@@ -47,6 +48,9 @@ static const char *RMDUP_USAGE_MESSAGE =
 "      -t, --threads=N                  use N threads (default: 1)\n"
 "      -d, --sample-rate=N              sample the symbol counts every N symbols in the FM-index. Higher values use significantly\n"
 "                                       less memory at the cost of higher runtime. This value must be a power of 2 (default: 256)\n"
+"          --shard=I/N                  only process the I-th of N equal ranges of reads (0 <= I < N). The output files\n"
+"                                       are tagged with the shard and the indices are not rebuilt. Combine the outputs\n"
+"                                       of all the shards with sga merge-shards\n"
 "\nReport bugs to " PACKAGE_BUGREPORT "\n\n";
 
 static const char* PROGRAM_IDENT =
@@ -62,11 +66,12 @@ namespace opt
     static double errorRate;
     static bool bReindex = true;
     static int sampleRate = 256;
+    static ShardSpec shard;
 }
 
 static const char* shortopts = "p:o:e:t:d:v";
 
-enum { OPT_HELP = 1, OPT_VERSION, OPT_VALIDATE };
+enum { OPT_HELP = 1, OPT_VERSION, OPT_VALIDATE, OPT_SHARD };
 
 static const struct option longopts[] = {
     { "verbose",        no_argument,       NULL, 'v' },
@@ -75,6 +80,7 @@ static const struct option longopts[] = {
     { "error-rate",     required_argument, NULL, 'e' },
     { "threads",        required_argument, NULL, 't' },
     { "sample-rate",    required_argument, NULL, 'd' },
+    { "shard",          required_argument, NULL, OPT_SHARD },
     { "help",           no_argument,       NULL, OPT_HELP },
     { "version",        no_argument,       NULL, OPT_VERSION },
     { NULL, 0, NULL, 0 }
@@ -90,42 +96,85 @@ int rmdupMain(int argc, char** argv)
     rmdup();
     delete pTimer;
 
-    if(opt::numThreads > 1)
-        pthread_exit(NULL);
+    // Release the worker threads
+    ThreadPool::shutdown();
     return 0;
 }
 
 void rmdup()
 {
-    StringVector hitsFilenames;
     BWT* pBWT = new BWT(opt::prefix + BWT_EXT, opt::sampleRate);
     BWT* pRBWT = new BWT(opt::prefix + RBWT_EXT, opt::sampleRate);
     OverlapAlgorithm* pOverlapper = new OverlapAlgorithm(pBWT, pRBWT, 
                                                          opt::errorRate, 0, 
                                                          0, false);
+
+    // Load the suffix array index and the reverse suffix array index
+    // Note these are not the full suffix arrays
+    SuffixArray* pFwdSAI = new SuffixArray(opt::prefix + SAI_EXT);
+    SuffixArray* pRevSAI = new SuffixArray(opt::prefix + RSAI_EXT);
+
+    // Load the read table to look up the lengths of the reads and their ids.
+    // When rmduping a set of reads, the ReadInfoTable can actually be larger than the
+    // BWT if the names of the reads are very long. Previously, when two reads
+    // are duplicated, the read with the lexographically lower read name was chosen
+    // to be kept. To save memory here, we break ties using the index in the ReadInfoTable
+    // instead. This allows us to avoid loading the read names.
+    ReadInfoTable* pRIT = new ReadInfoTable(opt::readsFile, pFwdSAI->getNumStrings(), RIO_NUMERICID);
+
     Timer* pTimer = new Timer(PROGRAM_IDENT);
-    size_t count;
+
+    // Determine the range of reads to process
+    size_t startIdx = 0;
+    size_t endIdx = -1;
+    if(opt::shard.isSharded())
+    {
+        opt::shard.getReadRange(pBWT->getNumStrings(), startIdx, endIdx);
+        printf("[%s] shard %d of %d: processing reads [%zu, %zu)\n", PROGRAM_IDENT, opt::shard.index, opt::shard.count, startIdx, endIdx);
+    }
+
+    // The decision for each read is made by the worker threads. The post processor
+    // receives the reads in input order and writes each one to the output or the duplicates file
+    std::string out_prefix = stripFilename(opt::outFile);
+    std::string outFile = out_prefix + ".fa";
+    std::string dupsFile = out_prefix + ".dups.fa";
+    std::ostream* pWriter = createWriter(outFile);
+    std::ostream* pDupWriter = createWriter(dupsFile);
+
+    RmdupDecisionProcess processor(pOverlapper, pRIT, pFwdSAI, pRevSAI);
+    RmdupDecisionPostProcess* pPostProcessor = new RmdupDecisionPostProcess(pWriter, pDupWriter);
+
     if(opt::numThreads <= 1)
     {
-        printf("[%s] starting serial-mode overlap computation\n", PROGRAM_IDENT);
-        count = computeRmdupHitsSerial(opt::prefix, opt::readsFile, pOverlapper, hitsFilenames);
+        printf("[%s] starting serial-mode duplicate detection\n", PROGRAM_IDENT);
+        computeRmdupSerial(opt::readsFile, &processor, pPostProcessor, startIdx, endIdx);
     }
     else
     {
-        printf("[%s] starting parallel-mode overlap computation with %d threads\n", PROGRAM_IDENT, opt::numThreads);
-        count = computeRmdupHitsParallel(opt::numThreads, opt::prefix, opt::readsFile, pOverlapper, hitsFilenames);
+        printf("[%s] starting parallel-mode duplicate detection with %d threads\n", PROGRAM_IDENT, opt::numThreads);
+        computeRmdupParallel(opt::numThreads, opt::readsFile, &processor, pPostProcessor, startIdx, endIdx);
     }
 
+    delete pPostProcessor;
+    delete pWriter;
+    delete pDupWriter;
+
     delete pOverlapper;
     delete pBWT; 
     delete pRBWT;
+    delete pFwdSAI;
+    delete pRevSAI;
+    delete pRIT;
     delete pTimer;
-    
-    std::string out_prefix = stripFilename(opt::outFile);
-    std::string dupsFile = parseDupHits(hitsFilenames, out_prefix);
 
-    // Rebuild the indices without the duplicated sequences
-    if(opt::bReindex)
+    // Rebuild the indices without the duplicated sequences. A shard only knows
+    // about the duplicates in its own range so the indices must be rebuilt
+    // from the merged output instead
+    if(opt::bReindex && opt::shard.isSharded())
+    {
+        std::cout << "Skipping index rebuild for shard, run sga index on the merged output\n";
+    }
+    else if(opt::bReindex)
     {
         std::cout << "Rebuilding indices without duplicated reads\n";
         removeReadsFromIndices(opt::prefix, dupsFile, out_prefix, BWT_EXT, SAI_EXT, false, opt::numThreads);
@@ -133,210 +182,42 @@ void rmdup()
     }
 }
 
-// Compute the hits for each read in the input file without threading
+// Decide which reads are duplicates without threading
 // Return the number of reads processed
-size_t computeRmdupHitsSerial(const std::string& prefix, const std::string& readsFile, 
-                              const OverlapAlgorithm* pOverlapper, StringVector& filenameVec)
+size_t computeRmdupSerial(const std::string& readsFile, RmdupDecisionProcess* pProcessor,
+                          RmdupDecisionPostProcess* pPostProcessor, size_t startIdx, size_t endIdx)
 {
-    std::string filename = prefix + RMDUPHITS_EXT + GZIP_EXT;
-    filenameVec.push_back(filename);
-
-    RmdupProcess processor(filename, pOverlapper);
-    RmdupPostProcess postProcessor;
-
     size_t numProcessed = 
            SequenceProcessFramework::processSequencesSerial<SequenceWorkItem,
-                                                            OverlapResult, 
-                                                            RmdupProcess, 
-                                                            RmdupPostProcess>(readsFile, &processor, &postProcessor);
+                                                            RmdupResult, 
+                                                            RmdupDecisionProcess, 
+                                                            RmdupDecisionPostProcess>(readsFile, pProcessor, pPostProcessor,
+                                                                                      endIdx, startIdx);
     return numProcessed;
 }
 
-// Compute the hits for each read in the SeqReader file with threading
-// The way this works is we create a vector of numThreads OverlapProcess pointers and 
-// pass this to the SequenceProcessFragmework which wraps the processes
-// in threads and distributes the reads to each thread.
+// Decide which reads are duplicates with threading. Each thread gets its own
+// copy of the processor as the overlap block list is scratch space. The 
+// decisions are passed to the post processor in input order.
 // The number of reads processsed is returned
-size_t computeRmdupHitsParallel(int numThreads, const std::string& prefix, const std::string& readsFile, 
-                                const OverlapAlgorithm* pOverlapper, StringVector& filenameVec)
+size_t computeRmdupParallel(int numThreads, const std::string& readsFile, RmdupDecisionProcess* pProcessor,
+                            RmdupDecisionPostProcess* pPostProcessor, size_t startIdx, size_t endIdx)
 {
-    std::string filename = prefix + RMDUPHITS_EXT + GZIP_EXT;
-
-    std::vector<RmdupProcess*> processorVector;
+    std::vector<RmdupDecisionProcess*> processorVector;
     for(int i = 0; i < numThreads; ++i)
-    {
-        std::stringstream ss;
-        ss << prefix << "-thread" << i << RMDUPHITS_EXT << GZIP_EXT;
-        std::string outfile = ss.str();
-        filenameVec.push_back(outfile);
-        RmdupProcess* pProcessor = new RmdupProcess(outfile, pOverlapper);
-        processorVector.push_back(pProcessor);
-    }
+        processorVector.push_back(new RmdupDecisionProcess(*pProcessor));
 
-    // The post processing is performed serially so only one post processor is created
-    RmdupPostProcess postProcessor;
-    
     size_t numProcessed = 
            SequenceProcessFramework::processSequencesParallel<SequenceWorkItem,
-                                                              OverlapResult, 
-                                                              RmdupProcess, 
-                                                              RmdupPostProcess>(readsFile, processorVector, &postProcessor);
+                                                              RmdupResult, 
+                                                              RmdupDecisionProcess, 
+                                                              RmdupDecisionPostProcess>(readsFile, processorVector, pPostProcessor,
+                                                                                        endIdx, startIdx);
     for(int i = 0; i < numThreads; ++i)
         delete processorVector[i];
     return numProcessed;
 }
 
-std::string parseDupHits(const StringVector& hitsFilenames, const std::string& out_prefix)
-{
-    // Load the suffix array index and the reverse suffix array index
-    // Note these are not the full suffix arrays
-    SuffixArray* pFwdSAI = new SuffixArray(opt::prefix + SAI_EXT);
-    SuffixArray* pRevSAI = new SuffixArray(opt::prefix + RSAI_EXT);
-
-    // Load the read table to look up the lengths of the reads and their ids.
-    // When rmduping a set of reads, the ReadInfoTable can actually be larger than the
-    // BWT if the names of the reads are very long. Previously, when two reads
-    // are duplicated, the read with the lexographically lower read name was chosen
-    // to be kept. To save memory here, we break ties using the index in the ReadInfoTable
-    // instead. This allows us to avoid loading the read names.
-    ReadInfoTable* pRIT = new ReadInfoTable(opt::readsFile, pFwdSAI->getNumStrings(), RIO_NUMERICID);
-
-    std::string outFile = out_prefix + ".fa";
-    std::string dupFile = out_prefix + ".dups.fa";
-    std::ostream* pWriter = createWriter(outFile);
-    std::ostream* pDupWriter = createWriter(dupFile);
-
-    size_t substringRemoved = 0;
-    size_t identicalRemoved = 0;
-    size_t kept = 0;
-    size_t buffer_size = SequenceProcessFramework::BUFFER_SIZE;
-
-    // The reads must be output in their original ordering.
-    // The hits are in the blocks of buffer_size items. We read
-    // buffer_size items from the first hits file, then buffer_size
-    // from the second and so on until all the hits have been processed.
-    size_t num_files = hitsFilenames.size();
-    std::vector<std::istream*> reader_vec(num_files, 0);
-
-    for(size_t i = 0; i < num_files; ++i)
-    {
-        std::cout << "Opening " << hitsFilenames[i] << "\n";
-        reader_vec[i] = createReader(hitsFilenames[i]);
-    }
-
-    bool done = false;
-    size_t currReaderIdx = 0;
-    size_t numRead = 0;
-    size_t numReadersDone = 0;
-    std::string line;
-
-    while(!done)
-    {
-        // Parse a line from the current file
-        bool valid = getline(*reader_vec[currReaderIdx], line);
-        ++numRead;
-        // Deal with switching the active reader and the end of files
-        if(!valid || numRead == buffer_size)
-        {
-            // Switch the reader
-            currReaderIdx = (currReaderIdx + 1) % num_files;
-            numRead = 0;
-
-            // Break once all the readers are invalid
-            if(!valid)
-            {
-                ++numReadersDone;
-                if(numReadersDone == num_files)
-                {
-                    done = true;
-                    break;
-                }
-            }
-        }
-
-        // Parse the data
-        if(valid)
-        {
-            std::string id;
-            std::string sequence;
-            std::string hitsStr;
-            size_t readIdx;
-            bool isSubstring;
-
-            std::stringstream parser(line);
-            parser >> id;
-            parser >> sequence;
-            getline(parser, hitsStr);
-
-            OverlapVector ov;
-            OverlapCommon::parseHitsString(hitsStr, pRIT, pFwdSAI, pRevSAI, readIdx, ov, isSubstring);
-            
-            bool isContained = false;
-            if(isSubstring)
-            {
-                ++substringRemoved;
-                isContained = true;
-            }
-            else
-            {
-                for(OverlapVector::iterator iter = ov.begin(); iter != ov.end(); ++iter)
-                {
-                    if(iter->isContainment() && iter->getContainedIdx() == 0)
-                    {
-                        // This read is contained by some other read
-                        ++identicalRemoved;
-                        isContained = true;
-                        break;
-                    }
-                }
-            }
-
-            SeqItem item = {id, sequence};
-            if(isContained)
-            {
-                // The read's index in the sequence data base
-                // is needed when removing it from the FM-index.
-                // In the output fasta, we set the reads ID to be the index
-                // and record its old id in the fasta header.
-                std::stringstream newID;
-                newID << item.id << ",seqrank=" << readIdx;
-                item.id = newID.str();
-
-                // Write some metadata with the fasta record
-                std::stringstream meta;
-                meta << id << " NumOverlaps: " << ov.size();
-                item.write(*pDupWriter, meta.str());
-            }
-            else
-            {
-                ++kept;
-                // Write the read
-                item.write(*pWriter);
-            }
-        }
-    }
-
-    for(size_t i = 0; i < num_files; ++i)
-    {
-        delete reader_vec[i];
-        unlink(hitsFilenames[i].c_str());
-    }
-
-    
-    printf("[%s] Removed %zu substring reads\n", PROGRAM_IDENT, substringRemoved);
-    printf("[%s] Removed %zu identical reads\n", PROGRAM_IDENT, identicalRemoved);
-    printf("[%s] Kept %zu reads\n", PROGRAM_IDENT, kept);
-
-    // Delete allocated data
-    delete pFwdSAI;
-    delete pRevSAI;
-    delete pRIT;
-    delete pWriter;
-    delete pDupWriter;
-
-    return dupFile;
-}
-
 // 
 // Handle command line arguments
 //
@@ -355,6 +236,13 @@ void parseRmdupOptions(int argc, char** argv)
             case 'd': arg >> opt::sampleRate; break;
             case 't': arg >> opt::numThreads; break;
             case 'v': opt::verbose++; break;
+            case OPT_SHARD:
+                if(!ShardCommon::parseShardSpec(arg.str(), opt::shard))
+                {
+                    std::cerr << SUBPROGRAM ": invalid shard specification: " << arg.str() << ", expected I/N\n";
+                    die = true;
+                }
+                break;
             case OPT_HELP:
                 std::cout << RMDUP_USAGE_MESSAGE;
                 exit(EXIT_SUCCESS);
@@ -394,5 +282,7 @@ void parseRmdupOptions(int argc, char** argv)
     {
         opt::outFile = stripFilename(opt::readsFile) + ".rmdup.fa";
     }
+
+    opt::outFile = opt::shard.tagFilename(opt::outFile);
 }
 
@@ -15,6 +15,5 @@
 int rmdupMain(int argc, char** argv);
 void parseRmdupOptions(int argc, char** argv);
 void rmdup();
-std::string parseDupHits(const StringVector& hitsFilenames, const std::string& out_prefix);
 
 #endif
@@ -27,6 +27,7 @@
 #include "stats.h"
 #include "filterBAM.h"
 #include "cluster.h"
+#include "merge-shards.h"
 
 #define PROGRAM_BIN "sga"
 #define AUTHOR "Jared Simpson"
@@ -53,6 +54,7 @@ static const char *SGA_USAGE_MESSAGE =
 "           oview           view overlap alignments\n"
 "           subgraph        extract a subgraph from a graph\n"
 "           filter          remove reads from a data set\n"
+"           merge-shards    combine the output files of a job split with --shard\n"
 "\n\nExperimental commands:\n"
 "           stats           print useful statistics about the read set\n"
 "           connect         resolve the complete sequence of a paired-end fragment\n"
@@ -123,6 +125,8 @@ int main(int argc, char** argv)
             filterBAMMain(argc - 1, argv + 1);
         else if(command == "cluster")
             clusterMain(argc - 1, argv + 1);
+        else if(command == "merge-shards")
+            mergeShardsMain(argc - 1, argv + 1);
         else
         {
             std::cerr << "Unrecognized command: " << command << "\n";
@@ -23,6 +23,8 @@
 #include "SequenceProcessFramework.h"
 #include "StatsProcess.h"
 #include "BWTDiskConstruction.h"
+#include "ThreadPool.h"
+#include "KmerCommon.h"
 
 // Functions
 
@@ -49,10 +51,14 @@ static const char *STATS_USAGE_MESSAGE =
 "                                       less memory at the cost of higher runtime. This value must be a power of 2 (default: 128)\n"
 "      -k, --kmer-size=N                The length of the kmer to use. (default: 27)\n"
 "      -n, --num-reads=N                Only use N reads to compute the statistics\n"
+"      -s, --sample=N                   estimate the statistics from N reads drawn uniformly at random from the FM-index\n"
+"                                       instead of reading READSFILE. 95% confidence intervals are printed for the estimates\n"
+"          --seed=N                     use N as the seed for --sample (default: based on the time)\n"
 "      -b, --branch-cutoff=N            stop the overlap search at N branches. This lowers the compute time but will bias the statistics\n"
 "                                       away from repetitive reads\n"
 "      --run-lengths                    Print the run length distribution of the BWT\n"
-"      --kmer-distribution              Print the distribution of kmer counts\n"
+"      --kmer-distribution              Print the distribution of kmer counts. The distribution is saved to PREFIX.kN.stats.kdist\n"
+"                                       and reused by later runs with --no-overlap and the same reads\n"
 "      --no-overlap                     Suppress the overlap-based error statistics (faster if you only want the k-mer distribution)\n"
 "\nReport bugs to " PACKAGE_BUGREPORT "\n\n";
 
@@ -73,11 +79,14 @@ namespace opt
     static bool bPrintRunLengths = false;
     static bool bPrintKmerDist = false;
     static bool bNoOverlap = false;
+    static size_t numSamples = 0;
+    static unsigned int seed = 0;
+    static bool bSeed = false;
 }
 
-static const char* shortopts = "p:d:t:o:k:n:b:v";
+static const char* shortopts = "p:d:t:o:k:n:b:s:v";
 
-enum { OPT_HELP = 1, OPT_VERSION, OPT_RUNLENGTHS, OPT_KMERDIST, OPT_NOOVERLAP};
+enum { OPT_HELP = 1, OPT_VERSION, OPT_RUNLENGTHS, OPT_KMERDIST, OPT_NOOVERLAP, OPT_SEED };
 
 static const struct option longopts[] = {
     { "verbose",            no_argument,       NULL, 'v' },
@@ -87,6 +96,8 @@ static const struct option longopts[] = {
     { "kmer-size",          required_argument, NULL, 'k' },
     { "num-reads",          required_argument, NULL, 'n' },
     { "branch-cutoff",      required_argument, NULL, 'b' },
+    { "sample",             required_argument, NULL, 's' },
+    { "seed",               required_argument, NULL, OPT_SEED },
     { "kmer-distribution",  no_argument,       NULL, OPT_KMERDIST },
     { "no-overlap",         no_argument,       NULL, OPT_NOOVERLAP },
     { "run-lengths",        no_argument,       NULL, OPT_RUNLENGTHS },
@@ -112,12 +123,59 @@ int statsMain(int argc, char** argv)
         pBWT->printRunLengths();
     }
 
-    SeqReader reader(opt::readsFile);
-    
     StatsPostProcess postProcessor(opt::bPrintKmerDist);
-    if(opt::numThreads <= 1)
+
+    // The kmer distribution is cached next to the index. If only the
+    // distribution is wanted and it has been computed from the same reads
+    // before, the reads do not need to be processed again
+    std::string distFile = KmerCommon::getDistributionFilename(opt::prefix, opt::kmerLength, "stats");
+    std::stringstream source;
+    source << "all kmers of ";
+    if(opt::numReads != (size_t)-1)
+        source << "the first " << opt::numReads << " reads of ";
+    else if(opt::numSamples > 0)
+        source << opt::numSamples << " reads sampled with seed " << opt::seed << " from ";
+    source << opt::readsFile;
+    std::string indexKey = KmerCommon::getIndexKey(opt::prefix + BWT_EXT, pBWT, opt::kmerLength, source.str());
+
+    bool bCachedDist = false;
+    if(opt::bPrintKmerDist && opt::bNoOverlap)
+    {
+        KmerDistribution cachedDist;
+        std::string cachedKey;
+        std::string cachedSource;
+        if(cachedDist.readFile(distFile, cachedKey, cachedSource) && cachedKey == indexKey)
+        {
+            postProcessor.setKmerDistribution(cachedDist);
+            bCachedDist = true;
+        }
+    }
+
+    if(bCachedDist)
+    {
+        std::cout << "Using the kmer distribution in " << distFile << "\n";
+    }
+    else if(opt::numSamples > 0)
+    {
+        // Sampling mode
+        printf("[%s] sampling %zu reads with seed %u\n", PROGRAM_IDENT, opt::numSamples, opt::seed);
+        postProcessor.setPopulationSize(pBWT->getNumStrings());
+
+        std::vector<StatsProcess*> processorVector;
+        for(int i = 0; i < opt::numThreads; ++i)
+            processorVector.push_back(new StatsProcess(pBWT, pRBWT, opt::kmerLength, opt::minOverlap, opt::branchCutoff, opt::bNoOverlap));
+
+        SequenceProcessFramework::processSequencesSampled<StatsResult,
+                                                          StatsProcess,
+                                                          StatsPostProcess>(pBWT, opt::numSamples, opt::seed, processorVector, &postProcessor);
+
+        for(int i = 0; i < opt::numThreads; ++i)
+            delete processorVector[i];
+    }
+    else if(opt::numThreads <= 1)
     {
         // Serial mode
+        SeqReader reader(opt::readsFile);
         StatsProcess processor(pBWT, pRBWT, opt::kmerLength, opt::minOverlap, opt::branchCutoff, opt::bNoOverlap);
 
         SequenceProcessFramework::processSequencesSerial<SequenceWorkItem,
@@ -128,6 +186,7 @@ int statsMain(int argc, char** argv)
     else
     {
         // Parallel mode
+        SeqReader reader(opt::readsFile);
         std::vector<StatsProcess*> processorVector;
         for(int i = 0; i < opt::numThreads; ++i)
         {
@@ -146,12 +205,15 @@ int statsMain(int argc, char** argv)
         }
     }
 
+    if(opt::bPrintKmerDist && !bCachedDist)
+        postProcessor.getKmerDistribution().writeFile(distFile, indexKey, source.str());
+
     delete pBWT;
     delete pRBWT;
     delete pTimer;
 
-    if(opt::numThreads > 1)
-        pthread_exit(NULL);
+    // Release the worker threads
+    ThreadPool::shutdown();
 
     return 0;
 }
@@ -174,6 +236,8 @@ void parseStatsOptions(int argc, char** argv)
             case 'k': arg >> opt::kmerLength; break;
             case 'n': arg >> opt::numReads; break;
             case 'b': arg >> opt::branchCutoff; break;
+            case 's': arg >> opt::numSamples; break;
+            case OPT_SEED: arg >> opt::seed; opt::bSeed = true; break;
             case '?': die = true; break;
             case 'v': opt::verbose++; break;
             case OPT_KMERDIST: opt::bPrintKmerDist = true; break;
@@ -211,6 +275,12 @@ void parseStatsOptions(int argc, char** argv)
         die = true;
     }
 
+    if(opt::numSamples > 0 && opt::numReads != (size_t)-1)
+    {
+        std::cerr << SUBPROGRAM ": --sample and --num-reads cannot be used together\n";
+        die = true;
+    }
+
     if (die) 
     {
         std::cout << "\n" << STATS_USAGE_MESSAGE;
@@ -224,4 +294,7 @@ void parseStatsOptions(int argc, char** argv)
     {
         opt::prefix = stripFilename(opt::readsFile);
     }
+
+    if(!opt::bSeed)
+        opt::seed = time(0);
 }
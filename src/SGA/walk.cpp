@@ -18,11 +18,13 @@
 #include "Timer.h"
 #include "SGSearch.h"
 #include "Bigraph.h"
+#include "CompactGraph.h"
 
 // functions
-void pairWalk(StringGraph* pGraph, SGWalkVector& outWalks);
-void explicitWalk(StringGraph* pGraph, SGWalkVector& outWalks);
-void componentWalk(StringGraph* pGraph, SGWalkVector& outWalks);
+void pairWalk(const CompactGraph* pGraph, CompactWalkVector& outWalks);
+void explicitWalk(const CompactGraph* pGraph, CompactWalkVector& outWalks);
+void componentWalk(const CompactGraph* pGraph, CompactWalkVector& outWalks);
+CompactGraph::VertexIdx findWalkVertex(const CompactGraph* pGraph, const std::string& id);
 
 //
 // Getopt
@@ -100,7 +102,11 @@ int walkMain(int argc, char** argv)
 
 void walk()
 {
-    StringGraph* pGraph = SGUtil::loadASQG(opt::asqgFile, 0, true);
+    // The graph is only searched so the walks are found
+    // on the compact read-only representation of it
+    StringGraph* pStringGraph = SGUtil::loadASQG(opt::asqgFile, 0, true);
+    CompactGraph* pGraph = new CompactGraph(pStringGraph);
+    delete pStringGraph;
     pGraph->printMemSize();
     std::ostream* pWriter = createWriter(opt::outFile);
     std::ostream* pDescWriter = NULL;
@@ -110,7 +116,7 @@ void walk()
     }
 
     // Build walks
-    SGWalkVector walkVector;
+    CompactWalkVector walkVector;
     if(!opt::id1.empty() && !opt::id2.empty())
     {
         pairWalk(pGraph, walkVector);
@@ -131,7 +137,7 @@ void walk()
     // Output walks
     for(size_t i = 0; i < walkVector.size(); ++i)
     {
-        SGWalk& walk = walkVector[i];
+        CompactWalk& walk = walkVector[i];
 
         std::stringstream idSS;
         if(opt::prefix.empty())
@@ -142,7 +148,7 @@ void walk()
         }
         std::string walkID = idSS.str();
 
-        std::string str = walk.getString(SGWT_START_TO_END);
+        std::string str = walk.getString();
         if(opt::verbose > 0)
         {
             std::cout << walkID << "\n";
@@ -154,7 +160,7 @@ void walk()
         if(pDescWriter != NULL)
         {
             for(size_t j = 0; j < walk.getNumVertices(); ++j)
-                *pDescWriter << walkID << "\t" << walk.getVertex(j)->getID() << "\n";
+                *pDescWriter << walkID << "\t" << pGraph->getName(walk.getVertexIdx(j)) << "\n";
         }
 
         writeFastaRecord(pWriter, walkID, str);
@@ -166,48 +172,69 @@ void walk()
         delete pDescWriter;
 }
 
+// Returns the index of the vertex with the given ID, exiting if there is no such vertex
+CompactGraph::VertexIdx findWalkVertex(const CompactGraph* pGraph, const std::string& id)
+{
+    CompactGraph::VertexIdx idx = pGraph->findVertex(id);
+    if(idx == CompactGraph::INVALID_VERTEX)
+    {
+        std::cerr << "[sga walk] Error: vertex " << id << " not found\n";
+        exit(EXIT_FAILURE);
+    }
+    return idx;
+}
+
 // Find walks between a pair of vertices
-void pairWalk(StringGraph* pGraph, SGWalkVector& outWalks)
+void pairWalk(const CompactGraph* pGraph, CompactWalkVector& outWalks)
 {
     // Search the the walk between id1 and id2
-    Vertex* pX = pGraph->getVertex(opt::id1);
-    Vertex* pY = pGraph->getVertex(opt::id2);
-    SGSearch::findWalks(pX, pY, ED_SENSE, opt::maxDistance, 1000, false, outWalks);
-    SGSearch::findWalks(pX, pY, ED_ANTISENSE, opt::maxDistance, 1000, false, outWalks);
+    CompactGraph::VertexIdx xIdx = findWalkVertex(pGraph, opt::id1);
+    CompactGraph::VertexIdx yIdx = findWalkVertex(pGraph, opt::id2);
+    SGSearch::findWalks(pGraph, xIdx, yIdx, ED_SENSE, opt::maxDistance, 1000, false, outWalks);
+    SGSearch::findWalks(pGraph, xIdx, yIdx, ED_ANTISENSE, opt::maxDistance, 1000, false, outWalks);
 }
 
 // Find walks using an explicitly provided string
-void explicitWalk(StringGraph* pGraph, SGWalkVector& outWalks)
+void explicitWalk(const CompactGraph* pGraph, CompactWalkVector& outWalks)
 {
     std::cout << "Building walk from string: " << opt::walkStr << "\n";
     StringVector vertIDs = split(opt::walkStr, ',');
     assert(vertIDs.size() > 0);
-    Vertex* pCurr = pGraph->getVertex(vertIDs.front());
-    SGWalk out(pCurr);
+    CompactGraph::VertexIdx currIdx = findWalkVertex(pGraph, vertIDs.front());
+    CompactWalk out(pGraph, currIdx);
     
     for(size_t i = 1; i < vertIDs.size(); ++i)
     {
-        Vertex* pNext = pGraph->getVertex(vertIDs[i]);
-        EdgePtrVec epv = pCurr->findEdgesTo(pNext->getID());
-        if(epv.size() == 0)
+        CompactGraph::VertexIdx nextIdx = findWalkVertex(pGraph, vertIDs[i]);
+        CompactEdgePtrVec edges;
+        pGraph->getEdges(currIdx, ED_SENSE, edges);
+        pGraph->getEdges(currIdx, ED_ANTISENSE, edges);
+
+        const CompactEdge* pFound = NULL;
+        for(size_t j = 0; j < edges.size() && pFound == NULL; ++j)
         {
-            std::cerr << "[sga walk] Error: edge between " << pCurr->getID() << " and " << pNext->getID() << " not found\n";
+            if(pGraph->getEndIdx(edges[j]) == nextIdx)
+                pFound = edges[j];
+        }
+
+        if(pFound == NULL)
+        {
+            std::cerr << "[sga walk] Error: edge between " << vertIDs[i - 1] << " and " << vertIDs[i] << " not found\n";
             exit(EXIT_FAILURE);
         }
-        out.addEdge(epv.front());
-        pCurr = pNext;
+        out.addEdge(pFound);
+        currIdx = nextIdx;
     }
 
     outWalks.push_back(out);
 }
 
 // Find all walks through the largest component of the graph
-void componentWalk(StringGraph* pGraph, SGWalkVector& outWalks)
+void componentWalk(const CompactGraph* pGraph, CompactWalkVector& outWalks)
 {
-    typedef std::vector<VertexPtrVec> ComponentVector;
-    VertexPtrVec allVertices = pGraph->getAllVertices();
+    typedef std::vector<std::vector<CompactGraph::VertexIdx> > ComponentVector;
     ComponentVector components;
-    SGSearchTree::connectedComponents(allVertices, components);
+    pGraph->getConnectedComponents(components);
 
     // Select the largest component
     int selectedIdx = -1;
@@ -224,47 +251,42 @@ void componentWalk(StringGraph* pGraph, SGWalkVector& outWalks)
     }
 
     assert(selectedIdx != -1);
-    VertexPtrVec selectedComponent = components[selectedIdx];
+    const std::vector<CompactGraph::VertexIdx>& selectedComponent = components[selectedIdx];
 
     std::cout << "component-walk: selected component of size " << selectedComponent.size() << "\n";
 
     // Build a vector of the terminal vertices
-    VertexPtrVec terminals;
+    std::vector<CompactGraph::VertexIdx> terminals;
     for(size_t i = 0; i < selectedComponent.size(); ++i)
     {
-        Vertex* pVertex = selectedComponent[i];
-        size_t asCount = pVertex->getEdges(ED_ANTISENSE).size();
-        size_t sCount = pVertex->getEdges(ED_SENSE).size();
-
-        if(asCount == 0 || sCount == 0)
-            terminals.push_back(pVertex);
+        CompactGraph::VertexIdx idx = selectedComponent[i];
+        if(pGraph->countEdges(idx, ED_ANTISENSE) == 0 || pGraph->countEdges(idx, ED_SENSE) == 0)
+            terminals.push_back(idx);
     }
 
     std::cout << "selected component has " << terminals.size() << " terminal vertices\n";
 
     // Find walks between all-pairs of terminal vertices
-    SGWalkVector tempWalks;
+    CompactWalkVector tempWalks;
     for(size_t i = 0; i < terminals.size(); ++i)
     {
         for(size_t j = i + 1; j < terminals.size(); j++)
         {
-            Vertex* pX = terminals[i];
-            Vertex* pY = terminals[j];
-            SGSearch::findWalks(pX, pY, ED_SENSE, opt::maxDistance, 1000, false, tempWalks);
-            SGSearch::findWalks(pX, pY, ED_ANTISENSE, opt::maxDistance, 1000, false, tempWalks);   
+            SGSearch::findWalks(pGraph, terminals[i], terminals[j], ED_SENSE, opt::maxDistance, 1000, false, tempWalks);
+            SGSearch::findWalks(pGraph, terminals[i], terminals[j], ED_ANTISENSE, opt::maxDistance, 1000, false, tempWalks);   
         }
     }
 
     // Remove duplicate walks
-    std::map<std::string, SGWalk> walkMap;
+    std::map<std::string, CompactWalk> walkMap;
     for(size_t i = 0; i < tempWalks.size(); ++i)
     {
-        std::string walkString = tempWalks[i].getString(SGWT_START_TO_END);
+        std::string walkString = tempWalks[i].getString();
         walkMap.insert(std::make_pair(walkString, tempWalks[i]));
     }
 
     // Copy unique walks to the output
-    for(std::map<std::string, SGWalk>::iterator mapIter = walkMap.begin(); mapIter != walkMap.end(); ++mapIter)
+    for(std::map<std::string, CompactWalk>::iterator mapIter = walkMap.begin(); mapIter != walkMap.end(); ++mapIter)
     {
         outWalks.push_back(mapIter->second);
     }
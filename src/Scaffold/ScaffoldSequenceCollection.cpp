@@ -24,7 +24,7 @@ std::string GraphSequenceCollection::getSequence(const std::string& id) const
 {
     Vertex* pVertex = m_pGraph->getVertex(id);
     assert(pVertex != NULL);
-    return pVertex->getSeq().toString();
+    return pVertex->getStr();
 }
 
 // 
@@ -51,7 +51,7 @@ struct UnplacedVisitor
         {
             std::stringstream idss;
             idss << "unplaced-" << m_numUnplaced++;
-            writeFastaRecord(m_pWriter, idss.str(), pVertex->getSeq().toString());
+            writeFastaRecord(m_pWriter, idss.str(), pVertex->getStr());
         }
         return false;
     }
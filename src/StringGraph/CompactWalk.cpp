@@ -0,0 +1,82 @@
+//-----------------------------------------------
+// Copyright 2010 Wellcome Trust Sanger Institute
+// Written by Jared Simpson (js18@sanger.ac.uk)
+// Released under the GPL
+//-----------------------------------------------
+//
+// CompactWalk - Data structure holding a walk
+// through a CompactGraph
+//
+#include <iostream>
+#include "CompactWalk.h"
+#include "Util.h"
+
+//
+CompactWalk::CompactWalk(const CompactGraph* pGraph, CompactGraph::VertexIdx startIdx) : m_pGraph(pGraph), 
+                                                                                          m_startIdx(startIdx)
+{
+
+}
+
+//
+void CompactWalk::addEdge(const CompactEdge* pEdge)
+{
+    assert(m_pGraph->getStartIdx(pEdge) == getVertexIdx(m_edges.size()));
+    m_edges.push_back(pEdge);
+}
+
+//
+CompactGraph::VertexIdx CompactWalk::getVertexIdx(size_t i) const
+{
+    assert(i < getNumVertices());
+    return i == 0 ? m_startIdx : m_pGraph->getEndIdx(m_edges[i - 1]);
+}
+
+//
+std::string CompactWalk::getString() const
+{
+    std::string out = m_pGraph->getSeq(m_startIdx);
+
+    // The labels are appended in the frame of the start vertex.
+    // currComp tracks whether the current vertex is reversed
+    // relative to the start vertex.
+    EdgeComp currComp = EC_SAME;
+
+    // If the walk direction is antisense, we reverse every component and then
+    // reverse the entire string to generate the final string
+    bool reverseAll = !m_edges.empty() && m_pGraph->getDir(m_edges[0]) == ED_ANTISENSE;
+    if(reverseAll)
+        out = reverse(out);
+
+    for(size_t i = 0; i < m_edges.size(); ++i)
+    {
+        std::string edge_str = m_pGraph->getLabel(m_edges[i]);
+        assert(edge_str.size() != 0);
+        if(currComp == EC_REVERSE)
+            edge_str = reverseComplement(edge_str);
+
+        if(reverseAll)
+            edge_str = reverse(edge_str);
+
+        if(m_pGraph->getComp(m_edges[i]) == EC_REVERSE)
+            currComp = !currComp;
+        out.append(edge_str);
+    }
+
+    if(reverseAll)
+        out = reverse(out);
+    return out;
+}
+
+//
+void CompactWalk::print() const
+{
+    std::cout << "Walk start: " << m_pGraph->getName(m_startIdx) << "\nWalk: ";
+    for(size_t i = 0; i < m_edges.size(); ++i)
+    {
+        const CompactEdge* pEdge = m_edges[i];
+        std::cout << m_pGraph->getName(getVertexIdx(i)) << " -- " << m_pGraph->getName(getVertexIdx(i + 1)) 
+                  << "," << m_pGraph->getDir(pEdge) << "," << m_pGraph->getComp(pEdge) << "\t";
+    }
+    std::cout << "\n";
+}
@@ -0,0 +1,43 @@
+//-----------------------------------------------
+// Copyright 2010 Wellcome Trust Sanger Institute
+// Written by Jared Simpson (js18@sanger.ac.uk)
+// Released under the GPL
+//-----------------------------------------------
+//
+// CompactWalk - Data structure holding a walk
+// through a CompactGraph
+//
+#ifndef COMPACTWALK_H
+#define COMPACTWALK_H
+
+#include "CompactGraph.h"
+
+class CompactWalk
+{
+    public:
+
+        CompactWalk(const CompactGraph* pGraph, CompactGraph::VertexIdx startIdx);
+
+        void addEdge(const CompactEdge* pEdge);
+
+        size_t getNumVertices() const { return m_edges.size() + 1; }
+        size_t getNumEdges() const { return m_edges.size(); }
+
+        // Returns the index of the i-th vertex of the walk, the start vertex is vertex 0
+        CompactGraph::VertexIdx getVertexIdx(size_t i) const;
+
+        // Returns the sequence of the walk from the start of the first vertex
+        // to the end of the last vertex, see SGWalk::getString(SGWT_START_TO_END)
+        std::string getString() const;
+
+        void print() const;
+
+    private:
+        const CompactGraph* m_pGraph;
+        CompactGraph::VertexIdx m_startIdx;
+        CompactEdgePtrVec m_edges;
+};
+
+typedef std::vector<CompactWalk> CompactWalkVector;
+
+#endif
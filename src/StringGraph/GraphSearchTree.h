@@ -18,12 +18,26 @@
 #include <deque>
 #include <queue>
 
-template<typename VERTEX, typename EDGE, typename DISTANCE>
+// The functions GraphSearchTree uses to move through the graph. The default
+// accessor calls the member functions of the vertex and edge types. Graphs
+// whose vertices and edges cannot navigate on their own (like CompactGraph)
+// provide an accessor object that holds a pointer to the graph.
+template<typename VERTEX, typename EDGE>
+struct GraphMemberAccessor
+{
+    std::vector<EDGE*> getEdges(VERTEX* pVertex, EdgeDir dir) const { return pVertex->getEdges(dir); }
+    VERTEX* getEnd(EDGE* pEdge) const { return pEdge->getEnd(); }
+
+    // The direction to continue the search in from the end of pEdge
+    EdgeDir getExpandDir(EDGE* pEdge) const { return !pEdge->getTwin()->getDir(); }
+};
+
+template<typename VERTEX, typename EDGE, typename DISTANCE, typename ACCESSOR = GraphMemberAccessor<VERTEX, EDGE> >
 class GraphSearchNode
 {
     // Typedefs
     public:
-        typedef std::deque<GraphSearchNode<VERTEX,EDGE,DISTANCE>* > GraphSearchNodePtrDeque;
+        typedef std::deque<GraphSearchNode<VERTEX,EDGE,DISTANCE,ACCESSOR>* > GraphSearchNodePtrDeque;
         typedef std::vector<EDGE*> _EDGEPtrVector;
 
     public:
@@ -35,7 +49,7 @@ class GraphSearchNode
 
         // Create the children of this node and place pointers to their nodes
         // on the queue. Returns the number of children created;
-        int createChildren(GraphSearchNodePtrDeque& outQueue, const DISTANCE& distanceFunc);
+        int createChildren(GraphSearchNodePtrDeque& outQueue, const DISTANCE& distanceFunc, const ACCESSOR& accessor);
 
         GraphSearchNode* getParent() const { return m_pParent; }
         VERTEX* getVertex() const { return m_pVertex; }
@@ -55,11 +69,11 @@ class GraphSearchNode
         int64_t m_distance;
 };
 
-template<typename VERTEX, typename EDGE, typename DISTANCE>
+template<typename VERTEX, typename EDGE, typename DISTANCE, typename ACCESSOR = GraphMemberAccessor<VERTEX, EDGE> >
 class GraphSearchTree
 {
     // typedefs
-    typedef GraphSearchNode<VERTEX,EDGE,DISTANCE> _SearchNode;
+    typedef GraphSearchNode<VERTEX,EDGE,DISTANCE,ACCESSOR> _SearchNode;
     typedef typename _SearchNode::GraphSearchNodePtrDeque _SearchNodePtrDeque;
     typedef typename std::set<_SearchNode*> _SearchNodePtrSet;
     typedef std::vector<EDGE*> WALK; // list of edges defines a walk through the graph
@@ -74,7 +88,9 @@ class GraphSearchTree
                      VERTEX* pEndVertex,
                      EdgeDir searchDir,
                      int64_t distanceLimit,
-                     size_t nodeLimit);
+                     size_t nodeLimit,
+                     const DISTANCE& distanceFunc = DISTANCE(),
+                     const ACCESSOR& accessor = ACCESSOR());
 
         ~GraphSearchTree();
 
@@ -153,13 +169,16 @@ class GraphSearchTree
 
         // Distance functor
         DISTANCE m_distanceFunc;
+
+        // Graph accessor
+        ACCESSOR m_accessor;
 };
 
 //
-template<typename VERTEX, typename EDGE, typename DISTANCE>
-GraphSearchNode<VERTEX,EDGE,DISTANCE>::GraphSearchNode(VERTEX* pVertex,
+template<typename VERTEX, typename EDGE, typename DISTANCE, typename ACCESSOR>
+GraphSearchNode<VERTEX,EDGE,DISTANCE,ACCESSOR>::GraphSearchNode(VERTEX* pVertex,
                            EdgeDir expandDir,
-                           GraphSearchNode<VERTEX,EDGE,DISTANCE>* pParent,
+                           GraphSearchNode<VERTEX,EDGE,DISTANCE,ACCESSOR>* pParent,
                            EDGE* pEdgeFromParent,
                            int distance) : m_pVertex(pVertex),
                                                     m_expandDir(expandDir),
@@ -183,8 +202,8 @@ GraphSearchNode<VERTEX,EDGE,DISTANCE>::GraphSearchNode(VERTEX* pVertex,
 // Delete this node and decrement the number of children
 // in the parent node. All children of a node must
 // be deleted before the parent
-template<typename VERTEX, typename EDGE, typename DISTANCE>
-GraphSearchNode<VERTEX,EDGE,DISTANCE>::~GraphSearchNode()
+template<typename VERTEX, typename EDGE, typename DISTANCE, typename ACCESSOR>
+GraphSearchNode<VERTEX,EDGE,DISTANCE,ACCESSOR>::~GraphSearchNode()
 {
     assert(m_numChildren == 0);
     if(m_pParent != NULL)
@@ -192,8 +211,8 @@ GraphSearchNode<VERTEX,EDGE,DISTANCE>::~GraphSearchNode()
 }
 
 //
-template<typename VERTEX, typename EDGE, typename DISTANCE>
-void GraphSearchNode<VERTEX,EDGE,DISTANCE>::decrementChildren()
+template<typename VERTEX, typename EDGE, typename DISTANCE, typename ACCESSOR>
+void GraphSearchNode<VERTEX,EDGE,DISTANCE,ACCESSOR>::decrementChildren()
 {
     assert(m_numChildren != 0);
     m_numChildren -= 1;
@@ -202,17 +221,19 @@ void GraphSearchNode<VERTEX,EDGE,DISTANCE>::decrementChildren()
 // creates nodes for the children of this node
 // and place pointers to them in the queue.
 // Returns the number of nodes created
-template<typename VERTEX, typename EDGE, typename DISTANCE>
-int GraphSearchNode<VERTEX,EDGE,DISTANCE>::createChildren(GraphSearchNodePtrDeque& outDeque, const DISTANCE& distanceFunc)
+template<typename VERTEX, typename EDGE, typename DISTANCE, typename ACCESSOR>
+int GraphSearchNode<VERTEX,EDGE,DISTANCE,ACCESSOR>::createChildren(GraphSearchNodePtrDeque& outDeque, 
+                                                                   const DISTANCE& distanceFunc,
+                                                                   const ACCESSOR& accessor)
 {
     assert(m_numChildren == 0);
 
-    _EDGEPtrVector edges = m_pVertex->getEdges(m_expandDir);
+    _EDGEPtrVector edges = accessor.getEdges(m_pVertex, m_expandDir);
 
     for(size_t i = 0; i < edges.size(); ++i)
     {
-        EdgeDir childExpandDir = !edges[i]->getTwin()->getDir();
-        GraphSearchNode* pNode = new GraphSearchNode(edges[i]->getEnd(), childExpandDir, this, edges[i], distanceFunc(edges[i]));
+        EdgeDir childExpandDir = accessor.getExpandDir(edges[i]);
+        GraphSearchNode* pNode = new GraphSearchNode(accessor.getEnd(edges[i]), childExpandDir, this, edges[i], distanceFunc(edges[i]));
         outDeque.push_back(pNode);
         m_numChildren += 1;
     }
@@ -222,18 +243,22 @@ int GraphSearchNode<VERTEX,EDGE,DISTANCE>::createChildren(GraphSearchNodePtrDequ
 //
 // GraphSearchTree
 //
-template<typename VERTEX, typename EDGE, typename DISTANCE>
-GraphSearchTree<VERTEX,EDGE,DISTANCE>::GraphSearchTree(VERTEX* pStartVertex, 
+template<typename VERTEX, typename EDGE, typename DISTANCE, typename ACCESSOR>
+GraphSearchTree<VERTEX,EDGE,DISTANCE,ACCESSOR>::GraphSearchTree(VERTEX* pStartVertex, 
                                                        VERTEX* pEndVertex, 
                                                        EdgeDir searchDir,
                                                        int64_t distanceLimit,
-                                                       size_t nodeLimit) : m_pGoalVertex(pEndVertex),
-                                                                           m_distanceLimit(distanceLimit),
-                                                                           m_nodeLimit(nodeLimit),
-                                                                           m_searchAborted(false)
+                                                       size_t nodeLimit,
+                                                       const DISTANCE& distanceFunc,
+                                                       const ACCESSOR& accessor) : m_pGoalVertex(pEndVertex),
+                                                                                   m_distanceLimit(distanceLimit),
+                                                                                   m_nodeLimit(nodeLimit),
+                                                                                   m_searchAborted(false),
+                                                                                   m_distanceFunc(distanceFunc),
+                                                                                   m_accessor(accessor)
 {
     // Create the root node of the search tree
-    m_pRootNode = new GraphSearchNode<VERTEX, EDGE, DISTANCE>(pStartVertex, searchDir, NULL, NULL, 0);
+    m_pRootNode = new GraphSearchNode<VERTEX,EDGE,DISTANCE,ACCESSOR>(pStartVertex, searchDir, NULL, NULL, 0);
 
     // add the root to the expand queue
     m_expandQueue.push_back(m_pRootNode);
@@ -241,8 +266,8 @@ GraphSearchTree<VERTEX,EDGE,DISTANCE>::GraphSearchTree(VERTEX* pStartVertex,
     m_totalNodes = 1;
 }
 
-template<typename VERTEX, typename EDGE, typename DISTANCE>
-GraphSearchTree<VERTEX,EDGE,DISTANCE>::~GraphSearchTree()
+template<typename VERTEX, typename EDGE, typename DISTANCE, typename ACCESSOR>
+GraphSearchTree<VERTEX,EDGE,DISTANCE,ACCESSOR>::~GraphSearchTree()
 {
     // Delete the tree
     // We delete each leaf and recurse up the tree iteratively deleting
@@ -277,8 +302,8 @@ GraphSearchTree<VERTEX,EDGE,DISTANCE>::~GraphSearchTree()
 }
 
 // Perform one step of the BFS
-template<typename VERTEX, typename EDGE, typename DISTANCE>
-bool GraphSearchTree<VERTEX,EDGE,DISTANCE>::stepOnce()
+template<typename VERTEX, typename EDGE, typename DISTANCE, typename ACCESSOR>
+bool GraphSearchTree<VERTEX,EDGE,DISTANCE,ACCESSOR>::stepOnce()
 {
     if(m_expandQueue.empty())
         return false;
@@ -319,7 +344,7 @@ bool GraphSearchTree<VERTEX,EDGE,DISTANCE>::stepOnce()
         else
         {
             // Add the children of this node to the queue
-            int numCreated = pNode->createChildren(incomingQueue, m_distanceFunc);
+            int numCreated = pNode->createChildren(incomingQueue, m_distanceFunc, m_accessor);
             m_totalNodes += numCreated;
 
             if(numCreated == 0)
@@ -337,8 +362,8 @@ bool GraphSearchTree<VERTEX,EDGE,DISTANCE>::stepOnce()
 // Return true if all the walks from the root converge
 // to one vertex (ie if the search from pX converged
 // to pY, then ALL paths from pX must go through pY).
-template<typename VERTEX, typename EDGE, typename DISTANCE>
-bool GraphSearchTree<VERTEX,EDGE,DISTANCE>::hasSearchConverged(VERTEX*& pConvergedVertex)
+template<typename VERTEX, typename EDGE, typename DISTANCE, typename ACCESSOR>
+bool GraphSearchTree<VERTEX,EDGE,DISTANCE,ACCESSOR>::hasSearchConverged(VERTEX*& pConvergedVertex)
 {
     // Construct a set of all the leaf nodes
     _SearchNodePtrDeque completeLeafNodes;
@@ -384,9 +409,9 @@ bool GraphSearchTree<VERTEX,EDGE,DISTANCE>::hasSearchConverged(VERTEX*& pConverg
 }
 
 // Construct walks representing every path from the start node
-template<typename VERTEX, typename EDGE, typename DISTANCE>
+template<typename VERTEX, typename EDGE, typename DISTANCE, typename ACCESSOR>
 template<typename BUILDER>
-void GraphSearchTree<VERTEX,EDGE,DISTANCE>::buildWalksToAllLeaves(BUILDER& walkBuilder)
+void GraphSearchTree<VERTEX,EDGE,DISTANCE,ACCESSOR>::buildWalksToAllLeaves(BUILDER& walkBuilder)
 {
     // Construct a queue with all leaf nodes in it
     _SearchNodePtrDeque completeLeafNodes;
@@ -396,17 +421,17 @@ void GraphSearchTree<VERTEX,EDGE,DISTANCE>::buildWalksToAllLeaves(BUILDER& walkB
 }
 
 // Construct walks representing every path from the start vertex to the goal vertex
-template<typename VERTEX, typename EDGE, typename DISTANCE>
+template<typename VERTEX, typename EDGE, typename DISTANCE, typename ACCESSOR>
 template<typename BUILDER>
-void GraphSearchTree<VERTEX,EDGE,DISTANCE>::buildWalksToGoal(BUILDER& walkBuilder)
+void GraphSearchTree<VERTEX,EDGE,DISTANCE,ACCESSOR>::buildWalksToGoal(BUILDER& walkBuilder)
 {
     _buildWalksToLeaves(m_goalQueue, walkBuilder);
 }
 
 // Build all the walks that contain pTarget.
-template<typename VERTEX, typename EDGE, typename DISTANCE>
+template<typename VERTEX, typename EDGE, typename DISTANCE, typename ACCESSOR>
 template<typename BUILDER>
-void GraphSearchTree<VERTEX,EDGE,DISTANCE>::buildWalksContainingVertex(VERTEX* pTarget, BUILDER& walkBuilder)
+void GraphSearchTree<VERTEX,EDGE,DISTANCE,ACCESSOR>::buildWalksContainingVertex(VERTEX* pTarget, BUILDER& walkBuilder)
 {
     _SearchNodePtrDeque completeLeafNodes;
     _makeFullLeafQueue(completeLeafNodes);
@@ -434,9 +459,9 @@ void GraphSearchTree<VERTEX,EDGE,DISTANCE>::buildWalksContainingVertex(VERTEX* p
 }
 
 // Main function for constructing a vector of walks from a set of leaves
-template<typename VERTEX, typename EDGE, typename DISTANCE>
+template<typename VERTEX, typename EDGE, typename DISTANCE, typename ACCESSOR>
 template<typename BUILDER>
-void GraphSearchTree<VERTEX,EDGE,DISTANCE>::_buildWalksToLeaves(const _SearchNodePtrDeque& queue, BUILDER& walkBuilder)
+void GraphSearchTree<VERTEX,EDGE,DISTANCE,ACCESSOR>::_buildWalksToLeaves(const _SearchNodePtrDeque& queue, BUILDER& walkBuilder)
 {
     for(typename _SearchNodePtrDeque::const_iterator iter = queue.begin();
                                                      iter != queue.end();
@@ -458,8 +483,8 @@ void GraphSearchTree<VERTEX,EDGE,DISTANCE>::_buildWalksToLeaves(const _SearchNod
 // Return true if the vertex pX is found somewhere in the branch 
 // from pNode to the root. If it is found, pFoundNode is set
 // to the furtherest instance of pX from the root.
-template<typename VERTEX, typename EDGE, typename DISTANCE>
-bool GraphSearchTree<VERTEX,EDGE,DISTANCE>::searchBranchForVertex(_SearchNode* pNode, VERTEX* pX, _SearchNode*& pFoundNode) const
+template<typename VERTEX, typename EDGE, typename DISTANCE, typename ACCESSOR>
+bool GraphSearchTree<VERTEX,EDGE,DISTANCE,ACCESSOR>::searchBranchForVertex(_SearchNode* pNode, VERTEX* pX, _SearchNode*& pFoundNode) const
 {
     if(pNode == NULL)
     {
@@ -476,8 +501,8 @@ bool GraphSearchTree<VERTEX,EDGE,DISTANCE>::searchBranchForVertex(_SearchNode* p
 }
 
 //
-template<typename VERTEX, typename EDGE, typename DISTANCE>
-void GraphSearchTree<VERTEX,EDGE,DISTANCE>::addEdgesFromBranch(_SearchNode* pNode, WALK& outEdges)
+template<typename VERTEX, typename EDGE, typename DISTANCE, typename ACCESSOR>
+void GraphSearchTree<VERTEX,EDGE,DISTANCE,ACCESSOR>::addEdgesFromBranch(_SearchNode* pNode, WALK& outEdges)
 {
     // Terminate the recursion at the root node and dont add an edge
     if(pNode->getParent() != NULL)
@@ -488,8 +513,8 @@ void GraphSearchTree<VERTEX,EDGE,DISTANCE>::addEdgesFromBranch(_SearchNode* pNod
 }
 
 //
-template<typename VERTEX, typename EDGE, typename DISTANCE>
-void GraphSearchTree<VERTEX,EDGE,DISTANCE>::_makeFullLeafQueue(_SearchNodePtrDeque& completeQueue) const
+template<typename VERTEX, typename EDGE, typename DISTANCE, typename ACCESSOR>
+void GraphSearchTree<VERTEX,EDGE,DISTANCE,ACCESSOR>::_makeFullLeafQueue(_SearchNodePtrDeque& completeQueue) const
 {
     completeQueue.insert(completeQueue.end(), m_expandQueue.begin(), m_expandQueue.end());
     completeQueue.insert(completeQueue.end(), m_goalQueue.begin(), m_goalQueue.end());
@@ -497,8 +522,8 @@ void GraphSearchTree<VERTEX,EDGE,DISTANCE>::_makeFullLeafQueue(_SearchNodePtrDeq
 }
 
 //
-template<typename VERTEX, typename EDGE, typename DISTANCE>
-void GraphSearchTree<VERTEX,EDGE,DISTANCE>::printBranch(_SearchNode* pNode) const
+template<typename VERTEX, typename EDGE, typename DISTANCE, typename ACCESSOR>
+void GraphSearchTree<VERTEX,EDGE,DISTANCE,ACCESSOR>::printBranch(_SearchNode* pNode) const
 {
     if(pNode != NULL)
     {
@@ -507,8 +532,8 @@ void GraphSearchTree<VERTEX,EDGE,DISTANCE>::printBranch(_SearchNode* pNode) cons
     }
 }
 
-template<typename VERTEX, typename EDGE, typename DISTANCE>
-void GraphSearchTree<VERTEX,EDGE,DISTANCE>::connectedComponents(VertexPtrVector allVertices, 
+template<typename VERTEX, typename EDGE, typename DISTANCE, typename ACCESSOR>
+void GraphSearchTree<VERTEX,EDGE,DISTANCE,ACCESSOR>::connectedComponents(VertexPtrVector allVertices, 
                                                                 VertexPtrVectorVector& connectedComponents)
 {
     // Set the color of each vertex to be white signalling its not visited
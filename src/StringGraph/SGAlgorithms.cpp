@@ -168,17 +168,16 @@ void SGAlgorithms::updateContainFlags(StringGraph* pGraph, Vertex* pVertex, cons
     assert(ovr.isContainment());
     // Determine which of the two vertices is contained
     Vertex* pOther = ed.pVertex;
-    if(ovr.getContainedIdx() == 0)
-        pVertex->setContained(true);
-    else
-        pOther->setContained(true);
+    Vertex* pContained = (ovr.getContainedIdx() == 0) ? pVertex : pOther;
+    pContained->setContained(true);
+    pGraph->markDirty(pContained);
     pGraph->setContainmentFlag(true);
 }
 
 // Calculate the error rate between the two vertices
 double SGAlgorithms::calcErrorRate(const Vertex* pX, const Vertex* pY, const Overlap& ovrXY)
 {
-    int num_diffs = ovrXY.match.countDifferences(pX->getSeq().toString(), pY->getSeq().toString());
+    int num_diffs = ovrXY.match.countDifferences(pX->getStr(), pY->getStr());
     return static_cast<double>(num_diffs) / static_cast<double>(ovrXY.match.getMinOverlapLength());
 }
 
@@ -299,7 +298,7 @@ void SGAlgorithms::removeSubmaximalOverlaps(EdgeDescOverlapMap* pOverlapMap)
     // Traverse the list of overlaps in order of length
     // Only add the first seen overlap for each vertex
     pOverlapMap->clear();
-    VertexIDSet seenVerts;
+    VertexIdxSet seenVerts;
     // the irreducible map to the transitive map
     while(!overlapQueue.empty())
     {
@@ -307,9 +306,9 @@ void SGAlgorithms::removeSubmaximalOverlaps(EdgeDescOverlapMap* pOverlapMap)
         overlapQueue.pop();
 
         EdgeDesc& edXY = edoPair.first;
-        if(seenVerts.count(edXY.pVertex->getID()) == 0)
+        if(seenVerts.count(edXY.pVertex->getIndex()) == 0)
         {
-            seenVerts.insert(edXY.pVertex->getID());
+            seenVerts.insert(edXY.pVertex->getIndex());
             pOverlapMap->insert(edoPair);
         }
     }
@@ -340,11 +339,11 @@ MultiOverlap SGAlgorithms::makeExtendedMultiOverlap(const StringGraph* pGraph, c
     CompleteOverlapSet overlapSet(pVertex, pGraph->getErrorRate(), 1);
     EdgeDescOverlapMap overlapMap = overlapSet.getOverlapMap();
 
-    MultiOverlap mo(pVertex->getID(), pVertex->getSeq().toString());
+    MultiOverlap mo(pVertex->getID(), pVertex->getStr());
     for(EdgeDescOverlapMap::const_iterator iter = overlapMap.begin();
         iter != overlapMap.end(); ++iter)
     {
-        mo.add(iter->first.pVertex->getSeq().toString(), iter->second);
+        mo.add(iter->first.pVertex->getStr(), iter->second);
     }
     return mo;
 }
@@ -360,7 +359,7 @@ void SGAlgorithms::makeExtendedSeqTries(const StringGraph* pGraph, const Vertex*
         iter != overlapMap.end(); ++iter)
     {
         // Coord[0] of the match is wrt pVertex, coord[1] is the other read
-        std::string overlapped = iter->second.match.coord[1].getSubstring(iter->first.pVertex->getSeq().toString());
+        std::string overlapped = iter->second.match.coord[1].getSubstring(iter->first.pVertex->getStr());
         if(iter->second.match.isRC())
             overlapped = reverseComplement(overlapped);
 
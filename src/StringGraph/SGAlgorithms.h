@@ -22,7 +22,7 @@ namespace SGAlgorithms
 //
 
 typedef std::pair<EdgeDesc, Overlap> EdgeDescOverlapPair;
-typedef std::set<VertexID> VertexIDSet;
+typedef std::set<VertexIdx> VertexIdxSet;
 
 // Comparator
 struct EDOPairCompare
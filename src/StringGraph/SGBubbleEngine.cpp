@@ -0,0 +1,241 @@
+//-----------------------------------------------
+// Copyright 2010 Wellcome Trust Sanger Institute
+// Written by Jared Simpson (js18@sanger.ac.uk)
+// Released under the GPL
+//-----------------------------------------------
+//
+// SGBubbleEngine - Find bubbles in a string graph
+// and the walks through them
+//
+#include "SGBubbleEngine.h"
+#include "SeqArena.h"
+
+//
+void SGBubbleEngine::init(size_t indexLimit)
+{
+    m_state.assign(indexLimit, 0);
+    m_distance.assign(indexLimit, 0);
+    m_touched.clear();
+}
+
+//
+void SGBubbleEngine::clear()
+{
+    for(size_t i = 0; i < m_touched.size(); ++i)
+        m_state[m_touched[i]] = 0;
+    m_touched.clear();
+}
+
+// The vertices are visited once all of their parents have been visited.
+// The search stops when a single vertex is waiting to be visited and it is
+// the only vertex that has been seen but not visited, which is the exit.
+bool SGBubbleEngine::findBubble(Vertex* pStart, EdgeDir dir, SGBubble& outBubble)
+{
+    clear();
+    outBubble.pStart = pStart;
+    outBubble.pEnd = NULL;
+    outBubble.dir = dir;
+    outBubble.internalVertices.clear();
+    outBubble.walks.clear();
+
+    VertexIdx startIdx = pStart->getIndex();
+    m_state[startIdx] = BS_SEEN | BS_QUEUED | (dir == ED_ANTISENSE ? BS_ANTISENSE : 0);
+    m_distance[startIdx] = 0;
+    m_touched.push_back(startIdx);
+
+    m_stack.clear();
+    m_stack.push_back(pStart);
+    size_t numSeen = 1;
+    size_t numVisited = 0;
+
+    while(!m_stack.empty())
+    {
+        Vertex* pVertex = m_stack.back();
+        m_stack.pop_back();
+
+        VertexIdx vIdx = pVertex->getIndex();
+        m_state[vIdx] = (m_state[vIdx] & ~BS_SEEN) | BS_VISITED;
+        --numSeen;
+        if(++numVisited > m_maxNodes)
+            return false;
+
+        if(pVertex != pStart)
+            outBubble.internalVertices.push_back(pVertex);
+
+        // The exit is never expanded so it may lie past the distance limit.
+        // Any other vertex that is too far from the start ends the search
+        if(m_distance[vIdx] > m_maxDistance)
+            return false;
+
+        // A dead end cannot be part of a bubble
+        pVertex->getEdges(getExitDir(m_state[vIdx]), m_edges);
+        if(m_edges.empty())
+            return false;
+
+        for(size_t i = 0; i < m_edges.size(); ++i)
+        {
+            Edge* pEdge = m_edges[i];
+            Vertex* pChild = pEdge->getEnd();
+            EdgeDir childDir = pEdge->getTransitiveDir();
+            VertexIdx cIdx = pChild->getIndex();
+
+            // Edges back to the start or to a visited vertex form a cycle
+            if(pChild == pStart || (m_state[cIdx] & BS_VISITED))
+                return false;
+
+            if(m_state[cIdx] == 0)
+            {
+                m_state[cIdx] = BS_SEEN | (childDir == ED_ANTISENSE ? BS_ANTISENSE : 0);
+                m_distance[cIdx] = 0;
+                m_touched.push_back(cIdx);
+                ++numSeen;
+            }
+            else if(getExitDir(m_state[cIdx]) != childDir)
+            {
+                // The vertex is reached from both strands
+                return false;
+            }
+
+            int distance = m_distance[vIdx] + pEdge->getSeqLen();
+            if(distance > m_distance[cIdx])
+                m_distance[cIdx] = distance;
+
+            if(!(m_state[cIdx] & BS_QUEUED) && checkParentsVisited(pChild, pEdge->getTwinDir()))
+            {
+                m_state[cIdx] |= BS_QUEUED;
+                m_stack.push_back(pChild);
+            }
+        }
+
+        if(m_stack.size() == 1 && numSeen == 1)
+        {
+            // The exit must not lead back to the start
+            Vertex* pEnd = m_stack.back();
+            pEnd->getEdges(getExitDir(m_state[pEnd->getIndex()]), m_edges);
+            for(size_t i = 0; i < m_edges.size(); ++i)
+            {
+                if(m_edges[i]->getEnd() == pStart)
+                    return false;
+            }
+            outBubble.pEnd = pEnd;
+            return true;
+        }
+    }
+    return false;
+}
+
+//
+bool SGBubbleEngine::checkParentsVisited(const Vertex* pVertex, EdgeDir entryDir)
+{
+    pVertex->getEdges(entryDir, m_parentEdges);
+    for(size_t i = 0; i < m_parentEdges.size(); ++i)
+    {
+        // The parent must have been left along the edge to this vertex
+        const Edge* pEdge = m_parentEdges[i];
+        uint8_t state = m_state[pEdge->getEnd()->getIndex()];
+        if(!(state & BS_VISITED) || getExitDir(state) != pEdge->getTwinDir())
+            return false;
+    }
+    return true;
+}
+
+// Depth-first search from the start to the end of the bubble.
+// The bubble is acyclic and every walk reaches the end, so the
+// search is linear in the length of the walks found.
+bool SGBubbleEngine::findWalks(SGBubble& bubble, size_t maxWalks)
+{
+    bubble.walks.clear();
+    m_path.clear();
+
+    size_t depth = 0;
+    if(m_frameEdges.empty())
+    {
+        m_frameEdges.resize(1);
+        m_frameNext.resize(1);
+    }
+    bubble.pStart->getEdges(bubble.dir, m_frameEdges[0]);
+    m_frameNext[0] = 0;
+
+    while(true)
+    {
+        if(m_frameNext[depth] == m_frameEdges[depth].size())
+        {
+            if(depth == 0)
+                break;
+            --depth;
+            m_path.pop_back();
+            continue;
+        }
+
+        Edge* pEdge = m_frameEdges[depth][m_frameNext[depth]++];
+        m_path.push_back(pEdge);
+        if(pEdge->getEnd() == bubble.pEnd)
+        {
+            bubble.walks.push_back(m_path);
+            if(bubble.walks.size() > maxWalks)
+                return false;
+            m_path.pop_back();
+            continue;
+        }
+
+        ++depth;
+        if(depth == m_frameEdges.size())
+        {
+            m_frameEdges.resize(depth + 1);
+            m_frameNext.resize(depth + 1);
+        }
+        pEdge->getEnd()->getEdges(pEdge->getTransitiveDir(), m_frameEdges[depth]);
+        m_frameNext[depth] = 0;
+    }
+    return true;
+}
+
+// The sequence of the start vertex is extended by the label of each edge,
+// oriented relative to the start vertex. Walks in the antisense direction
+// are built reversed and flipped at the end.
+void SGBubbleEngine::getWalkSequence(const SGBubble& bubble, const EdgePtrVec& walk, std::vector<uint8_t>& outCodes)
+{
+    bool reverseAll = bubble.dir == ED_ANTISENSE;
+    const uint8_t* pStartSeq = bubble.pStart->getPackedSeq();
+    size_t startLen = bubble.pStart->getSeqLen();
+
+    outCodes.clear();
+    for(size_t i = 0; i < startLen; ++i)
+        outCodes.push_back(SeqArena::getRank(pStartSeq, reverseAll ? startLen - i - 1 : i));
+
+    EdgeComp currComp = EC_SAME;
+    for(size_t i = 0; i < walk.size(); ++i)
+    {
+        const Edge* pEdge = walk[i];
+        const Vertex* pEnd = pEdge->getEnd();
+        const uint8_t* pSeq = pEnd->getPackedSeq();
+
+        // The label is the part of the end vertex that is not matched by the twin
+        SeqCoord unmatched = pEdge->getTwin()->getMatchCoord().complement();
+        int start = unmatched.interval.start;
+        int len = unmatched.isEmpty() ? 0 : unmatched.length();
+
+        bool rc = (pEdge->getComp() == EC_REVERSE) != (currComp == EC_REVERSE);
+        bool backwards = rc != reverseAll;
+        for(int j = 0; j < len; ++j)
+        {
+            uint8_t rank = SeqArena::getRank(pSeq, backwards ? start + len - j - 1 : start + j);
+            outCodes.push_back(rc ? 3 - rank : rank);
+        }
+
+        if(pEdge->getComp() == EC_REVERSE)
+            currComp = !currComp;
+    }
+
+    if(reverseAll)
+        std::reverse(outCodes.begin(), outCodes.end());
+}
+
+//
+std::string SGBubbleEngine::codesToString(const uint8_t* pCodes, size_t len)
+{
+    std::string out(len, 'A');
+    for(size_t i = 0; i < len; ++i)
+        out[i] = DNA_ALPHABET::getBase(pCodes[i]);
+    return out;
+}
@@ -0,0 +1,102 @@
+//-----------------------------------------------
+// Copyright 2010 Wellcome Trust Sanger Institute
+// Written by Jared Simpson (js18@sanger.ac.uk)
+// Released under the GPL
+//-----------------------------------------------
+//
+// SGBubbleEngine - Find bubbles in a string graph
+// and the walks through them. A bubble is found
+// with the superbubble algorithm of Onodera et al.
+// (2013) starting from a vertex in one direction,
+// which takes time linear in the size of the bubble.
+// A superbubble is a subgraph with a single entrance
+// and a single exit where every vertex is reachable
+// from the entrance and reaches the exit, with no
+// cycles and no edges leaving the subgraph, so any
+// of its walks can be removed cleanly. Each engine
+// keeps its own scratch buffers so the graph can be
+// searched by one engine per thread without any
+// allocation per vertex.
+//
+#ifndef SGBUBBLEENGINE_H
+#define SGBUBBLEENGINE_H
+
+#include "Bigraph.h"
+
+//
+struct SGBubble
+{
+    Vertex* pStart;
+    Vertex* pEnd;
+
+    // The direction of the edges of pStart that enter the bubble
+    EdgeDir dir;
+
+    // The vertices strictly between pStart and pEnd
+    VertexPtrVec internalVertices;
+
+    // The walks from pStart to pEnd, as filled in by findWalks
+    std::vector<EdgePtrVec> walks;
+};
+
+class SGBubbleEngine
+{
+    public:
+        SGBubbleEngine() : m_maxNodes(500), m_maxDistance(5000) {}
+
+        // Size the scratch marks for a graph with vertex indices below indexLimit
+        void init(size_t indexLimit);
+
+        // Limit the number of vertices in a bubble and the length
+        // of sequence that the bubble can add to the start vertex
+        void setLimits(size_t maxNodes, int maxDistance) { m_maxNodes = maxNodes; m_maxDistance = maxDistance; }
+
+        // Find the superbubble that is entered through the edges of pStart in direction dir.
+        // Returns false if there is no such bubble within the limits
+        bool findBubble(Vertex* pStart, EdgeDir dir, SGBubble& outBubble);
+
+        // Find every walk through the bubble. Returns false if there
+        // are more than maxWalks walks
+        bool findWalks(SGBubble& bubble, size_t maxWalks);
+
+        // Unpack the sequence spelled by a walk through the bubble into outCodes
+        // as base ranks, in the frame of the start vertex. This is the same
+        // sequence as the SGWT_START_TO_END string of an SGWalk
+        static void getWalkSequence(const SGBubble& bubble, const EdgePtrVec& walk, std::vector<uint8_t>& outCodes);
+
+        // Convert base ranks to a string
+        static std::string codesToString(const uint8_t* pCodes, size_t len);
+
+    private:
+
+        static const uint8_t BS_SEEN = 0x1;
+        static const uint8_t BS_VISITED = 0x2;
+        static const uint8_t BS_QUEUED = 0x4;
+        static const uint8_t BS_ANTISENSE = 0x8; // the direction the vertex is left by
+
+        static EdgeDir getExitDir(uint8_t state) { return (state & BS_ANTISENSE) ? ED_ANTISENSE : ED_SENSE; }
+
+        // Returns true if every edge into pVertex comes from a visited vertex
+        bool checkParentsVisited(const Vertex* pVertex, EdgeDir entryDir);
+
+        // Reset the marks that were set by the last search
+        void clear();
+
+        size_t m_maxNodes;
+        int m_maxDistance;
+
+        // Per-vertex state, indexed by vertex index
+        std::vector<uint8_t> m_state;
+        std::vector<int> m_distance;
+        std::vector<VertexIdx> m_touched;
+
+        // Search scratch
+        VertexPtrVec m_stack;
+        EdgePtrVec m_edges;
+        EdgePtrVec m_parentEdges;
+        EdgePtrVec m_path;
+        std::vector<EdgePtrVec> m_frameEdges;
+        std::vector<size_t> m_frameNext;
+};
+
+#endif
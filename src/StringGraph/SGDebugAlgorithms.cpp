@@ -13,6 +13,18 @@
 #include "ErrorCorrect.h"
 #include <algorithm>
 
+// Edge descriptions refer to the vertices of one graph. Translate ed
+// to the vertex with the same name in pGraph. Returns false if
+// that vertex is not in pGraph.
+static bool translateEdgeDesc(const StringGraph* pGraph, const EdgeDesc& ed, EdgeDesc& outED)
+{
+    Vertex* pVertex = pGraph->getVertex(ed.pVertex->getID());
+    if(pVertex == NULL)
+        return false;
+    outED = EdgeDesc(pVertex, ed.dir, ed.comp);
+    return true;
+}
+
 //
 // SGDebugEdgeClassificationVisitor - Collect statistics about the graph
 // using debug information about simulated reads
@@ -43,7 +55,7 @@ bool SGDebugEdgeClassificationVisitor::visit(StringGraph* /*pGraph*/, Vertex* pV
         int overlap_len = edges[i]->getMatchLength();
         int sum = distance + overlap_len;
         
-        if(sum == (int)pVertex->getSeq().length())
+        if(sum == (int)pVertex->getSeqLen())
             ++num_good;
         else
             ++num_bad;
@@ -138,8 +150,8 @@ void SGDebugGraphCompareVisitor::showMissing(StringGraph* pGraph, Vertex* pVerte
     for(size_t i = 0; i < compareEdges.size(); ++i)
     {
         Edge* pCompareEdge = compareEdges[i];
-        EdgeDesc ed = pCompareEdge->getDesc();
-        if(!pVertex->hasEdge(ed))
+        EdgeDesc ed;
+        if(!translateEdgeDesc(pGraph, pCompareEdge->getDesc(), ed) || !pVertex->hasEdge(ed))
         {
             std::cout << "MISSING!\t" << pCompareEdge->getMatchLength() << "\n";
             /*
@@ -195,8 +207,8 @@ void SGDebugGraphCompareVisitor::summarize(StringGraph* pGraph, Vertex* pVertex)
     for(size_t i = 0; i < compareEdges.size(); ++i)
     {
         Edge* pCompareEdge = compareEdges[i];
-        EdgeDesc ed = pCompareEdge->getDesc();
-        if(pVertex->hasEdge(ed))
+        EdgeDesc ed;
+        if(translateEdgeDesc(pGraph, pCompareEdge->getDesc(), ed) && pVertex->hasEdge(ed))
         {
             ++m_numFound;
         }
@@ -213,8 +225,8 @@ void SGDebugGraphCompareVisitor::summarize(StringGraph* pGraph, Vertex* pVertex)
     for(size_t i = 0; i < actualEdges.size(); ++i)
     {
         Edge* pActualEdge = actualEdges[i];
-        EdgeDesc ed = pActualEdge->getDesc();
-        if(m_pCompareGraph->getVertex(pActualEdge->getEndID()) != NULL && !pCompareVertex->hasEdge(ed))
+        EdgeDesc ed;
+        if(translateEdgeDesc(m_pCompareGraph, pActualEdge->getDesc(), ed) && !pCompareVertex->hasEdge(ed))
             ++m_numWrong;
     }
 
@@ -238,8 +250,8 @@ void SGDebugGraphCompareVisitor::compareSplitGroups(StringGraph* pGraph, Vertex*
     for(size_t i = 0; i < actualEdges.size(); ++i)
     {
         Edge* pActualEdge = actualEdges[i];
-        EdgeDesc ed = pActualEdge->getDesc();
-        if(m_pCompareGraph->getVertex(pActualEdge->getEndID()) != NULL && !pCompareVertex->hasEdge(ed))
+        EdgeDesc ed;
+        if(translateEdgeDesc(m_pCompareGraph, pActualEdge->getDesc(), ed) && !pCompareVertex->hasEdge(ed))
         {
             hasWrong = true;
             break;
@@ -298,7 +310,9 @@ void SGDebugGraphCompareVisitor::compareTransitiveGroups(StringGraph* /*pGraph*/
             for(size_t actualGroupIdx = 0; actualGroupIdx < actualTGC.numGroups(); ++actualGroupIdx)
             {
                 Edge* pIrr = actualTGC.getGroup(actualGroupIdx).getIrreducible();
-                size_t compareGroupIdx = compareTGC.findGroup(pIrr->getDesc());
+                EdgeDesc compareED;
+                translateEdgeDesc(m_pCompareGraph, pIrr->getDesc(), compareED);
+                size_t compareGroupIdx = compareTGC.findGroup(compareED);
                 
                 if(actualGroupIdx != compareGroupIdx)
                 {
@@ -373,8 +387,8 @@ void SGDebugGraphCompareVisitor::compareErrorRates(StringGraph* pGraph, Vertex*
     for(size_t i = 0; i < compareEdges.size(); ++i)
     {
         Edge* pCompareEdge = compareEdges[i];
-        EdgeDesc ed = pCompareEdge->getDesc();
-        bool is_missing = !pVertex->hasEdge(ed);
+        EdgeDesc ed;
+        bool is_missing = !translateEdgeDesc(pGraph, pCompareEdge->getDesc(), ed) || !pVertex->hasEdge(ed);
 
         //if(!pVertex->hasEdge(ed))
         {
@@ -24,7 +24,7 @@ EdgeDir SGPairedAlgorithms::getDirectionToPair(const std::string& /*id*/)
 
 std::string SGPairedAlgorithms::pathToString(const Vertex* pX, const Path& path)
 {
-    std::string out = pX->getSeq().toString();
+    std::string out = pX->getStr();
     EdgeComp currComp = EC_SAME;
 
     for(size_t i = 0; i < path.size(); ++i)
@@ -107,12 +107,12 @@ bool SGPairedPathResolveVisitor::visit(StringGraph* /*pGraph*/, Vertex* /*pVerte
         {
             SeqRecord recordX;
             recordX.id = pVertex->getID();
-            recordX.seq = pVertex->getSeq().toString();
+            recordX.seq = pVertex->getStr();
             recordX.write(*m_pWriter);
 
             SeqRecord recordY;
             recordY.id = pVertex->getID();
-            recordY.seq = pVertex->getSeq().toString();
+            recordY.seq = pVertex->getStr();
             recordY.write(*m_pWriter);
         }
     }
@@ -333,7 +333,7 @@ bool SGPairedOverlapVisitor::visit(StringGraph* /*pGraph*/, Vertex* /*pVertex*/)
         if(pPairW == NULL)
             continue;
 
-        EdgePtrVec ppw_edges = pPairW->findEdgesTo(pPairSV->getID());
+        EdgePtrVec ppw_edges = pPairW->findEdgesTo(pPairSV);
         size_t overlap_len = pVWEdge->getMatchLength();
 
         if(pVWEdge->getComp() == EC_SAME)
@@ -45,6 +45,31 @@ void SGWalkBuilder::finishCurrentWalk()
     m_pCurrWalk = NULL;
 }
 
+//
+CompactWalkBuilder::CompactWalkBuilder(const CompactGraph* pGraph, CompactWalkVector& outWalks) : m_pGraph(pGraph), 
+                                                                                                   m_outWalks(outWalks)
+{
+
+}
+
+//
+void CompactWalkBuilder::startNewWalk(const CompactVertex* pStartVertex)
+{
+    m_outWalks.push_back(CompactWalk(m_pGraph, m_pGraph->getIndex(pStartVertex)));
+}
+
+//
+void CompactWalkBuilder::addEdge(const CompactEdge* pEdge)
+{
+    m_outWalks.back().addEdge(pEdge);
+}
+
+//
+void CompactWalkBuilder::finishCurrentWalk()
+{
+
+}
+
 // Find all the walks between pX and pY that are within maxDistance
 // If the exhaustive flag is set, only return walks if all the possible
 // solutions have been found. If exhaustive is false, any walks found will be
@@ -70,6 +95,23 @@ bool SGSearch::findWalks(Vertex* pX, Vertex* pY, EdgeDir initialDir,
     return !searchTree.wasSearchAborted();
 }
 
+//
+bool SGSearch::findWalks(const CompactGraph* pGraph, CompactGraph::VertexIdx xIdx, CompactGraph::VertexIdx yIdx, 
+                         EdgeDir initialDir, int maxDistance, size_t maxNodes, bool exhaustive, 
+                         CompactWalkVector& outWalks)
+{
+    CompactSearchTree searchTree(pGraph->getVertex(xIdx), pGraph->getVertex(yIdx), initialDir, maxDistance, maxNodes,
+                                 CompactDistanceFunction(pGraph), CompactGraphAccessor(pGraph));
+    while(searchTree.stepOnce()) { }
+
+    if(!searchTree.wasSearchAborted() || !exhaustive)
+    {
+        CompactWalkBuilder builder(pGraph, outWalks);
+        searchTree.buildWalksToGoal(builder);
+    }
+    return !searchTree.wasSearchAborted();
+}
+
 // Search the graph for a set of walks that represent alternate
 // versions of the same sequence. Theese walks are found by searching
 // the graph for a set of walks that start/end at a common vertex and cover
@@ -13,6 +13,7 @@
 #include "Bigraph.h"
 #include "SGWalk.h"
 #include "GraphSearchTree.h"
+#include "CompactWalk.h"
 #include <deque>
 
 // Returns the extension distance indicated
@@ -27,6 +28,7 @@ struct SGDistanceFunction
 
 // 
 typedef GraphSearchTree<Vertex, Edge, SGDistanceFunction> SGSearchTree;
+typedef GraphSearchTree<const CompactVertex, const CompactEdge, CompactDistanceFunction, CompactGraphAccessor> CompactSearchTree;
 
 //
 struct SGWalkBuilder
@@ -49,6 +51,21 @@ struct SGWalkBuilder
 
 };
 
+// Builds the walks found by a CompactSearchTree
+struct CompactWalkBuilder
+{
+    public:
+        CompactWalkBuilder(const CompactGraph* pGraph, CompactWalkVector& outWalks);
+
+        void startNewWalk(const CompactVertex* pStartVertex);
+        void addEdge(const CompactEdge* pEdge);
+        void finishCurrentWalk();
+
+    private:
+        const CompactGraph* m_pGraph;
+        CompactWalkVector& m_outWalks;
+};
+
 // String Graph searching algorithms
 namespace SGSearch
 {
@@ -61,6 +78,16 @@ namespace SGSearch
                    bool exhaustive,
                    SGWalkVector& outWalks);
 
+    // As above, for the vertices with indices xIdx and yIdx of a CompactGraph
+    bool findWalks(const CompactGraph* pGraph,
+                   CompactGraph::VertexIdx xIdx,
+                   CompactGraph::VertexIdx yIdx,
+                   EdgeDir initialDir,
+                   int maxDistance,
+                   size_t maxNodes,
+                   bool exhaustive,
+                   CompactWalkVector& outWalks);
+
     void findVariantWalks(Vertex* pX, 
                           EdgeDir initialDir, 
                           int maxDistance,
@@ -79,7 +79,7 @@ StringGraph* SGUtil::loadASQG(const std::string& filename, const unsigned int mi
                 ASQG::VertexRecord vertexRecord(recordLine);
                 const SQG::IntTag& ssTag = vertexRecord.getSubstringTag();
 
-                Vertex* pVertex = new(pGraph->getVertexAllocator()) Vertex(vertexRecord.getID(), vertexRecord.getSeq());
+                Vertex* pVertex = pGraph->createVertex(vertexRecord.getID(), vertexRecord.getSeq());
                 if(ssTag.isInitialized() && ssTag.get() == 1)
                 {
                     // Vertex is a substring of some other vertex, mark it as contained
@@ -144,7 +144,7 @@ StringGraph* SGUtil::loadFASTA(const std::string& filename)
 
     while(reader.get(record))
     {
-        Vertex* pVertex = new(pGraph->getVertexAllocator()) Vertex(record.id, record.seq.toString());
+        Vertex* pVertex = pGraph->createVertex(record.id, record.seq.toString());
         pGraph->addVertex(pVertex);
     }
     return pGraph;
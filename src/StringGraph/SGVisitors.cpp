@@ -12,7 +12,8 @@
 #include "ErrorCorrect.h"
 #include "CompleteOverlapSet.h"
 #include "SGSearch.h"
-#include "stdaln.h"
+#include "EditDistance.h"
+#include <math.h>
 
 //
 // SGFastaVisitor - output the vertices in the graph in 
@@ -20,9 +21,9 @@
 //
 bool SGFastaVisitor::visit(StringGraph* /*pGraph*/, Vertex* pVertex)
 {
-    m_fileHandle << ">" << pVertex->getID() << " " <<  pVertex->getSeq().length() 
+    m_fileHandle << ">" << pVertex->getID() << " " <<  pVertex->getSeqLen() 
                  << " " << 0 << "\n";
-    m_fileHandle << pVertex->getSeq() << "\n";
+    m_fileHandle << pVertex->getStr() << "\n";
     return false;
 }
 
@@ -44,8 +45,7 @@ bool SGOverlapWriterVisitor::visit(StringGraph* /*pGraph*/, Vertex* pVertex)
 
 //
 // SGTransRedVisitor - Perform a transitive reduction about this vertex
-// This uses Myers' algorithm (2005, The fragment assembly string graph)
-// Precondition: the edge list is sorted by length (ascending)
+//
 void SGTransitiveReductionVisitor::previsit(StringGraph* pGraph)
 {
     // The graph must not have containments
@@ -57,11 +57,41 @@ void SGTransitiveReductionVisitor::previsit(StringGraph* pGraph)
 
     marked_verts = 0;
     marked_edges = 0;
+    m_indexLimit = pGraph->getVertexIndexLimit();
+    m_threadMarks.assign(1, NeighborMarks());
+    m_threadMarks[0].resize(m_indexLimit);
+    m_threadEdges.clear();
 }
 
 bool SGTransitiveReductionVisitor::visit(StringGraph* /*pGraph*/, Vertex* pVertex)
 {
-    size_t trans_count = 0;
+    EdgePtrVec transitiveEdges;
+    findTransitiveEdges(pVertex, m_threadMarks[0], transitiveEdges);
+    if(markTransitiveEdges(transitiveEdges) > 0)
+        ++marked_verts;
+    return false;
+}
+
+//
+void SGTransitiveReductionVisitor::beginParallel(int numThreads)
+{
+    m_threadEdges.assign(numThreads, EdgePtrVec());
+    m_threadMarks.resize(numThreads);
+    for(int i = 1; i < numThreads; ++i)
+        m_threadMarks[i].resize(m_indexLimit);
+}
+
+//
+bool SGTransitiveReductionVisitor::visitParallel(StringGraph* /*pGraph*/, Vertex* pVertex, int threadIdx)
+{
+    findTransitiveEdges(pVertex, m_threadMarks[threadIdx], m_threadEdges[threadIdx]);
+    return false;
+}
+
+// This uses Myers' algorithm (2005, The fragment assembly string graph)
+// Precondition: the edge list is sorted by length (ascending)
+void SGTransitiveReductionVisitor::findTransitiveEdges(Vertex* pVertex, NeighborMarks& marks, EdgePtrVec& outEdges) const
+{
     static const size_t FUZZ = 10; // see myers
 
     for(size_t idx = 0; idx < ED_COUNT; idx++)
@@ -71,8 +101,9 @@ bool SGTransitiveReductionVisitor::visit(StringGraph* /*pGraph*/, Vertex* pVerte
         if(edges.size() == 0)
             continue;
 
+        // All the neighbours start gray
         for(size_t i = 0; i < edges.size(); ++i)
-            (edges[i])->getEnd()->setColor(GC_GRAY);
+            marks.set(edges[i]->getEnd(), GC_GRAY);
 
         Edge* pLongestEdge = edges.back();
         size_t longestLen = pLongestEdge->getSeqLen() + FUZZ;
@@ -83,10 +114,8 @@ bool SGTransitiveReductionVisitor::visit(StringGraph* /*pGraph*/, Vertex* pVerte
             Edge* pVWEdge = edges[i];
             Vertex* pWVert = pVWEdge->getEnd();
 
-            //std::cout << "Examining edges from " << pWVert->getID() << " longest: " << longestLen << "\n";
-            //std::cout << pWVert->getID() << " w_edges: \n";
             EdgeDir transDir = !pVWEdge->getTwinDir();
-            if(pWVert->getColor() == GC_GRAY)
+            if(marks.get(pWVert) == GC_GRAY)
             {
                 EdgePtrVec w_edges = pWVert->getEdges(transDir);
                 for(size_t j = 0; j < w_edges.size(); ++j)
@@ -95,11 +124,10 @@ bool SGTransitiveReductionVisitor::visit(StringGraph* /*pGraph*/, Vertex* pVerte
                     size_t trans_len = pVWEdge->getSeqLen() + pWXEdge->getSeqLen();
                     if(trans_len <= longestLen)
                     {
-                        if(pWXEdge->getEnd()->getColor() == GC_GRAY)
+                        if(marks.get(pWXEdge->getEnd()) == GC_GRAY)
                         {
                             // X is the endpoint of an edge of V, therefore it is transitive
-                            pWXEdge->getEnd()->setColor(GC_BLACK);
-                            //std::cout << "Marking " << pWXEdge->getEndID() << " as transitive to " << pVertex->getID() << "\n";
+                            marks.set(pWXEdge->getEnd(), GC_BLACK);
                         }
                     }
                     else
@@ -114,24 +142,19 @@ bool SGTransitiveReductionVisitor::visit(StringGraph* /*pGraph*/, Vertex* pVerte
             Edge* pVWEdge = edges[i];
             Vertex* pWVert = pVWEdge->getEnd();
 
-            //std::cout << "Examining edges from " << pWVert->getID() << " longest: " << longestLen << "\n";
-            //std::cout << pWVert->getID() << " w_edges: \n";
             EdgeDir transDir = !pVWEdge->getTwinDir();
             EdgePtrVec w_edges = pWVert->getEdges(transDir);
             for(size_t j = 0; j < w_edges.size(); ++j)
             {
-                //std::cout << "    edge: " << *w_edges[j] << "\n";
                 Edge* pWXEdge = w_edges[j];
                 size_t len = pWXEdge->getSeqLen();
 
                 if(len < FUZZ || j == 0)
                 {
-                    if(pWXEdge->getEnd()->getColor() == GC_GRAY)
+                    if(marks.get(pWXEdge->getEnd()) == GC_GRAY)
                     {
                         // X is the endpoint of an edge of V, therefore it is transitive
-                        pWXEdge->getEnd()->setColor(GC_BLACK);
-                        //std::cout << "Marking " << pWXEdge->getEndID() << " as transitive to " << pVertex->getID() << " in stage 2";
-                        //std::cout << " via " << pWVert->getID() << "\n";
+                        marks.set(pWXEdge->getEnd(), GC_BLACK);
                     }
                 }
                 else
@@ -143,30 +166,54 @@ bool SGTransitiveReductionVisitor::visit(StringGraph* /*pGraph*/, Vertex* pVerte
 
         for(size_t i = 0; i < edges.size(); ++i)
         {
-            if(edges[i]->getEnd()->getColor() == GC_BLACK)
-            {
-                // Mark the edge and its twin for removal
-                if(edges[i]->getColor() != GC_BLACK || edges[i]->getTwin()->getColor() != GC_BLACK)
-                {
-                    edges[i]->setColor(GC_BLACK);
-                    edges[i]->getTwin()->setColor(GC_BLACK);
-                    marked_edges += 2;
-                    trans_count++;
-                }
-            }
-            edges[i]->getEnd()->setColor(GC_WHITE);
+            if(marks.get(edges[i]->getEnd()) == GC_BLACK)
+                outEdges.push_back(edges[i]);
         }
+        marks.clear();
     }
+}
 
-    if(trans_count > 0)
-        ++marked_verts;
-
-    return false;
+//
+int SGTransitiveReductionVisitor::markTransitiveEdges(const EdgePtrVec& edges)
+{
+    int trans_count = 0;
+    for(size_t i = 0; i < edges.size(); ++i)
+    {
+        // Mark the edge and its twin for removal
+        if(edges[i]->getColor() != GC_BLACK || edges[i]->getTwin()->getColor() != GC_BLACK)
+        {
+            edges[i]->setColor(GC_BLACK);
+            edges[i]->getTwin()->setColor(GC_BLACK);
+            marked_edges += 2;
+            trans_count++;
+        }
+    }
+    return trans_count;
 }
 
 // Remove all the marked edges
 void SGTransitiveReductionVisitor::postvisit(StringGraph* pGraph)
 {
+    // Mark the edges found by the parallel visit. The edges
+    // of each vertex are contiguous in the thread buffers
+    for(size_t i = 0; i < m_threadEdges.size(); ++i)
+    {
+        const EdgePtrVec& threadEdges = m_threadEdges[i];
+        size_t start = 0;
+        while(start < threadEdges.size())
+        {
+            size_t end = start + 1;
+            while(end < threadEdges.size() && threadEdges[end]->getStart() == threadEdges[start]->getStart())
+                ++end;
+
+            EdgePtrVec vertexEdges(threadEdges.begin() + start, threadEdges.begin() + end);
+            if(markTransitiveEdges(vertexEdges) > 0)
+                ++marked_verts;
+            start = end;
+        }
+    }
+    m_threadEdges.clear();
+
     printf("TR marked %d verts and %d edges\n", marked_verts, marked_edges);
     pGraph->sweepEdges(GC_BLACK);
     pGraph->setTransitiveFlag(false);
@@ -205,7 +252,7 @@ bool SGIdenticalRemoveVisitor::visit(StringGraph* /*pGraph*/, Vertex* pVertex)
         if(!ovr.isContainment() || ovr.getContainedIdx() != 0)
             continue;
 
-        if(pVertex->getSeq() == pOther->getSeq())
+        if(pVertex->getStr() == pOther->getStr())
         {
             pVertex->setColor(GC_BLACK);
             ++count;
@@ -233,6 +280,30 @@ void SGContainRemoveVisitor::previsit(StringGraph* pGraph)
     // during this algorithm the flag will be reset and another
     // round must be re-run
     pGraph->setContainmentFlag(false);    
+    m_threadVertices.clear();
+}
+
+// The neighbours of the contained vertices must be remodelled unless the graph
+// has been transitively reduced or is a complete overlap graph
+VisitScope SGContainRemoveVisitor::getVisitScope(const StringGraph* pGraph) const
+{
+    if(!pGraph->hasTransitive() && !pGraph->isExactMode())
+        return VS_EXCLUSIVE;
+    return VS_READ_ONLY;
+}
+
+//
+void SGContainRemoveVisitor::beginParallel(int numThreads)
+{
+    m_threadVertices.assign(numThreads, VertexPtrVec());
+}
+
+//
+bool SGContainRemoveVisitor::visitParallel(StringGraph* /*pGraph*/, Vertex* pVertex, int threadIdx)
+{
+    if(pVertex->isContained())
+        m_threadVertices[threadIdx].push_back(pVertex);
+    return false;
 }
 
 //
@@ -265,6 +336,7 @@ bool SGContainRemoveVisitor::visit(StringGraph* pGraph, Vertex* pVertex)
     }
             
     // Delete the edges from the graph
+    pGraph->markDirty(pVertex);
     for(size_t j = 0; j < neighborEdges.size(); ++j)
     {
         Vertex* pRemodelVert = neighborEdges[j]->getEnd();
@@ -278,6 +350,15 @@ bool SGContainRemoveVisitor::visit(StringGraph* pGraph, Vertex* pVertex)
 
 void SGContainRemoveVisitor::postvisit(StringGraph* pGraph)
 {
+    // The contained vertices found by the parallel visit are removed
+    // along with their edges by the sweep
+    for(size_t i = 0; i < m_threadVertices.size(); ++i)
+    {
+        for(size_t j = 0; j < m_threadVertices[i].size(); ++j)
+            m_threadVertices[i][j]->setColor(GC_BLACK);
+    }
+    m_threadVertices.clear();
+
     pGraph->sweepVertices(GC_BLACK);
 }
 
@@ -386,7 +467,7 @@ bool SGErrorCorrectVisitor::visit(StringGraph* pGraph, Vertex* pVertex)
         std::cerr << "Corrected " << numCorrected << " reads\n";
 
     std::string corrected = ErrorCorrect::correctVertex(pGraph, pVertex, 5, 0.01);
-    pVertex->setSeq(corrected);
+    pGraph->setVertexSeq(pVertex, corrected);
     ++numCorrected;
     return false;
 }
@@ -560,19 +641,56 @@ void SGTrimVisitor::previsit(StringGraph* pGraph)
 {
     num_island = 0;
     num_terminal = 0;
+    m_threadVertices.clear();
+    m_threadIsland.clear();
+    m_threadTerminal.clear();
     pGraph->setColors(GC_WHITE);
 }
 
 // Mark any nodes that either dont have edges or edges in only one direction for removal
 bool SGTrimVisitor::visit(StringGraph* /*pGraph*/, Vertex* pVertex)
 {
+    if(checkTrim(pVertex, num_island, num_terminal))
+        pVertex->setColor(GC_BLACK);
+
+    /*
+    if(isTrimmed)
+    {
+        std::stringstream ss;
+        ss << pVertex->getID() << "-trimmed";
+        writeFastaRecord(&m_tmpFile, ss.str(), pVertex->getStr());
+    }
+    */
+    return false;
+}
+
+//
+void SGTrimVisitor::beginParallel(int numThreads)
+{
+    m_threadVertices.assign(numThreads, VertexPtrVec());
+    m_threadIsland.assign(numThreads, 0);
+    m_threadTerminal.assign(numThreads, 0);
+}
+
+//
+bool SGTrimVisitor::visitParallel(StringGraph* /*pGraph*/, Vertex* pVertex, int threadIdx)
+{
+    if(checkTrim(pVertex, m_threadIsland[threadIdx], m_threadTerminal[threadIdx]))
+        m_threadVertices[threadIdx].push_back(pVertex);
+    return false;
+}
+
+//
+bool SGTrimVisitor::checkTrim(Vertex* pVertex, int& islandCount, int& terminalCount) const
+{
+    bool trim = false;
     if(pVertex->countEdges() == 0)
     {
         // Is an island, remove if the sequence length is less than the threshold
         if(pVertex->getSeqLen() < m_minLength)
         {
-            pVertex->setColor(GC_BLACK);
-            ++num_island;
+            trim = true;
+            ++islandCount;
         }
     }
     else
@@ -583,26 +701,27 @@ bool SGTrimVisitor::visit(StringGraph* /*pGraph*/, Vertex* pVertex)
             EdgeDir dir = EDGE_DIRECTIONS[idx];
             if(pVertex->countEdges(dir) == 0 && pVertex->getSeqLen() < m_minLength)
             {
-                pVertex->setColor(GC_BLACK);
-                ++num_terminal;
+                trim = true;
+                ++terminalCount;
             }
         }
     }
-
-    /*
-    if(isTrimmed)
-    {
-        std::stringstream ss;
-        ss << pVertex->getID() << "-trimmed";
-        writeFastaRecord(&m_tmpFile, ss.str(), pVertex->getSeq().toString());
-    }
-    */
-    return false;
+    return trim;
 }
 
 // Remove all the marked edges
 void SGTrimVisitor::postvisit(StringGraph* pGraph)
 {
+    // Merge the results of the parallel visit
+    for(size_t i = 0; i < m_threadVertices.size(); ++i)
+    {
+        for(size_t j = 0; j < m_threadVertices[i].size(); ++j)
+            m_threadVertices[i][j]->setColor(GC_BLACK);
+        num_island += m_threadIsland[i];
+        num_terminal += m_threadTerminal[i];
+    }
+    m_threadVertices.clear();
+
     pGraph->sweepVertices(GC_BLACK);
     printf("StringGraphTrim: Removed %d island and %d dead-end short vertices\n", num_island, num_terminal);
 }
@@ -670,7 +789,7 @@ void SGSmallRepeatResolveVisitor::previsit(StringGraph*)
 }
 
 //
-bool SGSmallRepeatResolveVisitor::visit(StringGraph* /*pGraph*/, Vertex* pX)
+bool SGSmallRepeatResolveVisitor::visit(StringGraph* pGraph, Vertex* pX)
 {
     bool changed = false;
     for(size_t idx = 0; idx < ED_COUNT; idx++)
@@ -723,6 +842,8 @@ bool SGSmallRepeatResolveVisitor::visit(StringGraph* /*pGraph*/, Vertex* pX)
                 printf("Spanned by longer edges of size: %zu and %zu\n", x_longest_len, y_longest_len);
                 printf("Differences: %d and %d\n", x_diff, y_diff);
                 */
+                pGraph->markDirty(pX);
+                pGraph->markDirty(pY);
                 pX->deleteEdge(pXY);
                 pY->deleteEdge(pYX);
                 changed = true;
@@ -747,120 +868,47 @@ void SGBubbleVisitor::previsit(StringGraph* pGraph)
 {
     pGraph->setColors(GC_WHITE);
     num_bubbles = 0;
+    m_engine.init(pGraph->getVertexIndexLimit());
+    m_engine.setLimits(100, 1000);
 }
 
-// Find bubbles (nodes where there is a split and then immediate rejoin) and mark them for removal
+// Find bubbles (nodes where there is a split and then a rejoin) and mark
+// every vertex that is not on the first walk through the bubble for removal
 bool SGBubbleVisitor::visit(StringGraph* /*pGraph*/, Vertex* pVertex)
 {
+    static const size_t MAX_WALKS = 10;
+
     bool bubble_found = false;
     for(size_t idx = 0; idx < ED_COUNT; idx++)
     {
         EdgeDir dir = EDGE_DIRECTIONS[idx];
-        EdgePtrVec edges = pVertex->getEdges(dir);
-        if(edges.size() > 1)
-        {
-            Vertex* pStart = pVertex;
-            Vertex* pEnd = NULL;
-            // Check the vertices
-            for(size_t i = 0; i < edges.size(); ++i)
-            {
-                Edge* pVWEdge = edges[i];
-                Vertex* pWVert = pVWEdge->getEnd();
-
-                // Get the edges from w in the same direction
-                EdgeDir transDir = !pVWEdge->getTwinDir();
-                EdgePtrVec wEdges = pWVert->getEdges(transDir);
-
-                if(pWVert->getColor() == GC_RED)
-                    return false;
-
-                // If the bubble has collapsed, there should only be one edge
-                if(wEdges.size() == 1)
-                {
-                    Vertex* pBubbleEnd = wEdges.front()->getEnd();
-                    if(pBubbleEnd->getColor() == GC_RED)
-                        return false;
-                }
-            }
-
-            // Mark the vertices
-            for(size_t i = 0; i < edges.size(); ++i)
-            {
-                Edge* pVWEdge = edges[i];
-                Vertex* pWVert = pVWEdge->getEnd();
-
-                // Get the edges from w in the same direction
-                EdgeDir transDir = !pVWEdge->getTwinDir();
-                EdgePtrVec wEdges = pWVert->getEdges(transDir);
-
-                // If the bubble has collapsed, there should only be one edge
-                if(wEdges.size() == 1)
-                {
-                    Vertex* pBubbleEnd = wEdges.front()->getEnd();
-                    if(pBubbleEnd->getColor() == GC_BLACK)
-                    {
-                        // The endpoint has been visited, set this vertex as needing removal
-                        // and set the endpoint as unvisited
-                        pWVert->setColor(GC_RED);
-                        bubble_found = true;
-                        pEnd = pBubbleEnd;
-                    }
-                    else
-                    {
-                        pBubbleEnd->setColor(GC_BLACK);
-                        pWVert->setColor(GC_BLUE);
-                    }
-                }
-            }
-            
-            // Unmark vertices
-            for(size_t i = 0; i < edges.size(); ++i)
-            {
-                Edge* pVWEdge = edges[i];
-                Vertex* pWVert = pVWEdge->getEnd();
+        if(pVertex->countEdges(dir) <= 1)
+            continue;
 
-                // Get the edges from w in the same direction
-                EdgeDir transDir = !pVWEdge->getTwinDir();
-                EdgePtrVec wEdges = pWVert->getEdges(transDir);
+        SGBubble bubble;
+        if(!m_engine.findBubble(pVertex, dir, bubble) || !m_engine.findWalks(bubble, MAX_WALKS))
+            continue;
 
-                // If the bubble has collapsed, there should only be one edge
-                if(wEdges.size() == 1)
-                {
-                    Vertex* pBubbleEnd = wEdges.front()->getEnd();
-                    pBubbleEnd->setColor(GC_WHITE);
-                }
-                if(pWVert->getColor() == GC_BLUE)
-                    pWVert->setColor(GC_WHITE);
-            }
+        // Skip bubbles that overlap a bubble that has already been collapsed
+        bool overlaps = bubble.pEnd->getColor() == GC_RED;
+        for(size_t i = 0; i < bubble.internalVertices.size(); ++i)
+            overlaps = overlaps || bubble.internalVertices[i]->getColor() == GC_RED;
+        if(overlaps)
+            continue;
 
-            (void)pStart;
-            (void)pEnd;
-            if(bubble_found)
-            {
-                /*
-                SGWalkVector walkVector;
-                SGSearch::findWalks(pStart, pEnd, dir, 1000, 20, walkVector);
-                
-                if(walkVector.size() == 2)
-                {
-                    SGWalk& walk1 = walkVector[0];
-                    SGWalk& walk2 = walkVector[1];
-
-                    int len1 = walk1.getStartToEndDistance();
-                    int len2 = walk2.getStartToEndDistance();
-                    int diff = len1 - len2;
-                    std::string type = "SNP";
-                    if(diff != 0)
-                    {
-                        type = "INDEL";
-                    }
-                    std::cout << "Bubble " << pStart->getID() << " to " << pEnd->getID() << " is a "
-                              << type << "(d: " << diff << ")\n";
-                }
-                */
-                ++num_bubbles;
-            }
+        // Mark the vertices that are not on the first walk
+        const EdgePtrVec& keepWalk = bubble.walks.front();
+        for(size_t i = 0; i < bubble.internalVertices.size(); ++i)
+        {
+            Vertex* pInternal = bubble.internalVertices[i];
+            bool keep = false;
+            for(size_t j = 0; j < keepWalk.size() && !keep; ++j)
+                keep = keepWalk[j]->getEnd() == pInternal;
+            if(!keep)
+                pInternal->setColor(GC_RED);
         }
+        bubble_found = true;
+        ++num_bubbles;
     }
     return bubble_found;
 }
@@ -1004,260 +1052,318 @@ void SGSmoothingVisitor::previsit(StringGraph* pGraph)
     pGraph->setColors(GC_WHITE);
     m_simpleBubblesRemoved = 0;
     m_complexBubblesRemoved = 0;
+
+    m_indexLimit = pGraph->getVertexIndexLimit();
+    m_threadScratch.assign(1, SmoothingScratch());
+    m_threadScratch[0].engine.init(m_indexLimit);
+    m_threadBubbles.assign(1, SmoothingBubbleVector());
 }
 
 //
-bool SGSmoothingVisitor::visit(StringGraph* pGraph, Vertex* pVertex)
+bool SGSmoothingVisitor::visit(StringGraph* /*pGraph*/, Vertex* pVertex)
 {
-    (void)pGraph;
-    if(pVertex->getColor() == GC_RED)
+    SmoothingBubbleVector& bubbles = m_threadBubbles[0];
+    bubbles.clear();
+    findBubbles(pVertex, m_threadScratch[0], bubbles);
+    if(bubbles.empty())
         return false;
+    removeBubbles(pVertex, &bubbles[0], bubbles.size());
+    return true;
+}
+
+//
+void SGSmoothingVisitor::beginParallel(int numThreads)
+{
+    m_threadScratch.resize(numThreads);
+    for(int i = 1; i < numThreads; ++i)
+        m_threadScratch[i].engine.init(m_indexLimit);
+    m_threadBubbles.assign(numThreads, SmoothingBubbleVector());
+}
 
-    bool found = false;
+//
+bool SGSmoothingVisitor::visitParallel(StringGraph* /*pGraph*/, Vertex* pVertex, int threadIdx)
+{
+    size_t numBubbles = m_threadBubbles[threadIdx].size();
+    findBubbles(pVertex, m_threadScratch[threadIdx], m_threadBubbles[threadIdx]);
+    return m_threadBubbles[threadIdx].size() > numBubbles;
+}
+
+// Find the bubbles that start at pVertex and pass the divergence checks.
+// The graph is not modified.
+void SGSmoothingVisitor::findBubbles(Vertex* pVertex, SmoothingScratch& scratch, SmoothingBubbleVector& outBubbles) const
+{
+    static const size_t MAX_WALKS = 10;
+    static const size_t MAX_NODES = 500;
+    static const int MAX_DISTANCE = 5000;
+
+    scratch.engine.setLimits(MAX_NODES, MAX_DISTANCE);
     for(size_t idx = 0; idx < ED_COUNT; idx++)
     {
         EdgeDir dir = EDGE_DIRECTIONS[idx];
-        EdgePtrVec edges = pVertex->getEdges(dir);
-        if(edges.size() <= 1)
+        if(pVertex->countEdges(dir) <= 1)
             continue;
 
-        for(size_t i = 0; i < edges.size(); ++i)
-        {
-            if(edges[i]->getEnd()->getColor() == GC_RED)
-                return false;
-        }
+        SGBubble& bubble = scratch.candidate.bubble;
+        if(!scratch.engine.findBubble(pVertex, dir, bubble) || !scratch.engine.findWalks(bubble, MAX_WALKS))
+            continue;
 
-        //std::cout << "Smoothing " << pVertex->getID() << "\n";
+        if(evaluateBubble(scratch))
+            outBubbles.push_back(scratch.candidate);
+    }
+}
 
-        const int MAX_WALKS = 10;
-        const int MAX_DISTANCE = 5000;
-        bool bIsDegenerate = false;
-        bool bFailGapCheck = false;
-        bool bFailDivergenceCheck = false;
-        bool bFailIndelSizeCheck = false;
+// Compare the sequence of each walk through the bubble to the walk with the most edges.
+// Returns true if the walks are similar enough for the bubble to be removed.
+bool SGSmoothingVisitor::evaluateBubble(SmoothingScratch& scratch) const
+{
+    SmoothingBubble& candidate = scratch.candidate;
+    const SGBubble& bubble = candidate.bubble;
+    size_t numWalks = bubble.walks.size();
+    if(numWalks <= 1)
+        return false;
 
-        SGWalkVector variantWalks;
-        SGSearch::findVariantWalks(pVertex, dir, MAX_DISTANCE, MAX_WALKS, variantWalks);
+    size_t selectedIdx = 0;
+    size_t selectedLength = 0;
 
-        if(variantWalks.size() > 0)
-        {
-            found = true;
-            size_t selectedIdx = -1;
-            size_t selectedLength = 0;
+    // Calculate the minimum amount overlapped on the start/end vertex.
+    // This is used to properly extract the sequences from walks that represent the variation.
+    int minOverlapX = std::numeric_limits<int>::max();
+    int minOverlapY = std::numeric_limits<int>::max();
 
-            // Calculate the minimum amount overlapped on the start/end vertex.
-            // This is used to properly extract the sequences from walks that represent the variation.
-            int minOverlapX = std::numeric_limits<int>::max();
-            int minOverlapY = std::numeric_limits<int>::max();
+    for(size_t i = 0; i < numWalks; ++i)
+    {
+        const EdgePtrVec& walk = bubble.walks[i];
+        if(walk.size() <= 1)
+            return false; // degenerate
 
-            for(size_t i = 0; i < variantWalks.size(); ++i)
-            {
-                if(variantWalks[i].getNumEdges() <= 1)
-                    bIsDegenerate = true;
+        if(walk.size() > selectedLength)
+        {
+            selectedIdx = i;
+            selectedLength = walk.size();
+        }
 
-                if(variantWalks[i].getNumEdges() > selectedLength)
-                {
-                    selectedIdx = i;
-                    selectedLength = variantWalks[i].getNumEdges();
-                }
-                
-                Edge* pFirstEdge = variantWalks[i].getFirstEdge();
-                Edge* pLastEdge = variantWalks[i].getLastEdge();
+        if((int)walk.front()->getMatchLength() < minOverlapX)
+            minOverlapX = walk.front()->getMatchLength();
 
-                if((int)pFirstEdge->getMatchLength() < minOverlapX)
-                    minOverlapX = pFirstEdge->getMatchLength();
+        if((int)walk.back()->getTwin()->getMatchLength() < minOverlapY)
+            minOverlapY = walk.back()->getTwin()->getMatchLength();
+    }
 
-                if((int)pLastEdge->getTwin()->getMatchLength() < minOverlapY)
-                    minOverlapY = pLastEdge->getTwin()->getMatchLength();
-            }
+    // Unpack the part of each walk that represents the region of variation
+    if(scratch.walkCodes.size() < numWalks)
+        scratch.walkCodes.resize(numWalks);
 
-            // Calculate the strings for each walk that represent the region of variation
-            StringVector walkStrings;
-            for(size_t i = 0; i < variantWalks.size(); ++i)
-            {
-                Vertex* pStartVertex = variantWalks[i].getStartVertex();
-                Vertex* pLastVertex = variantWalks[i].getLastVertex();
-                assert(pStartVertex != NULL && pLastVertex != NULL);
-                
-                std::string full = variantWalks[i].getString(SGWT_START_TO_END);
-                int posStart = 0;
-                int posEnd = 0;
+    std::vector<size_t> regionStart(numWalks, 0);
+    std::vector<size_t> regionLength(numWalks, 0);
+    Vertex* pStartVertex = bubble.pStart;
+    Vertex* pLastVertex = bubble.pEnd;
+    for(size_t i = 0; i < numWalks; ++i)
+    {
+        std::vector<uint8_t>& codes = scratch.walkCodes[i];
+        SGBubbleEngine::getWalkSequence(bubble, bubble.walks[i], codes);
 
-                if(dir == ED_ANTISENSE)
-                {
-                    // pLast   -----------
-                    // pStart          ------------
-                    // full    --------------------
-                    // out             ----
-                    posStart = pLastVertex->getSeqLen() - minOverlapY;
-                    posEnd = full.size() - (pStartVertex->getSeqLen() - minOverlapX);
-                }
-                else
-                {
-                    // pStart         --------------
-                    // pLast   -----------
-                    // full    ---------------------
-                    // out            ----
-                    posStart = pStartVertex->getSeqLen() - minOverlapX; // match start position
-                    posEnd = full.size() - (pLastVertex->getSeqLen() - minOverlapY); // match end position
-                }
-                
-                std::string out;
-                if(posEnd > posStart)
-                    out = full.substr(posStart, posEnd - posStart);
-                walkStrings.push_back(out);
-            }
+        int posStart = 0;
+        int posEnd = 0;
+        if(bubble.dir == ED_ANTISENSE)
+        {
+            // pLast   -----------
+            // pStart          ------------
+            // full    --------------------
+            // out             ----
+            posStart = pLastVertex->getSeqLen() - minOverlapY;
+            posEnd = codes.size() - (pStartVertex->getSeqLen() - minOverlapX);
+        }
+        else
+        {
+            // pStart         --------------
+            // pLast   -----------
+            // full    ---------------------
+            // out            ----
+            posStart = pStartVertex->getSeqLen() - minOverlapX; // match start position
+            posEnd = codes.size() - (pLastVertex->getSeqLen() - minOverlapY); // match end position
+        }
 
-            assert(selectedIdx != (size_t)-1);
-            SGWalk& selectedWalk = variantWalks[selectedIdx];
-            assert(selectedWalk.isIndexed());
+        if(posEnd > posStart)
+        {
+            regionStart[i] = posStart;
+            regionLength[i] = posEnd - posStart;
+        }
+    }
 
-            // Check the divergence of the other walks to this walk
-            StringVector cigarStrings;
-            std::vector<int> maxIndel;
-            std::vector<double> gapPercent; // percentage of matching that is gaps
-            std::vector<double> totalPercent; // percent of total alignment that is mismatch or gap
+    // Check the divergence of the other walks to the selected walk
+    candidate.selectedIdx = selectedIdx;
+    candidate.cigarStrings.assign(numWalks, "");
+    candidate.gapPercent.assign(numWalks, 0.0f);
+    candidate.totalPercent.assign(numWalks, 0.0f);
+    candidate.maxIndel.assign(numWalks, 0);
+
+    const uint8_t* pSelected = &scratch.walkCodes[selectedIdx][0] + regionStart[selectedIdx];
+    size_t selectedRegionLength = regionLength[selectedIdx];
+    EditDistance::EditOps ops;
+    for(size_t i = 0; i < numWalks; ++i)
+    {
+        if(i == selectedIdx)
+            continue;
 
-            cigarStrings.resize(variantWalks.size());
-            gapPercent.resize(variantWalks.size());
-            totalPercent.resize(variantWalks.size());
-            maxIndel.resize(variantWalks.size());
+        // We want to compute the total gap length, total mismatches and percent
+        // divergence between the two paths.
+        int matchLen = 0;
+        int totalDiff = 0;
+        int gapLength = 0;
+        int maxGapLength = 0;
+
+        // We have to handle the degenerate case where one internal string has zero length
+        // this can happen when there is an isolated insertion/deletion and the walks are like:
+        // x -> y -> z
+        // x -> z
+        if(selectedRegionLength == 0 || regionLength[i] == 0)
+        {
+            matchLen = std::max(selectedRegionLength, regionLength[i]);
+            totalDiff = matchLen;
+            gapLength = matchLen;
+        }
+        else
+        {
+            // The paths cannot pass the divergence check if the edit distance
+            // is greater than this, so the alignment is banded to it
+            const uint8_t* pOther = &scratch.walkCodes[i][0] + regionStart[i];
+            int maxDist = (int)ceil(m_maxTotalDivergence * (selectedRegionLength + regionLength[i]));
+            if(EditDistance::globalAlign(pSelected, selectedRegionLength, pOther, regionLength[i], maxDist, ops) == -1)
+                return false;
 
-            for(size_t i = 0; i < variantWalks.size(); ++i)
+            // Calculate the alignment parameters
+            matchLen = ops.size();
+            for(size_t j = 0; j < ops.size(); ++j)
             {
-                if(i == selectedIdx)
-                    continue;
-
-                // We want to compute the total gap length, total mismatches and percent
-                // divergence between the two paths.
-                int matchLen = 0;
-                int totalDiff = 0;
-                int gapLength = 0;
-                int maxGapLength = 0;
-                // We have to handle the degenerate case where one internal string has zero length
-                // this can happen when there is an isolated insertion/deletion and the walks are like:
-                // x -> y -> z
-                // x -> z
-                if(walkStrings[selectedIdx].empty() || walkStrings[i].empty())
+                if(ops[j] != 'M')
+                    totalDiff += 1;
+
+                if(ops[j] == 'I' || ops[j] == 'D')
                 {
-                    matchLen = std::max(walkStrings[selectedIdx].size(), walkStrings[i].size());
-                    totalDiff = matchLen;
-                    gapLength = matchLen;
+                    gapLength += 1;
+                    if(gapLength > maxGapLength)
+                        maxGapLength = gapLength;
                 }
-                else
-                {
-                    AlnAln *aln_global;
-                    aln_global = aln_stdaln(walkStrings[selectedIdx].c_str(), walkStrings[i].c_str(), &aln_param_blast, 1, 1);
+            }
+            candidate.cigarStrings[i] = EditDistance::opsToCigar(ops);
+        }
 
-                    // Calculate the alignment parameters
-                    while(aln_global->outm[matchLen] != '\0')
-                    {
-                        if(aln_global->outm[matchLen] == ' ')
-                            totalDiff += 1;
-                        matchLen += 1;
-                    }
+        double percentDiff = (double)totalDiff / matchLen;
+        double percentGap = (double)gapLength / matchLen;
 
-                    std::stringstream cigarSS;
-                    for (int j = 0; j != aln_global->n_cigar; ++j)
-                    {
-                        char cigarOp = "MID"[aln_global->cigar32[j]&0xf];
-                        int cigarLen = aln_global->cigar32[j]>>4;
-                        if(cigarOp == 'I' || cigarOp == 'D')
-                        {
-                            gapLength += cigarLen;
-                            if(gapLength > maxGapLength)
-                                maxGapLength = gapLength;
-                        }
+        if(percentDiff > m_maxTotalDivergence || percentGap > m_maxGapDivergence || maxGapLength > m_maxIndelLength)
+            return false;
 
-                        cigarSS << cigarLen;
-                        cigarSS << cigarOp;
-                    }
-                    cigarStrings[i] = cigarSS.str();
+        candidate.gapPercent[i] = percentGap;
+        candidate.totalPercent[i] = percentDiff;
+        candidate.maxIndel[i] = maxGapLength;
+    }
+    return true;
+}
 
-                    /*
-                    printf("1: %s\n", aln_global->out1);
-                    printf("M: %s\n", aln_global->outm);
-                    printf("2: %s\n", aln_global->out2);
-                    printf("CIGAR: %s\n", cigarStrings[i].c_str());
-                    */
+// Remove the non-selected walks of the bubbles of pVertex. The bubbles are skipped
+// if pVertex or one of its neighbours has already been marked for removal.
+void SGSmoothingVisitor::removeBubbles(Vertex* pVertex, const SmoothingBubble* pBubbles, size_t numBubbles)
+{
+    if(pVertex->getColor() == GC_RED)
+        return;
 
-                    aln_free_AlnAln(aln_global);
-                }
+    for(size_t idx = 0; idx < ED_COUNT; idx++)
+    {
+        EdgeDir dir = EDGE_DIRECTIONS[idx];
+        EdgePtrVec edges = pVertex->getEdges(dir);
+        if(edges.size() <= 1)
+            continue;
 
-                double percentDiff = (double)totalDiff / matchLen;
-                double percentGap = (double)gapLength / matchLen;
+        for(size_t i = 0; i < edges.size(); ++i)
+        {
+            if(edges[i]->getEnd()->getColor() == GC_RED)
+                return;
+        }
 
-                if(percentDiff > m_maxTotalDivergence)
-                    bFailDivergenceCheck = true;
-                
-                if(percentGap > m_maxGapDivergence)
-                    bFailGapCheck = true;
+        const SmoothingBubble* pBubble = NULL;
+        for(size_t i = 0; i < numBubbles; ++i)
+        {
+            if(pBubbles[i].bubble.dir == dir)
+                pBubble = &pBubbles[i];
+        }
 
-                if(maxGapLength > m_maxIndelLength)
-                    bFailIndelSizeCheck = true;
+        if(pBubble == NULL)
+            continue;
 
-                gapPercent[i] = percentGap;
-                totalPercent[i] = percentDiff;
-                maxIndel[i] = maxGapLength;
+        const SGBubble& bubble = pBubble->bubble;
+        const EdgePtrVec& selectedWalk = bubble.walks[pBubble->selectedIdx];
 
-                //printf("ml: %d tmm: %d pd: %lf pg: %lf\n", matchLen, totalDiff, percentDiff, percentGap);
-            }
+        // Write the selected path to the variants file as variant 0
+        int variantIdx = 0;
+        SGBubbleEngine::getWalkSequence(bubble, selectedWalk, m_outCodes);
+        std::stringstream ss;
+        ss << "variant-" << m_numRemovedTotal << "/" << variantIdx++;
+        writeFastaRecord(&m_outFile, ss.str(), SGBubbleEngine::codesToString(&m_outCodes[0], m_outCodes.size()));
 
-            if(bIsDegenerate || bFailGapCheck || bFailDivergenceCheck || bFailIndelSizeCheck)
+        // The vertex set for each walk is not necessarily disjoint,
+        // the selected walk may contain vertices that are part
+        // of other paths. These vertices are not marked.
+        for(size_t i = 0; i < bubble.walks.size(); ++i)
+        {
+            if(i == pBubble->selectedIdx)
                 continue;
 
-            // Write the selected path to the variants file as variant 0
-            int variantIdx = 0;
-            std::string selectedSequence = selectedWalk.getString(SGWT_START_TO_END);
-            std::stringstream ss;
-            ss << "variant-" << m_numRemovedTotal << "/" << variantIdx++;
-            writeFastaRecord(&m_outFile, ss.str(), selectedSequence);
-
-
-            // The vertex set for each walk is not necessarily disjoint,
-            // the selected walk may contain vertices that are part
-            // of other paths. We handle this be initially marking all
-            // vertices of the 
-            for(size_t i = 0; i < variantWalks.size(); ++i)
+            const EdgePtrVec& currWalk = bubble.walks[i];
+            for(size_t j = 0; j < currWalk.size() - 1; ++j)
             {
-                if(i == selectedIdx)
-                    continue;
-
-                SGWalk& currWalk = variantWalks[i];
-                for(size_t j = 0; j < currWalk.getNumEdges() - 1; ++j)
-                {
-                    Edge* currEdge = currWalk.getEdge(j);
-                    
-                    // If the vertex is also on the selected path, do not mark it
-                    Vertex* currVertex = currEdge->getEnd();
-                    if(!selectedWalk.containsVertex(currVertex->getID()))
-                    {
-                        currEdge->getEnd()->setColor(GC_RED);
-                    }
-                }
-
-                // Write the variant to a file
-                std::string variantSequence = currWalk.getString(SGWT_START_TO_END);
-                std::stringstream variantID;
-                std::stringstream ss;
-                ss << "variant-" << m_numRemovedTotal << "/" << variantIdx++;
-                ss << " IGD:" << (double)gapPercent[i] << " ITD:" << totalPercent[i] << " MID: " << maxIndel[i] << " InternalCigar:" << cigarStrings[i];
-                writeFastaRecord(&m_outFile, ss.str(), variantSequence);
+                Vertex* currVertex = currWalk[j]->getEnd();
+                bool onSelected = false;
+                for(size_t k = 0; k < selectedWalk.size() && !onSelected; ++k)
+                    onSelected = selectedWalk[k]->getEnd() == currVertex;
+                if(!onSelected)
+                    currVertex->setColor(GC_RED);
             }
 
-            if(variantWalks.size() == 2)
-                m_simpleBubblesRemoved += 1;
-            else
-                m_complexBubblesRemoved += 1;
-            ++m_numRemovedTotal;
+            // Write the variant to a file
+            SGBubbleEngine::getWalkSequence(bubble, currWalk, m_outCodes);
+            std::stringstream ss;
+            ss << "variant-" << m_numRemovedTotal << "/" << variantIdx++;
+            ss << " IGD:" << pBubble->gapPercent[i] << " ITD:" << pBubble->totalPercent[i];
+            ss << " MID: " << pBubble->maxIndel[i] << " InternalCigar:" << pBubble->cigarStrings[i];
+            writeFastaRecord(&m_outFile, ss.str(), SGBubbleEngine::codesToString(&m_outCodes[0], m_outCodes.size()));
         }
+
+        if(bubble.walks.size() == 2)
+            m_simpleBubblesRemoved += 1;
+        else
+            m_complexBubblesRemoved += 1;
+        ++m_numRemovedTotal;
     }
-    return found;
 }
 
-// Remove all the marked edges
+// Remove the bubbles found by the parallel visit in vertex order
+// then remove all the marked vertices
 void SGSmoothingVisitor::postvisit(StringGraph* pGraph)
 {
+    std::vector<std::pair<VertexIdx, const SmoothingBubble*> > order;
+    for(size_t i = 0; i < m_threadBubbles.size(); ++i)
+    {
+        for(size_t j = 0; j < m_threadBubbles[i].size(); ++j)
+        {
+            const SmoothingBubble* pBubble = &m_threadBubbles[i][j];
+            order.push_back(std::make_pair(pBubble->bubble.pStart->getIndex(), pBubble));
+        }
+    }
+    std::sort(order.begin(), order.end());
+
+    // The bubbles of a vertex are found by a single thread so they are adjacent
+    for(size_t i = 0; i < order.size();)
+    {
+        size_t j = i;
+        while(j < order.size() && order[j].first == order[i].first)
+            ++j;
+        removeBubbles(order[i].second->bubble.pStart, order[i].second, j - i);
+        i = j;
+    }
+    m_threadBubbles.clear();
+    m_threadScratch.clear();
+
     pGraph->sweepVertices(GC_RED);
     assert(pGraph->checkColors(GC_WHITE));
 
@@ -1428,5 +1534,5 @@ int SGBreakWriteVisitor::calculateOverlapLengthDifference(const Vertex* pVertex,
 
 void SGBreakWriteVisitor::writeBreak(const std::string& type, Vertex* pVertex)
 {
-    *m_pWriter << "BREAK\t" << type << "\t" << pVertex->getID() << "\t" << pVertex->getSeq() << "\n";
+    *m_pWriter << "BREAK\t" << type << "\t" << pVertex->getID() << "\t" << pVertex->getStr() << "\n";
 }
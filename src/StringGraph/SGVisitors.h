@@ -10,6 +10,7 @@
 //
 #include "SGAlgorithms.h"
 #include "SGUtil.h"
+#include "SGBubbleEngine.h"
 
 #ifndef SGVISITORS_H
 #define SGVISITORS_H
@@ -45,6 +46,36 @@ struct SGOverlapWriterVisitor
     std::ofstream m_fileHandle;
 };
 
+// Scratch marks for the neighbours of a vertex, indexed by vertex index.
+// Each thread has its own marks so that multiple vertices can be
+// reduced at the same time. Only the entries that were set are
+// reset when the marks are cleared.
+class NeighborMarks
+{
+    public:
+        void resize(size_t n) { m_colors.assign(n, GC_WHITE); m_touched.clear(); }
+
+        GraphColor get(const Vertex* pVertex) const { return m_colors[pVertex->getIndex()]; }
+        void set(const Vertex* pVertex, GraphColor c)
+        {
+            VertexIdx idx = pVertex->getIndex();
+            if(m_colors[idx] == GC_WHITE)
+                m_touched.push_back(idx);
+            m_colors[idx] = c;
+        }
+
+        void clear()
+        {
+            for(size_t i = 0; i < m_touched.size(); ++i)
+                m_colors[m_touched[i]] = GC_WHITE;
+            m_touched.clear();
+        }
+
+    private:
+        std::vector<GraphColor> m_colors;
+        std::vector<VertexIdx> m_touched;
+};
+
 // Run the Myers transitive reduction algorithm on each node
 struct SGTransitiveReductionVisitor
 {
@@ -53,8 +84,24 @@ struct SGTransitiveReductionVisitor
     bool visit(StringGraph* pGraph, Vertex* pVertex);
     void postvisit(StringGraph*);
 
+    // Parallel visit. The transitive edges found by each thread
+    // are buffered and marked for removal in postvisit
+    VisitScope getVisitScope(const StringGraph*) const { return VS_READ_ONLY; }
+    void beginParallel(int numThreads);
+    bool visitParallel(StringGraph* pGraph, Vertex* pVertex, int threadIdx);
+
+    // Find the edges of pVertex that are transitive. The neighbours
+    // are marked in marks so the graph is not modified
+    void findTransitiveEdges(Vertex* pVertex, NeighborMarks& marks, EdgePtrVec& outEdges) const;
+
+    // Mark the edges and their twins for removal, returning the number of newly marked edges
+    int markTransitiveEdges(const EdgePtrVec& edges);
+
     int marked_verts;
     int marked_edges;
+    size_t m_indexLimit;
+    std::vector<NeighborMarks> m_threadMarks;
+    std::vector<EdgePtrVec> m_threadEdges;
 };
 
 // Remove identical vertices from the graph
@@ -74,6 +121,15 @@ struct SGContainRemoveVisitor
     void previsit(StringGraph* pGraph);
     bool visit(StringGraph* pGraph, Vertex* pVertex);
     void postvisit(StringGraph* pGraph);
+
+    // Parallel visit. If the neighbours of the contained vertices must be
+    // remodelled the visit is exclusive, otherwise the contained vertices
+    // are buffered per thread and removed in postvisit
+    VisitScope getVisitScope(const StringGraph* pGraph) const;
+    void beginParallel(int numThreads);
+    bool visitParallel(StringGraph* pGraph, Vertex* pVertex, int threadIdx);
+
+    std::vector<VertexPtrVec> m_threadVertices;
 };
 
 // Validate that the graph does not contain
@@ -157,9 +213,21 @@ struct SGTrimVisitor
     bool visit(StringGraph* pGraph, Vertex* pVertex);
     void postvisit(StringGraph*);
 
+    // Parallel visit. The vertices to remove and the counts
+    // are kept per thread and merged in postvisit
+    VisitScope getVisitScope(const StringGraph*) const { return VS_READ_ONLY; }
+    void beginParallel(int numThreads);
+    bool visitParallel(StringGraph* pGraph, Vertex* pVertex, int threadIdx);
+
+    // Returns true if pVertex should be trimmed and updates the counts
+    bool checkTrim(Vertex* pVertex, int& islandCount, int& terminalCount) const;
+
     size_t m_minLength;
     int num_island;
     int num_terminal;
+    std::vector<VertexPtrVec> m_threadVertices;
+    std::vector<int> m_threadIsland;
+    std::vector<int> m_threadTerminal;
 };
 
 // Detect and remove duplicate edges
@@ -192,6 +260,7 @@ struct SGBubbleVisitor
     bool visit(StringGraph* pGraph, Vertex* pVertex);
     void postvisit(StringGraph*);
     int num_bubbles;
+    SGBubbleEngine m_engine;
 };
 
 // Detect whether bubble edges and remove them
@@ -221,6 +290,42 @@ struct SGSmoothingVisitor
     bool visit(StringGraph* pGraph, Vertex* pVertex);
     void postvisit(StringGraph*);
 
+    // Parallel visit. The bubbles that can be removed are found by
+    // each thread and removed in vertex order in postvisit, which
+    // gives the same result as the serial visit
+    VisitScope getVisitScope(const StringGraph*) const { return VS_READ_ONLY; }
+    void beginParallel(int numThreads);
+    bool visitParallel(StringGraph* pGraph, Vertex* pVertex, int threadIdx);
+
+    // A bubble that passed the divergence checks and the alignment
+    // of each of its walks to the selected walk
+    struct SmoothingBubble
+    {
+        SGBubble bubble;
+        size_t selectedIdx;
+        StringVector cigarStrings;
+        std::vector<double> gapPercent;
+        std::vector<double> totalPercent;
+        std::vector<int> maxIndel;
+    };
+    typedef std::vector<SmoothingBubble> SmoothingBubbleVector;
+
+    // The search state of one thread
+    struct SmoothingScratch
+    {
+        SGBubbleEngine engine;
+        std::vector<std::vector<uint8_t> > walkCodes;
+        SmoothingBubble candidate;
+    };
+
+    // Find the removable bubbles that start at pVertex
+    void findBubbles(Vertex* pVertex, SmoothingScratch& scratch, SmoothingBubbleVector& outBubbles) const;
+    bool evaluateBubble(SmoothingScratch& scratch) const;
+
+    // Remove the bubbles found for pVertex unless they conflict with a bubble
+    // that has already been removed
+    void removeBubbles(Vertex* pVertex, const SmoothingBubble* pBubbles, size_t numBubbles);
+
     int m_simpleBubblesRemoved;
     int m_complexBubblesRemoved;
     int m_numRemovedTotal;
@@ -229,6 +334,11 @@ struct SGSmoothingVisitor
     double m_maxTotalDivergence;
     int m_maxIndelLength;
     std::ofstream m_outFile;
+
+    size_t m_indexLimit;
+    std::vector<SmoothingScratch> m_threadScratch;
+    std::vector<SmoothingBubbleVector> m_threadBubbles;
+    std::vector<uint8_t> m_outCodes;
 };
 
 // Remove vertices/edges that have low coverage
@@ -90,9 +90,9 @@ void SGWalk::addEdge(Edge* pEdge)
     m_edges.push_back(pEdge);
     m_extensionDistance += pEdge->getSeqLen();
 
-    // Add the vertex ID to the index if necessary
+    // Add the vertex to the index if necessary
     if(m_pWalkIndex != NULL)
-        m_pWalkIndex->insert(m_edges.back()->getEndID());
+        m_pWalkIndex->insert(m_edges.back()->getEnd()->getIndex());
 }
 
 //
@@ -136,11 +136,11 @@ bool SGWalk::isIndexed() const
 }
 
 //
-bool SGWalk::containsVertex(const VertexID& id) const
+bool SGWalk::containsVertex(const Vertex* pVertex) const
 {
     if(m_pWalkIndex == NULL)
         assert(false);
-    return m_pWalkIndex->count(id) > 0;
+    return m_pWalkIndex->count(pVertex->getIndex()) > 0;
 }
 
 //
@@ -164,7 +164,7 @@ std::string SGWalk::getString(SGWalkType type) const
 
     if(type == SGWT_START_TO_END || type == SGWT_INTERNAL)
     {
-        out.append(m_pStartVertex->getSeq().toString());
+        out.append(m_pStartVertex->getStr());
     }
 
     // Determine if the string should go to the end of the last vertex
@@ -287,7 +287,7 @@ std::string SGWalk::getFragmentString(const Vertex* pX, const Vertex* pY,
         return "";
 
     //
-    out.append(m_pStartVertex->getSeq().substr(xCoord.interval.start, xCoord.length()));
+    out.append(m_pStartVertex->getStr().substr(xCoord.interval.start, xCoord.length()));
 
     // Determine if the string should go to the end of the last vertex
     // in the path
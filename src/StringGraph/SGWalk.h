@@ -54,7 +54,7 @@ class SGWalk
         // Returns true if the walk contains the specified vertex
         // If the walk is not indexed, this will assert
         bool isIndexed() const;
-        bool containsVertex(const VertexID& id) const;
+        bool containsVertex(const Vertex* pVertex) const;
 
         // Truncate the walk after the first instance of id
         void truncate(const VertexID& id);
@@ -83,7 +83,7 @@ class SGWalk
         Vertex* m_pStartVertex;
         EdgePtrVec m_edges;
         
-        typedef std::set<VertexID> WalkIndex;
+        typedef std::set<VertexIdx> WalkIndex;
         WalkIndex* m_pWalkIndex;
 
         // The distance from the end of pStart to the last vertex in the walk
@@ -13,7 +13,12 @@
 // coordinates [l, u] will be such that l > u
 BWTInterval BWTAlgorithms::findInterval(const BWT* pBWT, const std::string& w)
 {
-    int len = w.size();
+    return findInterval(pBWT, w.c_str(), w.size());
+}
+
+// Find the interval in pBWT corresponding to the len symbols starting at w
+BWTInterval BWTAlgorithms::findInterval(const BWT* pBWT, const char* w, size_t len)
+{
     int j = len - 1;
     char curr = w[j];
     BWTInterval interval;
@@ -34,15 +39,20 @@ BWTInterval BWTAlgorithms::findInterval(const BWT* pBWT, const std::string& w)
 // using a cache of short k-mer intervals to avoid
 // some of the iterations
 BWTInterval BWTAlgorithms::findIntervalWithCache(const BWT* pBWT, const BWTIntervalCache* pIntervalCache, const std::string& w)
+{
+    return findIntervalWithCache(pBWT, pIntervalCache, w.c_str(), w.size());
+}
+
+//
+BWTInterval BWTAlgorithms::findIntervalWithCache(const BWT* pBWT, const BWTIntervalCache* pIntervalCache, const char* w, size_t len)
 {
     size_t cacheLen = pIntervalCache->getCachedLength();
-    if(w.size() < cacheLen)
-        return findInterval(pBWT, w);
+    if(len < cacheLen)
+        return findInterval(pBWT, w, len);
 
     // Compute the interval using the cache for the last k bases
-    int len = w.size();
     int j = len - cacheLen;
-    BWTInterval interval = pIntervalCache->lookup(w.c_str() + j);
+    BWTInterval interval = pIntervalCache->lookup(w + j);
     j -= 1;
     for(;j >= 0; --j)
     {
@@ -150,7 +160,20 @@ std::string BWTAlgorithms::sampleRandomString(const BWT* pBWT)
     assert(RAND_MAX > 0x7FFF);
     size_t n = pBWT->getNumStrings();
     size_t idx = rand() % n;
+    return extractString(pBWT, idx);
+}
+
+//
+std::string BWTAlgorithms::sampleRandomString(const BWT* pBWT, unsigned int* pSeed)
+{
+    size_t n = pBWT->getNumStrings();
+    size_t r = ((size_t)rand_r(pSeed) << 31) | rand_r(pSeed);
+    return extractString(pBWT, r % n);
+}
 
+// Return the string whose terminal symbol is at position idx of the BWT
+std::string BWTAlgorithms::extractString(const BWT* pBWT, size_t idx)
+{
     std::string out;
 
     // The range [0,n) in the BWT contains all the terminal
@@ -25,7 +25,9 @@ namespace BWTAlgorithms
 
 // get the interval(s) in pBWT/pRevBWT that corresponds to the string w using a backward search algorithm
 BWTInterval findInterval(const BWT* pBWT, const std::string& w);
+BWTInterval findInterval(const BWT* pBWT, const char* w, size_t len);
 BWTInterval findIntervalWithCache(const BWT* pBWT, const BWTIntervalCache* pIntervalCache, const std::string& w);
+BWTInterval findIntervalWithCache(const BWT* pBWT, const BWTIntervalCache* pIntervalCache, const char* w, size_t len);
 
 BWTIntervalPair findIntervalPair(const BWT* pBWT, const BWT* pRevBWT, const std::string& w);
 
@@ -130,6 +132,13 @@ AlphaCount64 calculateExactExtensions(const unsigned int overlapLen, const std::
 // Returns a randomly chosen string from the BWT
 std::string sampleRandomString(const BWT* pBWT);
 
+// Returns a randomly chosen string from the BWT using the random state in pSeed
+// instead of the global state so it can be called from multiple threads
+std::string sampleRandomString(const BWT* pBWT, unsigned int* pSeed);
+
+// Returns the string whose terminal symbol is at position idx of the BWT
+std::string extractString(const BWT* pBWT, size_t idx);
+
 };
 
 #endif
@@ -0,0 +1,69 @@
+//-----------------------------------------------
+// Copyright 2010 Wellcome Trust Sanger Institute
+// Written by Jared Simpson (js18@sanger.ac.uk)
+// Released under the GPL license
+//-----------------------------------------------
+//
+// BWTReplicaSet - Holds one copy of a read-only BWT per
+// NUMA node.
+//
+#include "BWTReplicaSet.h"
+
+// Pool task that loads a BWT on the thread it runs on
+class BWTLoadTask : public PoolTask
+{
+    public:
+        BWTLoadTask(const std::string& filename, int sampleRate) : m_filename(filename),
+                                                                   m_sampleRate(sampleRate),
+                                                                   m_pBWT(NULL) {}
+        void run() { m_pBWT = new BWT(m_filename, m_sampleRate); }
+        BWT* getBWT() const { return m_pBWT; }
+
+    private:
+        std::string m_filename;
+        int m_sampleRate;
+        BWT* m_pBWT;
+};
+
+//
+BWTReplicaSet::BWTReplicaSet(const std::string& filename, int sampleRate, bool replicate)
+{
+    ThreadPool& pool = ThreadPool::getInstance();
+    if(!replicate || pool.getAffinityPolicy() == AP_NONE || pool.getNumNodes() == 1)
+    {
+        m_replicas.push_back(new BWT(filename, sampleRate));
+        return;
+    }
+
+    // Load the copies concurrently, one task per node
+    int numNodes = pool.getNumNodes();
+    TaskGroup taskGroup;
+    std::vector<BWTLoadTask*> tasks(numNodes);
+    for(int i = 0; i < numNodes; ++i)
+    {
+        tasks[i] = new BWTLoadTask(filename, sampleRate);
+        pool.submit(tasks[i], &taskGroup, i);
+    }
+    taskGroup.wait();
+
+    for(int i = 0; i < numNodes; ++i)
+    {
+        m_replicas.push_back(tasks[i]->getBWT());
+        delete tasks[i];
+    }
+}
+
+//
+BWTReplicaSet::~BWTReplicaSet()
+{
+    for(size_t i = 0; i < m_replicas.size(); ++i)
+        delete m_replicas[i];
+}
+
+//
+const BWT* BWTReplicaSet::get(int node) const
+{
+    if(node == ThreadPool::ANY_NODE)
+        return m_replicas.front();
+    return m_replicas[node % m_replicas.size()];
+}
@@ -0,0 +1,40 @@
+//-----------------------------------------------
+// Copyright 2010 Wellcome Trust Sanger Institute
+// Written by Jared Simpson (js18@sanger.ac.uk)
+// Released under the GPL license
+//-----------------------------------------------
+//
+// BWTReplicaSet - Holds one copy of a read-only BWT per
+// NUMA node. Each copy is loaded by a ThreadPool task
+// running on the node so the pages of the index are 
+// placed in the node's local memory (first-touch).
+// Workers then query the copy on their own node
+// instead of reading the index over the interconnect.
+//
+#ifndef BWTREPLICASET_H
+#define BWTREPLICASET_H
+
+#include "BWT.h"
+#include "ThreadPool.h"
+
+class BWTReplicaSet
+{
+    public:
+
+        // Load the BWT in filename. If replicate is true and the thread pool
+        // pins its threads, a copy is loaded on every NUMA node. Otherwise
+        // a single copy is loaded by the calling thread.
+        BWTReplicaSet(const std::string& filename, int sampleRate, bool replicate);
+        ~BWTReplicaSet();
+
+        // Return the copy of the BWT local to node. 
+        // ThreadPool::ANY_NODE returns the first copy
+        const BWT* get(int node) const;
+
+        size_t getNumReplicas() const { return m_replicas.size(); }
+
+    private:
+        std::vector<BWT*> m_replicas;
+};
+
+#endif
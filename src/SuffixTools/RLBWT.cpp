@@ -31,6 +31,24 @@ RLBWT::RLBWT(const std::string& filename, int sampleRate) : m_numStrings(0),
     delete pReader;
 }
 
+// The symbols are computed as in IBWTWriter::write
+RLBWT::RLBWT(const SuffixArray* pSA, const ReadTable* pRT, int sampleRate) : m_numStrings(pSA->getNumStrings()), 
+                                                                              m_numSymbols(0), 
+                                                                              m_largeSampleRate(DEFAULT_SAMPLE_RATE_LARGE),
+                                                                              m_smallSampleRate(sampleRate)
+{
+    size_t num_symbols = pSA->getSize();
+    for(size_t i = 0; i < num_symbols; ++i)
+    {
+        SAElem saElem = pSA->get(i);
+        const SeqItem& si = pRT->getRead(saElem.getID());
+        uint64_t f_pos = saElem.getPos();
+        uint64_t l_pos = (f_pos == 0) ? si.seq.length() : f_pos - 1;
+        append((l_pos == si.seq.length()) ? '$' : si.seq.get(l_pos));
+    }
+    initializeFMIndex();
+}
+
 //
 void RLBWT::append(char b)
 {
@@ -32,6 +32,9 @@ class RLBWT
         // Constructors
         RLBWT(const std::string& filename, int sampleRate = DEFAULT_SAMPLE_RATE_SMALL);
 
+        // Construct the BWT of the reads in pRT in memory from their suffix array
+        RLBWT(const SuffixArray* pSA, const ReadTable* pRT, int sampleRate = DEFAULT_SAMPLE_RATE_SMALL);
+
         //    
         void initializeFMIndex();
 
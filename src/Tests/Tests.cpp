@@ -5,13 +5,39 @@
 #include "SBWT.h"
 #include "RLBWT.h"
 #include "BWTWriter.h"
+#include "SGUtil.h"
+#include "SGAlgorithms.h"
+#include "SGBubbleEngine.h"
+#include "SGSearch.h"
+#include "CompactGraph.h"
+#include "RatioEstimator.h"
+#include "KmerCommon.h"
+#include "ReadTable.h"
+#include "SuffixArray.h"
+#include <fstream>
+#include <sstream>
+#include <utime.h>
+#include <dirent.h>
+#include <unistd.h>
 
 void dnaStringTests();
+void bubbleEngineTests();
+void ratioEstimatorTests();
+void kmerCacheKeyTests();
+void snapshotTests();
+void compactGraphTests();
 
 int main(int argc, char** argv)
 {
-    (void)argc;
-    (void)argv;
+    bubbleEngineTests();
+    ratioEstimatorTests();
+    kmerCacheKeyTests();
+    snapshotTests();
+    compactGraphTests();
+
+    // The remaining tests compare the BWT representations of an index
+    if(argc < 2)
+        return 0;
 
     std::string file = argv[1];
     SBWT* pBWT = new SBWT(file);
@@ -27,8 +53,8 @@ int main(int argc, char** argv)
     for(size_t i = 0; i < pBWT->getBWLen(); ++i)
     {
     
-        AlphaCount bAC = pBWT->getFullOcc(i);
-        AlphaCount rAC = pRLBWT->getFullOcc(i);
+        AlphaCount64 bAC = pBWT->getFullOcc(i);
+        AlphaCount64 rAC = pRLBWT->getFullOcc(i);
 
         //std::cout << "Test: RLBWT[" << i << "] = " << rAC << " BWT= " << bAC << "\n";
 
@@ -128,3 +154,339 @@ void dnaStringTests()
     }
 }
 
+// Build a graph with a single SNP bubble between A and C,
+// where C is much longer than the distance limit of the engine
+void bubbleEngineTests()
+{
+    std::cout << "Testing bubble detection with a long exit vertex\n";
+    srand(1);
+    std::string genome;
+    for(size_t i = 0; i < 6220; ++i)
+        genome.push_back("ACGT"[rand() % 4]);
+
+    std::string seqA = genome.substr(0, 100);
+    std::string seqB1 = genome.substr(60, 100);
+    std::string seqB2 = seqB1;
+    seqB2[50] = seqB2[50] == 'A' ? 'C' : 'A';
+    std::string seqC = genome.substr(120);
+
+    StringGraph* pGraph = new StringGraph;
+    Vertex* pA = pGraph->createVertex("A", seqA);
+    Vertex* pB1 = pGraph->createVertex("B1", seqB1);
+    Vertex* pB2 = pGraph->createVertex("B2", seqB2);
+    Vertex* pC = pGraph->createVertex("C", seqC);
+    pGraph->addVertex(pA);
+    pGraph->addVertex(pB1);
+    pGraph->addVertex(pB2);
+    pGraph->addVertex(pC);
+
+    // A[60,99] matches B[0,39] and B[60,99] matches C[0,39]
+    int lenC = seqC.size();
+    SGAlgorithms::createEdgesFromOverlap(pGraph, Overlap("A", 60, 99, 100, "B1", 0, 39, 100, false, 0), false);
+    SGAlgorithms::createEdgesFromOverlap(pGraph, Overlap("A", 60, 99, 100, "B2", 0, 39, 100, false, 0), false);
+    SGAlgorithms::createEdgesFromOverlap(pGraph, Overlap("B1", 60, 99, 100, "C", 0, 39, lenC, false, 0), false);
+    SGAlgorithms::createEdgesFromOverlap(pGraph, Overlap("B2", 60, 99, 100, "C", 0, 39, lenC, false, 0), false);
+
+    SGBubbleEngine engine;
+    engine.init(pGraph->getVertexIndexLimit());
+    engine.setLimits(500, 5000);
+
+    // The exit is further from A than the limit but it is never expanded
+    SGBubble bubble;
+    bool found = engine.findBubble(pA, ED_SENSE, bubble);
+    assert(found && bubble.pEnd == pC);
+    assert(bubble.internalVertices.size() == 2);
+    assert(engine.findWalks(bubble, 10) && bubble.walks.size() == 2);
+
+    // The walks spell the genome with either allele of the SNP
+    std::string variant = genome;
+    variant[110] = seqB2[50];
+    std::vector<uint8_t> codes;
+    for(size_t i = 0; i < bubble.walks.size(); ++i)
+    {
+        SGBubbleEngine::getWalkSequence(bubble, bubble.walks[i], codes);
+        std::string walkSeq = SGBubbleEngine::codesToString(&codes[0], codes.size());
+        assert(walkSeq == genome || walkSeq == variant);
+    }
+
+    // An internal vertex past the limit still ends the search
+    engine.setLimits(500, 30);
+    found = engine.findBubble(pA, ED_SENSE, bubble);
+    assert(!found);
+
+    delete pGraph;
+    (void)found;
+}
+
+// The intervals for proportions near 0 and 1 must stay within [0, 1]
+void ratioEstimatorTests()
+{
+    std::cout << "Testing confidence intervals of sampled proportions\n";
+    double lower, upper;
+    RatioEstimator::getWilsonInterval(998, 1000, Z_95, 100000, lower, upper);
+    assert(lower > 0.99 && lower < 0.998 && upper > 0.998 && upper <= 1.0);
+
+    RatioEstimator::getWilsonInterval(0, 1000, Z_95, 100000, lower, upper);
+    assert(lower == 0.0 && upper > 0.0 && upper < 0.01);
+
+    // Sampling the whole population gives the exact proportion
+    RatioEstimator::getWilsonInterval(10, 1000, Z_95, 1000, lower, upper);
+    assert(lower == 0.01 && upper == 0.01);
+
+    // A rare per-base error spread over many reads
+    RatioEstimator estimator;
+    estimator.add(0, 100, 999);
+    estimator.add(6, 100, 1);
+    estimator.getInterval(Z_95, 100000, 0.0, 1.0, lower, upper);
+    assert(lower == 0.0 && upper > estimator.getEstimate() && upper < 1.0);
+}
+
+// Create an empty directory for the files written by a test
+static std::string createTempDir()
+{
+    const char* pTmp = getenv("TMPDIR");
+    std::string path = std::string(pTmp != NULL ? pTmp : "/tmp") + "/sga-test-XXXXXX";
+    std::vector<char> buffer(path.begin(), path.end());
+    buffer.push_back('\0');
+    char* pDir = mkdtemp(&buffer[0]);
+    assert(pDir != NULL);
+    return pDir;
+}
+
+// Remove a directory made by createTempDir along with its files
+static void removeTempDir(const std::string& dir)
+{
+    DIR* pDir = opendir(dir.c_str());
+    assert(pDir != NULL);
+    struct dirent* pEntry;
+    while((pEntry = readdir(pDir)) != NULL)
+    {
+        std::string name = pEntry->d_name;
+        if(name != "." && name != "..")
+            unlink((dir + "/" + name).c_str());
+    }
+    closedir(pDir);
+    rmdir(dir.c_str());
+}
+
+// Write reads to prefix.fa and build prefix.bwt from them
+static void writeTestIndex(const std::string& prefix, const std::vector<std::string>& reads)
+{
+    std::string readsFile = prefix + ".fa";
+    std::ofstream writer(readsFile.c_str());
+    for(size_t i = 0; i < reads.size(); ++i)
+        writer << ">" << i << "\n" << reads[i] << "\n";
+    writer.close();
+
+    ReadTable* pRT = new ReadTable(readsFile);
+    SuffixArray* pSA = new SuffixArray(pRT, 1);
+    pSA->writeBWT(prefix + ".bwt", pRT);
+    delete pSA;
+    delete pRT;
+}
+
+//
+static std::string getTestIndexKey(const std::string& prefix, const std::string& sample)
+{
+    BWT* pBWT = new BWT(prefix + ".bwt");
+    std::string key = KmerCommon::getIndexKey(prefix + ".bwt", pBWT, 5, sample);
+    delete pBWT;
+    return key;
+}
+
+// A cached histogram must not be reused once the index it was computed from changes
+void kmerCacheKeyTests()
+{
+    std::cout << "Testing the kmer histogram cache key\n";
+    std::string dir = createTempDir();
+    std::string prefix = dir + "/kmer-cache-test";
+    std::vector<std::string> reads;
+    reads.push_back("ACGTTGCAAGGCTTACGATCGATT");
+    reads.push_back("TTGACCGATAGCAGGATCCATGCA");
+    writeTestIndex(prefix, reads);
+    std::string key = getTestIndexKey(prefix, "sample of 10 reads");
+    assert(key == getTestIndexKey(prefix, "sample of 10 reads"));
+
+    // A different sample of the same index
+    assert(key != getTestIndexKey(prefix, "sample of 20 reads"));
+
+    // An edited read set with the same number of reads and bases
+    reads[1][3] = 'T';
+    writeTestIndex(prefix, reads);
+    std::string editedKey = getTestIndexKey(prefix, "sample of 10 reads");
+    assert(editedKey != key);
+
+    // The same index written again later
+    struct utimbuf times;
+    times.actime = times.modtime = time(0) + 10;
+    utime((prefix + ".bwt").c_str(), &times);
+    assert(getTestIndexKey(prefix, "sample of 10 reads") != editedKey);
+
+    // Programs with different samples keep their histograms apart
+    assert(KmerCommon::getDistributionFilename(prefix, 5, "stats") != 
+           KmerCommon::getDistributionFilename(prefix, 5, "correct"));
+
+    removeTempDir(dir);
+}
+
+//
+static std::string readFileContents(const std::string& filename)
+{
+    std::ifstream reader(filename.c_str(), std::ios::in | std::ios::binary);
+    std::stringstream ss;
+    ss << reader.rdbuf();
+    return ss.str();
+}
+
+//
+static void writeFileContents(const std::string& filename, const std::string& contents)
+{
+    std::ofstream writer(filename.c_str(), std::ios::out | std::ios::binary);
+    writer.write(contents.data(), contents.size());
+}
+
+// Load a snapshot and return the error that was printed, if any
+static Bigraph* loadTestSnapshot(const std::string& filename, std::string& outError)
+{
+    std::stringstream errors;
+    std::streambuf* pOldBuf = std::cerr.rdbuf(errors.rdbuf());
+    std::string tag;
+    Bigraph* pGraph = Bigraph::loadSnapshot(filename, tag);
+    std::cerr.rdbuf(pOldBuf);
+    outError = errors.str();
+    return pGraph;
+}
+
+// A snapshot must load back into the same graph and a damaged
+// snapshot must be rejected with an error
+void snapshotTests()
+{
+    std::cout << "Testing graph snapshots\n";
+    std::string dir = createTempDir();
+    srand(2);
+    std::string genome;
+    for(size_t i = 0; i < 220; ++i)
+        genome.push_back("ACGT"[rand() % 4]);
+
+    // A and B overlap on the same strand and B overlaps the reverse complement C
+    StringGraph* pGraph = new StringGraph;
+    pGraph->setMinOverlap(30);
+    pGraph->setErrorRate(0.02);
+    Vertex* pA = pGraph->createVertex("A", genome.substr(0, 100));
+    Vertex* pB = pGraph->createVertex("B", genome.substr(60, 100));
+    Vertex* pC = pGraph->createVertex("C", reverseComplement(genome.substr(120, 100)));
+    pGraph->addVertex(pA);
+    pGraph->addVertex(pB);
+    pGraph->addVertex(pC);
+    pA->setContained(true);
+    SGAlgorithms::createEdgesFromOverlap(pGraph, Overlap("A", 60, 99, 100, "B", 0, 39, 100, false, 0), false);
+    SGAlgorithms::createEdgesFromOverlap(pGraph, Overlap("B", 60, 99, 100, "C", 60, 99, 100, true, 0), false);
+
+    std::string snapshotFile = dir + "/graph.snapshot";
+    pGraph->writeSnapshot(snapshotFile, "test");
+    pGraph->writeASQG(dir + "/graph.asqg");
+
+    std::string tag;
+    Bigraph* pLoaded = Bigraph::loadSnapshot(snapshotFile, tag);
+    assert(pLoaded != NULL && tag == "test");
+    assert(pLoaded->getNumVertices() == 3 && pLoaded->getVertex("B")->countEdges() == 2);
+    assert(pLoaded->getVertex("A")->isContained() && !pLoaded->getVertex("B")->isContained());
+    assert(pLoaded->getVertex("C")->getStr() == pC->getStr());
+    assert(pLoaded->getMinOverlap() == 30 && pLoaded->getErrorRate() == 0.02);
+    pLoaded->writeASQG(dir + "/loaded.asqg");
+    assert(readFileContents(dir + "/graph.asqg") == readFileContents(dir + "/loaded.asqg"));
+    delete pLoaded;
+
+    // Every truncated copy of the snapshot is rejected
+    std::string contents = readFileContents(snapshotFile);
+    std::string damagedFile = dir + "/damaged.snapshot";
+    std::string error;
+    for(size_t n = 0; n < contents.size(); ++n)
+    {
+        writeFileContents(damagedFile, contents.substr(0, n));
+        assert(loadTestSnapshot(damagedFile, error) == NULL);
+        assert(error.find("is truncated") != std::string::npos);
+    }
+
+    // An edge to a vertex that does not exist. The first edge follows the header,
+    // the vertex count, the three vertices and the edge count of A.
+    size_t headerBytes = 8 + (4 + 4) + 3 + 4 + 8 + 4;
+    size_t vertexBytes = 4 + 1 + 4 + 25 + 1;
+    std::string badEdge = contents;
+    badEdge.replace(headerBytes + 3 * vertexBytes + 4, 4, std::string(4, '\xff'));
+    writeFileContents(damagedFile, badEdge);
+    assert(loadTestSnapshot(damagedFile, error) == NULL);
+    assert(error.find("has an invalid edge") != std::string::npos);
+
+    // A vertex count that cannot fit in the file is rejected before anything is allocated
+    std::string badCount = contents;
+    badCount.replace(headerBytes - 4, 4, std::string(4, '\xff'));
+    writeFileContents(damagedFile, badCount);
+    assert(loadTestSnapshot(damagedFile, error) == NULL);
+    assert(error.find("is truncated") != std::string::npos);
+
+    delete pGraph;
+    removeTempDir(dir);
+}
+
+// A compact graph must convert back into the same Bigraph and
+// its walks must spell the same sequences as the walks of the Bigraph
+void compactGraphTests()
+{
+    std::cout << "Testing compact graphs\n";
+    std::string dir = createTempDir();
+    srand(3);
+    std::string genome;
+    for(size_t i = 0; i < 220; ++i)
+        genome.push_back("ACGT"[rand() % 4]);
+
+    // A and B overlap on the same strand and B overlaps the reverse complement C
+    StringGraph* pGraph = new StringGraph;
+    pGraph->setMinOverlap(30);
+    pGraph->setErrorRate(0.02);
+    Vertex* pA = pGraph->createVertex("A", genome.substr(0, 100));
+    Vertex* pB = pGraph->createVertex("B", genome.substr(60, 100));
+    Vertex* pC = pGraph->createVertex("C", reverseComplement(genome.substr(120, 100)));
+    Vertex* pD = pGraph->createVertex("D", genome.substr(10, 50));
+    pGraph->addVertex(pA);
+    pGraph->addVertex(pB);
+    pGraph->addVertex(pC);
+    pGraph->addVertex(pD);
+    pD->setContained(true);
+    SGAlgorithms::createEdgesFromOverlap(pGraph, Overlap("A", 60, 99, 100, "B", 0, 39, 100, false, 0), false);
+    SGAlgorithms::createEdgesFromOverlap(pGraph, Overlap("B", 60, 99, 100, "C", 60, 99, 100, true, 0), false);
+
+    CompactGraph* pCompact = new CompactGraph(pGraph);
+    assert(pCompact->getNumVertices() == 4 && pCompact->getNumEdges() == 4);
+    assert(pCompact->findVertex("E") == CompactGraph::INVALID_VERTEX);
+    CompactGraph::VertexIdx aIdx = pCompact->findVertex("A");
+    CompactGraph::VertexIdx cIdx = pCompact->findVertex("C");
+    CompactGraph::VertexIdx dIdx = pCompact->findVertex("D");
+    assert(pCompact->getSeq(cIdx) == pC->getStr() && pCompact->isContained(dIdx));
+
+    // D has no edges so it is a component on its own
+    std::vector<std::vector<CompactGraph::VertexIdx> > components;
+    pCompact->getConnectedComponents(components);
+    assert(components.size() == 2 && components[0].size() == 3 && components[1].size() == 1);
+
+    // Bigraph -> CompactGraph -> Bigraph
+    Bigraph* pConverted = pCompact->toBigraph();
+    pGraph->writeASQG(dir + "/graph.asqg");
+    pConverted->writeASQG(dir + "/converted.asqg");
+    assert(readFileContents(dir + "/graph.asqg") == readFileContents(dir + "/converted.asqg"));
+    delete pConverted;
+
+    // The walk from A to C crosses the reverse complement edge of B
+    SGWalkVector walks;
+    SGSearch::findWalks(pA, pC, ED_SENSE, 500, 1000, false, walks);
+    CompactWalkVector compactWalks;
+    SGSearch::findWalks(pCompact, aIdx, cIdx, ED_SENSE, 500, 1000, false, compactWalks);
+    assert(walks.size() == 1 && compactWalks.size() == 1);
+    assert(compactWalks[0].getNumVertices() == 3 && compactWalks[0].getVertexIdx(2) == cIdx);
+    assert(compactWalks[0].getString() == walks[0].getString(SGWT_START_TO_END));
+    assert(compactWalks[0].getString() == genome.substr(0, 220));
+
+    delete pCompact;
+    delete pGraph;
+    removeTempDir(dir);
+}
@@ -82,6 +82,14 @@ bool BitChar::updateCAS(unsigned char idx, bool oldValue, bool newValue)
     }
 }
 
+// Set the bit at idx with a single atomic fetch-and-or.
+// Returns the value of the bit before the update.
+bool BitChar::testAndSet(unsigned char idx)
+{
+    unsigned char oldData = __sync_fetch_and_or(&m_data, bc_mask[idx]);
+    return oldData & bc_mask[idx];
+}
+
 //
 std::ostream& operator<<(std::ostream& out, const BitChar& bc)
 {
@@ -20,6 +20,10 @@ struct BitChar
         // Returns true if the update was successfully performed. This is the only thread-safe way to update the BitChar
         bool updateCAS(unsigned char idx, bool oldValue, bool newValue);
 
+        // Atomically set the bit at idx and return its previous value. Unlike updateCAS
+        // this never retries, the update is a single locked fetch-and-or
+        bool testAndSet(unsigned char idx);
+
         // set the bit at idx to the value u
         void set(unsigned char idx, bool v);
 
@@ -72,6 +72,14 @@ bool BitVector::updateCAS(size_t i, bool oldValue, bool newValue)
     return m_data[byte].updateCAS(offset, oldValue, newValue);
 }
 
+//
+bool BitVector::testAndSet(size_t i)
+{
+    size_t byte = i / 8;
+    assert(byte < m_data.size());
+    size_t offset = i - byte * 8;
+    return m_data[byte].testAndSet(offset);
+}
 
 // Set bit at position i to value v
 void BitVector::set(size_t i, bool v)
@@ -90,3 +98,13 @@ bool BitVector::test(size_t i) const
     return m_data[byte].test(offset);
 }
 
+// Test bits lower through upper, inclusive
+bool BitVector::testRange(size_t lower, size_t upper) const
+{
+    for(size_t i = lower; i <= upper; ++i)
+    {
+        if(test(i))
+            return true;
+    }
+    return false;
+}
@@ -32,10 +32,17 @@ class BitVector
         // compare and swap operation. Returns true if the update is successful.
         bool updateCAS(size_t i, bool oldValue, bool newValue);
 
+        // Atomically set bit i and return its previous value. Exactly one of
+        // the threads racing to set a bit sees false, which makes this a claim
+        bool testAndSet(size_t i);
+
         void resize(size_t n);
         void set(size_t i, bool v);
         bool test(size_t i) const;
 
+        // Returns true if any bit in [lower, upper] is set
+        bool testRange(size_t lower, size_t upper) const;
+
     private:
 
         void initializeMutex();
@@ -0,0 +1,210 @@
+//-----------------------------------------------
+// Copyright 2010 Wellcome Trust Sanger Institute
+// Written by Jared Simpson (js18@sanger.ac.uk)
+// Released under the GPL
+//-----------------------------------------------
+//
+// ColumnarPileup - Per-column base counts of a
+// set of weighted overlapping reads
+//
+#include "ColumnarPileup.h"
+#include "CorrectionThresholds.h"
+#include "Quality.h"
+
+//
+void ColumnarPileup::reset(const std::string& rootSeq, const std::string& rootQual)
+{
+    m_rootSeq = rootSeq;
+    m_rootQual = rootQual;
+    m_rows.clear();
+    m_rowSeqs.clear();
+    m_numPrefix = 0;
+    m_numSuffix = 0;
+    m_rowCounts.assign(m_rootSeq.size(), AlphaCount64());
+}
+
+//
+void ColumnarPileup::addRow(const std::string& seq, int offset, int weight, const SeqCoord& rootCoord)
+{
+    Row row;
+    row.seqStart = m_rowSeqs.size();
+    row.seqLen = seq.size();
+    row.offset = offset;
+    row.weight = weight;
+    m_rows.push_back(row);
+    m_rowSeqs.append(seq);
+
+    if(!rootCoord.isContained())
+    {
+        if(rootCoord.isLeftExtreme())
+            m_numPrefix += weight;
+        if(rootCoord.isRightExtreme())
+            m_numSuffix += weight;
+    }
+
+    int start;
+    int end;
+    getColumnRange(row, start, end);
+    for(int i = start; i < end; ++i)
+        m_rowCounts[i].add(seq[i - offset], weight);
+}
+
+//
+void ColumnarPileup::updateRootSeq(const std::string& newSeq)
+{
+    assert(newSeq.size() == m_rootSeq.size());
+    m_rootSeq = newSeq;
+}
+
+//
+void ColumnarPileup::countOverlaps(size_t& prefix_count, size_t& suffix_count) const
+{
+    prefix_count = m_numPrefix;
+    suffix_count = m_numSuffix;
+}
+
+//
+AlphaCount64 ColumnarPileup::getColumnCount(size_t i) const
+{
+    AlphaCount64 ac = m_rowCounts[i];
+    ac.increment(m_rootSeq[i]);
+    return ac;
+}
+
+// A column is checked when the second most frequent base is above the
+// conflict cutoff and the root base is frequent enough to not be an error.
+// Rows that differ from the root at a checked column are left out of
+// the partitioned counts.
+std::string ColumnarPileup::consensusConflict(int conflictCutoff)
+{
+    size_t n = m_rootSeq.size();
+    m_columnCounts.resize(n);
+    m_checkColumn.resize(n);
+    m_partitionCounts.resize(n);
+
+    for(size_t i = 0; i < n; ++i)
+    {
+        AlphaCount64& ac = m_columnCounts[i];
+        ac = getColumnCount(i);
+
+        char sorted[ALPHABET_SIZE];
+        ac.getSorted(sorted, ALPHABET_SIZE);
+        int second = ac.get(sorted[1]);
+        int rootCount = ac.get(m_rootSeq[i]);
+        m_checkColumn[i] = second > conflictCutoff && rootCount > conflictCutoff;
+
+        // the root is always in the partition
+        m_partitionCounts[i] = AlphaCount64();
+        m_partitionCounts[i].increment(m_rootSeq[i]);
+    }
+
+    for(size_t j = 0; j < m_rows.size(); ++j)
+    {
+        const Row& row = m_rows[j];
+        int start;
+        int end;
+        getColumnRange(row, start, end);
+        const char* pSeq = m_rowSeqs.data() + row.seqStart;
+
+        bool mismatch = false;
+        for(int i = start; i < end && !mismatch; ++i)
+        {
+            if(m_checkColumn[i] && pSeq[i - row.offset] != m_rootSeq[i])
+                mismatch = true;
+        }
+
+        if(!mismatch)
+        {
+            for(int i = start; i < end; ++i)
+                m_partitionCounts[i].add(pSeq[i - row.offset], row.weight);
+        }
+    }
+
+    // The reads in the index have no qualities
+    CorrectionThresholds& thresholds = CorrectionThresholds::Instance();
+    int readLogRatio = Quality::getFixedLogCorrect(READ_PHRED) - Quality::getFixedLogError(READ_PHRED);
+
+    std::string consensus;
+    consensus.reserve(n);
+    for(size_t i = 0; i < n; ++i)
+    {
+        char rootBase = m_rootSeq[i];
+        int rootPhred = READ_PHRED;
+        size_t minSupport = thresholds.getMinSupportLowQuality();
+        if(!m_rootQual.empty())
+        {
+            rootPhred = Quality::char2phred(m_rootQual[i]);
+            minSupport = thresholds.getRequiredSupport(rootPhred);
+        }
+
+        AlphaCount64& ac = m_partitionCounts[i];
+        int64_t callSupport = ac.get(rootBase);
+        if(callSupport >= (int64_t)minSupport)
+        {
+            // This base does not require correction
+            consensus.push_back(rootBase);
+            continue;
+        }
+
+        int rootLogRatio = Quality::getFixedLogCorrect(rootPhred) - Quality::getFixedLogError(rootPhred);
+
+        // Attempt to correct the base with the most frequent other base
+        // in the partitioned counts if it explains the column better
+        // than the root base
+        char alt = getBestOtherBase(ac, rootBase);
+        if(alt != '$' && isBetterCall(ac.get(alt), callSupport, rootLogRatio, readLogRatio))
+        {
+            consensus.push_back(alt);
+            continue;
+        }
+
+        // A correction could not be made with the partitioned
+        // counts, use the full column if it is not conflicted
+        AlphaCount64& full = m_columnCounts[i];
+        char sorted[ALPHABET_SIZE];
+        full.getSorted(sorted, ALPHABET_SIZE);
+        int second = full.get(sorted[1]);
+        alt = getBestOtherBase(full, rootBase);
+        if(second <= conflictCutoff && alt != '$' && 
+           isBetterCall(full.get(alt), callSupport, rootLogRatio, readLogRatio))
+            consensus.push_back(alt);
+        else
+            consensus.push_back(rootBase);
+    }
+    return consensus;
+}
+
+// The most frequent base of the column other than the root base.
+// Returns '$' if no other base is seen
+char ColumnarPileup::getBestOtherBase(AlphaCount64& ac, char rootBase)
+{
+    char sorted[ALPHABET_SIZE];
+    ac.getSorted(sorted, ALPHABET_SIZE);
+    for(int i = 0; i < ALPHABET_SIZE; ++i)
+    {
+        if(sorted[i] != rootBase && sorted[i] != '$')
+            return ac.get(sorted[i]) > 0 ? sorted[i] : '$';
+    }
+    return '$';
+}
+
+// The log-likelihood ratio of the other base over the root base being the
+// true base, in fixed point. Reads showing a third base are as likely
+// under either base and cancel. The root read itself is counted in
+// rootCount but weighted by its own quality.
+bool ColumnarPileup::isBetterCall(int64_t altCount, int64_t rootCount, int rootLogRatio, int readLogRatio)
+{
+    int64_t ratio = (altCount - (rootCount - 1)) * readLogRatio - rootLogRatio;
+    return ratio > 0;
+}
+
+//
+bool ColumnarPileup::qcCheck() const
+{
+    for(size_t i = 0; i < m_rootSeq.size(); ++i)
+    {
+        if(getColumnCount(i).get(m_rootSeq[i]) < 2)
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,100 @@
+//-----------------------------------------------
+// Copyright 2010 Wellcome Trust Sanger Institute
+// Written by Jared Simpson (js18@sanger.ac.uk)
+// Released under the GPL
+//-----------------------------------------------
+//
+// ColumnarPileup - The bases of a set of overlapping
+// reads stacked on the columns of a root read, stored
+// as per-column base counts. Every read of an FM-index
+// overlap block has the same sequence and placement so
+// a block is added as a single row with a weight equal
+// to the number of reads in it. The consensus and
+// QC calculations work on the column counts. A base
+// is corrected when another base explains the column
+// better, scoring the root base by its own quality
+// with fixed-point log-likelihoods. Without qualities
+// this gives the same calls as MultiOverlap. The
+// buffers are kept between reads so a pileup can be
+// reused without allocating.
+//
+#ifndef COLUMNARPILEUP_H
+#define COLUMNARPILEUP_H
+
+#include "Alphabet.h"
+#include "SeqCoord.h"
+
+class ColumnarPileup
+{
+    public:
+        ColumnarPileup() : m_numPrefix(0), m_numSuffix(0) {}
+
+        // Start a new pileup on the root sequence
+        void reset(const std::string& rootSeq, const std::string& rootQual);
+
+        // Add weight copies of seq, which starts at column offset of the root
+        // (offset may be negative). rootCoord is the overlapped region of the root
+        void addRow(const std::string& seq, int offset, int weight, const SeqCoord& rootCoord);
+
+        // Replace the root sequence, keeping the rows
+        void updateRootSeq(const std::string& newSeq);
+
+        // Count the number of prefix and suffix overlaps (see MultiOverlap::countOverlaps)
+        void countOverlaps(size_t& prefix_count, size_t& suffix_count) const;
+
+        // Conflict-aware consensus (see MultiOverlap::consensusConflict),
+        // weighing the root base by its quality
+        std::string consensusConflict(int conflictCutoff);
+
+        // Returns true if every base of the root sequence is seen at least
+        // twice in its column, including the root itself
+        bool qcCheck() const;
+
+    private:
+
+        // The assumed quality of the reads in the index, and of the
+        // root when it has no quality string
+        static const int READ_PHRED = 20;
+
+        struct Row
+        {
+            size_t seqStart; // position of the sequence in m_rowSeqs
+            int seqLen;
+            int offset;
+            int weight;
+        };
+
+        // The count of each base in column i, including the root base
+        AlphaCount64 getColumnCount(size_t i) const;
+
+        // Consensus calling helpers
+        static char getBestOtherBase(AlphaCount64& ac, char rootBase);
+        static bool isBetterCall(int64_t altCount, int64_t rootCount, int rootLogRatio, int readLogRatio);
+
+        // The range of columns [start, end) that a row covers
+        inline void getColumnRange(const Row& row, int& start, int& end) const
+        {
+            start = row.offset > 0 ? row.offset : 0;
+            end = row.offset + row.seqLen;
+            if(end > (int)m_rootSeq.size())
+                end = m_rootSeq.size();
+        }
+
+        std::string m_rootSeq;
+        std::string m_rootQual;
+
+        std::vector<Row> m_rows;
+        std::string m_rowSeqs;
+        size_t m_numPrefix;
+        size_t m_numSuffix;
+
+        // The base counts of the rows in each column, not including the root
+        std::vector<AlphaCount64> m_rowCounts;
+
+        // Consensus scratch
+        std::vector<AlphaCount64> m_columnCounts;
+        std::vector<AlphaCount64> m_partitionCounts;
+        std::vector<uint8_t> m_checkColumn;
+};
+
+#endif
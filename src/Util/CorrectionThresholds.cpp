@@ -29,12 +29,3 @@ void CorrectionThresholds::setBaseMinSupport(int ms)
     m_minSupportLowQuality = ms + 1;
 }
 
-//
-int CorrectionThresholds::getRequiredSupport(int phred)
-{
-    int threshold = m_minSupportLowQuality;
-    if(phred >= m_highQualityCutoff)
-        threshold = m_minSupportHighQuality;
-    return threshold;
-}
-
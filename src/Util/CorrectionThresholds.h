@@ -25,7 +25,10 @@ class CorrectionThresholds
         int getHighQualityCutoff() { return m_highQualityCutoff; }
 
         // Returns the support required for a base with phred score phred
-        int getRequiredSupport(int phred);
+        inline int getRequiredSupport(int phred) const
+        {
+            return phred >= m_highQualityCutoff ? m_minSupportHighQuality : m_minSupportLowQuality;
+        }
 
     private:
         int m_highQualityCutoff;
@@ -11,7 +11,10 @@
 #include <cstdlib>
 #include <stdio.h>
 #include <iostream>
+#include <fstream>
+#include <sstream>
 #include <limits>
+#include <unistd.h>
 
 KmerDistribution::KmerDistribution()
 {
@@ -23,6 +26,70 @@ void KmerDistribution::add(int kcount)
     m_data[kcount]++;
 }
 
+//
+void KmerDistribution::merge(const KmerDistribution& other)
+{
+    std::map<int,int>::const_iterator iter = other.m_data.begin();
+    for(; iter != other.m_data.end(); ++iter)
+        m_data[iter->first] += iter->second;
+}
+
+//
+bool KmerDistribution::readFile(const std::string& filename, std::string& outIndexKey, std::string& outSource)
+{
+    std::ifstream reader(filename.c_str());
+    if(!reader.is_open())
+        return false;
+
+    std::string line;
+    if(!getline(reader, line) || line.compare(0, 7, "#index\t") != 0)
+        return false;
+    outIndexKey = line.substr(7);
+    if(!getline(reader, line) || line.compare(0, 8, "#source\t") != 0)
+        return false;
+    outSource = line.substr(8);
+
+    std::map<int,int> data;
+    while(getline(reader, line))
+    {
+        std::stringstream parser(line);
+        int kcount;
+        int n;
+        if(!(parser >> kcount >> n))
+            return false;
+        data[kcount] = n;
+    }
+    m_data.swap(data);
+    return true;
+}
+
+// The histogram is written to a temporary file which is then renamed
+// so concurrent readers never see a partially written file
+void KmerDistribution::writeFile(const std::string& filename, const std::string& indexKey, const std::string& source) const
+{
+    std::stringstream tmpName;
+    tmpName << filename << ".tmp." << getpid();
+    std::ofstream writer(tmpName.str().c_str());
+    if(!writer.is_open())
+    {
+        std::cerr << "Warning: could not write the kmer distribution to " << filename << "\n";
+        return;
+    }
+
+    writer << "#index\t" << indexKey << "\n";
+    writer << "#source\t" << source << "\n";
+    std::map<int,int>::const_iterator iter = m_data.begin();
+    for(; iter != m_data.end(); ++iter)
+        writer << iter->first << "\t" << iter->second << "\n";
+    writer.close();
+
+    if(rename(tmpName.str().c_str(), filename.c_str()) != 0)
+    {
+        std::cerr << "Warning: could not write the kmer distribution to " << filename << "\n";
+        unlink(tmpName.str().c_str());
+    }
+}
+
 double KmerDistribution::getCumulativeProportionLEQ(int n) const
 {
     std::vector<int> countVector = toCountVector();
@@ -11,6 +11,7 @@
 
 #include <vector>
 #include <map>
+#include <string>
 
 class KmerDistribution
 {
@@ -34,6 +35,16 @@ class KmerDistribution
         void add(int count);
         void print(int max) const; 
 
+        // Add the counts of another distribution to this one
+        void merge(const KmerDistribution& other);
+
+        // Read/write the histogram from/to a file. The file starts with
+        // two strings describing the index and the kmers the histogram was
+        // built from, which let the caller decide if it can be reused.
+        // readFile returns false if the file does not exist or is malformed
+        bool readFile(const std::string& filename, std::string& outIndexKey, std::string& outSource);
+        void writeFile(const std::string& filename, const std::string& indexKey, const std::string& source) const;
+
     private:
         std::vector<int> toCountVector() const;
 
@@ -394,35 +394,55 @@ int MultiOverlap::calculateCoverageOverlap()
 
 std::string MultiOverlap::calculateConsensusFromPartition(double p_error)
 {
-    std::string out;
-    out.reserve(m_rootSeq.size());
+    // Count the bases of the root and the reads in partition 0 at each position
+    std::vector<AlphaCount64> counts(m_rootSeq.size());
+    for(size_t i = 0; i < m_rootSeq.size(); ++i)
+        counts[i].increment(m_rootSeq[i]);
+
+    for(size_t j = 0; j < m_overlaps.size(); ++j)
+    {
+        const MOData& curr = m_overlaps[j];
+        if(curr.partitionID != 0)
+            continue;
+        int start = std::max(curr.offset, 0);
+        int end = std::min(curr.offset + (int)curr.seq.size(), (int)m_rootSeq.size());
+        for(int i = start; i < end; ++i)
+            counts[i].increment(curr.seq[i - curr.offset]);
+    }
+
+    // The log-likelihood of the calls at a position given the true base is b is
+    // n_b * log(1 - p_error) + (depth - n_b) * log(p_error) so two bases differ by
+    // the difference of their counts times the log ratio. This is computed once,
+    // in fixed point.
+    int64_t logRatio = static_cast<int64_t>(round(LOG_FIXED_SCALE * (log(1.0 - p_error) - log(p_error))));
 
     // require the best base call to be above this above to correct it
-    double epsilon = 0.01;
+    int64_t epsilon = static_cast<int64_t>(round(LOG_FIXED_SCALE * 0.01));
+
+    std::string out;
+    out.reserve(m_rootSeq.size());
     for(size_t i = 0; i < m_rootSeq.size(); ++i)
     {
-        Pileup p0;
-        Pileup p1;
-        getPartitionedPileup(i, p0, p1);
-        DNADouble ap = p0.calculateLikelihoodNoQuality(p_error);
-        char best_c;
-        char curr_c = m_rootSeq[i];
-        double max;
-        ap.getMax(best_c, max);
+        const AlphaCount64& ac = counts[i];
+        char best_c = DNA_ALPHABET::getBase(0);
+        int64_t best_count = ac.get(best_c);
+        for(int j = 1; j < DNA_ALPHABET::size; ++j)
+        {
+            char b = DNA_ALPHABET::getBase(j);
+            if((int64_t)ac.get(b) > best_count)
+            {
+                best_c = b;
+                best_count = ac.get(b);
+            }
+        }
 
-        //printf("%zu best: %c curr: %c max: %lf curr_l: %lf\n", i, best_c, curr_c, max, ap.get(curr_c));
         // Require the called value to be substantially better than the
         // current base
-        if(best_c == curr_c || (best_c != curr_c && max - ap.get(curr_c) < epsilon))
-        {
-            //std::cout << "using current\n";
-            out.push_back(curr_c);
-        }
-        else
-        {
-            //std::cout << "corrected\n";
+        char curr_c = m_rootSeq[i];
+        if(best_c != curr_c && (best_count - (int64_t)ac.get(curr_c)) * logRatio >= epsilon)
             out.push_back(best_c);
-        }
+        else
+            out.push_back(curr_c);
     }
     return out;
 }
@@ -8,6 +8,21 @@
 //
 #include "Quality.h"
 
+const Quality::LogLikelihoodTable Quality::logLikelihoodTable;
+
+// A call can be no worse than a random base
+Quality::LogLikelihoodTable::LogLikelihoodTable()
+{
+    for(int phred = 0; phred <= MAX_TABLE_PHRED; ++phred)
+    {
+        double p_error = pow(10.0, -phred / 10.0);
+        if(p_error > 0.75)
+            p_error = 0.75;
+        logCorrect[phred] = static_cast<int>(round(LOG_FIXED_SCALE * log(1.0 - p_error)));
+        logError[phred] = static_cast<int>(round(LOG_FIXED_SCALE * log(p_error / 3.0)));
+    }
+}
+
 // Return a uniform log-scaled quality vector of the given size
 DoubleVector Quality::uniformLogProbVector(double p_error, size_t n)
 {
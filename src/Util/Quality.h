@@ -19,6 +19,12 @@
 static const int DEFAULT_QUAL_SCORE = 15;
 static const int PHRED64_DIFF = 31;
 
+// The log-likelihood tables cover phred scores up to this value
+static const int MAX_TABLE_PHRED = 60;
+
+// Fixed-point log-likelihoods are natural logs multiplied by this value
+static const int LOG_FIXED_SCALE = 1024;
+
 typedef std::vector<double> DoubleVector;
 namespace Quality
 {
@@ -64,6 +70,35 @@ namespace Quality
         return static_cast<int>(round(-10.0f * lp));
     }
 
+    // Fixed-point log-likelihoods of a base call given its phred score,
+    // computed once at startup
+    struct LogLikelihoodTable
+    {
+        LogLikelihoodTable();
+
+        // log(1 - p), the call is the true base
+        int logCorrect[MAX_TABLE_PHRED + 1];
+
+        // log(p / 3), the call is a particular other base
+        int logError[MAX_TABLE_PHRED + 1];
+    };
+    extern const LogLikelihoodTable logLikelihoodTable;
+
+    inline int clampTablePhred(int phred)
+    {
+        return phred < 0 ? 0 : (phred > MAX_TABLE_PHRED ? MAX_TABLE_PHRED : phred);
+    }
+
+    inline int getFixedLogCorrect(int phred)
+    {
+        return logLikelihoodTable.logCorrect[clampTablePhred(phred)];
+    }
+
+    inline int getFixedLogError(int phred)
+    {
+        return logLikelihoodTable.logError[clampTablePhred(phred)];
+    }
+
     // Return a uniform log-scaled quality vector of the given size
     DoubleVector uniformLogProbVector(double p_error, size_t n);
 
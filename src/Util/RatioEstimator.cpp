@@ -0,0 +1,77 @@
+//-----------------------------------------------
+// Copyright 2010 Wellcome Trust Sanger Institute
+// Written by Jared Simpson (js18@sanger.ac.uk)
+// Released under the GPL
+//-----------------------------------------------
+//
+// RatioEstimator - Estimate the ratio sum(x) / sum(y) 
+// over a population from a sample of its (x, y) pairs
+//
+#include <math.h>
+#include <algorithm>
+#include "RatioEstimator.h"
+
+//
+void RatioEstimator::add(double x, double y, size_t count)
+{
+    m_n += count;
+    m_sumX += count * x;
+    m_sumY += count * y;
+    m_sumXX += count * x * x;
+    m_sumYY += count * y * y;
+    m_sumXY += count * x * y;
+}
+
+//
+double RatioEstimator::getEstimate() const
+{
+    return m_sumY > 0 ? m_sumX / m_sumY : 0.0f;
+}
+
+// The variance of the residuals x - r * y divided by the squared
+// mean of y, scaled by the finite population correction
+double RatioEstimator::getHalfWidth(double z, size_t populationSize) const
+{
+    if(m_n < 2 || m_sumY <= 0)
+        return 0.0f;
+
+    double n = m_n;
+    double r = getEstimate();
+    double meanY = m_sumY / n;
+    double residuals = m_sumXX - 2 * r * m_sumXY + r * r * m_sumYY;
+    double fpc = populationSize > m_n ? 1.0f - n / populationSize : 0.0f;
+    double variance = fpc * residuals / ((n - 1) * n * meanY * meanY);
+    return variance > 0 ? z * sqrt(variance) : 0.0f;
+}
+
+//
+void RatioEstimator::getInterval(double z, size_t populationSize, double minValue, double maxValue,
+                                 double& lower, double& upper) const
+{
+    double estimate = getEstimate();
+    double halfWidth = getHalfWidth(z, populationSize);
+    lower = std::max(estimate - halfWidth, minValue);
+    upper = std::min(estimate + halfWidth, maxValue);
+}
+
+// The finite population correction scales the variance of the
+// proportion so it is applied to z^2
+void RatioEstimator::getWilsonInterval(size_t count, size_t n, double z, size_t populationSize,
+                                       double& lower, double& upper)
+{
+    if(n == 0)
+    {
+        lower = 0.0f;
+        upper = 1.0f;
+        return;
+    }
+
+    double p = (double)count / n;
+    double fpc = populationSize > n ? 1.0f - (double)n / populationSize : 0.0f;
+    double z2 = z * z * fpc;
+    double denom = 1.0f + z2 / n;
+    double center = (p + z2 / (2 * n)) / denom;
+    double halfWidth = sqrt(z2 * (p * (1 - p) / n + z2 / (4.0f * n * n))) / denom;
+    lower = std::max(center - halfWidth, 0.0);
+    upper = std::min(center + halfWidth, 1.0);
+}
@@ -0,0 +1,58 @@
+//-----------------------------------------------
+// Copyright 2010 Wellcome Trust Sanger Institute
+// Written by Jared Simpson (js18@sanger.ac.uk)
+// Released under the GPL
+//-----------------------------------------------
+//
+// RatioEstimator - Estimate the ratio sum(x) / sum(y) 
+// over a population from a sample of its (x, y) pairs 
+// drawn without replacement. With y = 1 this estimates
+// the mean of x and with x in {0,1} the proportion of
+// the population where x is 1.
+//
+#ifndef RATIOESTIMATOR_H
+#define RATIOESTIMATOR_H
+
+#include <stddef.h>
+
+// The z-score of a two-sided 95% confidence interval
+const double Z_95 = 1.96;
+
+class RatioEstimator
+{
+    public:
+        RatioEstimator() : m_n(0), m_sumX(0), m_sumY(0), m_sumXX(0), m_sumYY(0), m_sumXY(0) {}
+
+        // Add count samples of the pair (x, y)
+        void add(double x, double y, size_t count = 1);
+
+        size_t getSampleSize() const { return m_n; }
+        double getEstimate() const;
+
+        // Returns the half width of the confidence interval around the
+        // estimate for the z-score, using the linearized variance of the 
+        // ratio. The interval has zero width when the whole population
+        // of populationSize elements was sampled
+        double getHalfWidth(double z, size_t populationSize) const;
+
+        // Returns the confidence interval around the estimate clipped to the
+        // range of values the ratio can take
+        void getInterval(double z, size_t populationSize, double minValue, double maxValue,
+                         double& lower, double& upper) const;
+
+        // Returns the Wilson score interval for the proportion count / n. Unlike
+        // the linearized interval it stays within [0, 1] and does not collapse 
+        // to a point when the sample proportion is 0 or 1
+        static void getWilsonInterval(size_t count, size_t n, double z, size_t populationSize,
+                                      double& lower, double& upper);
+
+    private:
+        size_t m_n;
+        double m_sumX;
+        double m_sumY;
+        double m_sumXX;
+        double m_sumYY;
+        double m_sumXY;
+};
+
+#endif
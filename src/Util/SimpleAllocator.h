@@ -6,52 +6,96 @@
 //
 // SimpleAllocator - High-level manager of SimplePool
 // memory pools. See SimplePool.h for description of allocation
-// strategy
+// strategy. Allocations are made from the current pool
+// until it is full, then from pools that have had
+// objects freed before a new pool is created. A pool
+// that becomes empty is returned to the system.
 //
 #ifndef SIMPLEALLOCATOR_H
 #define SIMPLEALLOCATOR_H
 
-#include <list>
+#include <set>
 #include "SimplePool.h"
 
 template<class T>
 class SimpleAllocator
 {
     typedef SimplePool<T> StorageType;
-    typedef std::list<StorageType* > StorageList;
+    typedef std::set<StorageType*> StorageSet;
 
     public:
-        SimpleAllocator() {}
+        SimpleAllocator() : m_pCurrent(NULL) {}
 
         ~SimpleAllocator()
         {
-            for(typename StorageList::iterator iter = m_pPoolList.begin(); iter != m_pPoolList.end(); ++iter)
+            for(typename StorageSet::iterator iter = m_pools.begin(); iter != m_pools.end(); ++iter)
             {
                 delete *iter;
             }
-            m_pPoolList.clear();
+            m_pools.clear();
         }
 
         void* alloc()
         {
-            if(m_pPoolList.empty() || m_pPoolList.back()->isFull())
+            if(m_pCurrent == NULL || m_pCurrent->isFull())
+                m_pCurrent = nextPool();
+            return m_pCurrent->alloc();
+        }
+
+        void dealloc(void* ptr)
+        {
+            StorageType* pPool = StorageType::getPool(ptr);
+            assert(pPool->getAllocator() == this);
+            pPool->dealloc(ptr);
+
+            if(pPool == m_pCurrent)
+                return;
+
+            if(pPool->isEmpty())
             {
-                // new storage must be allocated
-                m_pPoolList.push_back(new StorageType);
+                // Return the memory to the system
+                if(pPool->isPartial())
+                    m_partialPools.erase(pPool);
+                m_pools.erase(pPool);
+                delete pPool;
+            }
+            else if(!pPool->isPartial())
+            {
+                pPool->setPartial(true);
+                m_partialPools.insert(pPool);
             }
-
-            // allocate from the last pool
-            return m_pPoolList.back()->alloc();
         }
 
-        void dealloc(void* /*ptr*/)
+        // Free an object allocated by any SimpleAllocator<T>
+        static void release(void* ptr)
         {
-            // deallocation not tracked in this strategy
+            StorageType::getPool(ptr)->getAllocator()->dealloc(ptr);
         }
 
+        size_t getNumPools() const { return m_pools.size(); }
+        size_t getMemSize() const { return m_pools.size() * StorageType::SLAB_BYTES; }
+
     private:
 
-        StorageList m_pPoolList;
+        // Return a pool with a free block, creating one if necessary
+        StorageType* nextPool()
+        {
+            if(!m_partialPools.empty())
+            {
+                StorageType* pPool = *m_partialPools.begin();
+                m_partialPools.erase(m_partialPools.begin());
+                pPool->setPartial(false);
+                return pPool;
+            }
+
+            StorageType* pPool = new StorageType(this);
+            m_pools.insert(pPool);
+            return pPool;
+        }
+
+        StorageSet m_pools;
+        StorageSet m_partialPools;
+        StorageType* m_pCurrent;
 };
 
 #endif
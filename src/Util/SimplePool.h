@@ -4,68 +4,115 @@
 // Released under the GPL license
 //-----------------------------------------------
 //
-// SimplePool - Zero-overhead templated memory pool 
-// The design is based on the premise that the allocation
-// of the objects have a lifetime the length of the program's
-// execution so they are never freed. Should only be used when
-// the number of objects is bounded so the pool does not constantly grow.
+// SimplePool - Templated slab of memory holding a
+// fixed number of objects of type T. The slab is 
+// aligned to its size so the pool that owns an object 
+// can be found from the address of the object alone.
+// Freed objects are threaded onto a free list stored 
+// in the objects themselves and are reused by later 
+// allocations. The number of live objects is tracked
+// so the owner can return empty slabs to the system.
 //
 // Not thread-safe.
 // 
 #ifndef SIMPLEPOOL_H
 #define SIMPLEPOOL_H
 
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+#include <iostream>
+
+template<class T> class SimpleAllocator;
+
 template<class T>
 class SimplePool
 {
     public:
 
-        SimplePool()
+        static const size_t SLAB_BYTES = 1 << 20;
+
+        SimplePool(SimpleAllocator<T>* pAllocator) : m_pAllocator(pAllocator),
+                                                     m_pFreeList(NULL),
+                                                     m_numLive(0),
+                                                     m_isPartial(false)
         {
-            size_t bytes_per_object = sizeof(T);
-            size_t total_bytes = NUM_OBJECTS * bytes_per_object;
-            m_pPool = malloc(total_bytes);
-            if(m_pPool == NULL)
+            assert(sizeof(T) >= sizeof(void*));
+            if(posix_memalign(&m_pSlab, SLAB_BYTES, SLAB_BYTES) != 0)
             {
-                std::cerr << "SimpleStorage failed to allocate " << total_bytes << 
+                std::cerr << "SimplePool failed to allocate " << SLAB_BYTES << 
                 " bytes for memory pool, exiting\n";
                 abort();
             }
-            m_capacity = total_bytes;
-            m_used = 0;
+
+            // The header of the slab points back to this pool
+            *(SimplePool<T>**)m_pSlab = this;
+            size_t numObjects = (SLAB_BYTES - HEADER_BYTES) / sizeof(T);
+            m_pNext = (char*)m_pSlab + HEADER_BYTES;
+            m_pEnd = m_pNext + numObjects * sizeof(T);
         }
 
         ~SimplePool()
         {
-            free(m_pPool);
+            free(m_pSlab);
         }
     
-        // Return a pointer to the next unused block of memory
+        // Return a pointer to a free block of memory, 
+        // preferring previously freed blocks
         void* alloc()
         {
-            assert(m_used < m_capacity);
-            void* pNext = (char*)m_pPool + m_used;
-            m_used += sizeof(T);
+            void* pNext;
+            if(m_pFreeList != NULL)
+            {
+                pNext = m_pFreeList;
+                m_pFreeList = *(void**)pNext;
+            }
+            else
+            {
+                assert(m_pNext < m_pEnd);
+                pNext = m_pNext;
+                m_pNext += sizeof(T);
+            }
+            ++m_numLive;
             return pNext;
         }
 
-        // Do not track deallocations
-        void dealloc(void* /*ptr*/)
+        // Return a block to the free list
+        void dealloc(void* ptr)
         {
-            // does nothing
+            assert(getPool(ptr) == this && m_numLive > 0);
+            *(void**)ptr = m_pFreeList;
+            m_pFreeList = ptr;
+            --m_numLive;
         }
 
-        bool isFull()
+        bool isFull() const { return m_pFreeList == NULL && m_pNext >= m_pEnd; }
+        bool isEmpty() const { return m_numLive == 0; }
+        size_t getNumLive() const { return m_numLive; }
+        SimpleAllocator<T>* getAllocator() const { return m_pAllocator; }
+
+        // The allocator keeps a list of the pools that have free blocks
+        bool isPartial() const { return m_isPartial; }
+        void setPartial(bool b) { m_isPartial = b; }
+
+        // Return the pool that ptr was allocated from
+        static SimplePool<T>* getPool(void* ptr)
         {
-            return m_used >= m_capacity;
+            return *(SimplePool<T>**)((uintptr_t)ptr & ~(uintptr_t)(SLAB_BYTES - 1));
         }
 
     private:
 
-        void* m_pPool;
-        size_t m_capacity;
-        size_t m_used;
-        static const size_t NUM_OBJECTS = 50*1024;
+        // Keep the objects aligned after the back pointer
+        static const size_t HEADER_BYTES = 64;
+
+        SimpleAllocator<T>* m_pAllocator;
+        void* m_pSlab;
+        char* m_pNext;
+        char* m_pEnd;
+        void* m_pFreeList;
+        size_t m_numLive;
+        bool m_isPartial;
 };
 
 #endif
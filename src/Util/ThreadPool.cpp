@@ -0,0 +1,360 @@
+//-----------------------------------------------
+// Copyright 2010 Wellcome Trust Sanger Institute
+// Written by Jared Simpson (js18@sanger.ac.uk)
+// Released under the GPL license
+//-----------------------------------------------
+//
+// ThreadPool - Process-wide pool of worker threads.
+//
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstdio>
+#include <unistd.h>
+#include <sched.h>
+#include "ThreadPool.h"
+
+//
+// TaskGroup
+//
+TaskGroup::TaskGroup() : m_numPending(0)
+{
+    pthread_mutex_init(&m_mutex, NULL);
+    pthread_cond_init(&m_cond, NULL);
+}
+
+//
+TaskGroup::~TaskGroup()
+{
+    assert(m_numPending == 0);
+    pthread_cond_destroy(&m_cond);
+    pthread_mutex_destroy(&m_mutex);
+}
+
+//
+void TaskGroup::add()
+{
+    pthread_mutex_lock(&m_mutex);
+    ++m_numPending;
+    pthread_mutex_unlock(&m_mutex);
+}
+
+//
+void TaskGroup::done()
+{
+    pthread_mutex_lock(&m_mutex);
+    assert(m_numPending > 0);
+    if(--m_numPending == 0)
+        pthread_cond_broadcast(&m_cond);
+    pthread_mutex_unlock(&m_mutex);
+}
+
+//
+void TaskGroup::wait()
+{
+    pthread_mutex_lock(&m_mutex);
+    while(m_numPending > 0)
+        pthread_cond_wait(&m_cond, &m_mutex);
+    pthread_mutex_unlock(&m_mutex);
+}
+
+//
+// NumaTopology
+//
+NumaTopology::NumaTopology(const std::string& cpuList)
+{
+    std::vector<int> allowed;
+    if(!cpuList.empty())
+    {
+        allowed = parseCPUList(cpuList);
+        std::sort(allowed.begin(), allowed.end());
+    }
+
+    // Read the CPUs of each node from sysfs
+    for(int node = 0; ; ++node)
+    {
+        std::stringstream ss;
+        ss << "/sys/devices/system/node/node" << node << "/cpulist";
+        std::ifstream reader(ss.str().c_str());
+        if(!reader.is_open())
+            break;
+
+        std::string line;
+        getline(reader, line);
+        std::vector<int> nodeCPUs = parseCPUList(line);
+
+        std::vector<int> usable;
+        for(size_t i = 0; i < nodeCPUs.size(); ++i)
+        {
+            if(allowed.empty() || std::binary_search(allowed.begin(), allowed.end(), nodeCPUs[i]))
+                usable.push_back(nodeCPUs[i]);
+        }
+
+        if(!usable.empty())
+            m_nodeCPUs.push_back(usable);
+    }
+
+    // No NUMA information available, treat the machine as a single node
+    if(m_nodeCPUs.empty())
+    {
+        std::vector<int> usable = allowed;
+        if(usable.empty())
+        {
+            long numCPUs = sysconf(_SC_NPROCESSORS_ONLN);
+            for(long i = 0; i < numCPUs; ++i)
+                usable.push_back(i);
+        }
+        m_nodeCPUs.push_back(usable);
+    }
+
+    for(size_t i = 0; i < m_nodeCPUs.size(); ++i)
+        m_allCPUs.insert(m_allCPUs.end(), m_nodeCPUs[i].begin(), m_nodeCPUs[i].end());
+}
+
+//
+std::vector<int> NumaTopology::parseCPUList(const std::string& str)
+{
+    std::vector<int> out;
+    std::stringstream parser(str);
+    std::string range;
+    while(getline(parser, range, ','))
+    {
+        if(range.empty())
+            continue;
+
+        int start = 0;
+        int end = 0;
+        size_t dashPos = range.find('-');
+        if(dashPos == std::string::npos)
+        {
+            start = end = atoi(range.c_str());
+        }
+        else
+        {
+            start = atoi(range.substr(0, dashPos).c_str());
+            end = atoi(range.substr(dashPos + 1).c_str());
+        }
+
+        for(int i = start; i <= end; ++i)
+            out.push_back(i);
+    }
+    return out;
+}
+
+//
+// ThreadPool
+//
+static std::string getEnvString(const char* name)
+{
+    const char* value = getenv(name);
+    return value != NULL ? std::string(value) : std::string();
+}
+
+//
+ThreadPool::ThreadPool() : m_policy(AP_NONE),
+                           m_topology(getEnvString("SGA_CPU_LIST")),
+                           m_nextCPU(0)
+{
+    std::string policy = getEnvString("SGA_THREAD_AFFINITY");
+    if(policy == "node")
+        m_policy = AP_NODE;
+    else if(policy == "core")
+        m_policy = AP_CORE;
+    else if(!policy.empty() && policy != "none")
+        std::cerr << "Warning: unknown SGA_THREAD_AFFINITY value " << policy << ", threads will not be pinned\n";
+
+#if !defined(__linux__)
+    m_policy = AP_NONE;
+#endif
+
+    m_nextNodeCPU.resize(m_topology.getNumNodes(), 0);
+    pthread_mutex_init(&m_mutex, NULL);
+}
+
+//
+ThreadPool::~ThreadPool()
+{
+    stopThreads();
+    pthread_mutex_destroy(&m_mutex);
+}
+
+// The pool is intentionally never destroyed. Threads that are
+// still idle at exit are reclaimed with the process, which avoids
+// joining from a static destructor that may run on a pool thread
+ThreadPool& ThreadPool::getInstance()
+{
+    static ThreadPool* pPool = new ThreadPool;
+    return *pPool;
+}
+
+//
+void ThreadPool::shutdown()
+{
+    getInstance().stopThreads();
+}
+
+//
+int ThreadPool::getNodeForWorker(int i) const
+{
+    if(m_policy == AP_NONE)
+        return ANY_NODE;
+    return i % m_topology.getNumNodes();
+}
+
+//
+void ThreadPool::submit(PoolTask* pTask, TaskGroup* pGroup, int node)
+{
+    if(m_policy == AP_NONE)
+        node = ANY_NODE;
+
+    pGroup->add();
+    pthread_mutex_lock(&m_mutex);
+
+    // Find an idle thread that is on the requested node
+    PoolThread* pThread = NULL;
+    for(size_t i = 0; i < m_threads.size(); ++i)
+    {
+        if(m_threads[i]->pTask == NULL && (node == ANY_NODE || m_threads[i]->node == node))
+        {
+            pThread = m_threads[i];
+            break;
+        }
+    }
+
+    if(pThread == NULL)
+        pThread = createThread(node);
+
+    pThread->pTask = pTask;
+    pThread->pGroup = pGroup;
+    pthread_cond_signal(&pThread->cond);
+    pthread_mutex_unlock(&m_mutex);
+}
+
+// Create a new idle thread. The pool mutex must be held
+ThreadPool::PoolThread* ThreadPool::createThread(int node)
+{
+    PoolThread* pThread = new PoolThread;
+    pthread_cond_init(&pThread->cond, NULL);
+    pThread->pPool = this;
+    pThread->node = node;
+    pThread->pTask = NULL;
+    pThread->pGroup = NULL;
+    pThread->stopRequested = false;
+
+    int ret = pthread_create(&pThread->thread, 0, &ThreadPool::startThread, pThread);
+    if(ret != 0)
+    {
+        std::cerr << "Thread creation failed with error " << ret << ", aborting" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    // The thread cannot pick up work until the pool mutex is
+    // released so it is pinned before it runs any task
+    bindThread(pThread, node);
+    m_threads.push_back(pThread);
+    return pThread;
+}
+
+// Set the CPU affinity of the thread according to the policy
+void ThreadPool::bindThread(PoolThread* pThread, int node)
+{
+#if defined(__linux__)
+    std::vector<int> cpus;
+    if(m_policy == AP_NODE && node != ANY_NODE)
+    {
+        cpus = m_topology.getNodeCPUs(node);
+    }
+    else if(m_policy == AP_CORE && node != ANY_NODE)
+    {
+        const std::vector<int>& nodeCPUs = m_topology.getNodeCPUs(node);
+        cpus.push_back(nodeCPUs[m_nextNodeCPU[node]++ % nodeCPUs.size()]);
+    }
+    else if(m_policy == AP_CORE)
+    {
+        const std::vector<int>& allCPUs = m_topology.getAllCPUs();
+        cpus.push_back(allCPUs[m_nextCPU++ % allCPUs.size()]);
+    }
+
+    if(cpus.empty())
+        return;
+
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    for(size_t i = 0; i < cpus.size(); ++i)
+        CPU_SET(cpus[i], &cpuset);
+
+    int ret = pthread_setaffinity_np(pThread->thread, sizeof(cpu_set_t), &cpuset);
+    if(ret != 0)
+        std::cerr << "Warning: could not set thread affinity (error " << ret << ")\n";
+#else
+    (void)pThread;
+    (void)node;
+#endif
+}
+
+// Main loop of a pool thread
+void ThreadPool::runThread(PoolThread* pThread)
+{
+    pthread_mutex_lock(&m_mutex);
+    while(1)
+    {
+        while(pThread->pTask == NULL && !pThread->stopRequested)
+            pthread_cond_wait(&pThread->cond, &m_mutex);
+
+        if(pThread->pTask == NULL)
+            break;
+
+        PoolTask* pTask = pThread->pTask;
+        TaskGroup* pGroup = pThread->pGroup;
+        pthread_mutex_unlock(&m_mutex);
+
+        pTask->run();
+
+        // The task may be deleted by the submitter once
+        // the group is signalled so it is not touched after this
+        pthread_mutex_lock(&m_mutex);
+        pThread->pTask = NULL;
+        pThread->pGroup = NULL;
+        pthread_mutex_unlock(&m_mutex);
+        pGroup->done();
+        pthread_mutex_lock(&m_mutex);
+    }
+    pthread_mutex_unlock(&m_mutex);
+}
+
+// Stop all the threads once they have finished their current task
+void ThreadPool::stopThreads()
+{
+    pthread_mutex_lock(&m_mutex);
+    std::vector<PoolThread*> threads;
+    threads.swap(m_threads);
+    for(size_t i = 0; i < threads.size(); ++i)
+    {
+        threads[i]->stopRequested = true;
+        pthread_cond_signal(&threads[i]->cond);
+    }
+    pthread_mutex_unlock(&m_mutex);
+
+    for(size_t i = 0; i < threads.size(); ++i)
+    {
+        int ret = pthread_join(threads[i]->thread, NULL);
+        if(ret != 0)
+        {
+            std::cerr << "Thread join failed with error " << ret << ", aborting" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        pthread_cond_destroy(&threads[i]->cond);
+        delete threads[i];
+    }
+}
+
+// Thread entry point
+void* ThreadPool::startThread(void* obj)
+{
+    PoolThread* pThread = reinterpret_cast<PoolThread*>(obj);
+    pThread->pPool->runThread(pThread);
+    return NULL;
+}
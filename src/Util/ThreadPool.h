@@ -0,0 +1,149 @@
+//-----------------------------------------------
+// Copyright 2010 Wellcome Trust Sanger Institute
+// Written by Jared Simpson (js18@sanger.ac.uk)
+// Released under the GPL license
+//-----------------------------------------------
+//
+// ThreadPool - Process-wide pool of worker threads.
+// Threads are created on demand and reused by every
+// parallel stage of the program (sequence processing,
+// gap array construction, parallel sorting) instead of
+// being created and destroyed by each stage.
+//
+// Threads can optionally be pinned to CPUs. The placement
+// is controlled by two environment variables:
+//   SGA_THREAD_AFFINITY=none|node|core
+//      none - threads are not pinned (default)
+//      node - worker threads are bound to the CPUs of a single
+//             NUMA node, distributed round-robin over the nodes
+//      core - worker threads are bound to individual CPUs,
+//             distributed round-robin over the nodes
+//   SGA_CPU_LIST=LIST
+//      restrict the pool to the CPUs in LIST, which uses the
+//      kernel cpulist format (for example 0-7,16-23)
+//
+// Memory pages are placed on the NUMA node of the thread
+// that first writes to them. Data structures that are read
+// by all workers (like the FM-index) can be replicated per
+// node by loading them with a task pinned to that node.
+//
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <pthread.h>
+#include <vector>
+#include <string>
+
+// Interface for a unit of work that can be run on the pool
+class PoolTask
+{
+    public:
+        virtual ~PoolTask() {}
+        virtual void run() = 0;
+};
+
+// A set of tasks that the submitting thread can wait on
+class TaskGroup
+{
+    public:
+        TaskGroup();
+        ~TaskGroup();
+
+        // Called by the pool when a task is added/finishes
+        void add();
+        void done();
+
+        // Block until all the tasks in the group have finished
+        void wait();
+
+    private:
+        int m_numPending;
+        pthread_mutex_t m_mutex;
+        pthread_cond_t m_cond;
+};
+
+enum AffinityPolicy
+{
+    AP_NONE,
+    AP_NODE,
+    AP_CORE
+};
+
+// The CPUs available to the program grouped by NUMA node
+class NumaTopology
+{
+    public:
+        NumaTopology(const std::string& cpuList);
+
+        int getNumNodes() const { return m_nodeCPUs.size(); }
+        const std::vector<int>& getNodeCPUs(int node) const { return m_nodeCPUs[node]; }
+        const std::vector<int>& getAllCPUs() const { return m_allCPUs; }
+
+        // Parse a cpulist string like 0-3,8,10-11
+        static std::vector<int> parseCPUList(const std::string& str);
+
+    private:
+        std::vector<std::vector<int> > m_nodeCPUs;
+        std::vector<int> m_allCPUs;
+};
+
+class ThreadPool
+{
+    public:
+
+        static const int ANY_NODE = -1;
+
+        // Get the process-wide pool
+        static ThreadPool& getInstance();
+
+        // Stop and join all the pool threads. The pool
+        // will create new threads if it is used again
+        static void shutdown();
+
+        // Run pTask on a pool thread and register it with pGroup. If node is not ANY_NODE
+        // the task will be run on a thread bound to the CPUs of that NUMA node.
+        // A new thread is created if no idle thread is available so tasks
+        // which block on each other can always make progress.
+        void submit(PoolTask* pTask, TaskGroup* pGroup, int node = ANY_NODE);
+
+        // Returns the NUMA node the i-th worker of a parallel stage
+        // should run on, or ANY_NODE if threads are not pinned.
+        // Callers can use this to hand each worker node-local data
+        int getNodeForWorker(int i) const;
+
+        int getNumNodes() const { return m_topology.getNumNodes(); }
+        AffinityPolicy getAffinityPolicy() const { return m_policy; }
+
+    private:
+
+        struct PoolThread
+        {
+            pthread_t thread;
+            pthread_cond_t cond;
+            ThreadPool* pPool;
+            int node;
+            PoolTask* pTask;
+            TaskGroup* pGroup;
+            bool stopRequested;
+        };
+
+        ThreadPool();
+        ~ThreadPool();
+
+        void stopThreads();
+        PoolThread* createThread(int node);
+        void bindThread(PoolThread* pThread, int node);
+        void runThread(PoolThread* pThread);
+        static void* startThread(void* obj);
+
+        //
+        AffinityPolicy m_policy;
+        NumaTopology m_topology;
+
+        std::vector<PoolThread*> m_threads;
+        std::vector<size_t> m_nextNodeCPU;
+        size_t m_nextCPU;
+        pthread_mutex_t m_mutex;
+};
+
+#endif
@@ -183,12 +183,14 @@ void parallel_mkqs(T* pData, int n, int numThreads, const PrimarySorter& primary
     sem_t done_sem;
     sem_init( &done_sem, PTHREAD_PROCESS_PRIVATE, 0 );
 
-    // Create and start the threads
+    // Create the workers and start them on the thread pool
+    ThreadPool& pool = ThreadPool::getInstance();
+    TaskGroup taskGroup;
     MkqsThread<T, PrimarySorter, FinalSorter>* threads[numThreads];
     for(int i = 0; i < numThreads; ++i)
     {
         threads[i] = new MkqsThread<T, PrimarySorter, FinalSorter>(i, &queue, &queue_mutex, &queue_sem, &done_sem, threshold_size, &primarySorter, &finalSorter);   
-        threads[i]->start();
+        pool.submit(threads[i], &taskGroup, pool.getNodeForWorker(i));
     }
 
     // Check for the end condition
@@ -212,7 +214,7 @@ void parallel_mkqs(T* pData, int n, int numThreads, const PrimarySorter& primary
     }
 
     // Signal all the threads to stop, then post to the semaphore they are waiting on
-    // All threads will pick up the stop request after the posts and call pthread exit
+    // All threads will pick up the stop request after the posts and return to the pool
     for(int i = 0; i < numThreads; ++i)
     {
         threads[i]->stop();
@@ -223,12 +225,10 @@ void parallel_mkqs(T* pData, int n, int numThreads, const PrimarySorter& primary
         sem_post(&queue_sem);
     }
 
-    // Join and destroy the threads
+    // Wait for the workers to finish and destroy them
+    taskGroup.wait();
     for(int i = 0; i < numThreads; ++i)
-    {
-        threads[i]->join();
         delete threads[i];
-    }
 
     // Destroy the semaphore
     sem_destroy(&queue_sem);